@@ -0,0 +1,343 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <iostream>             // cout
+
+#include <QApplication>
+#include <QTreeWidgetItem>
+
+#include <zypp/Resolver.h>
+#include <zypp/ZYppFactory.h>
+
+#include "Exception.h"
+#include "Logger.h"
+#include "StartupProfile.h"
+#include "YQPkgFilterTab.h"
+#include "YQPkgList.h"
+#include "YQPkgSearchFilterView.h"
+#include "YQPkgSelector.h"
+#include "YQZypp.h"
+#include "Benchmark.h"
+
+
+// Select every nth package in the "details" scenario
+#define DETAILS_STEP            10
+
+// ...but not more than this number of packages
+#define DETAILS_MAX_PKG         500
+
+
+QString Benchmark::_scenarioToRun;
+
+
+// Fixed list of searches: Different search modes (see SearchFilter), many
+// and few results, and no result at all
+
+static const char * benchmarkSearches[] =
+{
+    "kernel-default",
+    "lib",
+    "python3",
+    "yast2-*",
+    "^perl-.*-devel$",
+    "firefox",
+    "no-such-package-xyz",
+    0
+};
+
+
+Benchmark::Benchmark( const QString & scenario, YQPkgSelector * pkgSel )
+    : _scenario( scenario )
+    , _pkgSel( pkgSel )
+{
+    CHECK_PTR( _pkgSel );
+}
+
+
+QStringList Benchmark::scenarios()
+{
+    QStringList scenarios;
+    scenarios << "all"
+              << "filter-pages"
+              << "search"
+              << "sort"
+              << "details"
+              << "global-update";
+
+    return scenarios;
+}
+
+
+int Benchmark::run()
+{
+    logInfo() << "Running benchmark scenario \"" << _scenario << "\"" << endl;
+
+    bool all = ( _scenario == "all" );
+
+    // Status changes must not trigger the solver: It would open the conflict
+    // dialog if there are any conflicts, and nobody would be there to close
+    // it. runGlobalUpdate() calls the solver directly.
+
+    bool autoCheck = _pkgSel->autoCheckDependencies();
+    _pkgSel->setAutoCheckDependencies( false );
+
+    if ( all || _scenario == "filter-pages"  )  runFilterPages();
+    if ( all || _scenario == "search"        )  runSearches();
+    if ( all || _scenario == "sort"          )  runSorting();
+    if ( all || _scenario == "details"       )  runDetails();
+    if ( all || _scenario == "global-update" )  runGlobalUpdate();
+
+    _pkgSel->setAutoCheckDependencies( autoCheck );
+
+    if ( _operations.isEmpty() )
+    {
+        logError() << "No operations for scenario \"" << _scenario << "\"" << endl;
+        return 1;
+    }
+
+    QString report = jsonReport();
+    std::cout << qPrintable( report ) << std::flush;
+    logInfo() << "Benchmark report:\n" << report << endl;
+
+    return 0;
+}
+
+
+int Benchmark::measure( const QString & name, std::function<int()> operation )
+{
+    QElapsedTimer timer;
+    qint64 startCpuUsec = StartupProfile::cpuMicrosec();
+    timer.start();
+
+    int items = operation();
+
+    Operation op;
+    op.name     = name;
+    op.wallUsec = timer.nsecsElapsed() / 1000;
+    op.cpuUsec  = StartupProfile::cpuMicrosec() - startCpuUsec;
+    op.items    = items;
+
+    _operations << op;
+
+    logInfo() << name << ": " << op.wallUsec / 1000.0 << " millisec, "
+              << items << " items" << endl;
+
+    // Let any deferred work (repaints, queued signals) settle outside of the
+    // measured time so it doesn't end up in the next operation
+
+    qApp->processEvents();
+
+    return items;
+}
+
+
+void Benchmark::runFilterPages()
+{
+    YQPkgFilterTab * filters = _pkgSel->filters();
+    CHECK_PTR( filters );
+
+    // Showing a page for the first time also creates it
+
+    for ( const QString & pageId: filters->pageIds() )
+    {
+        measure( QString( "page:%1" ).arg( pageId ), [ this, filters, pageId ]()
+            {
+                filters->showPage( pageId );
+                return pkgListCount();
+            });
+    }
+}
+
+
+void Benchmark::runSearches()
+{
+    for ( int i=0; benchmarkSearches[ i ]; i++ )
+    {
+        QString searchText = benchmarkSearches[ i ];
+
+        measure( QString( "search:%1" ).arg( searchText ), [ this, searchText ]()
+            {
+                return search( searchText );
+            });
+    }
+}
+
+
+void Benchmark::runSorting()
+{
+    fillPkgList();
+
+    YQPkgList * pkgList = _pkgSel->pkgList();
+    CHECK_PTR( pkgList );
+
+    for ( int col=0; col < pkgList->columnCount(); col++ )
+    {
+        QString name = QString( "sort:%1" ).arg( pkgList->headerItem()->text( col ) );
+
+        measure( name, [ this, pkgList, col ]()
+            {
+                pkgList->sortByColumn( col, Qt::AscendingOrder );
+                return pkgListCount();
+            });
+    }
+}
+
+
+void Benchmark::runDetails()
+{
+    fillPkgList();
+
+    YQPkgList * pkgList = _pkgSel->pkgList();
+    CHECK_PTR( pkgList );
+
+    measure( "details", [ pkgList ]()
+        {
+            int count = 0;
+
+            for ( int i=0;
+                  i < pkgList->topLevelItemCount() && count < DETAILS_MAX_PKG;
+                  i += DETAILS_STEP )
+            {
+                // This updates the visible details view
+                pkgList->setCurrentItem( pkgList->topLevelItem( i ) );
+                ++count;
+            }
+
+            return count;
+        });
+}
+
+
+void Benchmark::runGlobalUpdate()
+{
+    YQPkgList * pkgList = _pkgSel->pkgList();
+    CHECK_PTR( pkgList );
+
+    measure( "global-update:set-status", [ pkgList ]()
+        {
+            return pkgList->globalSetPkgStatus( S_Update,
+                                                false,   // force
+                                                false ); // countOnly
+        });
+
+    // Call the solver directly (see run()), so this is the only place where
+    // its time is measured
+
+    measure( "global-update:solver", []()
+        {
+            // Report the number of problems the solver found
+
+            zypp::Resolver_Ptr resolver = zypp::getZYpp()->resolver();
+
+            if ( resolver->resolvePool() )
+                return 0;
+
+            return (int) resolver->problems().size();
+        });
+}
+
+
+void Benchmark::fillPkgList()
+{
+    search( "lib" );
+    qApp->processEvents();
+}
+
+
+int Benchmark::search( const QString & searchText )
+{
+    YQPkgFilterTab * filters = _pkgSel->filters();
+    CHECK_PTR( filters );
+
+    filters->showPage( "search" ); // This creates the search filter view if needed
+
+    YQPkgFilterPage * page = filters->findPage( "search" );
+    CHECK_PTR( page );
+
+    YQPkgSearchFilterView * searchFilterView = qobject_cast<YQPkgSearchFilterView *>( page->content );
+    CHECK_PTR( searchFilterView );
+
+    searchFilterView->search( searchText );
+
+    return pkgListCount();
+}
+
+
+int Benchmark::pkgListCount() const
+{
+    YQPkgList * pkgList = _pkgSel->pkgList();
+
+    return pkgList ? pkgList->topLevelItemCount() : 0;
+}
+
+
+static QString jsonString( const QString & str )
+{
+    QString escaped = str;
+    escaped.replace( "\\", "\\\\" );
+    escaped.replace( "\"", "\\\"" );
+
+    return QString( "\"%1\"" ).arg( escaped );
+}
+
+
+static QString millisec( qint64 usec )
+{
+    return QString::number( usec / 1000.0, 'f', 1 );
+}
+
+
+QString Benchmark::jsonReport() const
+{
+    qint64 totalWallUsec = 0;
+    qint64 totalCpuUsec  = 0;
+    QStringList operations;
+
+    for ( const Operation & op: _operations )
+    {
+        // One operation per line so the reports are easy to diff
+
+        operations << QString( "    { \"name\": %1, \"wall_ms\": %2, \"cpu_ms\": %3, \"items\": %4 }" )
+            .arg( jsonString( op.name ) )
+            .arg( millisec( op.wallUsec ) )
+            .arg( millisec( op.cpuUsec  ) )
+            .arg( op.items );
+
+        totalWallUsec += op.wallUsec;
+        totalCpuUsec  += op.cpuUsec;
+    }
+
+    int pkgCount = 0;
+
+    for ( ZyppPoolIterator it = zyppPkgBegin(); it != zyppPkgEnd(); ++it )
+        ++pkgCount;
+
+    QString json;
+    json += "{\n";
+    json += QString( "  \"scenario\": %1,\n"      ).arg( jsonString( _scenario ) );
+    json += QString( "  \"version\": %1,\n"       ).arg( jsonString( VERSION ) );
+    json += QString( "  \"qt_version\": %1,\n"    ).arg( jsonString( QT_VERSION_STR ) );
+    json += QString( "  \"packages\": %1,\n"      ).arg( pkgCount );
+    json += QString( "  \"operations\": [\n%1\n  ],\n" ).arg( operations.join( ",\n" ) );
+    json += QString( "  \"total_wall_ms\": %1,\n" ).arg( millisec( totalWallUsec ) );
+    json += QString( "  \"total_cpu_ms\": %1,\n"  ).arg( millisec( totalCpuUsec  ) );
+    json += QString( "  \"peak_rss_kb\": %1\n"    ).arg( StartupProfile::peakRssKB() );
+    json += "}\n";
+
+    return json;
+}
@@ -0,0 +1,141 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef Benchmark_h
+#define Benchmark_h
+
+
+#include <functional>
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+
+class YQPkgSelector;
+
+
+/**
+ * Headless benchmark for the --benchmark <scenario> command line option:
+ * Run a number of scripted operations in the package selector without any
+ * user interaction, write a JSON report of the timings and the peak memory
+ * usage to stdout and to the log, and quit.
+ *
+ * Scenarios:
+ *
+ *   filter-pages   Open each filter page
+ *   search         Run a fixed list of searches
+ *   sort           Sort the package list by each column
+ *   details        Select every nth package to update the details views
+ *   global-update  Set all packages to "update" and run the solver
+ *   all            All of the above in that order
+ *
+ * The report only contains values that don't depend on the time of day or
+ * on the machine's name, and in a fixed order, so reports from different
+ * builds can be compared with 'diff'.
+ **/
+class Benchmark
+{
+public:
+
+    /**
+     * Constructor.
+     **/
+    Benchmark( const QString & scenario, YQPkgSelector * pkgSel );
+
+    /**
+     * Run the scenario and write the report.
+     * Return the exit code for the program: 0 for success.
+     **/
+    int run();
+
+    /**
+     * Return the report in JSON format.
+     **/
+    QString jsonReport() const;
+
+    /**
+     * Return the names of all known scenarios.
+     **/
+    static QStringList scenarios();
+
+    /**
+     * Set the scenario that the benchmark should run from the command line.
+     **/
+    static void setScenario( const QString & scenario ) { _scenarioToRun = scenario; }
+
+    /**
+     * Return the scenario from the command line.
+     **/
+    static const QString & scenarioToRun() { return _scenarioToRun; }
+
+
+protected:
+
+    /**
+     * Run 'operation', add its timing to the report with 'name', and return
+     * the number of items that it processed.
+     **/
+    int measure( const QString & name, std::function<int()> operation );
+
+    void runFilterPages();
+    void runSearches();
+    void runSorting();
+    void runDetails();
+    void runGlobalUpdate();
+
+    /**
+     * Fill the package list with a reasonably large number of packages
+     * without measuring it.
+     **/
+    void fillPkgList();
+
+    /**
+     * Search with the search filter view: Show its page and search for
+     * 'searchText'. Return the number of packages in the package list.
+     **/
+    int search( const QString & searchText );
+
+    /**
+     * Return the number of packages in the package list.
+     **/
+    int pkgListCount() const;
+
+
+    struct Operation
+    {
+        QString name;
+        qint64  wallUsec;
+        qint64  cpuUsec;
+        int     items;
+    };
+
+    //
+    // Data members
+    //
+
+    QString             _scenario;
+    YQPkgSelector *     _pkgSel;
+    QList<Operation>    _operations;
+
+    static QString      _scenarioToRun;
+};
+
+
+#endif // Benchmark_h
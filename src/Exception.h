@@ -368,7 +368,7 @@ void _throw_helper( const EX_t	  &exception,
 {
     exception.setSrcLocation( srcFile, srcLine, srcFunction );
 
-    Logger::log( logger, srcFile, srcLine, srcFunction, LogSeverityWarning )
+    LogVoidify() & Logger::log( logger, srcFile, srcLine, srcFunction, LogSeverityWarning )
 	<< "THROW "
 	<< exception.className() << ": "
 	<< exception.what()
@@ -385,7 +385,7 @@ void _caught_helper( const EX_t	   &exception,
 		     int	    srcLine,
 		     const QString &srcFunction )
 {
-    Logger::log( logger, srcFile, srcLine, srcFunction, LogSeverityWarning )
+    LogVoidify() & Logger::log( logger, srcFile, srcLine, srcFunction, LogSeverityWarning )
 	<< "CAUGHT "
 	<< exception.className() << ": "
 	<< exception.what()
@@ -402,7 +402,7 @@ void _rethrow_helper( const EX_t    &exception,
 {
     exception.setSrcLocation( srcFile, srcLine, srcFunction );
 
-    Logger::log( logger, srcFile, srcLine, srcFunction, LogSeverityWarning )
+    LogVoidify() & Logger::log( logger, srcFile, srcLine, srcFunction, LogSeverityWarning )
 	<< "RETHROW "
 	<< exception.className() << ": "
 	<< exception.what()
@@ -16,6 +16,7 @@
 
 
 #include <iostream>
+#include <limits>
 #include <sstream>
 
 #include "FSize.h"
@@ -34,10 +35,187 @@ const cpp_int FSize::EB = FSize::PB * 1024;
 const cpp_int FSize::ZB = FSize::EB * 1024;
 const cpp_int FSize::YB = FSize::ZB * 1024;
 
+// The range of the fast path
+static const cpp_int fastMaxBig = ( cpp_int( 1 ) << ( sizeof( FSize::FastInt ) * 8 - 1 ) ) - 1;
+
+
+FSize::FSize( double size_r )
+  : _size( 0 )
+{
+  // Same as casting to FastInt, but without undefined behaviour on overflow
+
+  if ( size_r > -(double) fastMaxBig && size_r < (double) fastMaxBig )
+    _size = (FastInt) size_r;
+  else
+    setBig( cpp_int( size_r ) );
+}
+
 
 FSize::FSize( const std::string &sizeStr, const Unit unit_r )
-  : _size( cpp_int(sizeStr) * factor( unit_r ) )
+  : _size( 0 )
+{
+  setBig( cpp_int(sizeStr) * factor( unit_r ) );
+}
+
+
+void FSize::setBig( const cpp_int &size_r )
+{
+  if ( size_r >= -fastMaxBig && size_r <= fastMaxBig )
+  {
+    // Assemble the FastInt from 64 bit pieces of the absolute value
+
+    cpp_int  usize = abs( size_r );
+    FastInt  size  = 0;
+    unsigned shift = 0;
+
+    while ( usize > 0 )
+    {
+      size  |= (FastInt) static_cast<unsigned long long>( usize & 0xFFFFFFFFFFFFFFFFULL ) << shift;
+      usize >>= 64;
+      shift  += 64;
+    }
+
+    _size = size_r < 0 ? -size : size;
+    _big.reset();
+  }
+  else
+  {
+    _size = 0;
+    _big.reset( new cpp_int( size_r ) );
+  }
+}
+
+
+cpp_int FSize::toBig( FastInt size_r )
+{
+  if ( size_r >= std::numeric_limits<long long>::min() &&
+       size_r <= std::numeric_limits<long long>::max() )
+  {
+    return cpp_int( (long long) size_r );
+  }
+
+  // Disassemble the absolute value into 64 bit pieces
+
+  UFastInt usize = size_r < 0 ? -(UFastInt) size_r : (UFastInt) size_r;
+  cpp_int  size  = 0;
+  unsigned shift = 0;
+
+  while ( usize > 0 )
+  {
+    size  += cpp_int( (unsigned long long) ( usize & 0xFFFFFFFFFFFFFFFFULL ) ) << shift;
+    usize >>= 32; // Two steps: Shifting by the whole width would be undefined
+    usize >>= 32;
+    shift  += 64;
+  }
+
+  return size_r < 0 ? cpp_int( -size ) : size;
+}
+
+
+FSize::operator long long() const
+{
+  if ( _big )
+    return static_cast<long long>( *_big );
+
+  if ( _size > std::numeric_limits<long long>::max() ) return std::numeric_limits<long long>::max();
+  if ( _size < std::numeric_limits<long long>::min() ) return std::numeric_limits<long long>::min();
+
+  return (long long) _size;
+}
+
+
+FSize::operator int() const
+{
+  if ( _big )
+    return static_cast<int>( *_big );
+
+  if ( _size > std::numeric_limits<int>::max() ) return std::numeric_limits<int>::max();
+  if ( _size < std::numeric_limits<int>::min() ) return std::numeric_limits<int>::min();
+
+  return (int) _size;
+}
+
+
+FSize::operator double() const
+{
+  return _big ? static_cast<double>( *_big ) : (double) _size;
+}
+
+
+cpp_int FSize::in_unit( const Unit unit_r ) const
 {
+  FastInt factor_r = fastFactor( unit_r );
+
+  if ( _big || ! factor_r )
+    return cpp_int( *this ) / factor( unit_r );
+
+  return toBig( _size / factor_r );
+}
+
+
+FSize FSize::operator-() const
+{
+  FSize ret( *this );
+
+  if ( ret._big )
+    ret.setBig( -*ret._big );
+  else
+    ret._size = -ret._size; // Can't overflow: fastMin() is never used
+
+  return ret;
+}
+
+
+FSize & FSize::operator+=( const FSize &rhs )
+{
+  FastInt result;
+
+  if ( _big || rhs._big || __builtin_add_overflow( _size, rhs._size, &result ) || result == fastMin() )
+    setBig( cpp_int( *this ) + cpp_int( rhs ) );
+  else
+    _size = result;
+
+  return *this;
+}
+
+
+FSize & FSize::operator-=( const FSize &rhs )
+{
+  FastInt result;
+
+  if ( _big || rhs._big || __builtin_sub_overflow( _size, rhs._size, &result ) || result == fastMin() )
+    setBig( cpp_int( *this ) - cpp_int( rhs ) );
+  else
+    _size = result;
+
+  return *this;
+}
+
+
+FSize & FSize::operator*=( const FSize &rhs )
+{
+  FastInt result;
+
+  if ( _big || rhs._big || __builtin_mul_overflow( _size, rhs._size, &result ) || result == fastMin() )
+    setBig( cpp_int( *this ) * cpp_int( rhs ) );
+  else
+    _size = result;
+
+  return *this;
+}
+
+
+FSize & FSize::operator/=( const FSize &rhs )
+{
+  // Like cpp_int, throw std::overflow_error for a division by zero; the
+  // fast path can't overflow otherwise since fastMin() is never used.
+
+  if ( _big || rhs._big || rhs._size == 0 )
+    setBig( cpp_int( *this ) / cpp_int( rhs ) );
+  else
+    _size /= rhs._size;
+
+  return *this;
 }
 
 //
@@ -49,13 +227,21 @@ FSize::FSize( const std::string &sizeStr, const Unit unit_r )
 //
 FSize & FSize::fillBlock( FSize blocksize_r )
 {
-  if ( _size > 0 && cpp_int(blocksize_r) > 0) {
-    cpp_int diff = _size % cpp_int(blocksize_r);
-    if ( diff ) {
-      if ( _size > 0 )
-	_size += cpp_int(blocksize_r);
-      _size -= diff;
+  if ( *this > 0 && blocksize_r > 0 ) {
+    if ( ! _big && ! blocksize_r._big ) {
+      FastInt diff = _size % blocksize_r._size;
+      FastInt result;
+      if ( ! diff )
+        return *this;
+      if ( ! __builtin_add_overflow( _size, blocksize_r._size - diff, &result ) && result != fastMin() ) {
+        _size = result;
+        return *this;
+      }
     }
+    cpp_int size = *this;
+    cpp_int diff = size % cpp_int(blocksize_r);
+    if ( diff )
+      setBig( size + cpp_int(blocksize_r) - diff );
   }
   return *this;
 }
@@ -69,7 +255,20 @@ FSize & FSize::fillBlock( FSize blocksize_r )
 //
 FSize::Unit FSize::bestUnit() const
 {
-  cpp_int usize = abs(_size);
+  if ( ! _big ) {
+    FastInt usize = _size < 0 ? -_size : _size;
+    int     unit  = 0;
+
+    while ( unit < (int) Unit::Y && fastFactor( (Unit) ( unit + 1 ) ) && usize >= fastFactor( (Unit) ( unit + 1 ) ) )
+      ++unit;
+
+    if ( unit == (int) Unit::Y || fastFactor( (Unit) ( unit + 1 ) ) )
+      return (Unit) unit;
+
+    // Otherwise the next factor doesn't fit into FastInt: Take the slow path
+  }
+
+  cpp_int usize = abs( cpp_int( *this ) );
   if ( usize < KB )
     return Unit::B;
   if ( usize < MB )
@@ -118,13 +317,29 @@ std::string FSize::form( const Unit unit_r, unsigned fw, unsigned prec, bool sho
   // set the precision and field width, use fixed notation (not the scientific Xe+Y)
   str << std::setprecision(prec) << std::setfill(' ') << std::setw(fw) << std::fixed;
 
+  FastInt factor_r = fastFactor( unit_r );
+  FastInt rounded;
+
   if (prec == 0)
+  {
     // no decimal part required, we can use integer division,
     // add one unit half for correct rounding
-    str << (_size + (factor( unit_r ) / 2))/ factor( unit_r );
+    if ( ! _big && factor_r && ! __builtin_add_overflow( _size, factor_r / 2, &rounded ) &&
+         rounded / factor_r <= std::numeric_limits<long long>::max() &&
+         rounded / factor_r >= std::numeric_limits<long long>::min() )
+      str << (long long) ( rounded / factor_r );
+    else
+      str << (cpp_int( *this ) + (factor( unit_r ) / 2))/ factor( unit_r );
+  }
+  else if ( ! _big && factor_r && (long double) _size < 1e18L && (long double) _size > -1e18L )
+  {
+    // long double has a 64 bit mantissa: Exact enough for any number of
+    // bytes that still fits into a long long
+    str << (long double) _size / (long double) factor_r;
+  }
   else
     // otherwise convert to boost floats
-    str << (boost::multiprecision::cpp_bin_float_50)( _size ) /
+    str << (boost::multiprecision::cpp_bin_float_50)( cpp_int( *this ) ) /
         (boost::multiprecision::cpp_bin_float_50)(factor( unit_r ) );
 
   if ( showunit )
@@ -19,7 +19,9 @@
 #define _FSize_h_
 
 #include <iosfwd>
+#include <memory>
 #include <string>
+#include <type_traits>
 
 // arbitrary precision integer
 #include <boost/multiprecision/cpp_int.hpp>
@@ -31,6 +33,12 @@
 //
 /**
  * Store and operate on (file/package/partition) sizes.
+ *
+ * Realistic sizes easily fit into a 128 bit integer (even 1 YiB is only
+ * 2^80 bytes), so that is what is used for all the arithmetic. Only if an
+ * operation overflows, the value is moved to an arbitrary precision
+ * boost::multiprecision::cpp_int, and it moves back as soon as it fits
+ * again.
  **/
 class FSize :
     // generate > / * + - <= => !== operators
@@ -46,13 +54,29 @@ class FSize :
      **/
     enum class Unit { B, K, M, G, T, P, E, Z, Y };
 
+    /**
+     * The integer type for the fast path
+     **/
+#ifdef __SIZEOF_INT128__
+    typedef __int128          FastInt;
+    typedef unsigned __int128 UFastInt;
+#else
+    typedef long long          FastInt;
+    typedef unsigned long long UFastInt;
+#endif
+
   private:
 
     /**
-     * The size (in bytes)
+     * The size (in bytes) if it fits into FastInt, i.e. if _big is null.
+     **/
+    FastInt _size;
+
+    /**
+     * The size (in bytes) if it doesn't fit into FastInt.
      * @see https://www.boost.org/doc/libs/release/libs/multiprecision/doc/html/index.html
      **/
-    boost::multiprecision::cpp_int _size;
+    std::unique_ptr<boost::multiprecision::cpp_int> _big;
 
   public:
 
@@ -84,6 +108,15 @@ class FSize :
       return 1;
     }
 
+    /**
+     * Return ammount of bytes in Unit as FastInt.
+     * Returns 0 if it doesn't fit (only for Z and Y without 128 bit integers).
+     **/
+    static FastInt fastFactor( const Unit unit_r ) {
+      int shift = 10 * (int) unit_r;
+      return shift < (int) sizeof( FastInt ) * 8 - 1 ? (FastInt) 1 << shift : 0;
+    }
+
     /**
      * String representation of Unit.
      **/
@@ -108,17 +141,37 @@ class FSize :
      * Construct from size in certain unit.
      * E.g. <code>FSize( 1, FSize::Unit::K )<code> makes 1024 Byte.
      **/
-    FSize( const boost::multiprecision::cpp_int &size_r = 0, const Unit unit_r = Unit::B)
-      : _size( boost::multiprecision::cpp_int(size_r) * factor( unit_r ) )
+    FSize( const boost::multiprecision::cpp_int &size_r, const Unit unit_r = Unit::B)
+      : _size( 0 )
+    { setBig( size_r * factor( unit_r ) ); }
+
+    /**
+     * Construct from an integer size in certain unit.
+     * This is the fast path for all the sizes from libzypp.
+     **/
+    template<typename T, typename = typename std::enable_if<std::is_integral<T>::value>::type>
+    FSize( T size_r, const Unit unit_r = Unit::B )
+      : _size( 0 )
+    {
+      FastInt factor_r = fastFactor( unit_r );
+      bool    overflow = ! factor_r || __builtin_mul_overflow( size_r, factor_r, &_size );
+
+      if ( overflow || _size == fastMin() )
+        setBig( boost::multiprecision::cpp_int( size_r ) * factor( unit_r ) );
+    }
+
+    /**
+     * Default constructor: 0 bytes.
+     **/
+    FSize()
+      : _size( 0 )
     {}
 
     /**
      * Construct from size in Byte.
      * @param size_r the initial value
      **/
-    FSize( double size_r )
-      : _size( size_r )
-    {}
+    FSize( double size_r );
 
     /**
       Construct from string containing a number in given unit.
@@ -129,33 +182,66 @@ class FSize :
     */
     FSize( const std::string &sizeStr, const Unit unit_r = Unit::B );
 
+    /**
+     * Copy constructor and assignment: Only the big values need a deep copy.
+     **/
+    FSize( const FSize &other )
+      : _size( other._size )
+      , _big( other._big ? new boost::multiprecision::cpp_int( *other._big ) : nullptr )
+    {}
+
+    FSize & operator=( const FSize &other ) {
+      if ( this != &other ) {
+        _size = other._size;
+        _big.reset( other._big ? new boost::multiprecision::cpp_int( *other._big ) : nullptr );
+      }
+      return *this;
+    }
+
+    FSize( FSize && other ) = default;
+    FSize & operator=( FSize && other ) = default;
+
+    /**
+     * Return 'true' if the value is stored in the fast FastInt, 'false' if
+     * it needs the arbitrary precision fallback.
+     **/
+    bool isFast() const { return ! _big; }
+
     /**
      * Conversions to native data types - only explicit as it might overflow
-     * If the value is out of range then the behavior depends on the boost version
-     *   - 1.67 - the min/max values for the corresponding type are returned
-     *   - 1.66 - returns just the lower bits
+     * If the value is out of range, the min/max values for the
+     * corresponding type are returned.
      **/
-    explicit operator long long() const { return static_cast<long long>(_size); }
-    explicit operator int() const { return static_cast<int>(_size); }
-    explicit operator double() const { return static_cast<double>(_size); }
+    explicit operator long long() const;
+    explicit operator int() const;
+    explicit operator double() const;
 
-    operator boost::multiprecision::cpp_int() const { return _size; }
-    boost::multiprecision::cpp_int in_unit(const Unit unit_r) const { return _size / factor( unit_r ); }
+    operator boost::multiprecision::cpp_int() const { return _big ? *_big : toBig( _size ); }
+    boost::multiprecision::cpp_int in_unit(const Unit unit_r) const;
 
     // unary minus
-    FSize operator-() const { return FSize(-_size); }
-    FSize & operator+=( const FSize &rhs ) { _size += boost::multiprecision::cpp_int(rhs); return *this; }
-    FSize & operator-=( const FSize &rhs ) { _size -= boost::multiprecision::cpp_int(rhs); return *this; }
-    FSize & operator*=( const FSize &rhs ) { _size *= boost::multiprecision::cpp_int(rhs); return *this; }
-    FSize & operator/=( const FSize &rhs ) { _size /= boost::multiprecision::cpp_int(rhs); return *this; }
+    FSize operator-() const;
+    FSize & operator+=( const FSize &rhs );
+    FSize & operator-=( const FSize &rhs );
+    FSize & operator*=( const FSize &rhs );
+    FSize & operator/=( const FSize &rhs );
+
+    bool operator<( const FSize &rhs ) const {
+      if ( ! _big && ! rhs._big )
+        return _size < rhs._size;
+      return boost::multiprecision::cpp_int( *this ) < boost::multiprecision::cpp_int( rhs );
+    }
 
-    bool operator<( const FSize &rhs ) const { return _size < boost::multiprecision::cpp_int(rhs); }
-    bool operator==( const FSize &rhs ) const { return _size == boost::multiprecision::cpp_int(rhs); }
+    bool operator==( const FSize &rhs ) const {
+      if ( ! _big && ! rhs._big )
+        return _size == rhs._size;
+      return boost::multiprecision::cpp_int( *this ) == boost::multiprecision::cpp_int( rhs );
+    }
 
     // ++operator (the prefix variant)
-    FSize & operator++() { _size += 1; return *this; }
+    FSize & operator++() { return *this += FSize( 1 ); }
     // --operator (the prefix variant)
-    FSize & operator--() { _size -= 1; return *this; }
+    FSize & operator--() { return *this -= FSize( 1 ); }
 
     /**
      * Adjust size to multiple of <code>blocksize_r</code>
@@ -167,7 +253,7 @@ class FSize :
      **/
     FSize fullBlock( FSize blocksize_r = boost::multiprecision::cpp_int(KB) ) const
     {
-        FSize ret( _size );
+        FSize ret( *this );
         return ret.fillBlock(  blocksize_r );
     }
 
@@ -205,6 +291,27 @@ class FSize :
      * Default string representation (precision 1 and unit appended).
      **/
     std::string asString() const;
+
+  private:
+
+    /**
+     * The smallest FastInt value. It is not used for the fast path so
+     * negating and abs() can never overflow.
+     **/
+    static constexpr FastInt fastMin() {
+      return -(FastInt) ( ~(UFastInt) 0 >> 1 ) - 1;
+    }
+
+    /**
+     * Store an arbitrary precision value: In _size if it fits, in _big
+     * otherwise.
+     **/
+    void setBig( const boost::multiprecision::cpp_int &size_r );
+
+    /**
+     * Convert a FastInt to an arbitrary precision integer.
+     **/
+    static boost::multiprecision::cpp_int toBig( FastInt size_r );
 };
 
 // stream operators
@@ -0,0 +1,461 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <exception>    // std::set_terminate(), std::current_exception()
+
+#include <fcntl.h>      // open()
+#include <signal.h>     // sigaction()
+#include <stdio.h>      // snprintf()
+#include <string.h>     // strncpy()
+#include <time.h>       // clock_gettime()
+#include <unistd.h>     // write(), getpid()
+
+#include "Logger.h"
+#include "Exception.h"
+#include "FlightRecorder.h"
+
+
+#define FLIGHT_RECORDER_FILE    "flight-recorder.log"
+#define FLIGHT_RECORDER_OLD     "flight-recorder-%02d.old"
+#define ALT_STACK_SIZE          ( 64 * 1024 )
+
+
+FlightRecorder * FlightRecorder::_instance = 0;
+
+
+namespace
+{
+    /**
+     * Return a small number for the current thread: Much easier to read in
+     * the dump than the real thread IDs.
+     **/
+    int threadNo()
+    {
+        static std::atomic<int> lastThreadNo( 0 );
+        static thread_local int threadNo = ++lastThreadNo;
+
+        return threadNo;
+    }
+
+
+    /**
+     * Line buffer for the dump. Only async-signal-safe functions may be used
+     * in a signal handler, so no snprintf() or streams.
+     **/
+    struct DumpLine
+    {
+        DumpLine(): len( 0 ) {}
+
+        void add( char ch )
+        {
+            if ( len < (int) sizeof( buf ) - 1 )
+                buf[ len++ ] = ch;
+        }
+
+        void add( const char * str )
+        {
+            while ( str && *str )
+                add( *str++ );
+        }
+
+        void add( qint64 num, int minWidth = 0, char fill = ' ' )
+        {
+            char digits[ 24 ];
+            int  count    = 0;
+            bool negative = num < 0;
+            quint64 rest  = negative ? -(quint64) num : num;
+
+            do
+            {
+                digits[ count++ ] = '0' + rest % 10;
+                rest /= 10;
+            }
+            while ( rest > 0 );
+
+            if ( negative )
+                digits[ count++ ] = '-';
+
+            for ( int i = count; i < minWidth; ++i )
+                add( fill );
+
+            while ( count > 0 )
+                add( digits[ --count ] );
+        }
+
+        void padTo( int column )
+        {
+            while ( len < column )
+                add( ' ' );
+        }
+
+        void write( int fd )
+        {
+            add( '\n' );
+            ssize_t result = ::write( fd, buf, len );
+            (void) result;
+            len = 0;
+        }
+
+        char buf[ 256 ];
+        int  len;
+    };
+
+
+    /**
+     * Alternate signal stack of one thread. It is disabled and freed when
+     * the thread exits.
+     **/
+    struct AltStack
+    {
+        AltStack(): mem( 0 ) {}
+
+        ~AltStack()
+        {
+            if ( mem )
+            {
+                stack_t stack;
+                memset( &stack, 0, sizeof( stack ) );
+                stack.ss_flags = SS_DISABLE;
+                sigaltstack( &stack, 0 );
+
+                delete[] mem;
+            }
+        }
+
+        char * mem;
+    };
+
+
+    void addSeconds( DumpLine & line, qint64 usec, int minWidth = 0 )
+    {
+        line.add( usec / 1000000, minWidth );
+        line.add( '.' );
+        line.add( usec % 1000000, 6, '0' );
+    }
+}
+
+
+FlightRecorder * FlightRecorder::instance()
+{
+    if ( ! _instance )
+    {
+        _instance = new FlightRecorder();
+        CHECK_NEW( _instance );
+    }
+
+    return _instance;
+}
+
+
+FlightRecorder::FlightRecorder()
+    : _next( 0 )
+    , _startUsec( usecNow() )
+    , _rotated( false )
+{
+    for ( Event & event: _events )
+        event.seq.store( 0, std::memory_order_relaxed );
+
+    _dumpFileName[ 0 ] = '\0';
+
+    for ( int i = 0; i < FLIGHT_RECORDER_OLD_DUMPS; ++i )
+        _oldDumpFileNames[ i ][ 0 ] = '\0';
+}
+
+
+qint64 FlightRecorder::usecNow()
+{
+    struct timespec now;
+    clock_gettime( CLOCK_MONOTONIC, &now );
+
+    return now.tv_sec * 1000000LL + now.tv_nsec / 1000;
+}
+
+
+void FlightRecorder::record( const char * eventName,
+                             const char * text,
+                             qint64       value1,
+                             qint64       value2 )
+{
+    quint64 no    = _next.fetch_add( 1, std::memory_order_relaxed );
+    Event & event = _events[ no & ( FLIGHT_RECORDER_SIZE - 1 ) ];
+
+    // Mark the slot as being written, so a concurrent dump skips it
+
+    event.seq.store( 0, std::memory_order_relaxed );
+    std::atomic_thread_fence( std::memory_order_release );
+
+    event.usec   = usecNow() - _startUsec;
+    event.thread = threadNo();
+    event.event  = eventName;
+    event.value1 = value1;
+    event.value2 = value2;
+
+    if ( text )
+    {
+        strncpy( event.text, text, sizeof( event.text ) - 1 );
+        event.text[ sizeof( event.text ) - 1 ] = '\0';
+    }
+    else
+    {
+        event.text[ 0 ] = '\0';
+    }
+
+    event.seq.store( no + 1, std::memory_order_release );
+}
+
+
+void FlightRecorder::install( const QString & logDir )
+{
+    QByteArray dir = logDir.toUtf8();
+
+    snprintf( _dumpFileName, sizeof( _dumpFileName ), "%s/%s",
+              dir.constData(), FLIGHT_RECORDER_FILE );
+
+    // Only build the names of the old dump files here: The rotation has to
+    // wait until there is something to dump (see rotateDumpFiles()), and
+    // then there is no time for anything that is not async-signal-safe.
+
+    for ( int i = 0; i < FLIGHT_RECORDER_OLD_DUMPS; ++i )
+    {
+        char oldName[ 64 ];
+        snprintf( oldName, sizeof( oldName ), FLIGHT_RECORDER_OLD, i );
+        snprintf( _oldDumpFileNames[ i ], sizeof( _oldDumpFileNames[ i ] ), "%s/%s",
+                  dir.constData(), oldName );
+    }
+
+    installAltStack();
+
+    struct sigaction action;
+    memset( &action, 0, sizeof( action ) );
+    sigemptyset( &action.sa_mask );
+    action.sa_handler = signalHandler;
+
+    // Fatal signals: Dump, then continue with the default action (core dump)
+
+    action.sa_flags = SA_ONSTACK | SA_RESETHAND;
+
+    sigaction( SIGSEGV, &action, 0 );
+    sigaction( SIGBUS,  &action, 0 );
+    sigaction( SIGFPE,  &action, 0 );
+    sigaction( SIGILL,  &action, 0 );
+    sigaction( SIGABRT, &action, 0 );
+
+    // SIGUSR1: Just dump and continue
+
+    action.sa_flags = SA_RESTART;
+    sigaction( SIGUSR1, &action, 0 );
+
+    // Exceptions that are thrown through the Qt event loop never reach the
+    // catch in main(); they end up in std::terminate().
+
+    std::set_terminate( terminateHandler );
+
+    logInfo() << "Flight recorder dumps go to " << _dumpFileName
+              << "; send SIGUSR1 for a dump" << endl;
+}
+
+
+void FlightRecorder::installAltStack()
+{
+    // Use an alternate stack for the signal handler:
+    // A stack overflow would otherwise leave no room to run it.
+
+    static thread_local AltStack altStack;
+
+    if ( altStack.mem ) // Already done for this thread
+        return;
+
+    altStack.mem = new char[ ALT_STACK_SIZE ];
+    CHECK_NEW( altStack.mem );
+
+    stack_t stack;
+    stack.ss_sp    = altStack.mem;
+    stack.ss_size  = ALT_STACK_SIZE;
+    stack.ss_flags = 0;
+    sigaltstack( &stack, 0 );
+}
+
+
+void FlightRecorder::terminateHandler()
+{
+    const char * reason = "std::terminate()";
+
+    if ( std::current_exception() )
+    {
+        reason = "Uncaught exception";
+
+        try
+        {
+            std::rethrow_exception( std::current_exception() );
+        }
+        catch ( const Exception & exception )
+        {
+            logError() << "Uncaught exception: " << exception.what() << endl;
+        }
+        catch ( const std::exception & exception )
+        {
+            // This includes zypp::Exception
+
+            logError() << "Uncaught exception: " << exception.what() << endl;
+        }
+        catch ( ... )
+        {
+            logError() << "Uncaught exception of unknown type" << endl;
+        }
+    }
+    else
+    {
+        logError() << "std::terminate() called" << endl;
+    }
+
+    if ( _instance )
+        _instance->dump( reason );
+
+    // The dump is done; don't do it again for the SIGABRT of abort()
+
+    signal( SIGABRT, SIG_DFL );
+    abort();
+}
+
+
+void FlightRecorder::signalHandler( int sig )
+{
+    const char * reason = "Signal";
+
+    switch ( sig )
+    {
+        case SIGSEGV: reason = "SIGSEGV"; break;
+        case SIGBUS:  reason = "SIGBUS";  break;
+        case SIGFPE:  reason = "SIGFPE";  break;
+        case SIGILL:  reason = "SIGILL";  break;
+        case SIGABRT: reason = "SIGABRT"; break;
+        case SIGUSR1: reason = "SIGUSR1"; break;
+    }
+
+    if ( _instance )
+        _instance->dump( reason );
+
+    if ( sig != SIGUSR1 )
+    {
+        // The handler was reset to the default action (SA_RESETHAND):
+        // Let that one terminate the program with a core dump.
+
+        raise( sig );
+    }
+}
+
+
+bool FlightRecorder::dump( const char * reason )
+{
+    if ( ! _dumpFileName[ 0 ] )
+        return false;
+
+    if ( ! _rotated.exchange( true ) )
+        rotateDumpFiles();
+
+    int fd = open( _dumpFileName, O_WRONLY | O_CREAT | O_APPEND | O_CLOEXEC, 0600 );
+
+    if ( fd < 0 )
+        return false;
+
+    DumpLine line;
+    line.add( "=== Flight recorder dump: " );
+    line.add( reason );
+    line.add( " - pid " );
+    line.add( (qint64) getpid() );
+    line.add( " - uptime " );
+    addSeconds( line, usecNow() - _startUsec );
+    line.add( " sec ===" );
+    line.write( fd );
+
+    line.add( "    Time (sec)" );
+    line.padTo( 18 );
+    line.add( "Thread" );
+    line.padTo( 26 );
+    line.add( "Event" );
+    line.padTo( 59 );
+    line.add( "Value 1     Value 2  Text" );
+    line.write( fd );
+
+    dump( fd );
+
+    line.write( fd ); // Empty line
+    close( fd );
+
+    return true;
+}
+
+
+void FlightRecorder::rotateDumpFiles()
+{
+    // rename() is async-signal-safe. Errors don't matter here: Most of the
+    // files usually don't exist.
+
+    for ( int i = FLIGHT_RECORDER_OLD_DUMPS - 1; i > 0; --i )
+        rename( _oldDumpFileNames[ i - 1 ], _oldDumpFileNames[ i ] );
+
+    rename( _dumpFileName, _oldDumpFileNames[ 0 ] );
+}
+
+
+void FlightRecorder::dump( int fd )
+{
+    quint64 next  = _next.load( std::memory_order_acquire );
+    quint64 first = next > FLIGHT_RECORDER_SIZE ? next - FLIGHT_RECORDER_SIZE : 0;
+
+    for ( quint64 no = first; no < next; ++no )
+    {
+        const Event & event = _events[ no & ( FLIGHT_RECORDER_SIZE - 1 ) ];
+
+        // Skip events that were overwritten in the meantime or that are just
+        // being written; they might be inconsistent.
+
+        if ( event.seq.load( std::memory_order_acquire ) != no + 1 )
+            continue;
+
+        qint64       usec       = event.usec;
+        int          thread     = event.thread;
+        const char * eventName  = event.event;
+        qint64       value1     = event.value1;
+        qint64       value2     = event.value2;
+        char         text[ sizeof( event.text ) ];
+
+        memcpy( text, event.text, sizeof( text ) );
+        text[ sizeof( text ) - 1 ] = '\0';
+
+        std::atomic_thread_fence( std::memory_order_acquire );
+
+        if ( event.seq.load( std::memory_order_relaxed ) != no + 1 )
+            continue;
+
+        DumpLine line;
+        line.add( "  " );
+        addSeconds( line, usec, 6 );
+        line.padTo( 18 );
+        line.add( "T" );
+        line.add( (qint64) thread );
+        line.padTo( 26 );
+        line.add( eventName );
+        line.padTo( 56 );
+        line.add( value1, 10 );
+        line.add( value2, 12 );
+        line.add( "  " );
+        line.add( text );
+        line.write( fd );
+    }
+}
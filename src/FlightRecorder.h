@@ -0,0 +1,176 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef FlightRecorder_h
+#define FlightRecorder_h
+
+
+#include <atomic>
+#include <string>
+
+#include <QString>
+
+
+// Number of events that are kept; must be a power of 2
+#define FLIGHT_RECORDER_SIZE    4096
+
+// Number of old dump files that are kept
+#define FLIGHT_RECORDER_OLD_DUMPS  3
+
+
+/**
+ * In-memory ring buffer of the most recent events of the hot paths (filter
+ * runs, solver runs, commit callbacks) with a high-resolution time stamp.
+ * Recording an event is cheap enough to do it all the time, unlike verbose
+ * logging to the log file.
+ *
+ * The events are dumped to flight-recorder.log in the log directory:
+ *
+ *   - on fatal signals (SIGSEGV, SIGABRT etc.)
+ *   - on SIGUSR1 (for a program that hangs)
+ *   - on exceptions that are caught in main()
+ *   - on exceptions that are not caught at all (std::terminate())
+ *   - on demand with a hidden hotkey (Ctrl+Alt+Shift+D)
+ *
+ * The old dump file is rotated with the first dump of a program run, so a
+ * run without any dump keeps the last crash record.
+ *
+ * Events may be recorded from any thread without locking. The dump only uses
+ * async-signal-safe functions, so it can be used in a signal handler.
+ *
+ * This is a singleton class.
+ **/
+class FlightRecorder
+{
+public:
+
+    /**
+     * Return the singleton of this class. Create it if it doesn't exist yet.
+     **/
+    static FlightRecorder * instance();
+
+    /**
+     * Record an event. 'event' has to be a string literal; 'text' is copied
+     * (truncated if needed). The meaning of 'value1' and 'value2' depends on
+     * the event, typically a count and a duration in microseconds.
+     **/
+    void record( const char * event,
+                 const char * text   = 0,
+                 qint64       value1 = 0,
+                 qint64       value2 = 0 );
+
+    void record( const char *        event,
+                 const std::string & text,
+                 qint64              value1 = 0,
+                 qint64              value2 = 0 )
+        { record( event, text.c_str(), value1, value2 ); }
+
+    /**
+     * Set the directory for the dump file and install the signal handlers
+     * and the terminate handler. Call this once early in main() after the
+     * logger is created.
+     **/
+    void install( const QString & logDir );
+
+    /**
+     * Set up an alternate signal stack for the current thread, so the signal
+     * handler can still run after a stack overflow. Each thread needs its
+     * own; call this at the start of the run() method of each thread.
+     * install() does this for the main thread.
+     **/
+    static void installAltStack();
+
+    /**
+     * Append all recorded events to the dump file with 'reason' as the
+     * header. Return 'true' on success, 'false' on error.
+     *
+     * This is async-signal-safe.
+     **/
+    bool dump( const char * reason );
+
+    /**
+     * Write all recorded events to file descriptor 'fd', oldest first.
+     *
+     * This is async-signal-safe.
+     **/
+    void dump( int fd );
+
+    /**
+     * Return the full path of the dump file.
+     **/
+    const char * dumpFileName() const { return _dumpFileName; }
+
+    /**
+     * Return the monotonic time in microseconds. This is the time base of
+     * the events. Use this to measure the durations to record.
+     **/
+    static qint64 usecNow();
+
+
+protected:
+
+    /**
+     * Constructor. Use instance() instead.
+     **/
+    FlightRecorder();
+
+    /**
+     * Handler for the signals that trigger a dump.
+     **/
+    static void signalHandler( int sig );
+
+    /**
+     * Handler for std::terminate(), mostly for exceptions that are thrown
+     * through the Qt event loop and never reach main().
+     **/
+    static void terminateHandler();
+
+    /**
+     * Rotate the old dump files to make room for the dumps of this program
+     * run. This is async-signal-safe.
+     **/
+    void rotateDumpFiles();
+
+
+    struct Event
+    {
+        std::atomic<quint64> seq;       // sequence number + 1, 0 while writing
+        qint64               usec;
+        int                  thread;
+        const char *         event;
+        qint64               value1;
+        qint64               value2;
+        char                 text[ 64 ];
+    };
+
+    //
+    // Data members
+    //
+
+    Event                   _events[ FLIGHT_RECORDER_SIZE ];
+    std::atomic<quint64>    _next;
+    qint64                  _startUsec;
+    std::atomic<bool>       _rotated;
+    char                    _dumpFileName[ 512 ];
+    char                    _oldDumpFileNames[ FLIGHT_RECORDER_OLD_DUMPS ][ 512 ];
+
+    static FlightRecorder * _instance;
+};
+
+
+#endif // FlightRecorder_h
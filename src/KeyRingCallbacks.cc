@@ -15,9 +15,60 @@
  */
 
 
+#include <QCoreApplication>
+#include <QMutex>
+#include <QMutexLocker>
+#include <QThread>
+
 #include "KeyRingCallbacks.h"
 
 
+ZyppKeyTrust
+KeyRingReceiveCallback::askUserToAcceptKey( const zypp::PublicKey  & key,
+                                            const zypp::KeyContext & context )
+{
+#if 0
+    std::cerr << "** Untrusted key **"
+              << "\nFingerprint: "  << zypp::str::gapify( key.fingerprint(), 4 )
+              << "\nRepo: " << context.repoInfo().name()
+              << "\nURL:  " << context.repoInfo().url()
+              << std::endl;
+#endif
+
+    ZyppKeyTrust trust = ZyppKeyTrust::KEY_DONT_TRUST;
+
+    auto askUser = [&]()
+    {
+        RepoGpgKeyImportDialog dialog( key, context.repoInfo() );
+        int result = dialog.exec();
+
+        trust = result == QDialog::Accepted ?
+            ZyppKeyTrust::KEY_TRUST_AND_IMPORT :
+            ZyppKeyTrust::KEY_DONT_TRUST;
+    };
+
+    QCoreApplication * app = QCoreApplication::instance();
+
+    if ( ! app || QThread::currentThread() == app->thread() )
+    {
+        askUser();
+    }
+    else
+    {
+        // Called from a worker thread: Open the dialog in the GUI thread and
+        // wait for the answer. Several workers might need an answer at the
+        // same time; ask only one question at a time.
+
+        static QMutex mutex;
+        QMutexLocker locker( &mutex );
+
+        QMetaObject::invokeMethod( app, askUser, Qt::BlockingQueuedConnection );
+    }
+
+    return trust;
+}
+
+
 KeyRingCallbacks::KeyRingCallbacks()
 {
     _keyRingReceiveCallback.connect();
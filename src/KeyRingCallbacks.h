@@ -38,24 +38,14 @@ typedef zypp::KeyRingReport::KeyTrust  ZyppKeyTrust;
 struct KeyRingReceiveCallback:
     public zypp::callback::ReceiveReport<zypp::KeyRingReport>
 {
+    /**
+     * Ask the user if the GPG key 'key' should be trusted.
+     *
+     * This may also be called from a worker thread (see
+     * ParallelRepoRefresher); the dialog is always opened in the GUI thread.
+     **/
     virtual ZyppKeyTrust askUserToAcceptKey( const zypp::PublicKey  & key,
-                                             const zypp::KeyContext & context ) override
-        {
-#if 0
-            std::cerr << "** Untrusted key **"
-                      << "\nFingerprint: "  << zypp::str::gapify( key.fingerprint(), 4 )
-                      << "\nRepo: " << context.repoInfo().name()
-                      << "\nURL:  " << context.repoInfo().url()
-                      << std::endl;
-#endif
-            RepoGpgKeyImportDialog dialog( key, context.repoInfo() );
-            int result = dialog.exec();
-
-            return result == QDialog::Accepted ?
-                ZyppKeyTrust::KEY_TRUST_AND_IMPORT :
-                ZyppKeyTrust::KEY_DONT_TRUST;
-        }
-
+                                             const zypp::KeyContext & context ) override;
 
     virtual bool askUserToAcceptUnsignedFile( const std::string      & file,
                                               const zypp::KeyContext & context ) override
@@ -9,33 +9,865 @@
 
 
 #include <QFile>
+#include <QFileInfo>
 #include <QDir>
 #include <QDateTime>
 #include <QString>
 #include <QStringList>
 
-#include <string.h>     // strlen()
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#include <stdint.h>     // intptr_t
+#include <string.h>     // strlen(), strrchr()
+#include <stdio.h>      // snprintf(), rename()
 #include <stdlib.h>     // abort(), mkdtemp()
+#include <time.h>       // localtime_r(), strftime()
 #include <unistd.h>     // getpid()
 #include <errno.h>
 #include <pwd.h>        // getpwuid()
+#include <spawn.h>      // posix_spawn()
+#include <fcntl.h>      // O_WRONLY etc.
 #include <sys/types.h>  // pid_t, getpwuid()
+#include <sys/wait.h>   // waitpid()
 
 #include "Logger.h"
 
 
 #define VERBOSE_ROTATE  0
 
+// Number of records in the queue of each logger; must be a power of 2.
+// If the writer thread can't keep up, producers wait for free slots.
+#define LOG_QUEUE_SIZE          8192
+
+// Max. millisec the writer thread sleeps when there is nothing to write
+#define LOG_WRITER_IDLE_MS      50
+
+#define MB                      ( 1024LL * 1024LL )
+
+// Absolute path: This might run as root, so don't look it up in $PATH
+#define GZIP_COMMAND            "/usr/bin/gzip"
+
+
+extern char ** environ;
+
 using std::endl;
 using std::cerr;
 
 static LogSeverity toLogSeverity( QtMsgType msgType );
+static LogStream & threadLogStream();
+
+static std::atomic<qint64> maxLogFileSizeBytes( 50 * MB );
+static std::atomic<qint64> logDirBudgetBytes( 200 * MB );
 
 static void qt_logger( QtMsgType                  msgType,
                        const QMessageLogContext & context,
                        const QString &            msg );
 
 
+/**
+ * One complete log record in the queue.
+ **/
+struct LogRecord
+{
+    LogRecordHeader header;
+    std::string     text;
+};
+
+
+/**
+ * Bounded lock-free multi-producer queue of log records with a single
+ * consumer (the writer thread).
+ *
+ * Each slot has a sequence number that tells whether it is free for the
+ * producer that claimed that position or whether it contains a record for
+ * the consumer, so producers only compete for the enqueue position with one
+ * compare-and-swap, never for a lock.
+ **/
+class LogRingBuffer
+{
+public:
+
+    LogRingBuffer( size_t size )
+        : _slots( new Slot[ size ] )
+        , _mask( size - 1 )
+        , _enqueuePos( 0 )
+        , _dequeuePos( 0 )
+    {
+        for ( size_t i=0; i < size; ++i )
+            _slots[ i ].seq.store( i, std::memory_order_relaxed );
+    }
+
+    ~LogRingBuffer() { delete[] _slots; }
+
+    /**
+     * Add a record to the queue. Return 'false' if the queue is full.
+     * Safe to call from any number of threads.
+     **/
+    bool tryPush( LogRecord & record )
+    {
+        Slot * slot;
+        size_t pos = _enqueuePos.load( std::memory_order_relaxed );
+
+        while ( true )
+        {
+            slot = &_slots[ pos & _mask ];
+            size_t   seq  = slot->seq.load( std::memory_order_acquire );
+            intptr_t diff = (intptr_t) seq - (intptr_t) pos;
+
+            if ( diff == 0 )
+            {
+                if ( _enqueuePos.compare_exchange_weak( pos, pos + 1, std::memory_order_relaxed ) )
+                    break;
+            }
+            else if ( diff < 0 )
+            {
+                return false; // full
+            }
+            else
+            {
+                pos = _enqueuePos.load( std::memory_order_relaxed );
+            }
+        }
+
+        slot->record = std::move( record );
+        slot->seq.store( pos + 1, std::memory_order_release );
+
+        return true;
+    }
+
+    /**
+     * Take the oldest record from the queue. Return 'false' if the queue is
+     * empty. Only the consumer thread may call this.
+     **/
+    bool tryPop( LogRecord & record )
+    {
+        Slot *   slot = &_slots[ _dequeuePos & _mask ];
+        size_t   seq  = slot->seq.load( std::memory_order_acquire );
+        intptr_t diff = (intptr_t) seq - (intptr_t) ( _dequeuePos + 1 );
+
+        if ( diff < 0 )
+            return false; // empty
+
+        record = std::move( slot->record );
+        slot->seq.store( _dequeuePos + _mask + 1, std::memory_order_release );
+        ++_dequeuePos;
+
+        return true;
+    }
+
+    /**
+     * Return the number of records that were pushed so far.
+     **/
+    size_t pushedCount() const { return _enqueuePos.load( std::memory_order_acquire ); }
+
+private:
+
+    struct Slot
+    {
+        std::atomic<size_t> seq;
+        LogRecord           record;
+    };
+
+    Slot *                          _slots;
+    const size_t                    _mask;
+    alignas( 64 ) std::atomic<size_t> _enqueuePos;
+    alignas( 64 ) size_t            _dequeuePos;
+};
+
+
+/**
+ * Background thread that moves rotated logs into place, compresses them and
+ * deletes the oldest old logs if the log directory exceeds its budget.
+ *
+ * There is only one for all loggers, so all renaming in the log directory
+ * after the startup is done in this thread in a well-defined order. The
+ * startup rotation in the main thread locks dirMutex() so it never runs at
+ * the same time as a job of this thread.
+ *
+ * This has to be shut down explicitly (see shutdown()): The destruction order
+ * of static objects is undefined, and the thread uses Qt classes.
+ **/
+class LogCompressor
+{
+public:
+
+    /**
+     * Return the singleton of this class.
+     **/
+    static LogCompressor * instance()
+    {
+        static LogCompressor compressor;
+
+        return &compressor;
+    }
+
+    /**
+     * Compress 'path' in the background and then enforce the budget of
+     * 'logDir'.
+     **/
+    void compress( const QString & logDir, const QString & path )
+    {
+        Job job;
+        job.logDir       = logDir;
+        job.compressPath = path;
+
+        addJob( job );
+    }
+
+    /**
+     * Make 'rotatedPath' (the log that was just rotated by the writer
+     * thread) old log no. 0 of 'filename' in 'logDir' after shifting the
+     * other old logs, then compress it and enforce the budget of 'logDir'.
+     **/
+    void rotate( const QString & logDir,
+                 const QString & filename,
+                 const QString & rotatedPath,
+                 int             logRotateCount )
+    {
+        Job job;
+        job.logDir         = logDir;
+        job.filename       = filename;
+        job.rotatedPath    = rotatedPath;
+        job.logRotateCount = logRotateCount;
+
+        addJob( job );
+    }
+
+    /**
+     * Return the mutex to lock while renaming or deleting files in a log
+     * directory outside of this thread.
+     **/
+    std::mutex & dirMutex() { return _dirMutex; }
+
+    /**
+     * Finish the pending jobs without compressing any more files and stop
+     * the thread. Any later job is done right away in the calling thread.
+     **/
+    void shutdown()
+    {
+        {
+            std::lock_guard<std::mutex> lock( _mutex );
+
+            _stop     = true;
+            _shutDown = true;
+        }
+
+        if ( _thread.joinable() )
+        {
+            _wakeUp.notify_one();
+            _thread.join();
+        }
+    }
+
+protected:
+
+    struct Job
+    {
+        Job(): logRotateCount( 0 ) {}
+
+        QString logDir;
+        QString filename;
+        QString rotatedPath;
+        int     logRotateCount;
+        QString compressPath;
+    };
+
+    LogCompressor()
+        : _stop( false )
+        , _shutDown( false )
+        {}
+
+    ~LogCompressor()
+    {
+        shutdown();
+    }
+
+    void addJob( const Job & job )
+    {
+        std::unique_lock<std::mutex> lock( _mutex );
+
+        if ( _shutDown )
+        {
+            lock.unlock();
+            process( job, false );
+
+            return;
+        }
+
+        _jobs.push_back( job );
+
+        if ( ! _thread.joinable() )
+            _thread = std::thread( &LogCompressor::run, this );
+        else
+            _wakeUp.notify_one();
+    }
+
+    void run()
+    {
+        while ( true )
+        {
+            Job  job;
+            bool stop;
+
+            {
+                std::unique_lock<std::mutex> lock( _mutex );
+                _wakeUp.wait( lock, [this]() { return _stop || ! _jobs.empty(); } );
+
+                if ( _jobs.empty() )
+                    return;
+
+                job = _jobs.front();
+                _jobs.pop_front();
+                stop = _stop;
+            }
+
+            // When the program is exiting, only move the rotated logs into
+            // place, but don't keep it waiting for compression.
+
+            process( job, ! stop );
+        }
+    }
+
+    // No logging in this thread: This might still be running while the
+    // loggers are destroyed.
+
+    // _dirMutex is only locked for renaming and deleting files, never while
+    // compressing: The startup rotation of a new logger in the GUI thread
+    // must not wait for that.
+
+    void process( const Job & job, bool doCompress )
+    {
+        QString compressPath = job.compressPath;
+
+        if ( ! job.rotatedPath.isEmpty() )
+        {
+            std::lock_guard<std::mutex> lock( _dirMutex );
+
+            QDir dir( job.logDir );
+            QStringList keepers;
+            Logger::shiftOldLogs( dir, job.filename, job.logRotateCount, keepers );
+
+            QString newName = Logger::oldName( job.filename, 0 );
+            dir.remove( newName );
+            dir.remove( newName + ".gz" );
+
+            if ( job.logRotateCount > 0 && dir.rename( job.rotatedPath, newName ) )
+                compressPath = dir.absoluteFilePath( newName );
+            else
+                QFile::remove( job.rotatedPath );
+        }
+
+        if ( doCompress && ! compressPath.isEmpty() )
+            compress( compressPath );
+
+        std::lock_guard<std::mutex> lock( _dirMutex );
+        enforceBudget( job.logDir );
+    }
+
+    /**
+     * Compress 'path' to 'path'.gz: First to a temporary file without
+     * locking the directory, then replace 'path' with that while it is
+     * locked. If the log was moved away in the meantime (a new rotation),
+     * the compressed file is discarded. If anything fails, the log simply
+     * stays uncompressed.
+     **/
+    void compress( const QString & path )
+    {
+        QString tmpPath = path + ".compressing"; // Also matches oldNamePattern()
+
+        if ( ! gzip( path, tmpPath ) )
+        {
+            QFile::remove( tmpPath );
+            return;
+        }
+
+        std::lock_guard<std::mutex> lock( _dirMutex );
+
+        if ( QFile::exists( path ) && ::rename( tmpPath.toUtf8().constData(),
+                                                ( path + ".gz" ).toUtf8().constData() ) == 0 )
+        {
+            QFile::remove( path );
+        }
+        else
+        {
+            QFile::remove( tmpPath );
+        }
+    }
+
+    /**
+     * Compress 'path' to 'outPath' with the external gzip command.
+     * Return 'true' on success.
+     **/
+    bool gzip( const QString & path, const QString & outPath )
+    {
+        if ( ! QFile::exists( path ) )
+            return false;
+
+        QByteArray fileArg = path.toUtf8();
+        QByteArray outFile = outPath.toUtf8();
+        const char * argv[] = { "gzip", "-c", "-q", fileArg.constData(), 0 };
+
+        posix_spawn_file_actions_t fileActions;
+        posix_spawn_file_actions_init( &fileActions );
+        posix_spawn_file_actions_addopen( &fileActions, STDOUT_FILENO, outFile.constData(),
+                                          O_WRONLY | O_CREAT | O_TRUNC, 0600 );
+        pid_t pid;
+        int result = posix_spawn( &pid, GZIP_COMMAND, &fileActions, 0, (char * const *) argv, environ );
+        posix_spawn_file_actions_destroy( &fileActions );
+
+        if ( result != 0 )
+            return false;
+
+        int status = 0;
+
+        if ( waitpid( pid, &status, 0 ) < 0 )
+            return false;
+
+        return WIFEXITED( status ) && WEXITSTATUS( status ) == 0;
+    }
+
+    /**
+     * Delete the oldest old logs in 'logDir' until all files there together
+     * are within the budget.
+     **/
+    void enforceBudget( const QString & logDir )
+    {
+        qint64 budget = Logger::logDirBudget();
+
+        if ( budget <= 0 )
+            return;
+
+        QDir dir( logDir );
+        const QFileInfoList & files = dir.entryInfoList( QDir::Files, QDir::Time | QDir::Reversed );
+        qint64 totalSize = 0;
+
+        for ( const QFileInfo & file: files )
+            totalSize += file.size();
+
+        for ( const QFileInfo & file: files ) // Oldest first
+        {
+            if ( totalSize <= budget )
+                break;
+
+            QString name = file.fileName();
+
+            if ( name.endsWith( ".old" ) || name.endsWith( ".old.gz" ) )
+            {
+                if ( dir.remove( name ) )
+                    totalSize -= file.size();
+            }
+        }
+    }
+
+
+private:
+
+    std::thread             _thread;
+    std::mutex              _mutex;
+    std::condition_variable _wakeUp;
+    std::deque<Job>         _jobs;
+    bool                    _stop;
+    bool                    _shutDown;
+    std::mutex              _dirMutex;
+};
+
+
+
+
+/**
+ * Background thread that takes the records from the queue of a logger,
+ * formats them and writes them to the log file.
+ *
+ * If 'logRotateCount' is more than 0, this also rotates the log when it
+ * exceeds Logger::maxLogFileSize(); the LogCompressor does the rest.
+ **/
+class LogWriter
+{
+public:
+
+    LogWriter( const QString & path, int logRotateCount )
+        : _queue( LOG_QUEUE_SIZE )
+        , _path( path )
+        , _file( path.toUtf8(), std::ofstream::out | std::ofstream::app )
+        , _writtenCount( 0 )
+        , _idle( false )
+        , _stop( false )
+        , _logRotateCount( logRotateCount )
+        , _fileSize( QFileInfo( path ).size() )
+        , _rotateNo( 0 )
+        , _lastSec( -1 )
+    {
+        snprintf( _pid, sizeof( _pid ), "[%d] ", (int) getpid() );
+
+        if ( _file.good() )
+            _thread = std::thread( &LogWriter::run, this );
+    }
+
+    ~LogWriter()
+    {
+        if ( _thread.joinable() )
+        {
+            _stop = true;
+            wakeUp();
+            _thread.join();
+        }
+    }
+
+    bool good() const { return _thread.joinable(); }
+
+    void push( LogRecord & record )
+    {
+        if ( ! good() )
+            return;
+
+        bool urgent = ! record.header.raw && record.header.severity >= LogSeverityError;
+
+        while ( ! _queue.tryPush( record ) )
+        {
+            // The writer can't keep up: Wait for it instead of losing records
+            wakeUp();
+            std::this_thread::yield();
+        }
+
+        if ( urgent || _idle.load( std::memory_order_relaxed ) )
+            wakeUp();
+    }
+
+    /**
+     * Wait until everything that was pushed until now is written.
+     **/
+    void flush()
+    {
+        if ( ! good() || _thread.get_id() == std::this_thread::get_id() )
+            return;
+
+        size_t target = _queue.pushedCount();
+        auto   giveUp = std::chrono::steady_clock::now() + std::chrono::seconds( 2 );
+
+        while ( _writtenCount.load( std::memory_order_acquire ) < target &&
+                std::chrono::steady_clock::now() < giveUp )
+        {
+            wakeUp();
+            std::this_thread::sleep_for( std::chrono::milliseconds( 1 ) );
+        }
+    }
+
+protected:
+
+    void wakeUp()
+    {
+        std::lock_guard<std::mutex> lock( _mutex );
+        _wakeUp.notify_one();
+    }
+
+    void run()
+    {
+        LogRecord   record;
+        std::string out;
+
+        while ( true )
+        {
+            bool stop  = _stop.load();
+            int  count = 0;
+
+            while ( _queue.tryPop( record ) )
+            {
+                format( record, out );
+                ++count;
+
+                if ( out.size() > 64 * 1024 )
+                    write( out );
+            }
+
+            write( out );
+
+            if ( count > 0 )
+                _writtenCount.fetch_add( count, std::memory_order_release );
+
+            if ( stop )
+                break;
+
+            if ( count == 0 )
+            {
+                std::unique_lock<std::mutex> lock( _mutex );
+                _idle = true;
+
+                // Producers don't take the mutex, so a wakeup might get lost;
+                // the timeout limits the delay in that case.
+
+                _wakeUp.wait_for( lock, std::chrono::milliseconds( LOG_WRITER_IDLE_MS ) );
+                _idle = false;
+            }
+        }
+    }
+
+    void write( std::string & out )
+    {
+        if ( out.empty() )
+            return;
+
+        _file.write( out.data(), out.size() );
+        _file.flush();
+        _fileSize += out.size();
+        out.clear();
+
+        qint64 maxSize = Logger::maxLogFileSize();
+
+        if ( _logRotateCount > 0 && maxSize > 0 && _fileSize >= maxSize )
+            rotate();
+    }
+
+    /**
+     * Rotate the log while it is in use: Only rename it and start a new one
+     * here; shifting the old logs and compressing is left to the
+     * LogCompressor so writing can continue right away.
+     **/
+    void rotate()
+    {
+        QFileInfo fileInfo( _path );
+        QString   rotatedPath = QString( "%1.rotating-%2" ).arg( _path ).arg( ++_rotateNo );
+
+        _file.close();
+
+        if ( ::rename( _path.toUtf8().constData(), rotatedPath.toUtf8().constData() ) == 0 )
+        {
+            _file.open( _path.toUtf8(), std::ofstream::out | std::ofstream::trunc );
+            _fileSize = 0;
+
+            LogCompressor::instance()->rotate( fileInfo.absolutePath(), fileInfo.fileName(),
+                                               rotatedPath, _logRotateCount );
+        }
+        else
+        {
+            // Continue with the same file and try again at the next write
+
+            _file.open( _path.toUtf8(), std::ofstream::out | std::ofstream::app );
+        }
+    }
+
+    void format( const LogRecord & record, std::string & out )
+    {
+        const LogRecordHeader & header = record.header;
+
+        if ( ! header.raw )
+        {
+            formatTime( header.time, out );
+            out += _pid;
+
+            switch ( header.severity )
+            {
+                case LogSeverityVerbose:   out += "<Verbose> "; break;
+                case LogSeverityDebug:     out += "<Debug>   "; break;
+                case LogSeverityInfo:      out += "<Info>    "; break;
+                case LogSeverityWarning:   out += "<WARNING> "; break;
+                case LogSeverityError:     out += "<ERROR>   "; break;
+                    // Intentionally omitting 'default' branch so the compiler can
+                    // complain about unhandled enum values
+            }
+
+            if ( header.srcFile && *header.srcFile )
+            {
+                // CMake passes the whole path to the compiler which gcc uses
+                // as __FILE__: Use only the basename.
+
+                const char * basename = strrchr( header.srcFile, '/' );
+                out += basename ? basename + 1 : header.srcFile;
+
+                if ( header.srcLine > 0 )
+                {
+                    out += ':';
+                    out += std::to_string( header.srcLine );
+                }
+
+                out += ' ';
+
+                if ( header.srcFunction && *header.srcFunction )
+                {
+                    out += header.srcFunction;
+                    out += "():  ";
+                }
+            }
+            else
+            {
+                out += header.location;
+            }
+        }
+
+        out += record.text;
+    }
+
+    /**
+     * Append the time stamp in the same format as Logger::timeStamp() and
+     * a blank to 'out'. The part up to the seconds is only formatted again
+     * when the second changes.
+     **/
+    void formatTime( qint64 msec, std::string & out )
+    {
+        time_t sec = (time_t) ( msec / 1000 );
+
+        if ( sec != _lastSec )
+        {
+            struct tm tm;
+            localtime_r( &sec, &tm );
+            strftime( _secStamp, sizeof( _secStamp ), "%Y-%m-%d %H:%M:%S", &tm );
+            _lastSec = sec;
+        }
+
+        char msecStamp[ 8 ];
+        snprintf( msecStamp, sizeof( msecStamp ), ".%03d ", (int) ( msec % 1000 ) );
+
+        out += _secStamp;
+        out += msecStamp;
+    }
+
+
+private:
+
+    LogRingBuffer           _queue;
+    QString                 _path;
+    std::ofstream           _file;
+    std::thread             _thread;
+    std::mutex              _mutex;
+    std::condition_variable _wakeUp;
+    std::atomic<size_t>     _writtenCount;
+    std::atomic<bool>       _idle;
+    std::atomic<bool>       _stop;
+    int                     _logRotateCount;
+
+    // Only used in the writer thread
+
+    qint64                  _fileSize;
+    int                     _rotateNo;
+    time_t                  _lastSec;
+    char                    _secStamp[ 32 ];
+    char                    _pid[ 16 ];
+};
+
+
+
+
+LogStream::LogStream( bool active )
+    : std::ostream( 0 )
+    , _buffer( this )
+    , _logger( 0 )
+    , _busy( false )
+{
+    if ( active )
+        rdbuf( &_buffer );   // This also clears the 'bad' state
+}
+
+
+LogStream::~LogStream()
+{
+    emitRecord();
+}
+
+
+void LogStream::begin( Logger * logger, LogRecordHeader && header )
+{
+    emitRecord();
+
+    _logger = logger;
+    _header = std::move( header );
+    _busy   = true;
+}
+
+
+void LogStream::emitRecord()
+{
+    std::string & text = _buffer.text();
+
+    if ( text.empty() )
+        return;
+
+    if ( _logger )
+    {
+        _logger->pushRecord( std::move( _header ), std::move( text ) );
+    }
+    else
+    {
+        std::cerr.write( text.data(), text.size() );
+        std::cerr.flush();
+    }
+
+    text.clear();
+    _header = LogRecordHeader(); // Continue without a header
+}
+
+
+void LogStream::endStatement()
+{
+    emitRecord();
+
+    // Don't keep the logger until the next statement: It might be destroyed
+    // in the meantime.
+
+    _logger = 0;
+    _busy   = false;
+}
+
+
+LogLineBuffer::int_type LogLineBuffer::overflow( int_type ch )
+{
+    if ( ! traits_type::eq_int_type( ch, traits_type::eof() ) )
+        _text += traits_type::to_char_type( ch );
+
+    return traits_type::not_eof( ch );
+}
+
+
+std::streamsize LogLineBuffer::xsputn( const char * str, std::streamsize len )
+{
+    _text.append( str, len );
+
+    return len;
+}
+
+
+int LogLineBuffer::sync()
+{
+    _stream->emitRecord();
+
+    return 0;
+}
+
+
+/**
+ * Return a LogStream of this thread that is not busy with a log statement.
+ * Normally this is always the same one; only log statements that run while
+ * another one is still composing its output need more.
+ **/
+static LogStream & threadLogStream()
+{
+    static thread_local std::deque<LogStream> logStreams;
+
+    for ( LogStream & logStream: logStreams )
+    {
+        if ( ! logStream.isBusy() )
+            return logStream;
+    }
+
+    logStreams.emplace_back(); // Doesn't move the existing ones
+
+    return logStreams.back();
+}
+
+
+static LogStream & nullLogStream()
+{
+    static thread_local LogStream nullStream( false );
+
+    return nullStream;
+}
+
+
+
+
 Logger * Logger::_defaultLogger = 0;
 QString  Logger::_lastLogDir;
 
@@ -43,7 +875,6 @@ QString  Logger::_lastLogDir;
 Logger::Logger( const QString & filename )
 {
     init();
-    createNullStream();
     openLogFile( filename );
 }
 
@@ -54,7 +885,6 @@ Logger::Logger( const QString & rawLogDir,
                 int             logRotateCount )
 {
     init();
-    createNullStream();
 
     QString logDir   = expandVariables( rawLogDir   );
     QString filename = expandVariables( rawFilename );
@@ -63,7 +893,10 @@ Logger::Logger( const QString & rawLogDir,
     _lastLogDir = logDir;
 
     if ( doRotate )
+    {
         logRotate( logDir, filename, logRotateCount );
+        _logRotateCount = logRotateCount;
+    }
 
     openLogFile( logDir + "/" + filename );
 }
@@ -71,57 +904,56 @@ Logger::Logger( const QString & rawLogDir,
 
 Logger::~Logger()
 {
-    if ( _logStream.is_open() )
-    {
-        // logInfo() << "-- Log End --\n" << endl;
-        _logStream.close();
-    }
+    bool wasDefaultLogger = ( this == _defaultLogger );
 
-    if ( this == _defaultLogger )
+    if ( wasDefaultLogger )
     {
         _defaultLogger = 0;
         qInstallMessageHandler(0); // Restore default message handler
     }
-}
 
+    // The log streams don't keep a logger beyond the end of a log statement
+    // (see LogStream::endStatement()), so none of them refers to this one.
 
-void Logger::init()
-{
-    _logLevel = LogSeverityVerbose;
-}
+    if ( _logWriter )
+        delete _logWriter; // This writes the remaining records
 
+    if ( wasDefaultLogger )
+    {
+        // Don't leave the compressor thread to the destructor of its static
+        // instance: That might run after Qt is gone.
 
-void Logger::createNullStream()
-{
-    // Open the null device to suppress output below the log level: This is
-    // necessary because each call to operator<<() for LogStream returns the
-    // LogStream, so we really need to return _nullStream (connected with
-    // /dev/null) to actually suppress anything; otherwise, it's just the
-    // logger time stamp etc. that gets suppressed, not the real logging
-    // output.
+        LogCompressor::instance()->shutdown();
+    }
+}
 
-    _nullStream.open( "/dev/null" );
 
-    if ( _nullStream.fail() )
-        cerr << "ERROR: Can't open /dev/null to suppress log output" << endl;
+void Logger::init()
+{
+    _logLevel       = LogSeverityVerbose;
+    _logWriter      = 0;
+    _logRotateCount = 0;
 }
 
 
 void Logger::openLogFile( const QString & filename )
 {
-    if ( ! _logStream.is_open() || _logFilename != filename )
+    if ( ! _logWriter || _logFilename != filename )
     {
+        if ( _logWriter )
+            delete _logWriter;
+
         _logFilename = filename;
-        _logStream.open( filename.toUtf8(), std::ofstream::out | std::ofstream::app );
+        _logWriter   = new LogWriter( filename, _logRotateCount );
 
-        if ( _logStream.good() )
+        if ( _logWriter->good() )
         {
             if ( ! _defaultLogger )
                 setDefaultLogger();
 
             cerr << "Logging to " << qPrintable( filename ) << endl;
-            _logStream << "\n\n";
-            log( __FILE__, __LINE__, __FUNCTION__, LogSeverityInfo )
+            logRaw( "\n" );
+            LogVoidify() & log( __FILE__, __LINE__, __FUNCTION__, LogSeverityInfo )
                 << "-- Log Start --" << endl;
         }
         else
@@ -140,83 +972,120 @@ void Logger::setDefaultLogger()
 
 
 LogStream & Logger::log( Logger *        logger,
-                         const QString & srcFile,
+                         const char *    srcFile,
                          int             srcLine,
-                         const QString & srcFunction,
+                         const char *    srcFunction,
                          LogSeverity     severity )
 {
-    static LogStream stderrStream;
-
     if ( ! logger )
         logger = Logger::defaultLogger();
 
     if ( logger )
         return logger->log( srcFile, srcLine, srcFunction, severity );
-    else
-    {
-        if ( ! stderrStream.is_open() )
-            stderrStream.open( "/dev/stderr" );
 
-        return stderrStream;
-    }
+    // No logger: Log only the text to stderr
+
+    LogStream & logStream = threadLogStream();
+    logStream.begin( 0, LogRecordHeader() );
+
+    return logStream;
 }
 
 
-LogStream & Logger::log( const QString & srcFile,
+LogStream & Logger::log( Logger *        logger,
+                         const QString & srcFile,
                          int             srcLine,
                          const QString & srcFunction,
                          LogSeverity     severity )
+{
+    LogStream & logStream = log( logger, (const char *) 0, 0, (const char *) 0, severity );
+
+    if ( &logStream == &nullLogStream() || srcFile.isEmpty() )
+        return logStream;
+
+    // Not string literals: Format the source location right away
+
+    QString location = srcFile.section( '/', -1 );
+
+    if ( srcLine > 0 )
+        location += QString( ":%1" ).arg( srcLine );
+
+    location += " ";
+
+    if ( ! srcFunction.isEmpty() )
+        location += srcFunction + "():  ";
+
+    LogRecordHeader header;
+    header.time     = QDateTime::currentMSecsSinceEpoch();
+    header.severity = severity;
+    header.location = location.toStdString();
+    header.raw      = false;
+
+    logStream.begin( logger ? logger : defaultLogger(), std::move( header ) );
+
+    return logStream;
+}
+
+
+LogStream & Logger::log( const char *    srcFile,
+                         int             srcLine,
+                         const char *    srcFunction,
+                         LogSeverity     severity )
 {
     if ( severity < _logLevel )
-        return _nullStream;
+        return nullLogStream();
 
-    std::string sev;
+    // Only collect what is needed for the header;
+    // the LogWriter thread does the formatting.
 
-    switch ( severity )
-    {
-        case LogSeverityVerbose:   sev = "<Verbose>"; break;
-        case LogSeverityDebug:     sev = "<Debug>  "; break;
-        case LogSeverityInfo:      sev = "<Info>   "; break;
-        case LogSeverityWarning:   sev = "<WARNING>"; break;
-        case LogSeverityError:     sev = "<ERROR>  "; break;
-            // Intentionally omitting 'default' branch so the compiler can
-            // complain about unhandled enum values
-    }
+    LogRecordHeader header;
+    header.time        = QDateTime::currentMSecsSinceEpoch();
+    header.severity    = severity;
+    header.srcFile     = srcFile;
+    header.srcLine     = srcLine;
+    header.srcFunction = srcFunction;
+    header.raw         = false;
 
-    _logStream << Logger::timeStamp() << " "
-               << "[" << (int) getpid() << "] "
-               << sev << " ";
+    LogStream & logStream = threadLogStream();
+    logStream.begin( this, std::move( header ) );
 
-    if ( ! srcFile.isEmpty() )
-    {
-        if ( srcFile.contains( "/") )
-        {
-            // CMake just dumps the whole path wholesale to the compiler
-            // command line which gcc merrily uses as __FILE__;
-            // which results in an abysmal-looking log line.
-            // So let's cut off the path: Use only the last (No. -1)
-            // section delimited with '/'.
+    return logStream;
+}
 
-            QString basename = srcFile.section( '/', -1 );
-            _logStream << basename;
 
-            // I hate CMake. Seriously, WTF?!
-        }
-        else
-        {
-            _logStream << srcFile;
-        }
+void Logger::pushRecord( LogRecordHeader && header, std::string && text )
+{
+    if ( ! _logWriter )
+        return;
+
+    LogRecord record;
+    record.header = std::move( header );
+    record.text   = std::move( text );
 
-        if ( srcLine > 0 )
-            _logStream << ":" << srcLine;
+    _logWriter->push( record );
+}
 
-        _logStream << " ";
 
-        if ( ! srcFunction.isEmpty() )
-            _logStream << srcFunction << "():  ";
-    }
+void Logger::logRaw( const std::string & line )
+{
+    pushRecord( LogRecordHeader(), line + "\n" );
+}
+
 
-    return _logStream;
+void Logger::flush()
+{
+    if ( _logWriter )
+        _logWriter->flush();
+}
+
+
+void Logger::flush( Logger * logger )
+{
+    if ( ! logger )
+        logger = Logger::defaultLogger();
+
+    if ( logger )
+        logger->flush();
 }
 
 
@@ -254,7 +1123,7 @@ void Logger::setLogLevel( Logger *logger, LogSeverity newLevel )
 
 void Logger::newline()
 {
-    _logStream << endl;
+    logRaw( "" );
 }
 
 
@@ -318,9 +1187,13 @@ static void qt_logger( QtMsgType                  msgType,
 
         if ( ! line.trimmed().isEmpty() )
         {
-            Logger::log( 0, // use default logger
-                         context.file, context.line, context.function,
-                         toLogSeverity( msgType ) )
+            // Not sure if the context strings are string literals,
+            // so use the QString version
+
+            LogVoidify() & Logger::log( 0, // use default logger
+                                        QString( context.file ), context.line,
+                                        QString( context.function ),
+                                        toLogSeverity( msgType ) )
                 << "[Qt] " << line << endl;
         }
     }
@@ -382,12 +1255,14 @@ static void qt_logger( QtMsgType                  msgType,
             }
 
             logInfo() << "-- Exiting --\n" << endl;
+            Logger::flush( 0 );
             exit( 1 ); // Don't dump core, just exit
         }
         else
         {
             cerr << "FATAL: " << qPrintable( msg ) << endl;
             logInfo() << "-- Aborting with core dump --\n" << endl;
+            Logger::flush( 0 );
             abort(); // Exit with core dump (it might contain a useful backtrace)
         }
     }
@@ -490,65 +1365,152 @@ QString Logger::oldNamePattern( const QString & filename )
     if ( pattern.endsWith( ".log" ) )
         pattern.chop( sizeof( ".log" ) - 1 );
 
-    pattern += "-??.old";
+    pattern += "-??.old*"; // Also the compressed ones
 
     return pattern;
 }
 
 
-void Logger::logRotate( const QString & logDir,
-                        const QString & filename,
-                        int             logRotateCount )
+/**
+ * Rename old log 'currentName' in 'dir' to 'newName' if it exists,
+ * uncompressed or compressed. Remove any old 'newName' first.
+ *
+ * Return the new name (with the ".gz" suffix if it is compressed)
+ * or an empty string if there was nothing to rename.
+ **/
+static QString moveLog( const QDir &    dir,
+                        const QString & currentName,
+                        const QString & newName )
 {
-    QDir dir( logDir );
-    QStringList keepers;
-    keepers << filename;
+    QDir logDir( dir );
 
-    for ( int i = logRotateCount - 1; i >= 0; --i )
+    for ( const QString & oldName: { newName, newName + ".gz" } )
     {
-        QString currentName = i > 0 ? oldName( filename, i-1 ) : filename;
-        QString newName     = oldName( filename, i );
-
-        if ( dir.exists( newName ) )
+        if ( logDir.exists( oldName ) )
         {
-            bool success = dir.remove( newName );
+            bool success = logDir.remove( oldName );
 #if VERBOSE_ROTATE
-            logDebug() << "Removing " << newName << ( success ? "" : " FAILED" ) << endl;
+            logDebug() << "Removing " << oldName << ( success ? "" : " FAILED" ) << endl;
 #else
             Q_UNUSED( success );
 #endif
         }
+    }
 
-        if ( dir.exists( currentName ) )
+    for ( const QString & suffix: { QString( ".gz" ), QString() } )
+    {
+        if ( logDir.exists( currentName + suffix ) )
         {
-            bool success = dir.rename( currentName, newName );
+            bool success = logDir.rename( currentName + suffix, newName + suffix );
 #if VERBOSE_ROTATE
-            logDebug() << "Renaming " << currentName << " to " << newName
+            logDebug() << "Renaming " << currentName + suffix << " to " << newName + suffix
                        << ( success ? "" : " FAILED" )
                        << endl;
-#else
-            Q_UNUSED( success );
 #endif
 
-            keepers << newName;
+            return success ? newName + suffix : QString();
         }
     }
 
-    const QStringList & matches = dir.entryList( QStringList() << oldNamePattern( filename ),
-                                                 QDir::Files );
+    return QString();
+}
+
+
+void Logger::shiftOldLogs( const QDir &    dir,
+                           const QString & filename,
+                           int             logRotateCount,
+                           QStringList &   keepers )
+{
+    for ( int i = logRotateCount - 1; i >= 1; --i )
+    {
+        QString newName = moveLog( dir, oldName( filename, i-1 ), oldName( filename, i ) );
+
+        if ( ! newName.isEmpty() )
+            keepers << newName;
+    }
+}
+
+
+void Logger::logRotate( const QString & logDir,
+                        const QString & filename,
+                        int             logRotateCount )
+{
+    QDir dir( logDir );
+    QString newestOldLog;
 
-    for ( const QString & match: matches )
     {
-        if ( ! keepers.contains( match ) )
+        // Don't get in the way of a compressor job in the same directory
+
+        std::lock_guard<std::mutex> lock( LogCompressor::instance()->dirMutex() );
+
+        QStringList keepers;
+        keepers << filename;
+
+        shiftOldLogs( dir, filename, logRotateCount, keepers );
+
+        if ( logRotateCount > 0 )
+            newestOldLog = moveLog( dir, filename, oldName( filename, 0 ) );
+
+        if ( ! newestOldLog.isEmpty() )
+            keepers << newestOldLog;
+
+        // Leftovers from a smaller logRotateCount or from a runtime rotation
+        // that was interrupted
+
+        QStringList patterns;
+        patterns << oldNamePattern( filename ) << filename + ".rotating-*";
+
+        const QStringList & matches = dir.entryList( patterns, QDir::Files );
+
+        for ( const QString & match: matches )
         {
-            bool success = dir.remove( match );
+            if ( ! keepers.contains( match ) )
+            {
+                bool success = dir.remove( match );
 #if VERBOSE_ROTATE
-            logDebug() << "Removing leftover " << match << ( success ? "" : " FAILED" ) << endl;
+                logDebug() << "Removing leftover " << match << ( success ? "" : " FAILED" ) << endl;
 #else
-            Q_UNUSED( success );
+                Q_UNUSED( success );
 #endif
+            }
         }
     }
+
+    // Compress the newest old log and enforce the directory budget in the
+    // background
+
+    LogCompressor::instance()->compress( dir.absolutePath(),
+                                         newestOldLog.isEmpty() ?
+                                         QString() : dir.absoluteFilePath( newestOldLog ) );
+}
+
+
+qint64 Logger::maxLogFileSize()
+{
+    return maxLogFileSizeBytes.load();
+}
+
+
+void Logger::setMaxLogFileSize( qint64 size )
+{
+    maxLogFileSizeBytes.store( size );
+}
+
+
+qint64 Logger::logDirBudget()
+{
+    return logDirBudgetBytes.load();
+}
+
+
+void Logger::setLogDirBudget( qint64 size )
+{
+    qint64 oldSize = logDirBudgetBytes.exchange( size );
+
+    // The startup rotation might have enforced the old budget already
+
+    if ( size != oldSize && ! _lastLogDir.isEmpty() )
+        LogCompressor::instance()->compress( _lastLogDir, QString() );
 }
 
 
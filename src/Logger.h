@@ -19,7 +19,10 @@
 #include <QStringList>
 
 
-typedef std::ofstream LogStream;
+class Logger;
+class LogStream;
+class LogWriter;
+class QDir;
 
 
 // Define NO_USING_STD_ENDL before including this header (or on the compiler
@@ -59,15 +62,80 @@ enum LogSeverity
 // Usage example:
 //
 //   logDebug() << "Result: " << result << endl;
-
-#define logVerbose()    Logger::log( 0, __FILE__, __LINE__, __FUNCTION__, LogSeverityVerbose   )
-#define logDebug()      Logger::log( 0, __FILE__, __LINE__, __FUNCTION__, LogSeverityDebug     )
-#define logInfo()       Logger::log( 0, __FILE__, __LINE__, __FUNCTION__, LogSeverityInfo      )
-#define logWarning()    Logger::log( 0, __FILE__, __LINE__, __FUNCTION__, LogSeverityWarning   )
-#define logError()      Logger::log( 0, __FILE__, __LINE__, __FUNCTION__, LogSeverityError     )
+//
+// If the severity is below the log level of the default logger, nothing
+// after the macro is evaluated: Neither Logger::log() is called nor any of the
+// streamed arguments, so it is OK to leave verbose logging in hot loops.
+// Severities below LOG_MIN_SEVERITY are compiled out completely.
+//
+// The macros expand to a void expression, so they can safely be used in an
+// unbraced 'if' / 'else', but the LogStream can't be stored or passed on.
+
+#define logVerbose()    LOG_WITH_SEVERITY( LogSeverityVerbose   )
+#define logDebug()      LOG_WITH_SEVERITY( LogSeverityDebug     )
+#define logInfo()       LOG_WITH_SEVERITY( LogSeverityInfo      )
+#define logWarning()    LOG_WITH_SEVERITY( LogSeverityWarning   )
+#define logError()      LOG_WITH_SEVERITY( LogSeverityError     )
 #define logNewline()    Logger::newline( 0 )
 
 
+// Define LOG_MIN_SEVERITY on the compiler command line to compile out all log
+// statements below that severity, e.g. -DLOG_MIN_SEVERITY=LogSeverityInfo
+
+#ifndef LOG_MIN_SEVERITY
+#  define LOG_MIN_SEVERITY      LogSeverityVerbose
+#endif
+
+
+// The basename of the current source file as a string literal or a
+// compile-time constant: CMake passes the whole path to the compiler which
+// gcc uses as __FILE__.
+
+#ifdef __FILE_NAME__
+#  define LOG_SRC_FILE          __FILE_NAME__
+#else
+#  define LOG_SRC_FILE          ( [] { constexpr const char * basename = logBasename( __FILE__ ); return basename; }() )
+#endif
+
+
+// operator&() binds less tightly than operator<<(), so the whole output
+// chain belongs to the second branch of the '?:'.
+
+#define LOG_WITH_SEVERITY( SEVERITY )                                   \
+    ( (SEVERITY) < LOG_MIN_SEVERITY || ! Logger::isEnabled( SEVERITY ) ) ? \
+        (void) 0 :                                                      \
+        LogVoidify() & Logger::log( 0, LOG_SRC_FILE, __LINE__, __FUNCTION__, (SEVERITY) )
+
+
+/**
+ * Helper for the log macros to make both branches of the '?:' void.
+ * This is applied when all the output of a log statement is done, so it also
+ * ends that statement for its LogStream.
+ **/
+struct LogVoidify
+{
+    inline void operator&( std::ostream & str );
+};
+
+
+/**
+ * Return the part of 'path' after the last '/'.
+ * This can be evaluated at compile time.
+ **/
+constexpr const char * logBasename( const char * path )
+{
+    const char * basename = path;
+
+    for ( const char * pos = path; *pos; ++pos )
+    {
+        if ( *pos == '/' )
+            basename = pos + 1;
+    }
+
+    return basename;
+}
+
+
 /**
  * Log the signal sender of a QObject.
  *
@@ -95,6 +163,126 @@ enum LogSeverity
 
 
 
+/**
+ * Header of one log record: Everything that is needed to format the part of a
+ * log line before the text. This is filled in by Logger::log(), the actual
+ * formatting is done in the background by the LogWriter.
+ **/
+struct LogRecordHeader
+{
+    LogRecordHeader()
+        : time( 0 )
+        , severity( LogSeverityVerbose )
+        , srcFile( 0 )
+        , srcLine( 0 )
+        , srcFunction( 0 )
+        , raw( true )
+        {}
+
+    qint64       time;          // millisec since the epoch
+    LogSeverity  severity;
+    const char * srcFile;       // string literal, i.e. __FILE__
+    int          srcLine;
+    const char * srcFunction;   // string literal, i.e. __FUNCTION__
+    std::string  location;      // preformatted source location if not literals
+    bool         raw;           // no header at all, just the text
+};
+
+
+/**
+ * Stream buffer that collects the text of one log record and hands it over
+ * to its LogStream when the stream is flushed, i.e. with 'endl'.
+ **/
+class LogLineBuffer: public std::streambuf
+{
+public:
+
+    LogLineBuffer( LogStream * stream ): _stream( stream ) {}
+
+    std::string & text() { return _text; }
+
+protected:
+
+    virtual int_type        overflow( int_type ch ) override;
+    virtual std::streamsize xsputn( const char * str, std::streamsize len ) override;
+    virtual int             sync() override;
+
+private:
+
+    LogStream * _stream;
+    std::string _text;
+};
+
+
+/**
+ * Output stream returned by the log macros. Each thread has its own
+ * LogStream, so threads never have to wait for each other while they are
+ * composing a log line. When the line is complete ('endl'), it is pushed as
+ * one record into the queue of its logger; a background thread formats it and
+ * writes it to the log file.
+ *
+ * A LogStream is busy from the start of a log statement until the end of it.
+ * A log statement that runs while another one of the same thread is still
+ * busy, e.g. in a function that is called for one of its arguments or in the
+ * Qt message handler, gets another LogStream.
+ **/
+class LogStream: public std::ostream
+{
+public:
+
+    /**
+     * Constructor. A stream that is not 'active' is a null stream that
+     * discards everything.
+     **/
+    LogStream( bool active = true );
+
+    /**
+     * Destructor. This emits any incomplete record.
+     **/
+    virtual ~LogStream();
+
+    /**
+     * Start a new record for 'logger' with 'header'. This emits any
+     * incomplete previous record first. If 'logger' is 0, the text goes to
+     * stderr.
+     **/
+    void begin( Logger * logger, LogRecordHeader && header );
+
+    /**
+     * Hand the collected text over to the logger. Subsequent text without
+     * another begin() is logged without a header.
+     **/
+    void emitRecord();
+
+    /**
+     * End the log statement: Emit any record that was not terminated with
+     * 'endl' and forget the logger. The stream is no longer busy after that.
+     **/
+    void endStatement();
+
+    /**
+     * Return 'true' if a log statement is using this stream.
+     **/
+    bool isBusy() const { return _busy; }
+
+private:
+
+    LogLineBuffer   _buffer;
+    Logger *        _logger;
+    LogRecordHeader _header;
+    bool            _busy;
+};
+
+
+void LogVoidify::operator&( std::ostream & str )
+{
+    // All output operators return the stream that the log statement started
+    // with, and that is always a LogStream.
+
+    static_cast<LogStream &>( str ).endStatement();
+}
+
+
 /**
  * Logging class. Use one of the macros above for stream output:
  *
@@ -125,7 +313,8 @@ public:
      *
      * If 'doRotate' is 'true, rotate any old logs in that directory
      * before opening the log and keep a maximum of 'logRotateCount' old logs
-     * in that directory.
+     * in that directory. The log is also rotated while it is in use when it
+     * exceeds maxLogFileSize().
      *
      * The first logger created is also implicitly used as the default
      * logger. This can be changed later with setDefaultLogger().
@@ -144,24 +333,62 @@ public:
     /**
      * Internal logging function. In most cases, better use the logDebug(),
      * logWarning() etc. macros instead.
+     *
+     * 'srcFile' and 'srcFunction' have to be string literals (__FILE__,
+     * __FUNCTION__) since they are only used later in the background.
      */
-    LogStream & log( const QString & srcFile,
+    LogStream & log( const char *    srcFile,
                      int             srcLine,
-                     const QString & srcFunction,
+                     const char *    srcFunction,
                      LogSeverity     severity );
 
     /**
      * Static version of the internal logging function.
      * Use the logDebug(), logWarning() etc. macros instead.
      *
+     * A direct call has to end its statement like the macros do
+     * ("LogVoidify() & Logger::log(...) << ..."); otherwise the LogStream
+     * stays busy and is never used again.
+     *
      * If 'logger' is 0, the default logger is used.
      */
+    static LogStream & log( Logger        * logger,
+                            const char *    srcFile,
+                            int             srcLine,
+                            const char *    srcFunction,
+                            LogSeverity     severity );
+
+    /**
+     * Version of the static internal logging function for source locations
+     * that are not string literals. This is a bit more expensive.
+     */
     static LogStream & log( Logger        * logger,
                             const QString & srcFile,
                             int             srcLine,
                             const QString & srcFunction,
                             LogSeverity     severity );
 
+    /**
+     * Log a line that is already completely formatted, i.e. without adding
+     * a timestamp or anything else except a newline. This is safe to call
+     * from any thread.
+     */
+    void logRaw( const std::string & line );
+
+    /**
+     * Wait until everything that was logged until now is written to the log
+     * file. Use this before the program exits without destroying the logger,
+     * e.g. with exit() or abort().
+     */
+    void flush();
+    static void flush( Logger * logger );
+
+    /**
+     * Push a complete record into the queue of the background writer thread.
+     * This is safe to call from any thread. Not for general use.
+     */
+    void pushRecord( LogRecordHeader && header, std::string && text );
+
     /**
      * Log a plain newline without any prefix (timestamp, source file name,
      * line number).
@@ -205,25 +432,26 @@ public:
     static Logger * defaultLogger() { return _defaultLogger; }
 
     /**
-     * Return the LogStream associated with this logger. Not for general use.
+     * Return 'true' if log lines with 'severity' would be logged by the
+     * default logger. This is what the log macros use to skip everything
+     * else, so it needs to be as cheap as possible.
+     *
+     * Without any logger, everything goes to stderr.
      */
-    LogStream & logStream() { return _logStream; }
+    static bool isEnabled( LogSeverity severity )
+        { return ! _defaultLogger || severity >= _defaultLogger->_logLevel; }
 
     /**
      * Return the current log level, i.e. the severity that will actually be
      * logged. Any lower severity will be suppressed.
      *
-     * Notice that due to the way C++ evaluates expressions, the runtime cost
-     * will not change significantly, only the log file size:
+     * For the default logger, the log macros check this before evaluating
+     * anything else, so this:
      *
      *     logDebug() << "Result: " << myObj->result() << endl;
      *
-     * Even if the log level is higher than logDebug(), this will still call
-     * myObj->result() and its operator<<(). If you want to avoid that, use
-     * your own 'if' around the log output:
-     *
-     * if ( logLevel() >= LogSeverityDebug )
-     *     logDebug() ...
+     * does not call myObj->result() or its operator<<() if the log level is
+     * higher than logDebug().
      */
     LogSeverity logLevel() const { return _logLevel; }
 
@@ -262,23 +490,48 @@ public:
      * Rotate the logs in directory 'logDir' based on future log file
      * 'filename' (without path). Keep at most 'logRotateCount' old logs and
      * delete all other old logs.
+     *
+     * The most recent old log is compressed in the background, and then the
+     * oldest old logs in 'logDir' are deleted if the directory exceeds
+     * logDirBudget().
      **/
     static void logRotate( const QString & logDir,
                            const QString & filename,
                            int             logRotateCount );
 
-protected:
+    /**
+     * Return the size in bytes at which a log is rotated while it is in use.
+     * 0 means never. The default is 50 MB.
+     **/
+    static qint64 maxLogFileSize();
 
     /**
-     * Common initialization for all constructors.
+     * Set the size at which a log is rotated while it is in use.
+     * This is safe to call at any time.
      **/
-    void init();
+    static void setMaxLogFileSize( qint64 size );
+
+    /**
+     * Return the maximum total size in bytes of all files in the log
+     * directory. When rotating, the oldest old logs are deleted until the
+     * directory is within that budget; the current logs are never deleted.
+     * 0 means unlimited. The default is 200 MB.
+     **/
+    static qint64 logDirBudget();
 
     /**
-     * Create the null log stream to suppress messages below the current log
-     * level.
+     * Set the maximum total size of all files in the log directory.
+     * If that changes the budget, it is enforced in the background right
+     * away.
      **/
-    void createNullStream();
+    static void setLogDirBudget( qint64 size );
+
+protected:
+
+    /**
+     * Common initialization for all constructors.
+     **/
+    void init();
 
     /**
      * Actually open the log file.
@@ -312,16 +565,28 @@ protected:
      **/
     static QString oldNamePattern( const QString & filename );
 
+    /**
+     * Move old logs no. 0 .. 'logRotateCount' - 2 to the next higher number,
+     * both uncompressed and compressed ones. The oldest one falls off the
+     * end. Add the names of the old logs that are kept to 'keepers'.
+     **/
+    static void shiftOldLogs( const QDir &    dir,
+                              const QString & filename,
+                              int             logRotateCount,
+                              QStringList &   keepers );
+
 
 private:
 
+    friend class LogCompressor;
+
     static Logger * _defaultLogger;
     static QString  _lastLogDir;
 
-    LogStream       _logStream;
+    LogWriter *     _logWriter;
     QString         _logFilename;
-    LogStream       _nullStream;
     LogSeverity     _logLevel;
+    int             _logRotateCount;
 };
 
 
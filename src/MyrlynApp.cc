@@ -21,14 +21,17 @@
 #include <QLabel>
 #include <QMessageBox>
 #include <QCloseEvent>
+#include <QShortcut>
 
 #include "Exception.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
 #include "MainWindow.h"
 #include "MyrlynRepoManager.h"
 #include "MyrlynWorkflowSteps.h"
 #include "PkgCommitPage.h"
 #include "PkgTasks.h"
+#include "StartupProfile.h"
 #include "SummaryPage.h"
 #include "Workflow.h"
 #include "YQPkgSelector.h"
@@ -106,7 +109,7 @@ MyrlynApp::~MyrlynApp()
 }
 
 
-void MyrlynApp::run()
+int MyrlynApp::run()
 {
     logDebug() << endl;
 
@@ -122,9 +125,11 @@ void MyrlynApp::run()
     // They send signals to trigger slots like 'next()', 'back()', 'quit()',
     // 'restart()' (which goes back to the package selection).
 
-    qApp->exec();  // Qt main event loop
+    int exitCode = qApp->exec();  // Qt main event loop
 
     // Only 'quit()' or an exception terminate the event loop.
+
+    return exitCode;
 }
 
 
@@ -136,12 +141,23 @@ void MyrlynApp::createMainWin()
         return;
 
     logDebug() << "Creating the main window" << endl;
+    StartupPhase phase( "Create main window" );
 
     _mainWin = new MainWindow();
     CHECK_NEW( _mainWin );
 
     setWindowTitle( _mainWin );
     _mainWin->installEventFilter( this );
+
+    // Hidden hotkey for the flight recorder, also during the commit
+
+    QShortcut * shortcut = new QShortcut( QKeySequence( Qt::CTRL | Qt::ALT | Qt::SHIFT | Qt::Key_D ), _mainWin );
+    CHECK_NEW( shortcut );
+    shortcut->setContext( Qt::ApplicationShortcut );
+
+    connect( shortcut, SIGNAL( activated()          ),
+             this,     SLOT  ( dumpFlightRecorder() ) );
+
     _mainWin->show();
 }
 
@@ -198,6 +214,7 @@ void MyrlynApp::createPkgSel()
     if ( _pkgSel )
         return;
 
+    StartupPhase phase( "Create package selector" );
     QLabel busyPage( _( "Preparing the package selector..." ) );
 
     if ( _mainWin )
@@ -473,6 +490,17 @@ void MyrlynApp::quit( bool askForConfirmation )
 }
 
 
+void MyrlynApp::dumpFlightRecorder()
+{
+    FlightRecorder * recorder = FlightRecorder::instance();
+
+    if ( recorder->dump( "Hotkey" ) )
+        logInfo() << "Flight recorder dumped to " << recorder->dumpFileName() << endl;
+    else
+        logError() << "Could not dump the flight recorder" << endl;
+}
+
+
 QFont
 MyrlynApp::headingFont()
 {
@@ -44,12 +44,25 @@ enum MyrlynAppOption
     OptDownloadOnly    = 0x04,
     OptNoRepoRefresh   = 0x08,
 
+    // Download mode for the package commit; without any of them, the one
+    // selected on the commit page is used
+
+    OptDownloadInAdvance = 0x10,
+    OptDownloadInHeaps   = 0x20,
+    OptDownloadAsNeeded  = 0x40,
+
+    // Start with the cached repo data and refresh the repos in the background
+
+    OptBackgroundRepoRefresh = 0x80,
+
     // For debugging
 
     OptFakeRoot        = 0x100,
     OptFakeCommit      = 0x200,
     OptFakeSummary     = 0x400,
     OptSlowRepoRefresh = 0x800,
+    OptStartupProfile  = 0x1000,
+    OptBenchmark       = 0x2000,
 };
 
 // See https://doc.qt.io/qt-5/qflags.html
@@ -92,8 +105,9 @@ public:
 
     /**
      * Run the application. This also handles the Qt event loop.
+     * Return the exit code of the event loop.
      **/
-    void run();
+    int run();
 
     /**
      * Return 'true' if this program is running with root privileges
@@ -237,6 +251,12 @@ public slots:
      **/
     void quit( bool askForConfirmation = false );
 
+    /**
+     * Dump the flight recorder to its file in the log directory.
+     * This is connected to a hidden hotkey (Ctrl+Alt+Shift+D).
+     **/
+    void dumpFlightRecorder();
+
 
 protected:
 
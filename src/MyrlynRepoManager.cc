@@ -17,22 +17,36 @@
 
 #include <unistd.h>             // sleep()
 #include <iostream>             // cerr
-#include <QElapsedTimer>
+#include <QApplication>
+#include <QEventLoop>
 #include <QMessageBox>
+#include <QSettings>
+#include <QTimer>
 
 #include <zypp/ZYppFactory.h>
+#include <zypp/sat/Pool.h>
 
 #include "Exception.h"
 #include "KeyRingCallbacks.h"
 #include "Logger.h"
 #include "MainWindow.h"
 #include "MyrlynApp.h"
+#include "ParallelRepoRefresher.h"
+#include "ReverseDepIndex.h"
+#include "StartupProfile.h"
 #include "YQi18n.h"
 #include "utf8.h"
 #include "MyrlynRepoManager.h"
 
 
+QString MyrlynRepoManager::_rootDir( "/" );
+
+
 MyrlynRepoManager::MyrlynRepoManager()
+    : _backgroundRefresher( 0 )
+    , _keyRingCallbacks( 0 )
+    , _needBackgroundRefresh( false )
+    , _skipReload( false )
 {
     logDebug() << "Creating MyrlynRepoManager" << endl;
 }
@@ -42,21 +56,57 @@ MyrlynRepoManager::~MyrlynRepoManager()
 {
     logDebug() << "Destroying MyrlynRepoManager..." << endl;
 
+    // The background refresh workers need to finish before zypp is shut down
+    delete _backgroundRefresher;
+    delete _keyRingCallbacks;
+
     shutdownZypp();
 
     logDebug() << "Destroying MyrlynRepoManager done" << endl;
 }
 
 
+void MyrlynRepoManager::setRootDir( const QString & rootDir )
+{
+    _rootDir = rootDir;
+
+    if ( _rootDir != "/" )
+    {
+        logInfo() << "Using root directory " << _rootDir << endl;
+
+        // Like 'zypper --root': Use the zypp lock below that root directory
+        // so this doesn't need root permissions for /run/zypp.pid
+
+        qputenv( "ZYPP_LOCKFILE_ROOT", _rootDir.toUtf8() );
+    }
+}
+
+
+zypp::RepoManagerOptions
+MyrlynRepoManager::repoManagerOptions()
+{
+    return zypp::RepoManagerOptions( toUTF8( _rootDir ) );
+}
+
+
 void MyrlynRepoManager::initTarget()
 {
+    StartupPhase phase( "Init target" );
+
     logDebug() << "Creating the ZyppLogger" << endl;
     MyrlynApp::instance()->createZyppLogger();
 
     logDebug() << "Initializing zypp..." << endl;
 
-    zyppPtr()->initializeTarget( "/", false );  // don't rebuild rpmdb
-    zyppPtr()->target()->load(); // Load pkgs from the target (rpmdb)
+    {
+        StartupPhase phase( "Initialize target" );
+        zyppPtr()->initializeTarget( toUTF8( _rootDir ), false );  // don't rebuild rpmdb
+    }
+
+    {
+        StartupPhase phase( "Load rpmdb" );
+        zyppPtr()->target()->load(); // Load pkgs from the target (rpmdb)
+    }
 
     logDebug() << "Initializing zypp done" << endl;
 }
@@ -89,7 +139,7 @@ MyrlynRepoManager::repoManager()
     if ( ! _repo_manager_ptr )
     {
         logDebug() << "Creating RepoManager" << endl;
-        _repo_manager_ptr.reset( new zypp::RepoManager() );
+        _repo_manager_ptr.reset( new zypp::RepoManager( repoManagerOptions() ) );
     }
 
     return _repo_manager_ptr;
@@ -147,10 +197,25 @@ void MyrlynRepoManager::attachRepos()
 {
     // TO DO: check and load services (?)
 
+    StartupPhase phase( "Attach repos" );
+
     try
     {
         findEnabledRepos();
-        refreshRepos();
+
+        if ( backgroundRefresh() && canRefreshRepos() )
+        {
+            // Use the existing caches now and refresh the repos later in the
+            // background (see startBackgroundRefresh()).
+
+            refreshUncachedRepos();
+            _needBackgroundRefresh = true;
+        }
+        else
+        {
+            refreshRepos();
+        }
+
         loadRepos();
     }
     catch ( const zypp::Exception & ex )
@@ -197,9 +262,19 @@ void MyrlynRepoManager::findEnabledRepos()
 }
 
 
+bool MyrlynRepoManager::canRefreshRepos() const
+{
+    return ( MyrlynApp::runningAsRealRoot() || _rootDir != "/" ) &&
+        ! MyrlynApp::isOptionSet( OptNoRepoRefresh );
+}
+
+
 void MyrlynRepoManager::refreshRepos()
 {
-    if ( ! MyrlynApp::runningAsRealRoot() )
+    // With a root directory other than "/" (--root), the user owns the
+    // caches, so refreshing works without root permissions
+
+    if ( ! MyrlynApp::runningAsRealRoot() && _rootDir == "/" )
     {
         logWarning() << "Skipping repos refresh for non-root user" << endl;
         return;
@@ -208,48 +283,100 @@ void MyrlynRepoManager::refreshRepos()
     if ( MyrlynApp::isOptionSet( OptNoRepoRefresh ) )
         return;
 
-    KeyRingCallbacks keyRingCallbacks;
-    QElapsedTimer    timer;
+    // This includes building the caches: Both run in the worker threads.
+    StartupPhase phase( "Refresh repos" );
+
+    // Each repo is refreshed in a worker thread with a RepoManager of its
+    // own, created with the same options as repoManager(). The downloads are
+    // serialized between them; only building the caches overlaps. Those
+    // worker threads also call the key ring callbacks; they ask the user in
+    // the GUI thread.
 
-    for ( ZyppRepoInfo & repo: _repos )
+    KeyRingCallbacks      keyRingCallbacks;
+    ParallelRepoRefresher refresher( repoManagerOptions(), maxParallelRefresh() );
+
+    if ( MyrlynApp::isOptionSet( OptSlowRepoRefresh ) )
+        refresher.setDelay( 2000 ); // millisec
+
+    connect( &refresher, SIGNAL( refreshRepoStart( ZyppRepoInfo ) ),
+             this,       SIGNAL( refreshRepoStart( ZyppRepoInfo ) ) );
+
+    connect( &refresher, SIGNAL( refreshRepoDone ( ZyppRepoInfo ) ),
+             this,       SIGNAL( refreshRepoDone ( ZyppRepoInfo ) ) );
+
+    refresher.refresh( _repos );
+}
+
+
+void MyrlynRepoManager::refreshUncachedRepos()
+{
+    RepoInfoList uncachedRepos;
+
+    for ( const ZyppRepoInfo & repo: _repos )
     {
-        try
-        {
-            timer.start();
-            logInfo() << "Refreshing repo " << repo.name() << "..." << endl;
-            emit refreshRepoStart( repo );
+        if ( repo.enabled() && ! repoManager()->isCached( repo ) )
+            uncachedRepos.push_back( repo );
+    }
 
-            repoManager()->refreshMetadata( repo, zypp::RepoManager::RefreshIfNeeded );
-            repoManager()->buildCache     ( repo, zypp::RepoManager::BuildIfNeeded   );
+    if ( uncachedRepos.empty() )
+        return;
 
-            if ( MyrlynApp::isOptionSet( OptSlowRepoRefresh ) )
-                sleep( 2 );
+    logInfo() << uncachedRepos.size() << " repos without a cache; refreshing them now" << endl;
+    StartupPhase phase( "Refresh uncached repos" );
 
-            logInfo() << "Refreshing repo " << repo.name()
-                      << " done after " << timer.elapsed() / 1000.0 << " sec"
-                      << endl;
+    KeyRingCallbacks      keyRingCallbacks;
+    ParallelRepoRefresher refresher( repoManagerOptions(), maxParallelRefresh() );
 
-            emit refreshRepoDone( repo );
-        }
-        catch ( const zypp::repo::RepoException & exception )
-        {
-            Q_UNUSED( exception );
-            logWarning() << "CAUGHT zypp exception for repo " << repo.name() << endl;
+    connect( &refresher, SIGNAL( refreshRepoStart( ZyppRepoInfo ) ),
+             this,       SIGNAL( refreshRepoStart( ZyppRepoInfo ) ) );
+
+    connect( &refresher, SIGNAL( refreshRepoDone ( ZyppRepoInfo ) ),
+             this,       SIGNAL( refreshRepoDone ( ZyppRepoInfo ) ) );
 
-            logInfo() << "Disabling repo " << repo.name() << endl;
-            repo.setEnabled( false );
+    refresher.refresh( uncachedRepos );
+
+    // Take over which ones were disabled because they failed
+
+    for ( const ZyppRepoInfo & uncachedRepo: uncachedRepos )
+    {
+        if ( uncachedRepo.enabled() )
+            continue;
+
+        for ( ZyppRepoInfo & repo: _repos )
+        {
+            if ( repo.alias() == uncachedRepo.alias() )
+                repo.setEnabled( false );
         }
     }
 }
 
 
+int MyrlynRepoManager::maxParallelRefresh() const
+{
+    QSettings settings;
+    settings.beginGroup( "MyrlynRepoManager" );
+
+    int maxParallel = settings.value( "maxParallelRefresh", 4 ).toInt();
+
+    // Write it back so it's easy to find in the config file
+    settings.setValue( "maxParallelRefresh", maxParallel );
+    settings.endGroup();
+
+    return qBound( 1, maxParallel, 32 );
+}
+
+
 void MyrlynRepoManager::loadRepos()
 {
+    StartupPhase phase( "Load repos from cache" );
+
     for ( const ZyppRepoInfo & repo: _repos )
     {
         if ( repo.enabled() )
         {
             logDebug() << "Loading resolvables from " << repo.name() << endl;
+
+            StartupPhase repoPhase( fromUTF8( repo.alias() ) );
             repoManager()->loadFromCache( repo );
         }
         else
@@ -257,6 +384,301 @@ void MyrlynRepoManager::loadRepos()
             logInfo() << "Skipping disabled repo " << repo.name() << endl;
         }
     }
+
+    // The pool content changed, so any old index is now outdated anyway.
+    // This is built from the event loop, i.e. while the user can already
+    // work with the package selector.
+
+    ReverseDepIndex::instance()->startBuild();
+}
+
+
+bool MyrlynRepoManager::backgroundRefresh() const
+{
+    if ( MyrlynApp::isOptionSet( OptBackgroundRepoRefresh ) )
+        return true;
+
+    QSettings settings;
+    settings.beginGroup( "MyrlynRepoManager" );
+
+    bool backgroundRefresh = settings.value( "backgroundRefresh", false ).toBool();
+
+    // Write it back so it's easy to find in the config file
+    settings.setValue( "backgroundRefresh", backgroundRefresh );
+    settings.endGroup();
+
+    return backgroundRefresh;
+}
+
+
+bool MyrlynRepoManager::isBackgroundRefreshRunning() const
+{
+    return _backgroundRefresher && _backgroundRefresher->isRunning();
+}
+
+
+void MyrlynRepoManager::startBackgroundRefresh()
+{
+    if ( ! _needBackgroundRefresh )
+        return;
+
+    _needBackgroundRefresh = false;
+
+    // Work on copies of the repo infos: A repo that can't be refreshed now
+    // stays enabled with the data from its old cache.
+
+    _backgroundRepos = _repos;
+
+    // The key ring callbacks need to stay connected while the workers run;
+    // they ask the user in the GUI thread.
+
+    _keyRingCallbacks = new KeyRingCallbacks();
+    CHECK_NEW( _keyRingCallbacks );
+
+    _backgroundRefresher = new ParallelRepoRefresher( repoManagerOptions(),
+                                                      maxParallelRefresh() );
+    CHECK_NEW( _backgroundRefresher );
+
+    _backgroundRefresher->setDisableFailedRepos( false );
+
+    if ( MyrlynApp::isOptionSet( OptSlowRepoRefresh ) )
+        _backgroundRefresher->setDelay( 2000 ); // millisec
+
+    connect( _backgroundRefresher, SIGNAL( refreshRepoDone   ( ZyppRepoInfo ) ),
+             this,                 SLOT  ( backgroundRepoDone()               ) );
+
+    connect( _backgroundRefresher, SIGNAL( refreshRepoFailed ( ZyppRepoInfo, QString ) ),
+             this,                 SLOT  ( backgroundRepoDone()                        ) );
+
+    connect( _backgroundRefresher, SIGNAL( refreshFinished()       ),
+             this,                 SLOT  ( backgroundRefreshDone() ) );
+
+    int repoCount = 0;
+
+    for ( const ZyppRepoInfo & repo: _backgroundRepos )
+    {
+        if ( repo.enabled() )
+            ++repoCount;
+    }
+
+    logInfo() << "Starting background refresh of " << repoCount << " repos" << endl;
+    emit backgroundRefreshStarted( repoCount );
+
+    _backgroundRefresher->start( _backgroundRepos );
+}
+
+
+void MyrlynRepoManager::backgroundRepoDone()
+{
+    if ( _backgroundRefresher )
+    {
+        emit backgroundRefreshProgress( _backgroundRefresher->doneCount(),
+                                        _backgroundRefresher->totalCount() );
+    }
+}
+
+
+void MyrlynRepoManager::backgroundRefreshDone()
+{
+    CHECK_PTR( _backgroundRefresher );
+
+    _reposToReload  = _backgroundRefresher->changedRepos();
+    int failedCount = _backgroundRefresher->failedCount();
+
+    // This is called from a signal of the refresher, so don't delete it here
+
+    _backgroundRefresher->deleteLater();
+    _backgroundRefresher = 0;
+
+    delete _keyRingCallbacks;
+    _keyRingCallbacks = 0;
+
+    if ( _skipReload && ! _reposToReload.isEmpty() )
+    {
+        logInfo() << "Not reloading " << _reposToReload.size()
+                  << " repos with new metadata now" << endl;
+
+        _reposToReload.clear();
+    }
+
+    emit backgroundRefreshFinished( _reposToReload.size(), failedCount );
+    reloadChangedRepos();
+}
+
+
+void MyrlynRepoManager::waitForBackgroundRefresh( bool reload )
+{
+    _needBackgroundRefresh = false;
+
+    if ( ! reload )
+        _reposToReload.clear(); // Drop a postponed reload
+
+    if ( ! isBackgroundRefreshRunning() )
+        return;
+
+    logInfo() << "Waiting for the background refresh to finish" << endl;
+
+    // Unless requested, don't reload the repos that the refresh is about to
+    // report, but only for this one: The caller is about to use the pool as
+    // it is now.
+
+    _skipReload = ! reload;
+
+    QEventLoop eventLoop;
+
+    connect( _backgroundRefresher, SIGNAL( refreshFinished() ),
+             &eventLoop,           SLOT  ( quit()            ) );
+
+    eventLoop.exec( QEventLoop::ExcludeUserInputEvents );
+
+    _skipReload = false;
+}
+
+
+namespace
+{
+    /**
+     * A package selection by the user that needs to survive reloading repos:
+     * The pool items are replaced, so it is identified by kind and name, and
+     * its candidate by edition, arch and repo.
+     **/
+    struct UserSelection
+    {
+        zypp::ResKind kind;
+        std::string   name;
+        ZyppStatus    status;
+        zypp::Edition edition;
+        zypp::Arch    arch;
+        std::string   repoAlias;
+    };
+
+    typedef QList<UserSelection> UserSelections;
+
+
+    template<class T>
+    void saveUserSelections( UserSelections & selections )
+    {
+        for ( ZyppPoolIterator it = zyppBegin<T>(); it != zyppEnd<T>(); ++it )
+        {
+            ZyppSel    sel    = *it;
+            ZyppStatus status = sel->status();
+
+            // Only what the user chose; the resolver takes care of the rest
+
+            if ( status != S_Install && status != S_Update && status != S_Del &&
+                 status != S_Taboo   && status != S_Protected )
+            {
+                continue;
+            }
+
+            UserSelection selection;
+            selection.kind   = sel->kind();
+            selection.name   = sel->name();
+            selection.status = status;
+
+            ZyppObj candidate = sel->candidateObj();
+
+            if ( candidate )
+            {
+                selection.edition   = candidate->edition();
+                selection.arch      = candidate->arch();
+                selection.repoAlias = candidate->repoInfo().alias();
+            }
+
+            selections << selection;
+        }
+    }
+
+
+    void restoreUserSelections( const UserSelections & selections )
+    {
+        for ( const UserSelection & selection: selections )
+        {
+            ZyppSel sel = zypp::ui::Selectable::get( selection.kind, selection.name );
+
+            if ( ! sel )
+            {
+                logWarning() << "Can't restore the status of " << selection.name << endl;
+                continue;
+            }
+
+            // Keep the candidate the user might have chosen if it still exists
+
+            for ( zypp::ui::Selectable::available_iterator it = sel->availableBegin();
+                  it != sel->availableEnd();
+                  ++it )
+            {
+                if ( (*it)->edition() == selection.edition &&
+                     (*it)->arch()    == selection.arch    &&
+                     (*it)->repoInfo().alias() == selection.repoAlias )
+                {
+                    sel->setCandidate( *it );
+                    break;
+                }
+            }
+
+            if ( ! sel->setStatus( selection.status, zypp::ResStatus::USER ) )
+            {
+                logWarning() << "Can't restore the status of " << selection.name << endl;
+            }
+        }
+    }
+
+}   // namespace
+
+
+void MyrlynRepoManager::reloadChangedRepos()
+{
+    if ( _reposToReload.isEmpty() )
+        return;
+
+    // Don't pull the pool away from under an open dialog that might use it
+
+    if ( QApplication::activeModalWidget() )
+    {
+        logDebug() << "Postponing reloading repos" << endl;
+        QTimer::singleShot( 1000, this, SLOT( reloadChangedRepos() ) );
+
+        return;
+    }
+
+    logInfo() << "Reloading repos with new metadata: "
+              << _reposToReload.join( ", " ) << endl;
+
+    emit aboutToReloadRepos();
+
+    UserSelections selections;
+    saveUserSelections<zypp::Package>( selections );
+    saveUserSelections<zypp::Pattern>( selections );
+    saveUserSelections<zypp::Patch  >( selections );
+
+    for ( const ZyppRepoInfo & repo: _repos )
+    {
+        if ( ! repo.enabled() || ! _reposToReload.contains( fromUTF8( repo.alias() ) ) )
+            continue;
+
+        try
+        {
+            zypp::sat::Pool::instance().reposErase( repo.alias() );
+            repoManager()->loadFromCache( repo );
+        }
+        catch ( const zypp::Exception & exception )
+        {
+            logError() << "Reloading repo " << repo.name() << " failed: "
+                       << exception.asString() << endl;
+        }
+    }
+
+    _reposToReload.clear();
+    restoreUserSelections( selections );
+
+    logInfo() << "Restored " << selections.size() << " user selections" << endl;
+
+    // The pool content changed, so the old index is outdated
+
+    ReverseDepIndex::instance()->startBuild();
+
+    emit reposReloaded();
 }
 
 
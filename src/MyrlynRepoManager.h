@@ -25,12 +25,17 @@
 #include <zypp/RepoManager.h>
 #include <zypp/RepoInfo.h>
 
+#include <QStringList>
+
 #include "YQZypp.h"
 
 
 using RepoManager_Ptr = std::shared_ptr<zypp::RepoManager>;
 typedef std::list<ZyppRepoInfo> RepoInfoList;
 
+class KeyRingCallbacks;
+class ParallelRepoRefresher;
+
 
 /**
  * Handler for zypp Repos on the Myrlyn side
@@ -50,6 +55,26 @@ public:
      **/
     virtual ~MyrlynRepoManager();
 
+    /**
+     * Set the root directory of the target and the repos instead of "/", like
+     * 'zypper --root'. This is used for the --root command line option.
+     *
+     * Everything (the repo definitions, the caches, the RPMDB) is then taken
+     * from below that directory, so this works without root permissions if
+     * the user owns that directory. Set this before connecting to zypp.
+     **/
+    static void setRootDir( const QString & rootDir );
+
+    /**
+     * Return the root directory of the target and the repos.
+     **/
+    static const QString & rootDir() { return _rootDir; }
+
+    /**
+     * Return the options for creating a zypp::RepoManager for rootDir().
+     **/
+    static zypp::RepoManagerOptions repoManagerOptions();
+
     /**
      * Connect to the package manager (libzypp).
      *
@@ -89,6 +114,44 @@ public:
      **/
     RepoManager_Ptr repoManager();
 
+    /**
+     * Return 'true' if the repos should be loaded from their existing caches
+     * first and refreshed in the background while the user can already work
+     * with the package selector (--background-refresh or the
+     * "backgroundRefresh" setting).
+     **/
+    bool backgroundRefresh() const;
+
+    /**
+     * Return 'true' if a background refresh is currently running.
+     **/
+    bool isBackgroundRefreshRunning() const;
+
+    /**
+     * Wait until a running background refresh is finished. A background
+     * refresh that didn't start yet won't start anymore.
+     *
+     * The worker threads of the refresh use the process-wide MediaManager
+     * and KeyRing of libzypp, so use this before anything in the GUI thread
+     * uses them, too: The package commit, the repo configuration.
+     *
+     * If 'reload' is 'false', don't reload any repos afterwards: Use this
+     * before the package commit that uses the pool as it is now.
+     **/
+    void waitForBackgroundRefresh( bool reload = false );
+
+
+public slots:
+
+    /**
+     * Start refreshing the repos in the background if attachRepos() loaded
+     * them from their caches without refreshing them first. When that is
+     * done, the repos with new metadata are reloaded.
+     *
+     * Call this when the event loop is running.
+     **/
+    void startBackgroundRefresh();
+
 
 signals:
 
@@ -107,6 +170,56 @@ signals:
      **/
     void refreshRepoDone ( const ZyppRepoInfo & repo );
 
+    /**
+     * Emitted when a background refresh of 'repoCount' repos starts.
+     **/
+    void backgroundRefreshStarted( int repoCount );
+
+    /**
+     * Emitted when one more repo is refreshed in the background.
+     **/
+    void backgroundRefreshProgress( int doneCount, int totalCount );
+
+    /**
+     * Emitted when the background refresh is finished. 'changedCount' repos
+     * have new metadata and will be reloaded, 'failedCount' could not be
+     * refreshed.
+     **/
+    void backgroundRefreshFinished( int changedCount, int failedCount );
+
+    /**
+     * Emitted right before repos are reloaded into the pool after a
+     * background refresh. All ZyppSel etc. pointers become invalid; any
+     * widgets holding them need to be cleared.
+     **/
+    void aboutToReloadRepos();
+
+    /**
+     * Emitted after repos were reloaded into the pool and the user's package
+     * selections were restored.
+     **/
+    void reposReloaded();
+
+
+protected slots:
+
+    /**
+     * Report the progress of the background refresh.
+     **/
+    void backgroundRepoDone();
+
+    /**
+     * Clean up after the background refresh and reload the changed repos.
+     **/
+    void backgroundRefreshDone();
+
+    /**
+     * Reload the repos in _reposToReload into the pool while keeping the
+     * user's package selections. This is postponed while a modal dialog is
+     * open.
+     **/
+    void reloadChangedRepos();
+
 
 protected:
 
@@ -129,12 +242,35 @@ protected:
      **/
     void findEnabledRepos();
 
+    /**
+     * Return 'true' if the repos may be refreshed: Only for root, and not
+     * with --no-repo-refresh.
+     **/
+    bool canRefreshRepos() const;
+
+    /**
+     * Refresh only the enabled repos that don't have a solv cache yet:
+     * Those can't be loaded without that.
+     **/
+    void refreshUncachedRepos();
+
     /**
      * Refresh the enabled repos if needed.
      * This is skipped for non-privileged users.
+     *
+     * The solv caches of several repos are built concurrently, but their
+     * metadata are downloaded one at a time (see ParallelRepoRefresher).
+     * Repos that can't be refreshed are disabled.
      **/
     void refreshRepos();
 
+    /**
+     * Return the maximum number of repos to refresh concurrently from the
+     * settings ("maxParallelRefresh"). 1 refreshes one repo after the other.
+     * Only building the solv caches overlaps; the downloads don't.
+     **/
+    int maxParallelRefresh() const;
+
     /**
      * Load the resolvables from the enabled repos.
      **/
@@ -154,6 +290,17 @@ protected:
     zypp::ZYpp::Ptr _zypp_ptr;
     RepoManager_Ptr _repo_manager_ptr;
     RepoInfoList    _repos;
+
+    // Background refresh
+
+    ParallelRepoRefresher * _backgroundRefresher;
+    KeyRingCallbacks *      _keyRingCallbacks;
+    RepoInfoList            _backgroundRepos;
+    QStringList             _reposToReload;
+    bool                    _needBackgroundRefresh;
+    bool                    _skipReload;
+
+    static QString          _rootDir;
 };
 
 #endif // MyrlynRepoManager_h
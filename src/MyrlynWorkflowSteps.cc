@@ -15,14 +15,18 @@
  */
 
 
+#include <QApplication>
 #include <QMessageBox>
+#include <QTimer>
 
+#include "Benchmark.h"
 #include "Exception.h"
 #include "InitReposPage.h"
 #include "Logger.h"
 #include "MainWindow.h"
 #include "PkgCommitPage.h"
 #include "QY2CursorHelper.h"
+#include "StartupProfile.h"
 #include "SummaryPage.h"
 #include "YQPkgSelector.h"
 #include "YQi18n.h"
@@ -154,6 +158,7 @@ void InitReposStep::initRepos()
         return;
 
     logDebug() << "Initializing zypp..." << endl;
+    StartupPhase phase( "Init repos" );
 
     MyrlynRepoManager * repoMan = _app->repoManager();
     CHECK_PTR( repoMan );
@@ -161,6 +166,7 @@ void InitReposStep::initRepos()
 
     try
     {
+        StartupPhase phase( "Connect to zypp" );
         repoMan->zyppConnect(); // This may throw
     }
     catch ( ... )
@@ -182,6 +188,10 @@ void InitReposStep::initRepos()
 
     logDebug() << "Initializing zypp done" << endl;
     _reposInitialized = true;
+
+    // Only if background refresh is enabled; start it when the package
+    // selection is up.
+    QTimer::singleShot( 0, repoMan, SLOT( startBackgroundRefresh() ) );
 }
 
 
@@ -205,6 +215,30 @@ void PkgSelStep::activate( bool goingForward )
 {
     MyrlynWorkflowStep::activate( goingForward ); // Show the page
 
+    StartupProfile * profile = StartupProfile::instance();
+
+    if ( profile->isEnabled() )
+    {
+        // The first paint of the package selector only happens in the event
+        // loop, with a lower priority than a zero timer: Wait for the paint
+        // event itself.
+
+        profile->beginPhase( "First paint" );
+        profile->finishAfterFirstPaint( _app->pkgSel() );
+    }
+
+    if ( goingForward && MyrlynApp::isOptionSet( OptBenchmark ) )
+    {
+        // Run the benchmark from the event loop when the package selector is
+        // up and quit when it's done
+
+        QTimer::singleShot( 0, [ this ]()
+            {
+                Benchmark benchmark( Benchmark::scenarioToRun(), _app->pkgSel() );
+                qApp->exit( benchmark.run() );
+            });
+    }
+
     if ( ! goingForward )
         _app->pkgSel()->reset(); // includes resetResolver()
 }
@@ -228,6 +262,10 @@ void PkgCommitStep::activate( bool goingForward )
         MyrlynWorkflowStep::activate( goingForward ); // Show the page
         _app->pkgCommitPage()->reset();  // Reset the widgets on the page
 
+        busyCursor();
+        _app->repoManager()->waitForBackgroundRefresh();
+        normalCursor();
+
         _app->pkgCommitPage()->commit(); // Do the package transactions
     }
 
@@ -0,0 +1,330 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <QElapsedTimer>
+#include <QEventLoop>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QMutexLocker>
+
+#include <zypp/repo/RepoException.h>
+
+#include "Exception.h"
+#include "FlightRecorder.h"
+#include "Logger.h"
+#include "utf8.h"
+#include "ParallelRepoRefresher.h"
+
+
+// Serializes the use of the process-wide parts of libzypp by the
+// RepoRefreshThreads: MediaManager, KeyRing, ZConfig, ReceiveReport callbacks.
+//
+// The GUI thread doesn't lock this: The key ring callbacks of a worker that
+// holds it may wait for the GUI thread to ask the user. Instead, it waits for
+// a background refresh before it uses those parts of libzypp itself (see
+// MyrlynRepoManager::waitForBackgroundRefresh()).
+static QMutex zyppSharedStateMutex;
+
+
+RepoRefreshThread::RepoRefreshThread( const ZyppRepoInfo &             repo,
+                                      const zypp::RepoManagerOptions & options,
+                                      int                              delayMillisec,
+                                      QObject *                        parent )
+    : QThread( parent )
+    , _repo( repo )
+    , _options( options )
+    , _delayMillisec( delayMillisec )
+    , _failed( false )
+    , _changed( false )
+    , _elapsedMillisec( 0 )
+{
+}
+
+
+RepoRefreshThread::~RepoRefreshThread()
+{
+    wait();
+}
+
+
+void RepoRefreshThread::run()
+{
+    // No logging here: The logger is only used from the GUI thread.
+
+    FlightRecorder::installAltStack();
+
+    QElapsedTimer timer;
+    timer.start();
+
+    try
+    {
+        // A RepoManager of our own, but it still uses the process-wide
+        // MediaManager, KeyRing and callbacks for downloading and checking
+        // the metadata: Only one thread at a time may do that, and the GUI
+        // thread not at all while any worker is running.
+
+        zypp::RepoManager repoManager( _options );
+        zypp::RepoStatus  oldStatus = repoManager.cacheStatus( _repo );
+
+        {
+            QMutexLocker locker( &zyppSharedStateMutex );
+
+            if ( _delayMillisec > 0 ) // Simulate a slow server
+                msleep( _delayMillisec );
+
+            repoManager.refreshMetadata( _repo, zypp::RepoManager::RefreshIfNeeded );
+        }
+
+        // This only reads the ZConfig that is settled by now, uses the files
+        // of this repo and runs repo2solv: Let this overlap with the download
+        // of the next repo.
+
+        repoManager.buildCache( _repo, zypp::RepoManager::BuildIfNeeded );
+
+        _changed = ! ( repoManager.cacheStatus( _repo ) == oldStatus );
+    }
+    catch ( const zypp::repo::RepoException & exception )
+    {
+        _failed       = true;
+        _errorMessage = fromUTF8( exception.asUserString() );
+    }
+    catch ( ... )
+    {
+        // An exception must not leave the thread function;
+        // hand it over to the GUI thread.
+
+        _failed    = true;
+        _exception = std::current_exception();
+    }
+
+    _elapsedMillisec = timer.elapsed();
+}
+
+
+void RepoRefreshThread::rethrowException() const
+{
+    if ( _exception )
+        std::rethrow_exception( _exception );
+}
+
+
+//
+//----------------------------------------------------------------------
+//
+
+
+ParallelRepoRefresher::ParallelRepoRefresher( const zypp::RepoManagerOptions & options,
+                                              int                              maxWorkers,
+                                              QObject *                        parent )
+    : QObject( parent )
+    , _options( options )
+    , _maxWorkers( qMax( 1, maxWorkers ) )
+    , _delayMillisec( 0 )
+    , _disableFailedRepos( true )
+    , _failedCount( 0 )
+    , _doneCount( 0 )
+    , _totalCount( 0 )
+{
+}
+
+
+ParallelRepoRefresher::~ParallelRepoRefresher()
+{
+    // Don't start anything new, but let the running workers finish:
+    // libzypp can't be interrupted in the middle of a refresh.
+
+    _pending.clear();
+    qDeleteAll( _running ); // The RepoRefreshThread destructor waits
+}
+
+
+void ParallelRepoRefresher::refresh( RepoInfoList & repos )
+{
+    start( repos );
+
+    if ( isRunning() )
+    {
+        QEventLoop eventLoop;
+
+        connect( this,       SIGNAL( refreshFinished() ),
+                 &eventLoop, SLOT  ( quit()            ) );
+
+        eventLoop.exec( QEventLoop::ExcludeUserInputEvents );
+    }
+
+    if ( _exception )
+        std::rethrow_exception( _exception );
+}
+
+
+void ParallelRepoRefresher::start( RepoInfoList & repos )
+{
+    if ( isRunning() )
+    {
+        logError() << "Repo refresh already running" << endl;
+        return;
+    }
+
+    _changedRepos.clear();
+    _failedCount = 0;
+    _doneCount   = 0;
+    _exception   = std::exception_ptr();
+
+    for ( ZyppRepoInfo & repo: repos )
+    {
+        if ( repo.enabled() )
+            _pending << &repo;
+    }
+
+    _totalCount = _pending.size();
+
+    logInfo() << "Refreshing " << _totalCount << " repos with up to "
+              << _maxWorkers << " worker threads" << endl;
+
+    _timer.start();
+    startWorkers();
+
+    if ( ! isRunning() )        // Nothing to do?
+        emit refreshFinished();
+}
+
+
+void ParallelRepoRefresher::startWorkers()
+{
+    // After an unexpected exception, don't start any more workers, but wait
+    // for the running ones to finish
+
+    if ( _exception )
+        _pending.clear();
+
+    while ( _running.size() < _maxWorkers && ! _pending.isEmpty() )
+    {
+        ZyppRepoInfo * repo = _pending.takeFirst();
+
+        logInfo() << "Refreshing repo " << repo->name() << "..." << endl;
+        emit refreshRepoStart( *repo );
+
+        RepoRefreshThread * thread = new RepoRefreshThread( *repo, _options, _delayMillisec );
+        CHECK_NEW( thread );
+
+        // QThread::finished() is sent from the worker thread, so this is a
+        // queued connection: workerFinished() is called in this thread.
+
+        connect( thread, SIGNAL( finished()       ),
+                 this,   SLOT  ( workerFinished() ) );
+
+        _threadRepo.insert( thread, repo );
+        _running << thread;
+        thread->start();
+    }
+}
+
+
+void ParallelRepoRefresher::workerFinished()
+{
+    // Collect the results of all the finished ones, not only of the sender:
+    // Another one might already be finished, too.
+
+    // That also means that this may be called for a thread that is already
+    // collected; don't report being finished more than once.
+
+    bool collected = false;
+
+    for ( int i = _running.size() - 1; i >= 0; --i )
+    {
+        RepoRefreshThread * thread = _running.at( i );
+
+        if ( thread->isFinished() )
+        {
+            _running.removeAt( i );
+            collectResult( thread );
+            collected = true;
+        }
+    }
+
+    if ( ! collected )
+        return;
+
+    startWorkers();
+
+    if ( ! isRunning() )
+    {
+        logInfo() << "Refreshing all repos done after "
+                  << _timer.elapsed() / 1000.0 << " sec; "
+                  << _changedRepos.size() << " with new metadata, "
+                  << _failedCount << " failed" << endl;
+
+        emit refreshFinished();
+    }
+}
+
+
+void ParallelRepoRefresher::collectResult( RepoRefreshThread * thread )
+{
+    thread->wait();
+    ZyppRepoInfo * repo = _threadRepo.take( thread );
+    CHECK_PTR( repo );
+    ++_doneCount;
+
+    try
+    {
+        thread->rethrowException();
+    }
+    catch ( ... )
+    {
+        // Keep the first one; the other workers need to finish first
+        if ( ! _exception )
+            _exception = std::current_exception();
+
+        logError() << "Refreshing repo " << repo->name() << " failed" << endl;
+        ++_failedCount;
+        delete thread;
+
+        return;
+    }
+
+    if ( thread->failed() )
+    {
+        logWarning() << "Refreshing repo " << repo->name() << " failed: "
+                     << thread->errorMessage() << endl;
+        ++_failedCount;
+
+        if ( _disableFailedRepos )
+        {
+            logInfo() << "Disabling repo " << repo->name() << endl;
+            repo->setEnabled( false );
+        }
+
+        emit refreshRepoFailed( *repo, thread->errorMessage() );
+    }
+    else
+    {
+        logInfo() << "Refreshing repo " << repo->name()
+                  << " done after " << thread->elapsedMillisec() / 1000.0 << " sec"
+                  << ( thread->changed() ? " (new metadata)" : "" )
+                  << endl;
+
+        if ( thread->changed() )
+            _changedRepos << fromUTF8( repo->alias() );
+
+        emit refreshRepoDone( *repo );
+    }
+
+    delete thread;
+}
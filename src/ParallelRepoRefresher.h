@@ -0,0 +1,290 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef ParallelRepoRefresher_h
+#define ParallelRepoRefresher_h
+
+
+#include <exception>    // std::exception_ptr
+
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+#include <QThread>
+
+#include <zypp/RepoManager.h>
+
+#include "YQZypp.h"     // ZyppRepoInfo
+#include "MyrlynRepoManager.h"  // RepoInfoList
+
+
+/**
+ * Thread for refreshing the metadata of one repo and building its solv cache.
+ *
+ * This uses its own zypp::RepoManager, but that does not make it independent
+ * of the other threads: The MediaManager, the KeyRing, the ZConfig and the
+ * ReceiveReport callbacks of libzypp are process-wide, and they are not
+ * thread-safe. So downloading and checking the metadata, which uses all of
+ * them, is serialized between all RepoRefreshThreads; only building the solv
+ * cache (running repo2solv) overlaps with that of other repos.
+ *
+ * While any RepoRefreshThread is running, the GUI thread must not use those
+ * parts of libzypp either, e.g. for a package commit or in the repo
+ * configuration; MyrlynRepoManager::waitForBackgroundRefresh() waits for
+ * them.
+ **/
+class RepoRefreshThread: public QThread
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructor. Use start() to start refreshing 'repo'.
+     *
+     * 'delayMillisec' is an artificial latency for testing that is added to
+     * downloading the metadata, i.e. it is serialized like that.
+     **/
+    RepoRefreshThread( const ZyppRepoInfo &             repo,
+                       const zypp::RepoManagerOptions & options,
+                       int                              delayMillisec = 0,
+                       QObject *                        parent        = 0 );
+
+    /**
+     * Destructor. This waits until the thread is finished.
+     **/
+    virtual ~RepoRefreshThread();
+
+    /**
+     * Return the repo that is refreshed.
+     **/
+    const ZyppRepoInfo & repo() const { return _repo; }
+
+    /**
+     * Return 'true' if refreshing the repo failed.
+     * Only meaningful after the thread is finished.
+     **/
+    bool failed() const { return _failed; }
+
+    /**
+     * Return the error message if refreshing the repo failed.
+     **/
+    const QString & errorMessage() const { return _errorMessage; }
+
+    /**
+     * Return 'true' if the solv cache of the repo changed, i.e. if there was
+     * new metadata. Only meaningful after the thread is finished.
+     **/
+    bool changed() const { return _changed; }
+
+    /**
+     * Return the time it took to refresh the repo in millisec.
+     **/
+    qint64 elapsedMillisec() const { return _elapsedMillisec; }
+
+    /**
+     * Throw the exception other than a zypp::repo::RepoException that
+     * refreshing the repo threw, if there was any.
+     **/
+    void rethrowException() const;
+
+
+protected:
+
+    /**
+     * The thread function.
+     *
+     * Reimplemented from QThread.
+     **/
+    virtual void run() override;
+
+
+    ZyppRepoInfo             _repo;
+    zypp::RepoManagerOptions _options;
+    int                      _delayMillisec;
+    bool                     _failed;
+    bool                     _changed;
+    QString                  _errorMessage;
+    qint64                   _elapsedMillisec;
+    std::exception_ptr       _exception;
+};
+
+
+/**
+ * Refresh the metadata of a number of repos and build their solv caches with
+ * a bounded number of RepoRefreshThreads running concurrently.
+ *
+ * Only building the solv caches runs in parallel: The metadata downloads are
+ * done one at a time (see RepoRefreshThread), so this does not help with
+ * slow servers. The gain is from building the solv cache of one repo while
+ * the next one is downloaded and while the caches of others are built.
+ *
+ * Use refresh() to wait until all repos are refreshed, or start() to refresh
+ * them in the background while the event loop keeps running.
+ *
+ * All signals are sent from the thread that calls refresh() or start(), and
+ * all logging is done from that thread as well.
+ **/
+class ParallelRepoRefresher: public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructor. Each worker thread creates a zypp::RepoManager with
+     * 'options'. At most 'maxWorkers' repos are refreshed at the same time.
+     **/
+    ParallelRepoRefresher( const zypp::RepoManagerOptions & options,
+                           int                              maxWorkers = 4,
+                           QObject *                        parent     = 0 );
+
+    /**
+     * Destructor. This waits until all worker threads are finished.
+     **/
+    virtual ~ParallelRepoRefresher();
+
+    /**
+     * Set an artificial latency for downloading the metadata of each repo
+     * for testing. Like the downloads, this is serialized between the
+     * worker threads.
+     **/
+    void setDelay( int millisec ) { _delayMillisec = millisec; }
+
+    /**
+     * Set if repos that could not be refreshed are disabled (default: true).
+     **/
+    void setDisableFailedRepos( bool disable ) { _disableFailedRepos = disable; }
+
+    /**
+     * Return the maximum number of repos that are refreshed concurrently.
+     **/
+    int maxWorkers() const { return _maxWorkers; }
+
+    /**
+     * Refresh all enabled repos in 'repos' and return when all are done.
+     * Events are processed while waiting, except user input events.
+     *
+     * Repos that could not be refreshed are disabled in 'repos'.
+     *
+     * Exceptions other than zypp::repo::RepoException are rethrown after all
+     * worker threads are finished.
+     **/
+    void refresh( RepoInfoList & repos );
+
+    /**
+     * Start refreshing all enabled repos in 'repos' and return immediately.
+     * 'repos' has to stay valid until refreshFinished() is emitted.
+     **/
+    void start( RepoInfoList & repos );
+
+    /**
+     * Return 'true' if any repo refresh is still pending or running.
+     **/
+    bool isRunning() const { return ! _pending.isEmpty() || ! _running.isEmpty(); }
+
+    /**
+     * Return the aliases of the repos with new metadata after the last
+     * refresh.
+     **/
+    const QStringList & changedRepos() const { return _changedRepos; }
+
+    /**
+     * Return the number of repos that could not be refreshed.
+     **/
+    int failedCount() const { return _failedCount; }
+
+    /**
+     * Return the number of repos that are refreshed (with or without
+     * success) so far.
+     **/
+    int doneCount() const { return _doneCount; }
+
+    /**
+     * Return the total number of repos to refresh.
+     **/
+    int totalCount() const { return _totalCount; }
+
+
+signals:
+
+    /**
+     * Emitted when refreshing a repo starts.
+     **/
+    void refreshRepoStart( const ZyppRepoInfo & repo );
+
+    /**
+     * Emitted when refreshing a repo is done.
+     **/
+    void refreshRepoDone ( const ZyppRepoInfo & repo );
+
+    /**
+     * Emitted when refreshing a repo failed.
+     **/
+    void refreshRepoFailed( const ZyppRepoInfo & repo,
+                            const QString &      errorMessage );
+
+    /**
+     * Emitted when all repos are refreshed.
+     **/
+    void refreshFinished();
+
+
+protected slots:
+
+    /**
+     * Collect the results of the finished worker threads and start new ones.
+     **/
+    void workerFinished();
+
+
+protected:
+
+    /**
+     * Start as many worker threads as allowed for the pending repos.
+     **/
+    void startWorkers();
+
+    /**
+     * Handle the result of a finished worker thread and delete it.
+     **/
+    void collectResult( RepoRefreshThread * thread );
+
+
+    zypp::RepoManagerOptions _options;
+    int                      _maxWorkers;
+    int                      _delayMillisec;
+    bool                     _disableFailedRepos;
+
+    QList<ZyppRepoInfo *>    _pending;
+    QList<RepoRefreshThread *> _running;
+    QHash<RepoRefreshThread *, ZyppRepoInfo *> _threadRepo;
+
+    QStringList              _changedRepos;
+    int                      _failedCount;
+    int                      _doneCount;
+    int                      _totalCount;
+    std::exception_ptr       _exception;
+    QElapsedTimer            _timer;
+};
+
+
+#endif // ParallelRepoRefresher_h
@@ -15,8 +15,12 @@
  */
 
 
+#include <QGuiApplication>
+#include <QScreen>
+
 #include "Logger.h"
 #include "Exception.h"
+#include "FlightRecorder.h"
 #include "PkgCommitCallbacks.h"
 
 
@@ -42,6 +46,26 @@ PkgCommitCallbacks::~PkgCommitCallbacks()
 PkgCommitSignalForwarder * PkgCommitSignalForwarder::_instance = 0;
 
 
+PkgCommitSignalForwarder::PkgCommitSignalForwarder()
+    : QObject()
+    , _doAbort( 0 )
+    , _reply( AbortReply )
+    , _pendingKind( NoProgress )
+    , _pendingValue( 0 )
+    , _progressInterval( 16 )
+    , _flushScheduled( false )
+{
+    // Needed for the queued connections: The metatype is looked up by name
+
+    qRegisterMetaType<PkgResInfo>( "PkgResInfo" );
+
+    _flushTimer.setSingleShot( true );
+
+    connect( &_flushTimer, SIGNAL( timeout()              ),
+             this,         SLOT  ( flushStalledProgress() ) );
+}
+
+
 PkgCommitSignalForwarder * PkgCommitSignalForwarder::instance()
 {
     if ( ! _instance )
@@ -56,62 +80,210 @@ PkgCommitSignalForwarder * PkgCommitSignalForwarder::instance()
 
 void PkgCommitSignalForwarder::reset()
 {
-    _doAbort = false;
+    _doAbort.storeRelease( 0 );
+    _flushTimer.stop();
+
+    QMutexLocker locker( &_progressMutex );
+
+    _pendingKind    = NoProgress;
+    _flushScheduled = false;
+    _progressTimer.invalidate();
+
+    QScreen * screen = QGuiApplication::primaryScreen();
+    qreal refreshRate = screen ? screen->refreshRate() : 60.0; // Hz
+
+    if ( refreshRate < 1.0 )
+        refreshRate = 60.0;
+
+    _progressInterval = qMax( 1, (int) ( 1000.0 / refreshRate ) );
+}
+
+
+void PkgCommitSignalForwarder::sendProgress( ProgressKind kind,
+                                             ZyppRes      zyppRes,
+                                             int          value )
+{
+    PkgResInfo res( zyppRes );
+    QMutexLocker locker( &_progressMutex );
+
+    // A different kind of progress or a different resolvable: Don't lose
+    // the last value of the previous one.
+
+    if ( _pendingKind != NoProgress &&
+         ( _pendingKind != kind || _pendingRes.ident != res.ident ) )
+    {
+        flushProgressLocked();
+    }
+
+    _pendingKind  = kind;
+    _pendingRes   = res;
+    _pendingValue = value;
+
+    if ( ! _progressTimer.isValid() || _progressTimer.elapsed() >= _progressInterval )
+    {
+        flushProgressLocked();
+    }
+    else if ( ! _flushScheduled )
+    {
+        // If no more progress or other signal comes in, send this one from
+        // the GUI thread. A QTimer can only be started from its own thread.
+
+        _flushScheduled = true;
+        QMetaObject::invokeMethod( &_flushTimer, "start", Qt::QueuedConnection,
+                                   Q_ARG( int, _progressInterval ) );
+    }
+}
+
+
+void PkgCommitSignalForwarder::flushProgress()
+{
+    QMutexLocker locker( &_progressMutex );
+    flushProgressLocked();
+}
+
+
+void PkgCommitSignalForwarder::flushStalledProgress()
+{
+    QMutexLocker locker( &_progressMutex );
+
+    _flushScheduled = false;
+    flushProgressLocked();
+}
+
+
+void PkgCommitSignalForwarder::flushProgressLocked()
+{
+    ProgressKind kind = _pendingKind;
+    _pendingKind = NoProgress;
+
+    switch ( kind )
+    {
+        case NoProgress:            return;
+        case DownloadProgress:      emit pkgDownloadProgress( _pendingRes, _pendingValue ); break;
+        case InstallProgress:       emit pkgInstallProgress ( _pendingRes, _pendingValue ); break;
+        case RemoveProgress:        emit pkgRemoveProgress  ( _pendingRes, _pendingValue ); break;
+        case FileConflictsProgress: emit fileConflictsCheckProgress( _pendingValue );       break;
+    }
+
+    _progressTimer.start();
+}
+
+
+/**
+ * Return the flight recorder event name for a commit timeline event type.
+ **/
+static const char * flightRecorderEvent( PkgCommitTimeline::EventType type )
+{
+    switch ( type )
+    {
+        case PkgCommitTimeline::DownloadStart:      return "commit-download-start";
+        case PkgCommitTimeline::DownloadEnd:        return "commit-download-end";
+        case PkgCommitTimeline::CacheHit:           return "commit-cache-hit";
+        case PkgCommitTimeline::InstallStart:       return "commit-install-start";
+        case PkgCommitTimeline::InstallEnd:         return "commit-install-end";
+        case PkgCommitTimeline::RemoveStart:        return "commit-remove-start";
+        case PkgCommitTimeline::RemoveEnd:          return "commit-remove-end";
+        case PkgCommitTimeline::PkgError:           return "commit-error";
+        case PkgCommitTimeline::FileConflictsStart: return "commit-file-conflicts-start";
+        case PkgCommitTimeline::FileConflictsEnd:   return "commit-file-conflicts-end";
+    }
+
+    return "commit-event";
+}
+
+
+void PkgCommitSignalForwarder::record( PkgCommitTimeline::EventType type,
+                                       ZyppRes                      zyppRes )
+{
+    flushProgress();
+
+    if ( zyppRes )
+        FlightRecorder::instance()->record( flightRecorderEvent( type ), zyppRes->name() );
+    else
+        FlightRecorder::instance()->record( flightRecorderEvent( type ) );
+
+    QString pkgName;
+
+    if ( zyppRes )
+        pkgName = fromUTF8( zyppRes->name() );
+
+    PkgCommitTimeline::instance()->addEvent( type, pkgName );
 }
 
 
 void PkgCommitSignalForwarder::connectAll( QObject * receiver )
 {
-    connect( instance(), SIGNAL( pkgDownloadStart    ( ZyppRes ) ),
-             receiver,   SLOT  ( pkgDownloadStart    ( ZyppRes ) ) );
+    // The signals are sent from the commit thread, the receiver lives in the
+    // GUI thread. The error signals need a reply before the callback can
+    // return, so they block the commit thread until the slot has returned.
+    // Never send them from the receiver's thread: That would deadlock.
+
+    connect( instance(), SIGNAL( pkgDownloadStart    ( PkgResInfo ) ),
+             receiver,   SLOT  ( pkgDownloadStart    ( PkgResInfo ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgDownloadProgress ( ZyppRes, int ) ),
-             receiver,   SLOT  ( pkgDownloadProgress ( ZyppRes, int ) ) );
+    connect( instance(), SIGNAL( pkgDownloadProgress ( PkgResInfo, int ) ),
+             receiver,   SLOT  ( pkgDownloadProgress ( PkgResInfo, int ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgDownloadEnd      ( ZyppRes ) ),
-             receiver,   SLOT  ( pkgDownloadEnd      ( ZyppRes ) ) );
+    connect( instance(), SIGNAL( pkgDownloadEnd      ( PkgResInfo ) ),
+             receiver,   SLOT  ( pkgDownloadEnd      ( PkgResInfo ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgCachedNotify     ( ZyppRes ) ),
-             receiver,   SLOT  ( pkgCachedNotify     ( ZyppRes ) ) );
+    connect( instance(), SIGNAL( pkgCachedNotify     ( PkgResInfo ) ),
+             receiver,   SLOT  ( pkgCachedNotify     ( PkgResInfo ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgDownloadError    ( ZyppRes, const QString & ) ),
-             receiver,   SLOT  ( pkgDownloadError    ( ZyppRes, const QString & ) ) );
+    connect( instance(), SIGNAL( pkgDownloadError    ( PkgResInfo, QString ) ),
+             receiver,   SLOT  ( pkgDownloadError    ( PkgResInfo, QString ) ),
+             Qt::BlockingQueuedConnection );
 
 
-    connect( instance(), SIGNAL( pkgInstallStart     ( ZyppRes ) ),
-             receiver,   SLOT  ( pkgInstallStart     ( ZyppRes ) ) );
+    connect( instance(), SIGNAL( pkgInstallStart     ( PkgResInfo ) ),
+             receiver,   SLOT  ( pkgInstallStart     ( PkgResInfo ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgInstallProgress  ( ZyppRes, int ) ),
-             receiver,   SLOT  ( pkgInstallProgress  ( ZyppRes, int ) ) );
+    connect( instance(), SIGNAL( pkgInstallProgress  ( PkgResInfo, int ) ),
+             receiver,   SLOT  ( pkgInstallProgress  ( PkgResInfo, int ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgInstallEnd       ( ZyppRes ) ),
-             receiver,   SLOT  ( pkgInstallEnd       ( ZyppRes ) ) );
+    connect( instance(), SIGNAL( pkgInstallEnd       ( PkgResInfo ) ),
+             receiver,   SLOT  ( pkgInstallEnd       ( PkgResInfo ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgInstallError     ( ZyppRes, const QString & ) ),
-             receiver,   SLOT  ( pkgInstallError     ( ZyppRes, const QString & ) ) );
+    connect( instance(), SIGNAL( pkgInstallError     ( PkgResInfo, QString ) ),
+             receiver,   SLOT  ( pkgInstallError     ( PkgResInfo, QString ) ),
+             Qt::BlockingQueuedConnection );
 
 
-    connect( instance(), SIGNAL( pkgRemoveStart      ( ZyppRes ) ),
-             receiver,   SLOT  ( pkgRemoveStart      ( ZyppRes ) ) );
+    connect( instance(), SIGNAL( pkgRemoveStart      ( PkgResInfo ) ),
+             receiver,   SLOT  ( pkgRemoveStart      ( PkgResInfo ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgRemoveProgress   ( ZyppRes, int ) ),
-             receiver,   SLOT  ( pkgRemoveProgress   ( ZyppRes, int ) ) );
+    connect( instance(), SIGNAL( pkgRemoveProgress   ( PkgResInfo, int ) ),
+             receiver,   SLOT  ( pkgRemoveProgress   ( PkgResInfo, int ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgRemoveEnd        ( ZyppRes ) ),
-             receiver,   SLOT  ( pkgRemoveEnd        ( ZyppRes ) ) );
+    connect( instance(), SIGNAL( pkgRemoveEnd        ( PkgResInfo ) ),
+             receiver,   SLOT  ( pkgRemoveEnd        ( PkgResInfo ) ),
+             Qt::QueuedConnection );
 
-    connect( instance(), SIGNAL( pkgRemoveError      ( ZyppRes, const QString & ) ),
-             receiver,   SLOT  ( pkgRemoveError      ( ZyppRes, const QString & ) ) );
+    connect( instance(), SIGNAL( pkgRemoveError      ( PkgResInfo, QString ) ),
+             receiver,   SLOT  ( pkgRemoveError      ( PkgResInfo, QString ) ),
+             Qt::BlockingQueuedConnection );
 
 
     connect( instance(), SIGNAL( fileConflictsCheckStart() ),
-             receiver,   SLOT  ( fileConflictsCheckStart() ) );
+             receiver,   SLOT  ( fileConflictsCheckStart() ),
+             Qt::QueuedConnection );
 
     connect( instance(), SIGNAL( fileConflictsCheckProgress( int ) ),
-             receiver,   SLOT  ( fileConflictsCheckProgress( int ) ) );
+             receiver,   SLOT  ( fileConflictsCheckProgress( int ) ),
+             Qt::QueuedConnection );
 
     connect( instance(), SIGNAL( fileConflictsCheckResult( QStringList ) ),
-             receiver,   SLOT  ( fileConflictsCheckResult( QStringList ) ) );
+             receiver,   SLOT  ( fileConflictsCheckResult( QStringList ) ),
+             Qt::QueuedConnection );
 
 
     connect( receiver,   SIGNAL( abortCommit() ),
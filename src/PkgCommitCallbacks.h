@@ -22,6 +22,11 @@
 #include <iostream>  // cerr
 #include <QObject>
 #include <QStringList>
+#include <QAtomicInt>
+#include <QElapsedTimer>
+#include <QMetaType>
+#include <QMutex>
+#include <QTimer>
 
 #include <zypp/Resolvable.h>
 #include <zypp/Url.h>
@@ -29,6 +34,7 @@
 #include <zypp/sat/FileConflicts.h>
 
 #include "utf8.h"
+#include "PkgCommitTimeline.h"
 #include "YQZypp.h"     // ZyppRes
 
 #define TEST_FILE_CONFLICTS     0
@@ -45,10 +51,46 @@ enum ErrorReply
 };
 
 
+/**
+ * What the receiver of the commit signals needs to know about a resolvable:
+ * Its sat ident to find the corresponding package task and its name for
+ * messages.
+ *
+ * The libzypp commit runs in a separate thread (see PkgCommitThread), so the
+ * signals can't pass a ZyppRes: Its reference count is not thread-safe, and
+ * the receiver must not access the pool while libzypp is committing. This is
+ * a plain value that is created in the commit thread.
+ **/
+struct PkgResInfo
+{
+    PkgResInfo() {}
+
+    PkgResInfo( ZyppRes zyppRes )
+        : ident( zyppRes ? zyppRes->ident() : zypp::IdString() )
+        , name ( zyppRes ? fromUTF8( zyppRes->name() ) : QString() )
+        {}
+
+    zypp::IdString ident;
+    QString        name;
+};
+
+Q_DECLARE_METATYPE( PkgResInfo )
+
+
 /**
  * Signal forwarder for the callbacks so they can send Qt signals to a receiver
  * QObject without being subclasses of QObject themselves.
  *
+ * The callbacks are called in the commit thread, the receiver lives in the
+ * GUI thread, so the signals are delivered as queued connections. The error
+ * signals use blocking queued connections since the callbacks need the reply.
+ *
+ * Progress signals are coalesced to the refresh rate of the display: Only the
+ * latest progress value within one refresh interval is sent. A pending value
+ * is always sent before any other signal so the order of events remains
+ * intact. If no other signal follows, a timer in the GUI thread sends it
+ * after one refresh interval, so the last value never gets stuck.
+ *
  * This is a singleton class.
  **/
 class PkgCommitSignalForwarder: public QObject
@@ -60,10 +102,7 @@ protected:
     /**
      * Constructor. Use instance() instead.
      **/
-    PkgCommitSignalForwarder()
-        : QObject()
-        , _doAbort( false )
-        {}
+    PkgCommitSignalForwarder();
 
 public:
 
@@ -85,8 +124,10 @@ public:
     /**
      * Return 'true' if 'abortCommit()' has been received since the last
      * 'reset()'
+     *
+     * This is safe to call from any thread.
      **/
-    bool doAbort() const { return _doAbort; }
+    bool doAbort() const { return _doAbort.loadAcquire() != 0; }
 
     /**
      * Return the latest reply to an error.
@@ -100,17 +141,28 @@ public:
      * similar effect: Before the connected slot returns, it should call this
      * to set a reply (in this case one of Abort / Retry / Ignore).
      *
-     * Of course, this only works with direct signal / slot connections,
-     * i.e. in the same thread. See also QObject::connect() and
-     * Qt::ConnectionType.
+     * Of course, this only works with direct or blocking queued signal /
+     * slot connections: The slot must have returned when the emitting
+     * function continues. See also QObject::connect() and Qt::ConnectionType.
      **/
     void setReply( ErrorReply val ) { _reply = val; }
 
     /**
      * Reset the internal status, including the _doAbort flag.
+     *
+     * Call this from the GUI thread before starting the commit thread: This
+     * also fetches the refresh rate of the display for coalescing the
+     * progress signals.
      **/
     void reset();
 
+    /**
+     * Send a pending coalesced progress signal now.
+     *
+     * This is safe to call from any thread.
+     **/
+    void flushProgress();
+
 
 signals:
 
@@ -119,23 +171,23 @@ signals:
     // signals:
     //
 
-    void pkgDownloadStart    ( ZyppRes zyppRes );
-    void pkgDownloadProgress ( ZyppRes zyppRes, int value );
-    void pkgDownloadEnd      ( ZyppRes zyppRes );
+    void pkgDownloadStart    ( const PkgResInfo & res );
+    void pkgDownloadProgress ( const PkgResInfo & res, int value );
+    void pkgDownloadEnd      ( const PkgResInfo & res );
 
-    void pkgCachedNotify     ( ZyppRes zyppRes );
-    void pkgDownloadError    ( ZyppRes zyppRes, const QString & msg );
+    void pkgCachedNotify     ( const PkgResInfo & res );
+    void pkgDownloadError    ( const PkgResInfo & res, const QString & msg );
 
 
-    void pkgInstallStart     ( ZyppRes zyppRes );
-    void pkgInstallProgress  ( ZyppRes zyppRes, int value );
-    void pkgInstallEnd       ( ZyppRes zyppRes );
-    void pkgInstallError     ( ZyppRes zyppRes, const QString & msg );
+    void pkgInstallStart     ( const PkgResInfo & res );
+    void pkgInstallProgress  ( const PkgResInfo & res, int value );
+    void pkgInstallEnd       ( const PkgResInfo & res );
+    void pkgInstallError     ( const PkgResInfo & res, const QString & msg );
 
-    void pkgRemoveStart      ( ZyppRes zyppRes );
-    void pkgRemoveProgress   ( ZyppRes zyppRes, int value );
-    void pkgRemoveEnd        ( ZyppRes zyppRes );
-    void pkgRemoveError      ( ZyppRes zyppRes, const QString & msg );
+    void pkgRemoveStart      ( const PkgResInfo & res );
+    void pkgRemoveProgress   ( const PkgResInfo & res, int value );
+    void pkgRemoveEnd        ( const PkgResInfo & res );
+    void pkgRemoveError      ( const PkgResInfo & res, const QString & msg );
 
     void fileConflictsCheckStart();
     void fileConflictsCheckProgress( int percent );
@@ -144,45 +196,103 @@ signals:
 
 public slots:
 
-    void abortCommit() { _doAbort = true; }
+    void abortCommit() { _doAbort.storeRelease( 1 ); }
+
+
+protected slots:
+
+    /**
+     * Send a progress value that is still pending one refresh interval
+     * after it was received. This is called in the GUI thread from
+     * _flushTimer.
+     **/
+    void flushStalledProgress();
 
 
 public:
 
     // Use each one with  PkgCommitSignalForwarder::instance()->sendPkg...()
+    //
+    // The start, end and error events are also recorded in the
+    // PkgCommitTimeline with the time stamp of when libzypp reported them,
+    // not when the GUI thread got around to processing the signal.
 
-    void sendPkgDownloadStart    ( ZyppRes zyppRes )             { emit pkgDownloadStart   ( zyppRes);         }
-    void sendPkgDownloadProgress ( ZyppRes zyppRes, int value )  { emit pkgDownloadProgress( zyppRes, value ); }
-    void sendPkgDownloadEnd      ( ZyppRes zyppRes )             { emit pkgDownloadEnd     ( zyppRes );        }
+    void sendPkgDownloadStart    ( ZyppRes zyppRes )             { record( PkgCommitTimeline::DownloadStart, zyppRes ); emit pkgDownloadStart( zyppRes ); }
+    void sendPkgDownloadProgress ( ZyppRes zyppRes, int value )  { sendProgress( DownloadProgress, zyppRes, value ); }
+    void sendPkgDownloadEnd      ( ZyppRes zyppRes )             { record( PkgCommitTimeline::DownloadEnd,   zyppRes ); emit pkgDownloadEnd  ( zyppRes ); }
 
-    void sendPkgCachedNotify     ( ZyppRes zyppRes )             { emit pkgCachedNotify    ( zyppRes );        }
+    void sendPkgCachedNotify     ( ZyppRes zyppRes )             { record( PkgCommitTimeline::CacheHit,      zyppRes ); emit pkgCachedNotify ( zyppRes ); }
     void sendPkgDownloadError    ( ZyppRes zyppRes,
-                                   const QString & msg )         { emit pkgDownloadError   ( zyppRes, msg );   }
+                                   const QString & msg )         { record( PkgCommitTimeline::PkgError,      zyppRes ); emit pkgDownloadError( zyppRes, msg ); }
 
 
-    void sendPkgInstallStart     ( ZyppRes zyppRes )             { emit pkgInstallStart    ( zyppRes);         }
-    void sendPkgInstallProgress  ( ZyppRes zyppRes, int value )  { emit pkgInstallProgress ( zyppRes, value ); }
-    void sendPkgInstallEnd       ( ZyppRes zyppRes )             { emit pkgInstallEnd      ( zyppRes );        }
+    void sendPkgInstallStart     ( ZyppRes zyppRes )             { record( PkgCommitTimeline::InstallStart,  zyppRes ); emit pkgInstallStart ( zyppRes ); }
+    void sendPkgInstallProgress  ( ZyppRes zyppRes, int value )  { sendProgress( InstallProgress, zyppRes, value ); }
+    void sendPkgInstallEnd       ( ZyppRes zyppRes )             { record( PkgCommitTimeline::InstallEnd,    zyppRes ); emit pkgInstallEnd   ( zyppRes ); }
     void sendPkgInstallError     ( ZyppRes zyppRes,
-                                   const QString & msg )         { emit pkgInstallError    ( zyppRes, msg );   }
+                                   const QString & msg )         { record( PkgCommitTimeline::PkgError,      zyppRes ); emit pkgInstallError ( zyppRes, msg ); }
 
-    void sendPkgRemoveStart      ( ZyppRes zyppRes )             { emit pkgRemoveStart     ( zyppRes);         }
-    void sendPkgRemoveProgress   ( ZyppRes zyppRes, int value )  { emit pkgRemoveProgress  ( zyppRes, value ); }
-    void sendPkgRemoveEnd        ( ZyppRes zyppRes )             { emit pkgRemoveEnd       ( zyppRes );        }
+    void sendPkgRemoveStart      ( ZyppRes zyppRes )             { record( PkgCommitTimeline::RemoveStart,   zyppRes ); emit pkgRemoveStart  ( zyppRes ); }
+    void sendPkgRemoveProgress   ( ZyppRes zyppRes, int value )  { sendProgress( RemoveProgress, zyppRes, value ); }
+    void sendPkgRemoveEnd        ( ZyppRes zyppRes )             { record( PkgCommitTimeline::RemoveEnd,     zyppRes ); emit pkgRemoveEnd    ( zyppRes ); }
     void sendPkgRemoveError      ( ZyppRes zyppRes,
-                                   const QString & msg )         { emit pkgRemoveError     ( zyppRes, msg );   }
+                                   const QString & msg )         { record( PkgCommitTimeline::PkgError,      zyppRes ); emit pkgRemoveError  ( zyppRes, msg ); }
+
+    void sendFileConflictsCheckStart()                           { record( PkgCommitTimeline::FileConflictsStart ); emit fileConflictsCheckStart(); }
+    void sendFileConflictsCheckProgress( int percent )           { sendProgress( FileConflictsProgress, ZyppRes(), percent ); }
+    void sendFileConflictsCheckResult( const QStringList & conflicts ) { record( PkgCommitTimeline::FileConflictsEnd ); emit fileConflictsCheckResult( conflicts ); }
+
+
+protected:
 
-    void sendFileConflictsCheckStart()                           { emit fileConflictsCheckStart();             }
-    void sendFileConflictsCheckProgress( int percent )           { emit fileConflictsCheckProgress( percent ); }
-    void sendFileConflictsCheckResult( const QStringList & conflicts ) { emit fileConflictsCheckResult( conflicts ); }
+    enum ProgressKind
+    {
+        NoProgress,
+        DownloadProgress,
+        InstallProgress,
+        RemoveProgress,
+        FileConflictsProgress
+    };
+
+    /**
+     * Send a progress signal of kind 'kind' or keep it pending if the last
+     * progress signal was sent less than one refresh interval ago.
+     **/
+    void sendProgress( ProgressKind kind, ZyppRes zyppRes, int value );
+
+    /**
+     * Send a pending coalesced progress signal. The caller has to lock
+     * _progressMutex.
+     **/
+    void flushProgressLocked();
+
+    /**
+     * Send a pending coalesced progress signal (so the GUI gets the last
+     * value before the next event) and record an event of type 'type' in
+     * the commit timeline.
+     **/
+    void record( PkgCommitTimeline::EventType type, ZyppRes zyppRes = ZyppRes() );
 
 
     //
     // Data members
     //
 
-    bool       _doAbort;
-    ErrorReply _reply;
+    QAtomicInt    _doAbort;
+    ErrorReply    _reply;
+
+    // Used in the commit thread and in the GUI thread (_flushTimer).
+    // The signals are always sent with _progressMutex locked, so they are
+    // queued in the same order in which they were sent.
+
+    QMutex        _progressMutex;
+    ProgressKind  _pendingKind;
+    PkgResInfo    _pendingRes;
+    int           _pendingValue;
+    QElapsedTimer _progressTimer;
+    int           _progressInterval; // millisec
+    bool          _flushScheduled;
+    QTimer        _flushTimer;       // lives in the GUI thread
 
     static PkgCommitSignalForwarder * _instance;
 };
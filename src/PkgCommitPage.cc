@@ -19,6 +19,8 @@
 
 #include <zypp/target/TargetException.h>
 
+#include <QElapsedTimer>
+#include <QEventLoop>
 #include <QSettings>
 #include <QTimer>
 #include <QMessageBox>
@@ -28,29 +30,75 @@
 #include "MainWindow.h"
 #include "PkgTasks.h"
 #include "PkgTaskListWidget.h"
+#include "PkgCommitTaskMover.h"
 #include "ProgressDialog.h"
 #include "MyrlynApp.h"
 #include "YQZypp.h"
 #include "YQi18n.h"
 #include "utf8.h"
 #include "PkgCommitCallbacks.h"
+#include "PkgCommitThread.h"
+#include "PkgCommitTimeline.h"
+#include "PkgHistoryIndex.h"
+#include "ReverseDepIndex.h"
+#include "YQPkgSelector.h"
 #include "PkgCommitPage.h"
 
 #define VERBOSE_PROGRESS        0
 #define VERBOSE_TRANSACT        1
 #define SORT_TO_DO_LIST         1
 
+// Packages per heap for simulating zypp::DownloadInHeaps with --fake-commit
+#define FAKE_COMMIT_HEAP_SIZE   20
+
 
 PkgCommitPage * PkgCommitPage::_instance = 0;
 
 
+/**
+ * Return the name of download mode 'mode' for the log and the settings.
+ **/
+static QString downloadModeName( zypp::DownloadMode mode )
+{
+    switch ( mode )
+    {
+        case zypp::DownloadDefault:     return "DownloadDefault";
+        case zypp::DownloadOnly:        return "DownloadOnly";
+        case zypp::DownloadInAdvance:   return "DownloadInAdvance";
+        case zypp::DownloadInHeaps:     return "DownloadInHeaps";
+        case zypp::DownloadAsNeeded:    return "DownloadAsNeeded";
+    }
+
+    return "DownloadDefault";
+}
+
+
+/**
+ * Return the download mode for 'name' or zypp::DownloadDefault if 'name' is
+ * not a known download mode name.
+ **/
+static zypp::DownloadMode downloadModeFromName( const QString & name )
+{
+    if ( name == "DownloadInAdvance" ) return zypp::DownloadInAdvance;
+    if ( name == "DownloadInHeaps"   ) return zypp::DownloadInHeaps;
+    if ( name == "DownloadAsNeeded"  ) return zypp::DownloadAsNeeded;
+
+    return zypp::DownloadDefault;
+}
+
+
 PkgCommitPage::PkgCommitPage( QWidget * parent )
     : QWidget( parent )
     , _ui( new Ui::PkgCommitPage ) // Use the Qt designer .ui form (XML)
     , _pkgTasks( 0 )
+    , _taskMover( 0 )
     , _showDetails( false )
-    , _startedInstallingPkg( false )
+    , _commitPhase( NoPhase )
+    , _downloadPhaseCount( 0 )
+    , _commitDownloadMode( zypp::DownloadDefault )
     , _fileConflictsProgressDialog( 0 )
+    , _commitThread( 0 )
+    , _commitMillisec( -1 )
 {
     CHECK_PTR( _ui );
     _ui->setupUi( this ); // Actually create the widgets from the .ui form
@@ -79,6 +127,7 @@ PkgCommitPage::PkgCommitPage( QWidget * parent )
 PkgCommitPage::~PkgCommitPage()
 {
     writeSettings();
+    delete _taskMover;
     delete _ui;
     // PkgCommitSignalForwarder::instance()->deleteLater();
 
@@ -101,16 +150,34 @@ void PkgCommitPage::connectWidgets()
 
 void PkgCommitPage::commit()
 {
+    _commitDownloadMode = MyrlynApp::isOptionSet( OptDownloadOnly ) ?
+        zypp::DownloadOnly : downloadMode();
+    _commitPhase        = NoPhase;
+    _downloadPhaseCount = 0;
+
+    logInfo() << "Download mode: " << downloadModeName( _commitDownloadMode ) << endl;
+
     populateLists();
     initProgressData();
-    _startedInstallingPkg = false;
     _ui->totalProgressBar->setValue( 0 );
     PkgCommitSignalForwarder::instance()->reset();
+    PkgCommitTimeline::instance()->start();
 
     if ( MyrlynApp::isOptionSet( OptFakeCommit ) )
         fakeCommit();
     else
         realCommit();
+
+    _commitMillisec = _commitTimer.elapsed();
+    updateRates( true );
+
+    for ( const QString & line: commitStats() )
+        logInfo() << line << endl;
+
+    logInfo() << "Download phases: " << _downloadPhaseCount << endl;
+
+    if ( ! Logger::lastLogDir().isEmpty() )
+        PkgCommitTimeline::instance()->writeTraceFiles( Logger::lastLogDir() );
 }
 
 
@@ -169,31 +236,114 @@ PkgTasks * PkgCommitPage::pkgTasks()
 }
 
 
+PkgCommitTaskMover * PkgCommitPage::taskMover()
+{
+    if ( ! _taskMover )
+    {
+        _taskMover = new PkgCommitTaskMover( pkgTasks(),
+                                             _ui->todoList,
+                                             _ui->downloadsList,
+                                             _ui->doingList,
+                                             _ui->doneList );
+        CHECK_NEW( _taskMover );
+    }
+
+    return _taskMover;
+}
+
+
 void PkgCommitPage::fakeCommit()
 {
     logInfo() << "Simulating package transactions" << endl;
 
-    QListWidgetItem * item = _ui->todoList->count() > 0 ?
-        _ui->todoList->item( 0 ) : 0;
+    // Replay the tasks through the same bookkeeping that the libzypp
+    // callbacks use during a real commit, just without libzypp.
+    //
+    // The simulated time per task keeps the whole replay at about 10 seconds
+    // for normal task counts; the log shows how much of the time was spent
+    // outside of that, i.e. for the bookkeeping and the UI updates.
+    //
+    // The download mode decides how many packages are downloaded before they
+    // are installed: All of them, a heap of them, or each one right before it
+    // is installed. zypp::DownloadOnly simulates only the downloads.
+
+    QList<PkgTask *> tasks = pkgTasks()->todo(); // The todo list changes below
+    int delay = tasks.isEmpty() ? 0 :
+        qBound( 0, 10 * 1000 * 1000 / (int) tasks.size(), 100 * 1000 ); // microseconds
 
-    for ( int i=1; i <= 100; ++i )
+    int  heapSize     = 1;
+    bool downloadOnly = _commitDownloadMode == zypp::DownloadOnly;
+
+    switch ( _commitDownloadMode )
     {
-        if ( PkgCommitSignalForwarder::instance()->doAbort() )
-            return;
+        case zypp::DownloadOnly:
+        case zypp::DownloadInAdvance: heapSize = qMax( 1, (int) tasks.size() ); break;
+        case zypp::DownloadInHeaps:   heapSize = FAKE_COMMIT_HEAP_SIZE;         break;
+        default:                      heapSize = 1;                             break;
+    }
 
-        if ( i == 20 && item )
-            item->setIcon( _downloadOngoingIcon );
+    PkgCommitTimeline * timeline = PkgCommitTimeline::instance();
+    int delayCount = 0;
 
-        if ( i == 60 && item )
-            item->setIcon( _downloadDoneIcon );
+    QElapsedTimer timer;
+    timer.start();
 
-        usleep( 100 * 1000 ); // microseconds
-        _ui->totalProgressBar->setValue( i );
-        updateListHeaders();
-        processEvents();
+    for ( int heapStart = 0; heapStart < tasks.size(); heapStart += heapSize )
+    {
+        int heapEnd = qMin( heapStart + heapSize, (int) tasks.size() );
+
+        for ( int i = heapStart; i < heapEnd; ++i )
+        {
+            PkgTask * task = tasks.at( i );
+
+            if ( PkgCommitSignalForwarder::instance()->doAbort() )
+                return;
+
+            if ( task->action() & PkgAdd )
+            {
+                timeline->addEvent( PkgCommitTimeline::DownloadStart, task->name() );
+                taskDownloadStart( task, false );
+
+                if ( downloadOnly )
+                {
+                    usleep( delay );
+                    ++delayCount;
+                }
+
+                taskDownloadEnd( task );
+                timeline->addEvent( PkgCommitTimeline::DownloadEnd, task->name() );
+            }
+        }
+
+        if ( downloadOnly )
+            continue;
+
+        for ( int i = heapStart; i < heapEnd; ++i )
+        {
+            PkgTask * task = tasks.at( i );
+            bool remove    = task->action() == PkgRemove;
+
+            if ( PkgCommitSignalForwarder::instance()->doAbort() )
+                return;
+
+            timeline->addEvent( remove ? PkgCommitTimeline::RemoveStart : PkgCommitTimeline::InstallStart,
+                                task->name() );
+            taskActionStart( task );
+            usleep( delay );
+            ++delayCount;
+            taskActionEnd( task );
+            timeline->addEvent( remove ? PkgCommitTimeline::RemoveEnd : PkgCommitTimeline::InstallEnd,
+                                task->name() );
+        }
     }
 
-    logInfo() << "Simulating transactions done" << endl;
+    qint64 elapsed = timer.elapsed(); // millisec
+    qint64 delays  = (qint64) delayCount * delay / 1000;
+
+    logInfo() << "Simulating " << tasks.size() << " transactions done after "
+              << elapsed / 1000.0 << " sec; without simulated delays: "
+              << ( elapsed - delays ) / 1000.0 << " sec"
+              << endl;
 }
 
 
@@ -201,24 +351,67 @@ void PkgCommitPage::realCommit()
 {
     processEvents();
 
-    // Create and install the callbacks.
-    // They are uninstalled when the 'callbacks' variable goes out of scope.
-    PkgCommitCallbacks callbacks;
-    PkgCommitSignalForwarder::instance()->reset();
+    // Run the libzypp commit in a separate thread so this (the GUI) thread
+    // can keep running a normal event loop: The callbacks send everything
+    // here with queued signals, and the window, the "Cancel" button and the
+    // window manager's close button remain responsive even while libzypp
+    // is busy with a long RPM scriptlet or a big download.
 
-    try
-    {
-        logInfo() << "Starting package transactions" << endl;
+    PkgCommitThread commitThread( commitPolicy() );
+    QEventLoop      eventLoop;
 
-        zypp::getZYpp()->commit( commitPolicy() );
+    connect( &commitThread, SIGNAL( finished() ),
+             &eventLoop,    SLOT  ( quit()     ) );
 
-        logInfo() << "Package transactions done" << endl;
-    }
-    catch ( const zypp::target::TargetAbortedException & ex )
-    {
+    // This event loop must not run anything that reads the pool while the
+    // commit thread changes it: Only the progress updates from the commit
+    // callbacks and the widgets of this page.
+
+    suspendPoolConsumers();
+
+    logInfo() << "Starting package transactions" << endl;
+
+    _commitThread = &commitThread;
+    commitThread.start();
+    eventLoop.exec();
+
+    // The event loop is also left when the application quits (see wmClose()).
+    // libzypp still needs to finish properly, and the commit thread might
+    // be waiting for a reply from this thread, so keep processing events.
+
+    while ( ! commitThread.wait( 100 ) ) // millisec
+        QCoreApplication::processEvents();
+
+    _commitThread = 0;
+    resumePoolConsumers();
+
+    if ( commitThread.aborted() )
         logInfo() << "libzypp aborted as requested" << endl;
-    }
+    else
+        logInfo() << "Package transactions done" << endl;
+
+    // libzypp appended the transactions to the history file (even if the
+    // commit failed halfway); if the history index is already in use, let it
+    // read just those new lines.
+
+    if ( PkgHistoryIndex::hasInstance() )
+        PkgHistoryIndex::instance()->update();
+
+    commitThread.rethrowException();
+}
+
+
+void PkgCommitPage::suspendPoolConsumers()
+{
+    ReverseDepIndex::instance()->suspend();
+    MyrlynApp::instance()->pkgSel()->suspendPoolAccess();
+}
+
 
+void PkgCommitPage::resumePoolConsumers()
+{
+    MyrlynApp::instance()->pkgSel()->resumePoolAccess();
+    ReverseDepIndex::instance()->resume();
 }
 
 
@@ -233,11 +426,12 @@ PkgCommitPage::commitPolicy() const
         policy.dryRun( true );
     }
 
-    if ( MyrlynApp::isOptionSet( OptDownloadOnly ) )
-    {
-        logInfo() << "download only" << endl;
-        policy.downloadMode( zypp::DownloadOnly );
-    }
+    // See commit(): _commitDownloadMode is also zypp::DownloadOnly with
+    // --download-only. With zypp::DownloadDefault, libzypp uses the one from
+    // zypp.conf or its own default.
+
+    if ( _commitDownloadMode != zypp::DownloadDefault )
+        policy.downloadMode( _commitDownloadMode );
 
     policy.allowDowngrade( true );
 
@@ -254,6 +448,11 @@ bool PkgCommitPage::showSummaryPage() const
 void PkgCommitPage::reset()
 {
     _ui->totalProgressBar->setValue( 0 );
+    _ui->downloadProgressBar->setValue( 0 );
+    _ui->installProgressBar->setValue( 0 );
+    _ui->downloadRateLabel->setText( "---" );
+    _ui->installRateLabel->setText( "---" );
+    _ui->remainingLabel->setText( "---" );
 
     _ui->todoList->clear();
     _ui->downloadsList->clear();
@@ -356,10 +555,12 @@ void PkgCommitPage::readSettings()
 
     _showDetails         = settings.value( "showDetails",  true ).toBool();
     bool showSummaryPage = settings.value( "showSummaryPage", true ).toBool();
+    QString downloadMode = settings.value( "downloadMode", "DownloadDefault" ).toString();
 
     settings.endGroup();
 
     _ui->showSummaryPageCheckBox->setChecked( showSummaryPage );
+    initDownloadModeComboBox( downloadModeFromName( downloadMode ) );
 }
 
 
@@ -371,12 +572,59 @@ void PkgCommitPage::writeSettings()
     settings.setValue( "showDetails",    _showDetails );
     settings.setValue( "showSummaryPage", showSummaryPage() );
 
+    // Don't save a download mode from the command line as the new default
+
+    if ( _ui->downloadModeComboBox->isEnabled() )
+        settings.setValue( "downloadMode", downloadModeName( downloadMode() ) );
+
     settings.endGroup();
 }
 
 
+void PkgCommitPage::initDownloadModeComboBox( zypp::DownloadMode mode )
+{
+    QComboBox * comboBox = _ui->downloadModeComboBox;
+
+    comboBox->clear();
+    comboBox->addItem( _( "Default"    ), (int) zypp::DownloadDefault   );
+    comboBox->addItem( _( "In Advance" ), (int) zypp::DownloadInAdvance );
+    comboBox->addItem( _( "In Heaps"   ), (int) zypp::DownloadInHeaps   );
+    comboBox->addItem( _( "As Needed"  ), (int) zypp::DownloadAsNeeded  );
+
+    // A download mode from the command line overrides the one from the
+    // settings; so does --download-only.
+
+    bool fromCommandLine = true;
+
+    if ( MyrlynApp::isOptionSet( OptDownloadInAdvance ) )
+        mode = zypp::DownloadInAdvance;
+    else if ( MyrlynApp::isOptionSet( OptDownloadInHeaps ) )
+        mode = zypp::DownloadInHeaps;
+    else if ( MyrlynApp::isOptionSet( OptDownloadAsNeeded ) )
+        mode = zypp::DownloadAsNeeded;
+    else
+        fromCommandLine = MyrlynApp::isOptionSet( OptDownloadOnly );
+
+    comboBox->setCurrentIndex( qMax( 0, comboBox->findData( (int) mode ) ) );
+    comboBox->setEnabled( ! fromCommandLine );
+}
+
+
+zypp::DownloadMode PkgCommitPage::downloadMode() const
+{
+    return (zypp::DownloadMode) _ui->downloadModeComboBox->currentData().toInt();
+}
+
+
 void PkgCommitPage::processEvents()
 {
+    // While the commit thread is running, the GUI thread runs its own event
+    // loop anyway; processing events here would only nest the slots that are
+    // connected to the commit thread's queued signals.
+
+    if ( _instance && _instance->_commitThread )
+        return;
+
     QCoreApplication::processEvents( QEventLoop::AllEvents,
                                      500 ); //millisec
 }
@@ -420,9 +668,176 @@ void PkgCommitPage::initProgressData()
     _pkgActionWeight    = 0.30;
     _pkgFixedCostWeight = 0.10;
 
+    if ( _commitDownloadMode == zypp::DownloadOnly )
+    {
+        // Nothing will be installed or removed, and no task will ever be
+        // completed: The downloads are all there is to it.
+
+        _pkgDownloadWeight  = 1.0;
+        _pkgActionWeight    = 0.0;
+        _pkgFixedCostWeight = 0.0;
+    }
+
     logDebug() << "pkgDownloadWeight:  " << _pkgDownloadWeight  << endl;
     logDebug() << "pkgActionWeight:    " << _pkgActionWeight    << endl;
     logDebug() << "pkgFixedCostWeight: " << _pkgFixedCostWeight << endl;
+
+    _downloadMeter.reset();
+    _installMeter.reset();
+    _rateDisplayTimer.invalidate();
+    _commitTimer.start();
+    _commitMillisec = -1;
+
+    updateRates( true ); // The first sample is the starting point
+}
+
+
+ByteCount PkgCommitPage::currentDownloadedSize()
+{
+    return _completedDownloadSize + pkgTasks()->downloads().runningDownloadSizeSum();
+}
+
+
+ByteCount PkgCommitPage::currentInstalledSize()
+{
+    return _completedInstalledSize + pkgTasks()->doing().runningInstalledSizeSum();
+}
+
+
+// Format a duration in seconds as "m:ss" or "h:mm:ss"
+
+static QString formatDuration( qint64 sec )
+{
+    if ( sec >= 3600 )
+    {
+        return QString( "%1:%2:%3" )
+            .arg( sec / 3600 )
+            .arg( ( sec / 60 ) % 60, 2, 10, QChar( '0' ) )
+            .arg( sec % 60,          2, 10, QChar( '0' ) );
+    }
+
+    return QString( "%1:%2" )
+        .arg( sec / 60 )
+        .arg( sec % 60, 2, 10, QChar( '0' ) );
+}
+
+
+// Format a rate in bytes per second like "3.2 MiB/s"
+
+static QString formatRate( double bytesPerSecond )
+{
+    ByteCount rate( (ByteCount::SizeType) bytesPerSecond );
+
+    // Translators: Transfer rate like "3.2 MiB/s"
+    return _( "%1/s" ).arg( fromUTF8( rate.asString() ) );
+}
+
+
+void PkgCommitPage::updateRates( bool force )
+{
+    _downloadMeter.addSample( currentDownloadedSize() );
+    _installMeter.addSample ( currentInstalledSize()  );
+
+    if ( ! force && _rateDisplayTimer.isValid() && _rateDisplayTimer.elapsed() < 500 )
+        return;
+
+    _rateDisplayTimer.start();
+
+    // Download vs. install progress split
+
+    int downloadPercent = 100;
+    int installPercent  = 100;
+
+    if ( _totalDownloadSize > 0 )
+        downloadPercent = (int) ( ( 100.0 * currentDownloadedSize() ) / _totalDownloadSize );
+
+    if ( _totalInstalledSize > 0 )
+        installPercent = (int) ( ( 100.0 * currentInstalledSize() ) / _totalInstalledSize );
+
+    _ui->downloadProgressBar->setValue( qBound( 0, downloadPercent, 100 ) );
+    _ui->installProgressBar->setValue ( qBound( 0, installPercent,  100 ) );
+
+
+    // Rates
+
+    double downloadRate = _downloadMeter.bytesPerSecond();
+    double installRate  = _installMeter.bytesPerSecond();
+
+    _ui->downloadRateLabel->setText( downloadRate > 0.0 ? formatRate( downloadRate ) : "---" );
+    _ui->installRateLabel->setText ( installRate  > 0.0 ? formatRate( installRate  ) : "---" );
+
+
+    // Remaining time
+
+    int sec = remainingSec();
+    _ui->remainingLabel->setText( sec >= 0 ? formatDuration( sec ) : "---" );
+}
+
+
+int PkgCommitPage::remainingSec()
+{
+    // Downloads and installations mostly alternate or happen one after the
+    // other, so the remaining times for both simply add up.
+
+    double sec = 0.0;
+
+    ByteCount remainingDownload = _totalDownloadSize  - currentDownloadedSize();
+    ByteCount remainingInstall  = _totalInstalledSize - currentInstalledSize();
+
+    if ( remainingDownload > 0 )
+    {
+        if ( _downloadMeter.bytesPerSecond() <= 0.0 )
+            return -1;
+
+        sec += remainingDownload / _downloadMeter.bytesPerSecond();
+    }
+
+    if ( remainingInstall > 0 && _commitDownloadMode != zypp::DownloadOnly )
+    {
+        if ( _installMeter.bytesPerSecond() <= 0.0 )
+            return -1;
+
+        sec += remainingInstall / _installMeter.bytesPerSecond();
+    }
+
+    return (int) ( sec + 0.5 );
+}
+
+
+QStringList PkgCommitPage::commitStats() const
+{
+    QStringList lines;
+
+    if ( _commitMillisec < 0 )
+        return lines;
+
+    qint64 totalSec = ( _commitMillisec + 500 ) / 1000;
+
+    lines << _( "Commit statistics:" );
+    lines << "";
+
+    if ( _downloadMeter.totalBytes() > 0 )
+    {
+        lines << QString( "  - " )
+            + _( "Downloaded %1 in %2 (%3)" )
+            .arg( fromUTF8( ByteCount( _downloadMeter.totalBytes() ).asString() ) )
+            .arg( formatDuration( ( _downloadMeter.activeMillisec() + 500 ) / 1000 ) )
+            .arg( formatRate( _downloadMeter.averageBytesPerSecond() ) );
+    }
+
+    if ( _installMeter.totalBytes() > 0 )
+    {
+        lines << QString( "  - " )
+            + _( "Installed / removed %1 in %2 (%3)" )
+            .arg( fromUTF8( ByteCount( _installMeter.totalBytes() ).asString() ) )
+            .arg( formatDuration( ( _installMeter.activeMillisec() + 500 ) / 1000 ) )
+            .arg( formatRate( _installMeter.averageBytesPerSecond() ) );
+    }
+
+    lines << QString( "  - " ) + _( "Total time: %1" ).arg( formatDuration( totalSec ) );
+    lines << "";
+
+    return lines;
 }
 
 
@@ -439,8 +854,7 @@ int PkgCommitPage::currentProgressPercent()
 
     if ( _totalDownloadSize > 0 )
     {
-        ByteCount downloadSize = _completedDownloadSize
-            + pkgTasks()->downloads().downloadSizeSum();
+        ByteCount downloadSize = currentDownloadedSize();
 
         percent = ( 100.0 * downloadSize ) / _totalDownloadSize;
     }
@@ -465,8 +879,7 @@ int PkgCommitPage::currentProgressPercent()
 
     if ( _totalInstalledSize > 0 )  // Prevent division by zero
     {
-        ByteCount installedSize = _completedInstalledSize
-            + pkgTasks()->doing().installedSizeSum();
+        ByteCount installedSize = currentInstalledSize();
 
         percent          = ( 100.0 * installedSize ) / _totalInstalledSize;
         installedPercent = percent * _pkgActionWeight;
@@ -516,6 +929,8 @@ int PkgCommitPage::currentProgressPercent()
 
 bool PkgCommitPage::updateTotalProgressBar()
 {
+    updateRates();
+
     bool didUpdate   = false;
     int  oldProgress = _ui->totalProgressBar->value();
     int  progress    = currentProgressPercent();
@@ -553,14 +968,13 @@ PkgCommitPage::fileConflictsProgressDialog()
 // PkgCommitCallback slots
 //
 
-void PkgCommitPage::pkgDownloadStart( ZyppRes zyppRes )
+void PkgCommitPage::pkgDownloadStart( const PkgResInfo & res )
 {
-    CHECK_PTR( zyppRes );
-    PkgTask * task = pkgTasks()->todo().find( zyppRes );
+    PkgTask * task = pkgTasks()->todo().find( res.ident );
 
     if ( ! task )
     {
-        logError() << "Can't find task for " << zyppRes << " in todo" << endl;
+        logError() << "Can't find task for " << res.name << " in todo" << endl;
         return;
     }
 
@@ -568,23 +982,11 @@ void PkgCommitPage::pkgDownloadStart( ZyppRes zyppRes )
     logVerbose() << task << endl;
 #endif
 
-    // Move the task from the todo list to the downloads list
-
-    PkgTasks::moveTask( task, pkgTasks()->todo(), pkgTasks()->downloads() );
-    task->setDownloadedPercent( 0 ); // Just to make sure
-
-    // Move the task from the todo list widget to the downloads list widget
-
-    _ui->todoList->removeTaskItem( task );
-    PkgTaskListWidgetItem * item = _ui->downloadsList->addTaskItem( task );
-    item->setIcon( _downloadOngoingIcon );
-    updateListHeaders();
-
-    processEvents(); // Update the UI
+    taskDownloadStart( task, false );
 }
 
 
-void PkgCommitPage::pkgDownloadProgress( ZyppRes zyppRes, int percent )
+void PkgCommitPage::pkgDownloadProgress( const PkgResInfo & res, int percent )
 {
     // Avoid unnecessary expensive progress updates:
     //
@@ -594,12 +996,11 @@ void PkgCommitPage::pkgDownloadProgress( ZyppRes zyppRes, int percent )
     if ( percent < 1 || percent > 99 )
         return;
 
-    CHECK_PTR( zyppRes );
-    PkgTask * task = pkgTasks()->downloads().find( zyppRes );
+    PkgTask * task = pkgTasks()->downloads().find( res.ident );
 
     if ( ! task )
     {
-        logError() << "Can't find task for " << zyppRes << " in downloads" << endl;
+        logError() << "Can't find task for " << res.name << " in downloads" << endl;
         return;
     }
 
@@ -619,14 +1020,13 @@ void PkgCommitPage::pkgDownloadProgress( ZyppRes zyppRes, int percent )
 }
 
 
-void PkgCommitPage::pkgDownloadEnd( ZyppRes zyppRes )
+void PkgCommitPage::pkgDownloadEnd( const PkgResInfo & res )
 {
-    CHECK_PTR( zyppRes );
-    PkgTask * task = pkgTasks()->downloads().find( zyppRes );
+    PkgTask * task = pkgTasks()->downloads().find( res.ident );
 
     if ( ! task )
     {
-        logError() << "Can't find task for " << zyppRes << " in downloads" << endl;
+        logError() << "Can't find task for " << res.name << " in downloads" << endl;
         return;
     }
 
@@ -634,29 +1034,17 @@ void PkgCommitPage::pkgDownloadEnd( ZyppRes zyppRes )
     logVerbose() << task << endl;
 #endif
 
-    task->setDownloadedPercent( 100 );
-    PkgTaskListWidgetItem * item = _ui->downloadsList->findTaskItem( task );
-
-    if ( item )
-    {
-        item->setIcon( _downloadDoneIcon );
-        processEvents();
-    }
-
-    // Important: Not adding the download size to _completedDownloadSize just
-    // yet, or it would be counted twice while the task is still in the doing
-    // list. That has to wait until it is moved to the doing list.
+    taskDownloadEnd( task );
 }
 
 
-void PkgCommitPage::pkgCachedNotify( ZyppRes zyppRes )
+void PkgCommitPage::pkgCachedNotify( const PkgResInfo & res )
 {
-    CHECK_PTR( zyppRes );
-    PkgTask * task = pkgTasks()->todo().find( zyppRes );
+    PkgTask * task = pkgTasks()->todo().find( res.ident );
 
     if ( ! task )
     {
-        logError() << "Can't find task for " << zyppRes << " in todo" << endl;
+        logError() << "Can't find task for " << res.name << " in todo" << endl;
         return;
     }
 
@@ -664,30 +1052,13 @@ void PkgCommitPage::pkgCachedNotify( ZyppRes zyppRes )
     logVerbose() << task << endl;
 #endif
 
-    // Move the task from the todo list to the downloads list
-
-    PkgTasks::moveTask( task, pkgTasks()->todo(), pkgTasks()->downloads() );
-    task->setDownloadedPercent( 100 );
-
-    // Move the task from the todo list widget to the downloads list widget
-
-    _ui->todoList->removeTaskItem( task );
-    PkgTaskListWidgetItem * item = _ui->downloadsList->addTaskItem( task );
-    item->setIcon( _downloadDoneIcon );
-    updateListHeaders();
-
-    processEvents(); // Update the UI
-
-
-    // Important: Not adding the download size to _completedDownloadSize just
-    // yet, or it would be counted twice while the task is still in the doing
-    // list. That has to wait until it is moved to the doing list.
+    taskDownloadStart( task, true );
 }
 
 
-void PkgCommitPage::pkgDownloadError( ZyppRes zyppRes, const QString & errorMsg )
+void PkgCommitPage::pkgDownloadError( const PkgResInfo & res, const QString & errorMsg )
 {
-    pkgActionError( zyppRes, errorMsg,
+    pkgActionError( res, errorMsg,
                     _( "Error downloading package %1" ),
                     __FUNCTION__ );
 }
@@ -696,46 +1067,27 @@ void PkgCommitPage::pkgDownloadError( ZyppRes zyppRes, const QString & errorMsg
 //----------------------------------------------------------------------
 
 
-void PkgCommitPage::pkgInstallStart( ZyppRes zyppRes )
+void PkgCommitPage::pkgInstallStart( const PkgResInfo & res )
 {
-    // While packages are being downloaded, the list always scrolls to the
-    // bottom, so the list appears to scroll like a text terminal as new output
-    // appears.
-    //
-    // But when we are installing the first package, the downloads phase is
-    // probably over, so scroll the downloads list widget to the top so the
-    // user can now see the packages that are probably installed next and how
-    // they move from the downloads list to the doing list.
-    //
-    // But only do that once: The user might choose to scroll the list
-    // manually, and we don't want to fight the user's actions every few
-    // seconds.
-
-    if ( ! _startedInstallingPkg )
-    {
-        _startedInstallingPkg = true;
-        _ui->downloadsList->scrollToTop();
-    }
-
-    pkgActionStart( zyppRes, PkgInstall, __FUNCTION__ );
+    pkgActionStart( res, PkgInstall, __FUNCTION__ );
 }
 
 
-void PkgCommitPage::pkgInstallProgress( ZyppRes zyppRes, int percent )
+void PkgCommitPage::pkgInstallProgress( const PkgResInfo & res, int percent )
 {
-    pkgActionProgress( zyppRes, percent, PkgInstall, __FUNCTION__ );
+    pkgActionProgress( res, percent, PkgInstall, __FUNCTION__ );
 }
 
 
-void PkgCommitPage::pkgInstallEnd( ZyppRes zyppRes )
+void PkgCommitPage::pkgInstallEnd( const PkgResInfo & res )
 {
-    pkgActionEnd( zyppRes, PkgInstall, __FUNCTION__ );
+    pkgActionEnd( res, PkgInstall, __FUNCTION__ );
 }
 
 
-void PkgCommitPage::pkgInstallError( ZyppRes zyppRes, const QString & errorMsg )
+void PkgCommitPage::pkgInstallError( const PkgResInfo & res, const QString & errorMsg )
 {
-    pkgActionError( zyppRes, errorMsg,
+    pkgActionError( res, errorMsg,
                     _( "Error installing package %1" ),
                     __FUNCTION__ );
 }
@@ -744,27 +1096,27 @@ void PkgCommitPage::pkgInstallError( ZyppRes zyppRes, const QString & errorMsg )
 //----------------------------------------------------------------------
 
 
-void PkgCommitPage::pkgRemoveStart( ZyppRes zyppRes )
+void PkgCommitPage::pkgRemoveStart( const PkgResInfo & res )
 {
-    pkgActionStart( zyppRes, PkgRemove, __FUNCTION__ );
+    pkgActionStart( res, PkgRemove, __FUNCTION__ );
 }
 
 
-void PkgCommitPage::pkgRemoveProgress( ZyppRes zyppRes, int percent )
+void PkgCommitPage::pkgRemoveProgress( const PkgResInfo & res, int percent )
 {
-    pkgActionProgress( zyppRes, percent, PkgRemove, __FUNCTION__ );
+    pkgActionProgress( res, percent, PkgRemove, __FUNCTION__ );
 }
 
 
-void PkgCommitPage::pkgRemoveEnd( ZyppRes zyppRes )
+void PkgCommitPage::pkgRemoveEnd( const PkgResInfo & res )
 {
-    pkgActionEnd( zyppRes, PkgRemove, __FUNCTION__ );
+    pkgActionEnd( res, PkgRemove, __FUNCTION__ );
 }
 
 
-void PkgCommitPage::pkgRemoveError( ZyppRes zyppRes, const QString & errorMsg )
+void PkgCommitPage::pkgRemoveError( const PkgResInfo & res, const QString & errorMsg )
 {
-    pkgActionError( zyppRes, errorMsg,
+    pkgActionError( res, errorMsg,
                     _( "Error installing package %1" ),
                     __FUNCTION__ );
 }
@@ -773,85 +1125,38 @@ void PkgCommitPage::pkgRemoveError( ZyppRes zyppRes, const QString & errorMsg )
 //----------------------------------------------------------------------
 
 
-void PkgCommitPage::pkgActionStart( ZyppRes       zyppRes,
-                                    PkgTaskAction action,
-                                    const char *  caller )
+void PkgCommitPage::pkgActionStart( const PkgResInfo & res,
+                                    PkgTaskAction      action,
+                                    const char *       caller )
 {
-    CHECK_PTR( zyppRes );
     PkgTask * task = 0;
 
-    // If we are already starting installing or removing packages,
-    // the time for checking file conflicts is definitely over;
-    // close the dialog. It doesn't hurt if it's already closed.
-
-    fileConflictsProgressDialog()->hide();
-
     if ( action & PkgAdd ) // PkgInstall | PkgUpdate
-    {
-        task = pkgTasks()->downloads().find( zyppRes );
-
-        if ( task )
-        {
-            // Move the task from the downloads list to the doing list
-            PkgTasks::moveTask( task, pkgTasks()->downloads(), pkgTasks()->doing() );
-
-            // Move the task from the downloads list widget to the doing list widget
-
-            _ui->downloadsList->removeTaskItem( task );
-            _ui->doingList->addTaskItem( task );
-            updateListHeaders();
-
-            // Update the bookkeeping sums.
-            // We already know that the task was in the downloads list.
-
-            if ( task->downloadSize() > 0 )
-                _completedDownloadSize += task->downloadSize();
-        }
-    }
+        task = pkgTasks()->downloads().find( res.ident );
 
     if ( ! task ) // PkgRemove or no download needed
-    {
-        task = pkgTasks()->todo().find( zyppRes );
-
-        if ( ! task )
-        {
-            logError() << caller << "(): "
-                       << "Can't find task for " << zyppRes
-                       << " in either downloads or todo" << endl;
-            return;
-        }
+        task = pkgTasks()->todo().find( res.ident );
 
-        // Move the task from the todo list to the doing list
-        PkgTasks::moveTask( task, pkgTasks()->todo(), pkgTasks()->doing() );
-
-        // Move the task from the todo list widget to the doing list widget
-
-        _ui->todoList->removeTaskItem( task );
-        _ui->doingList->addTaskItem( task );
-        updateListHeaders();
+    if ( ! task )
+    {
+        logError() << caller << "(): "
+                   << "Can't find task for " << res.name
+                   << " in either downloads or todo" << endl;
+        return;
     }
 
 #if VERBOSE_TRANSACT
     logVerbose() << task << endl;
 #endif
 
-    task->setDownloadedPercent( 100 ); // The download is complete for sure
-    task->setCompletedPercent( 0 );    // But the task itself isn't completed
-    processEvents(); // Update the UI
-
-    // No
-    //
-    //  _completedDownloadSize += task->downloadSize()
-    //
-    // here while the task is in the doing list, otherwise it would be
-    // summed up twice!
+    taskActionStart( task );
 }
 
 
-void PkgCommitPage::pkgActionProgress( ZyppRes       zyppRes,
-                                       int           percent,
-                                       PkgTaskAction action,
-                                       const char *  caller )
+void PkgCommitPage::pkgActionProgress( const PkgResInfo & res,
+                                       int                percent,
+                                       PkgTaskAction      action,
+                                       const char *       caller )
 {
     Q_UNUSED( action );
 
@@ -868,14 +1173,13 @@ void PkgCommitPage::pkgActionProgress( ZyppRes       zyppRes,
     if ( percent % 5 != 0 || percent <= 0 || percent >= 100 )
         return;
 
-    CHECK_PTR( zyppRes );
-    PkgTask * task = pkgTasks()->doing().find( zyppRes );
+    PkgTask * task = pkgTasks()->doing().find( res.ident );
 
     if ( ! task )
     {
         logError() << caller << "(): "
                    << "Can't find task for "
-                   << zyppRes << " in doing" << endl;
+                   << res.name << " in doing" << endl;
         return;
     }
 
@@ -895,18 +1199,16 @@ void PkgCommitPage::pkgActionProgress( ZyppRes       zyppRes,
 }
 
 
-void PkgCommitPage::pkgActionEnd( ZyppRes       zyppRes,
-                                  PkgTaskAction action,
-                                  const char *  caller )
+void PkgCommitPage::pkgActionEnd( const PkgResInfo & res,
+                                  PkgTaskAction      action,
+                                  const char *       caller )
 {
-    CHECK_PTR( zyppRes );
-
-    PkgTask * task = pkgTasks()->doing().find( zyppRes );
+    PkgTask * task = pkgTasks()->doing().find( res.ident );
 
     if ( ! task )
     {
         logError() << caller << "(): "
-                   << "Can't find task for " << zyppRes
+                   << "Can't find task for " << res.name
                    << " in doing" << endl;
         return;
     }
@@ -915,52 +1217,30 @@ void PkgCommitPage::pkgActionEnd( ZyppRes       zyppRes,
     logVerbose() << task << endl;
 #endif
 
-
-    // Move the task from the doing list to the done list
-
-    PkgTasks::moveTask( task, pkgTasks()->doing(), pkgTasks()->done() );
-    task->setDownloadedPercent( 100 );
-    task->setCompletedPercent( 100 ); // Just to make sure
-
-
-    // Move the task from the doing list widget to the done list widget
-
-    _ui->doingList->removeTaskItem( task );
-    _ui->doneList->addTaskItem( task );
-    updateListHeaders();
-
-
-    // Update the internal bookkeeping sums
-
-    ++_completedTasksCount;
-
-    if ( task->installedSize() > 0 )
-        _completedInstalledSize += task->installedSize();
-
-    // The task's download size has already be added to _completeDownloadSize
-    // when the task was moved from the downloads list to the doing list.
-
-
-    // Update the UI
-
-    updateTotalProgressBar(); // This may or may not be needed
-    processEvents();          // But this is needed for sure
+    taskActionEnd( task );
 }
 
 
-void PkgCommitPage::pkgActionError( ZyppRes         zyppRes,
-                                    const QString & zyppErrorMsg,
-                                    const QString & msgHeader,
-                                    const char *    caller     )
+void PkgCommitPage::pkgActionError( const PkgResInfo & res,
+                                    const QString &    zyppErrorMsg,
+                                    const QString &    msgHeader,
+                                    const char *       caller     )
 {
-    CHECK_PTR( zyppRes );
+    logError() << caller << "(): " << res.name << ": " << zyppErrorMsg << endl;
 
-    logError() << caller << "(): " << zyppRes << ": " << zyppErrorMsg << endl;
+    if ( PkgCommitSignalForwarder::instance()->doAbort() )
+    {
+        // The user already cancelled the commit or closed the window:
+        // Don't bother with a pop-up, just let libzypp abort.
+
+        PkgCommitSignalForwarder::instance()->setReply( AbortReply );
+        return;
+    }
 
     QString msg;
 
     if ( msgHeader.contains( "%1" ) )
-        msg = msgHeader.arg( fromUTF8( zyppRes->name() ) );
+        msg = msgHeader.arg( res.name );
 
     msg = QString( "<b>%1</b>\n\n" ).arg( msg );
 
@@ -983,27 +1263,26 @@ void PkgCommitPage::pkgActionError( ZyppRes         zyppRes,
     }
 
     // Using the PkgCommitSignalForwarder::setReply() kludge since we can't
-    // simply return a value from a Qt slot. But this only works with direct Qt
-    // signal / slot connections: When the signal is emitted, the connected
-    // slots are called immediately one after the other, and control flow only
-    // returns to the emitter when the last one returns.
+    // simply return a value from a Qt slot. This works because the error
+    // signals use a blocking queued connection: The commit thread waits until
+    // this slot returns, and only then it fetches the reply.
     //
     // That makes it safe to open the pop-up warning dialog and wait until the
     // user clicks on an answer button, and to set the reply before we return
-    // here. None of this would work with multiple Qt threads.
+    // here.
 
     PkgCommitSignalForwarder::instance()->setReply( reply );
 
 
     if ( reply != RetryReply )
     {
-        PkgTask * task = pkgTasks()->downloads().find( zyppRes );
+        PkgTask * task = pkgTasks()->downloads().find( res.ident );
 
         if ( task )
             PkgTasks::moveTask( task, pkgTasks()->downloads(), pkgTasks()->failed() );
         else
         {
-            task = pkgTasks()->doing().find( zyppRes );
+            task = pkgTasks()->doing().find( res.ident );
 
             if ( task )
                 PkgTasks::moveTask( task, pkgTasks()->doing(), pkgTasks()->failed() );
@@ -1014,12 +1293,158 @@ void PkgCommitPage::pkgActionError( ZyppRes         zyppRes,
         if ( ! task )
         {
             logError() << caller << "(): "
-                       << "Can't find task for " << zyppRes << endl;
+                       << "Can't find task for " << res.name << endl;
         }
     }
 }
 
 
+//----------------------------------------------------------------------
+
+//
+// Task bookkeeping, shared between the libzypp callbacks and fakeCommit()
+//
+
+void PkgCommitPage::setCommitPhase( CommitPhase phase )
+{
+    if ( phase == _commitPhase )
+        return;
+
+    _commitPhase = phase;
+
+    if ( phase == DownloadPhase )
+        ++_downloadPhaseCount;
+
+    // With zypp::DownloadAsNeeded, the phases change with every package, and
+    // there is never more than one package in the downloads list.
+
+    if ( _commitDownloadMode == zypp::DownloadAsNeeded )
+        return;
+
+    if ( phase == DownloadPhase )
+    {
+        logInfo() << "Download phase #" << _downloadPhaseCount << ": "
+                  << pkgTasks()->todo().size() << " tasks to do" << endl;
+    }
+    else if ( phase == ActionPhase )
+    {
+        logInfo() << "Install / remove phase after download phase #"
+                  << _downloadPhaseCount << ": "
+                  << pkgTasks()->downloads().size() << " downloaded packages"
+                  << endl;
+
+        // While packages are being downloaded, the downloads list always
+        // scrolls to the bottom, so the list appears to scroll like a text
+        // terminal as new output appears.
+        //
+        // But now that a download phase is over, scroll the downloads list
+        // widget to the top so the user can see the packages that are
+        // probably installed next and how they move from the downloads list
+        // to the doing list.
+        //
+        // Only do that once for each heap of downloads: The user might
+        // choose to scroll the list manually, and we don't want to fight the
+        // user's actions every few seconds.
+
+        _ui->downloadsList->scrollToTop();
+    }
+}
+
+
+void PkgCommitPage::taskDownloadStart( PkgTask * task, bool cached )
+{
+    setCommitPhase( DownloadPhase );
+
+    // Move the task from the todo list and its widget to the downloads list
+    // and its widget
+
+    PkgTaskListWidgetItem * item = taskMover()->downloadStart( task, cached );
+    item->setIcon( cached ? _downloadDoneIcon : _downloadOngoingIcon );
+    updateListHeaders();
+
+    processEvents(); // Update the UI
+
+    // Important: Not adding the download size to _completedDownloadSize just
+    // yet, or it would be counted twice while the task is still in the doing
+    // list. That has to wait until it is moved to the doing list.
+}
+
+
+void PkgCommitPage::taskDownloadEnd( PkgTask * task )
+{
+    PkgTaskListWidgetItem * item = taskMover()->downloadEnd( task );
+
+    if ( item )
+    {
+        item->setIcon( _downloadDoneIcon );
+        processEvents();
+    }
+
+    // See taskDownloadStart() why _completedDownloadSize is not updated here.
+}
+
+
+void PkgCommitPage::taskActionStart( PkgTask * task )
+{
+    // If we are already starting installing or removing packages,
+    // the time for checking file conflicts is definitely over;
+    // close the dialog. It doesn't hurt if it's already closed.
+
+    fileConflictsProgressDialog()->hide();
+    setCommitPhase( ActionPhase );
+
+    // Move the task from the downloads list or from the todo list
+    // (PkgRemove or no download needed) to the doing list and their widgets
+
+    bool downloaded = taskMover()->actionStart( task );
+
+    if ( downloaded && task->downloadSize() > 0 )
+    {
+        // Update the bookkeeping sums.
+        // We already know that the task was in the downloads list.
+
+        _completedDownloadSize += task->downloadSize();
+    }
+
+    updateListHeaders();
+    processEvents(); // Update the UI
+
+    // No
+    //
+    //  _completedDownloadSize += task->downloadSize()
+    //
+    // here while the task is in the doing list, otherwise it would be
+    // summed up twice!
+}
+
+
+void PkgCommitPage::taskActionEnd( PkgTask * task )
+{
+    // Move the task from the doing list and its widget to the done list and
+    // its widget
+
+    taskMover()->actionEnd( task );
+    updateListHeaders();
+
+
+    // Update the internal bookkeeping sums
+
+    ++_completedTasksCount;
+
+    if ( task->installedSize() > 0 )
+        _completedInstalledSize += task->installedSize();
+
+    // The task's download size has already be added to _completeDownloadSize
+    // when the task was moved from the downloads list to the doing list.
+
+
+    // Update the UI
+
+    updateTotalProgressBar(); // This may or may not be needed
+    processEvents();          // But this is needed for sure
+}
+
+
 //----------------------------------------------------------------------
 
 
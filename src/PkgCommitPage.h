@@ -19,12 +19,15 @@
 #define PkgCommitPage_h
 
 
+#include <QElapsedTimer>
 #include <QStringList>
 #include <QWidget>
 
 #include <zypp/ZYppCommitPolicy.h>
 
 #include "YQZypp.h"     // ZyppRes
+#include "PkgCommitCallbacks.h" // PkgResInfo
+#include "ThroughputMeter.h"
 
 
 // Generated with 'uic' from a Qt designer .ui form: pkg-commit.ui
@@ -36,6 +39,8 @@
 
 
 class ProgressDialog;
+class PkgCommitThread;
+class PkgCommitTaskMover;
 using zypp::ByteCount;
 
 
@@ -94,10 +99,11 @@ public:
     /**
      * Start the package transactions.
      *
-     * The passes control mostly to libzypp which has to call callbacks to
-     * update the widgets reporting the progress. The callbacks will also do a
-     * little Qt event processing (some milliseconds) to give the user a chance
-     * to use the "Cancel" button or other interactive widgets.
+     * The passes control mostly to libzypp in a separate thread
+     * (PkgCommitThread). Its callbacks send queued signals to update the
+     * widgets reporting the progress while this thread runs an event loop,
+     * so the user can use the "Cancel" button or other interactive widgets
+     * at any time.
      *
      * When this function returns (which will take a while), all the package
      * transactions should be done, or there was an unrecoverable error.
@@ -109,6 +115,22 @@ public:
      **/
     bool showSummaryPage() const;
 
+    /**
+     * Return the download mode for the next commit: The one from the command
+     * line (--download-in-advance etc.) if there is one, otherwise the one
+     * selected in the download mode combo box. zypp::DownloadDefault lets
+     * libzypp decide.
+     **/
+    zypp::DownloadMode downloadMode() const;
+
+    /**
+     * Return the final throughput numbers of the last commit as text lines
+     * for the summary page: The downloaded and installed sizes, the time
+     * spent and the average rates. Return an empty list if there was no
+     * commit yet.
+     **/
+    QStringList commitStats() const;
+
     /**
      * Return the UI (the widget tree) of this page.
      **/
@@ -117,8 +139,10 @@ public:
     /**
      * Process the pending Qt events.
      *
-     * This is necessary in callbacks to receive user events (e.g. button
-     * clicks) and to update the display.
+     * This is necessary during a fake commit to receive user events
+     * (e.g. button clicks) and to update the display. During a real commit,
+     * this does nothing: The GUI thread is running an event loop anyway while
+     * the commit thread is busy.
      *
      * DO NOT use MainWindow::processEvents() instead which might ignore user
      * input events (e.g. clicks on buttons).
@@ -174,23 +198,23 @@ public slots:
     // PkgCommitCallback slots
     //
 
-    void pkgDownloadStart    ( ZyppRes zyppRes );
-    void pkgDownloadProgress ( ZyppRes zyppRes, int value );
-    void pkgDownloadEnd      ( ZyppRes zyppRes );
+    void pkgDownloadStart    ( const PkgResInfo & res );
+    void pkgDownloadProgress ( const PkgResInfo & res, int value );
+    void pkgDownloadEnd      ( const PkgResInfo & res );
 
-    void pkgCachedNotify     ( ZyppRes zyppRes );
-    void pkgDownloadError    ( ZyppRes zyppRes, const QString & msg );
+    void pkgCachedNotify     ( const PkgResInfo & res );
+    void pkgDownloadError    ( const PkgResInfo & res, const QString & msg );
 
 
-    void pkgInstallStart     ( ZyppRes zyppRes );
-    void pkgInstallProgress  ( ZyppRes zyppRes, int value );
-    void pkgInstallEnd       ( ZyppRes zyppRes );
-    void pkgInstallError     ( ZyppRes zyppRes, const QString & msg );
+    void pkgInstallStart     ( const PkgResInfo & res );
+    void pkgInstallProgress  ( const PkgResInfo & res, int value );
+    void pkgInstallEnd       ( const PkgResInfo & res );
+    void pkgInstallError     ( const PkgResInfo & res, const QString & msg );
 
-    void pkgRemoveStart      ( ZyppRes zyppRes );
-    void pkgRemoveProgress   ( ZyppRes zyppRes, int value );
-    void pkgRemoveEnd        ( ZyppRes zyppRes );
-    void pkgRemoveError      ( ZyppRes zyppRes, const QString & msg );
+    void pkgRemoveStart      ( const PkgResInfo & res );
+    void pkgRemoveProgress   ( const PkgResInfo & res, int value );
+    void pkgRemoveEnd        ( const PkgResInfo & res );
+    void pkgRemoveError      ( const PkgResInfo & res, const QString & msg );
 
     void fileConflictsCheckStart();
     void fileConflictsCheckProgress( int percent );
@@ -216,19 +240,59 @@ protected:
     void realCommit();
 
     /**
-     * A visual fake for committing packages: Just moving the progress bar
-     * ahead, not actually installing packages.
+     * A visual fake for committing packages: Replay all tasks through the
+     * same bookkeeping as a real commit, not actually installing packages.
+     * This also logs how long the bookkeeping took, so it doubles as a
+     * benchmark for large transactions.
      *
      * Use the '--fake-commit' command line option to trigger this rather than
      * the real commit.
      **/
     void fakeCommit();
 
+    /**
+     * Stop everything that reads the pool from the GUI event loop on its
+     * own, like the reverse dependency index build and the debounced solver
+     * and disk usage updates of the package selector.
+     **/
+    void suspendPoolConsumers();
+
+    /**
+     * Restart everything that was stopped with suspendPoolConsumers().
+     **/
+    void resumePoolConsumers();
+
     /**
      * Return a commit policy based on the app's options.
      **/
     zypp::ZYppCommitPolicy commitPolicy() const;
 
+    /**
+     * The phases of a commit as far as the task lists are concerned:
+     * Downloading packages or installing / removing them.
+     *
+     * With zypp::DownloadInAdvance, there is one download phase followed by
+     * one action phase; with zypp::DownloadInHeaps, they alternate for each
+     * heap of packages; with zypp::DownloadAsNeeded, for each package.
+     **/
+    enum CommitPhase
+    {
+        NoPhase,
+        DownloadPhase,
+        ActionPhase
+    };
+
+    /**
+     * Switch to commit phase 'phase' if it is not already the current one.
+     **/
+    void setCommitPhase( CommitPhase phase );
+
+    /**
+     * Fill the download mode combo box and select 'mode'.
+     * Disable it if the download mode was set from the command line.
+     **/
+    void initDownloadModeComboBox( zypp::DownloadMode mode );
+
     /**
      * Fill the list widgets with content from the app's pkgTasks() lists.
      **/
@@ -290,6 +354,12 @@ protected:
      **/
     PkgTasks * pkgTasks();
 
+    /**
+     * Get the task mover that moves the tasks between the task lists and
+     * the list widgets; create it if necessary.
+     **/
+    PkgCommitTaskMover * taskMover();
+
     /**
      * Initialize and calculate the values for the overall progress.
      **/
@@ -299,9 +369,38 @@ protected:
      * Calculate the current progress percent based on the weighted progress
      * percent of number of completed tasks, completed download size, completed
      * install size.
+     *
+     * This is O(1): The partial sizes of the tasks that are currently being
+     * downloaded or done come from the running sums of those task lists.
      **/
     int currentProgressPercent();
 
+    /**
+     * Return the download size that is completed so far, including the
+     * partial downloads in progress.
+     **/
+    ByteCount currentDownloadedSize();
+
+    /**
+     * Return the installed size that is completed so far, including the
+     * partial installations in progress.
+     **/
+    ByteCount currentInstalledSize();
+
+    /**
+     * Feed the throughput meters with the current sizes and update the rate
+     * labels, the download / install progress bars and the remaining time
+     * estimate. To avoid flicker, the widgets are only updated every half
+     * second unless 'force' is 'true'.
+     **/
+    void updateRates( bool force = false );
+
+    /**
+     * Return the estimated remaining time in seconds based on the current
+     * download and install rates, or -1 if there is no estimate yet.
+     **/
+    int remainingSec();
+
     /**
      * Calculate the total progress and update the total progress bar if the
      * (integer) percent value is different from the old one.
@@ -327,23 +426,43 @@ protected:
      * 'action' is one of PkgInstall or PkgRemove,
      * 'caller' is the calling function (__FUNCTION__) for logging.
      **/
-    void pkgActionStart   ( ZyppRes         zyppRes,
-                            PkgTaskAction   action,
-                            const char *    caller );
+    void pkgActionStart   ( const PkgResInfo & res,
+                            PkgTaskAction      action,
+                            const char *       caller );
 
-    void pkgActionProgress( ZyppRes         zyppRes,
-                            int             percent,
-                            PkgTaskAction   action,
-                            const char *    caller );
+    void pkgActionProgress( const PkgResInfo & res,
+                            int                percent,
+                            PkgTaskAction      action,
+                            const char *       caller );
 
-    void pkgActionEnd     ( ZyppRes         zyppRes,
-                            PkgTaskAction   action,
-                            const char *    caller );
+    void pkgActionEnd     ( const PkgResInfo & res,
+                            PkgTaskAction      action,
+                            const char *       caller );
 
-    void pkgActionError   ( ZyppRes         zyppRes,
-                            const QString & errorMsg,
-                            const QString & msgHeader,
-                            const char *    caller );
+    void pkgActionError   ( const PkgResInfo & res,
+                            const QString &    errorMsg,
+                            const QString &    msgHeader,
+                            const char *       caller );
+
+    /**
+     * The task bookkeeping for the callbacks above once the task for a
+     * resolvable is found: Move the task between the task lists and the list
+     * widgets with the task mover and update the icons, the commit phase and
+     * the progress sums.
+     *
+     * These are also used by fakeCommit() to replay the tasks without
+     * libzypp; test/pkg-tasks-benchmark replays them with the same task
+     * mover.
+     *
+     * taskDownloadStart() expects the task in the todo list,
+     * taskDownloadEnd() in the downloads list,
+     * taskActionStart() in the downloads or the todo list,
+     * taskActionEnd() in the doing list.
+     **/
+    void taskDownloadStart( PkgTask * task, bool cached );
+    void taskDownloadEnd  ( PkgTask * task );
+    void taskActionStart  ( PkgTask * task );
+    void taskActionEnd    ( PkgTask * task );
 
     //
     // Data members
@@ -351,9 +470,13 @@ protected:
 
     Ui::PkgCommitPage * _ui;
     PkgTasks *          _pkgTasks;
+    PkgCommitTaskMover * _taskMover;
     bool                _showDetails;
-    bool                _startedInstallingPkg;
+    CommitPhase         _commitPhase;
+    int                 _downloadPhaseCount;
+    zypp::DownloadMode  _commitDownloadMode; // of the current commit
     ProgressDialog *    _fileConflictsProgressDialog;
+    PkgCommitThread *   _commitThread;
 
     ByteCount           _totalDownloadSize;
     ByteCount           _totalInstalledSize;
@@ -363,6 +486,12 @@ protected:
     ByteCount           _completedInstalledSize;
     int                 _completedTasksCount;
 
+    ThroughputMeter     _downloadMeter;
+    ThroughputMeter     _installMeter;
+    QElapsedTimer       _rateDisplayTimer;
+    QElapsedTimer       _commitTimer;
+    qint64              _commitMillisec;
+
     float               _pkgFixedCostWeight; // 0.0 .. 1.0
     float               _pkgDownloadWeight;  // 0.0 .. 1.0
     float               _pkgActionWeight;    // 0.0 .. 1.0
@@ -0,0 +1,94 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include "Exception.h"
+#include "PkgTasks.h"
+#include "PkgTaskListWidget.h"
+#include "PkgCommitTaskMover.h"
+
+
+PkgCommitTaskMover::PkgCommitTaskMover( PkgTasks *          pkgTasks,
+                                        PkgTaskListWidget * todoList,
+                                        PkgTaskListWidget * downloadsList,
+                                        PkgTaskListWidget * doingList,
+                                        PkgTaskListWidget * doneList )
+    : _pkgTasks( pkgTasks )
+    , _todoList( todoList )
+    , _downloadsList( downloadsList )
+    , _doingList( doingList )
+    , _doneList( doneList )
+{
+    CHECK_PTR( _pkgTasks      );
+    CHECK_PTR( _todoList      );
+    CHECK_PTR( _downloadsList );
+    CHECK_PTR( _doingList     );
+    CHECK_PTR( _doneList      );
+}
+
+
+PkgTaskListWidgetItem * PkgCommitTaskMover::downloadStart( PkgTask * task, bool cached )
+{
+    PkgTasks::moveTask( task, _pkgTasks->todo(), _pkgTasks->downloads() );
+    task->setDownloadedPercent( cached ? 100 : 0 );
+
+    _todoList->removeTaskItem( task );
+
+    return _downloadsList->addTaskItem( task );
+}
+
+
+PkgTaskListWidgetItem * PkgCommitTaskMover::downloadEnd( PkgTask * task )
+{
+    task->setDownloadedPercent( 100 );
+
+    return _downloadsList->findTaskItem( task );
+}
+
+
+bool PkgCommitTaskMover::actionStart( PkgTask * task )
+{
+    bool downloaded = task->list() == &_pkgTasks->downloads();
+
+    if ( downloaded )
+    {
+        PkgTasks::moveTask( task, _pkgTasks->downloads(), _pkgTasks->doing() );
+        _downloadsList->removeTaskItem( task );
+    }
+    else // PkgRemove or no download needed
+    {
+        PkgTasks::moveTask( task, _pkgTasks->todo(), _pkgTasks->doing() );
+        _todoList->removeTaskItem( task );
+    }
+
+    _doingList->addTaskItem( task );
+
+    task->setDownloadedPercent( 100 ); // The download is complete for sure
+    task->setCompletedPercent( 0 );    // But the task itself isn't completed
+
+    return downloaded;
+}
+
+
+void PkgCommitTaskMover::actionEnd( PkgTask * task )
+{
+    PkgTasks::moveTask( task, _pkgTasks->doing(), _pkgTasks->done() );
+    task->setDownloadedPercent( 100 );
+    task->setCompletedPercent( 100 ); // Just to make sure
+
+    _doingList->removeTaskItem( task );
+    _doneList->addTaskItem( task );
+}
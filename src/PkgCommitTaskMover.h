@@ -0,0 +1,93 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#ifndef PkgCommitTaskMover_h
+#define PkgCommitTaskMover_h
+
+
+class PkgTask;
+class PkgTasks;
+class PkgTaskListWidget;
+class PkgTaskListWidgetItem;
+
+
+/**
+ * The task bookkeeping of the package commit: Move the tasks between the
+ * task lists of PkgTasks and the corresponding list widgets as libzypp
+ * reports the downloads and the install / remove actions.
+ *
+ * This is what PkgCommitPage does for every libzypp callback and for every
+ * simulated task of its fakeCommit(); the icons, the commit phases and the
+ * progress sums remain in PkgCommitPage.
+ *
+ * This does not take ownership of the task lists or of the widgets.
+ **/
+class PkgCommitTaskMover
+{
+public:
+
+    /**
+     * Constructor.
+     **/
+    PkgCommitTaskMover( PkgTasks *          pkgTasks,
+                        PkgTaskListWidget * todoList,
+                        PkgTaskListWidget * downloadsList,
+                        PkgTaskListWidget * doingList,
+                        PkgTaskListWidget * doneList );
+
+    /**
+     * Move a task from the todo list to the downloads list when its download
+     * starts, or when libzypp found it in the package cache ('cached').
+     *
+     * Return the new item in the downloads list widget.
+     **/
+    PkgTaskListWidgetItem * downloadStart( PkgTask * task, bool cached );
+
+    /**
+     * Mark the download of a task in the downloads list as complete.
+     *
+     * Return its item in the downloads list widget or 0 if there is none.
+     **/
+    PkgTaskListWidgetItem * downloadEnd( PkgTask * task );
+
+    /**
+     * Move a task from the downloads list or, if it didn't need a download,
+     * from the todo list to the doing list when libzypp starts installing or
+     * removing it.
+     *
+     * Return 'true' if it came from the downloads list, 'false' if not.
+     **/
+    bool actionStart( PkgTask * task );
+
+    /**
+     * Move a task from the doing list to the done list when libzypp is done
+     * installing or removing it.
+     **/
+    void actionEnd( PkgTask * task );
+
+
+protected:
+
+    PkgTasks *          _pkgTasks;
+    PkgTaskListWidget * _todoList;
+    PkgTaskListWidget * _downloadsList;
+    PkgTaskListWidget * _doingList;
+    PkgTaskListWidget * _doneList;
+};
+
+
+#endif // PkgCommitTaskMover_h
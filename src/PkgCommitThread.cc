@@ -0,0 +1,78 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <zypp/ZYpp.h>
+#include <zypp/ZYppFactory.h>
+#include <zypp/target/TargetException.h>
+
+#include "FlightRecorder.h"
+#include "PkgCommitCallbacks.h"
+#include "PkgCommitThread.h"
+
+
+PkgCommitThread::PkgCommitThread( const zypp::ZYppCommitPolicy & policy,
+                                  QObject *                     parent )
+    : QThread( parent )
+    , _policy( policy )
+    , _aborted( false )
+{
+}
+
+
+PkgCommitThread::~PkgCommitThread()
+{
+    wait();
+}
+
+
+void PkgCommitThread::run()
+{
+    // No logging here: The logger is only used from the GUI thread.
+
+    FlightRecorder::installAltStack();
+
+    // Create and install the callbacks.
+    // They are uninstalled when the 'callbacks' variable goes out of scope.
+    PkgCommitCallbacks callbacks;
+
+    try
+    {
+        zypp::getZYpp()->commit( _policy );
+    }
+    catch ( const zypp::target::TargetAbortedException & )
+    {
+        _aborted = true;
+    }
+    catch ( ... )
+    {
+        // An exception must not leave the thread function;
+        // hand it over to the GUI thread.
+
+        _exception = std::current_exception();
+    }
+
+    // Don't keep the last progress value pending
+    PkgCommitSignalForwarder::instance()->flushProgress();
+}
+
+
+void PkgCommitThread::rethrowException() const
+{
+    if ( _exception )
+        std::rethrow_exception( _exception );
+}
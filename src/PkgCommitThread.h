@@ -0,0 +1,89 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef PkgCommitThread_h
+#define PkgCommitThread_h
+
+
+#include <exception>    // std::exception_ptr
+
+#include <QThread>
+
+#include <zypp/ZYppCommitPolicy.h>
+
+
+/**
+ * Thread for the libzypp package commit, i.e. for
+ * zypp::getZYpp()->commit().
+ *
+ * This installs the PkgCommitCallbacks in this thread, so all the libzypp
+ * callbacks are called in this thread, and they forward everything to the GUI
+ * thread with queued Qt signals (see PkgCommitSignalForwarder). The GUI thread
+ * can keep running its normal event loop while this thread is busy.
+ *
+ * Nothing in the GUI thread may use libzypp while this thread is running.
+ **/
+class PkgCommitThread: public QThread
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructor. Use start() to start the commit.
+     **/
+    PkgCommitThread( const zypp::ZYppCommitPolicy & policy,
+                     QObject *                     parent = 0 );
+
+    /**
+     * Destructor. This waits until the thread is finished.
+     **/
+    virtual ~PkgCommitThread();
+
+    /**
+     * Return 'true' if libzypp aborted the commit as requested.
+     * Only meaningful after the thread is finished.
+     **/
+    bool aborted() const { return _aborted; }
+
+    /**
+     * Throw the exception that the commit threw, if there was any.
+     *
+     * Call this in the GUI thread after the thread is finished so exceptions
+     * are handled there just like before the commit was moved to a thread.
+     **/
+    void rethrowException() const;
+
+
+protected:
+
+    /**
+     * The thread function.
+     *
+     * Reimplemented from QThread.
+     **/
+    virtual void run() override;
+
+
+    zypp::ZYppCommitPolicy _policy;
+    bool                   _aborted;
+    std::exception_ptr     _exception;
+};
+
+
+#endif // PkgCommitThread_h
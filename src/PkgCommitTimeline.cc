@@ -0,0 +1,364 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <algorithm>    // std::sort()
+
+#include <QFile>
+#include <QHash>
+#include <QMutexLocker>
+#include <QTextStream>
+
+#include "Logger.h"
+#include "Exception.h"
+#include "YQi18n.h"
+#include "PkgCommitTimeline.h"
+
+
+// Chrome trace_event thread IDs: One lane for each kind of activity
+
+#define TID_DOWNLOADS           1
+#define TID_INSTALL_REMOVE      2
+#define TID_FILE_CONFLICTS      3
+
+
+PkgCommitTimeline * PkgCommitTimeline::_instance = 0;
+
+
+PkgCommitTimeline * PkgCommitTimeline::instance()
+{
+    if ( ! _instance )
+    {
+        _instance = new PkgCommitTimeline();
+        CHECK_NEW( _instance );
+    }
+
+    return _instance;
+}
+
+
+void PkgCommitTimeline::start()
+{
+    QMutexLocker locker( &_mutex );
+
+    _events.clear();
+    _clock.start();
+}
+
+
+void PkgCommitTimeline::addEvent( EventType type, const QString & pkgName )
+{
+    QMutexLocker locker( &_mutex );
+
+    if ( ! _clock.isValid() )
+        _clock.start();
+
+    _events << Event { _clock.nsecsElapsed() / 1000, type, pkgName };
+}
+
+
+bool PkgCommitTimeline::isEmpty() const
+{
+    QMutexLocker locker( &_mutex );
+
+    return _events.isEmpty();
+}
+
+
+QList<PkgCommitTimeline::Event> PkgCommitTimeline::events() const
+{
+    QMutexLocker locker( &_mutex );
+
+    return _events;
+}
+
+
+QList<PkgCommitTimeline::Span> PkgCommitTimeline::spans() const
+{
+    QList<Span> spans;
+    QHash<QString, qint64> downloadStart;
+    QHash<QString, qint64> actionStart;
+    qint64 fileConflictsStart = -1;
+
+    for ( const Event & event: events() )
+    {
+        switch ( event.type )
+        {
+            case DownloadStart:
+                downloadStart[ event.pkgName ] = event.usec;
+                break;
+
+            case InstallStart:
+            case RemoveStart:
+                actionStart[ event.pkgName ] = event.usec;
+                break;
+
+            case FileConflictsStart:
+                fileConflictsStart = event.usec;
+                break;
+
+            case DownloadEnd:
+                if ( downloadStart.contains( event.pkgName ) )
+                {
+                    qint64 startUsec = downloadStart.take( event.pkgName );
+                    spans << Span { event.pkgName, "download", startUsec, event.usec - startUsec };
+                }
+                break;
+
+            case InstallEnd:
+            case RemoveEnd:
+                if ( actionStart.contains( event.pkgName ) )
+                {
+                    qint64 startUsec = actionStart.take( event.pkgName );
+                    spans << Span { event.pkgName,
+                                    event.type == InstallEnd ? "install" : "remove",
+                                    startUsec, event.usec - startUsec };
+                }
+                break;
+
+            case FileConflictsEnd:
+                if ( fileConflictsStart >= 0 )
+                {
+                    spans << Span { "", "file conflicts", fileConflictsStart,
+                                    event.usec - fileConflictsStart };
+                    fileConflictsStart = -1;
+                }
+                break;
+
+            case CacheHit:
+            case PkgError:
+                // Instant events; not part of any span
+                break;
+        }
+    }
+
+    return spans;
+}
+
+
+bool PkgCommitTimeline::writeTraceFiles( const QString & dir ) const
+{
+    if ( isEmpty() )
+        return true;
+
+    bool ok = writeChromeTrace( dir + "/commit-trace.json" );
+    ok = writeCsv( dir + "/commit-trace.csv" ) && ok;
+
+    return ok;
+}
+
+
+/**
+ * Return 'str' escaped for use in a JSON string literal.
+ **/
+static QString jsonEscaped( const QString & str )
+{
+    QString result;
+    result.reserve( str.size() );
+
+    for ( QChar c: str )
+    {
+        switch ( c.unicode() )
+        {
+            case '"':  result += "\\\""; break;
+            case '\\': result += "\\\\"; break;
+            case '\n': result += "\\n";  break;
+            case '\t': result += "\\t";  break;
+
+            default:
+                if ( c.unicode() < 0x20 )
+                    result += QString( "\\u%1" ).arg( (int) c.unicode(), 4, 16, QChar( '0' ) );
+                else
+                    result += c;
+                break;
+        }
+    }
+
+    return result;
+}
+
+
+bool PkgCommitTimeline::writeChromeTrace( const QString & filename ) const
+{
+    // Chrome trace_event format: A complete event ("ph": "X") for each span,
+    // an instant event ("ph": "i") for cache hits and errors, and metadata
+    // events ("ph": "M") for the names of the lanes. All times in microsec.
+
+    QFile file( filename );
+
+    if ( ! file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        logError() << "Can't open " << filename << endl;
+        return false;
+    }
+
+    QTextStream str( &file );
+    QStringList traceEvents;
+
+    traceEvents << "{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 1, \"args\": { \"name\": \"Downloads\" } }";
+    traceEvents << "{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 2, \"args\": { \"name\": \"Install / Remove\" } }";
+    traceEvents << "{ \"name\": \"thread_name\", \"ph\": \"M\", \"pid\": 1, \"tid\": 3, \"args\": { \"name\": \"File Conflicts\" } }";
+
+    for ( const Span & span: spans() )
+    {
+        int tid = TID_INSTALL_REMOVE;
+
+        if ( span.phase == "download" )
+            tid = TID_DOWNLOADS;
+        else if ( span.phase == "file conflicts" )
+            tid = TID_FILE_CONFLICTS;
+
+        QString name = span.pkgName.isEmpty() ? span.phase : span.pkgName;
+
+        traceEvents << QString( "{ \"name\": \"%1\", \"cat\": \"%2\", \"ph\": \"X\", "
+                                "\"ts\": %3, \"dur\": %4, \"pid\": 1, \"tid\": %5 }" )
+            .arg( jsonEscaped( name ) )
+            .arg( span.phase )
+            .arg( span.startUsec )
+            .arg( span.durationUsec )
+            .arg( tid );
+    }
+
+    for ( const Event & event: events() )
+    {
+        if ( event.type != CacheHit && event.type != PkgError )
+            continue;
+
+        traceEvents << QString( "{ \"name\": \"%1\", \"cat\": \"%2\", \"ph\": \"i\", \"s\": \"t\", "
+                                "\"ts\": %3, \"pid\": 1, \"tid\": %4 }" )
+            .arg( jsonEscaped( event.pkgName ) )
+            .arg( event.type == CacheHit ? "cache hit" : "error" )
+            .arg( event.usec )
+            .arg( event.type == CacheHit ? TID_DOWNLOADS : TID_INSTALL_REMOVE );
+    }
+
+    str << "{\n"
+        << "  \"displayTimeUnit\": \"ms\",\n"
+        << "  \"traceEvents\": [\n    "
+        << traceEvents.join( ",\n    " )
+        << "\n  ]\n"
+        << "}\n";
+
+    str.flush();
+
+    if ( file.error() != QFileDevice::NoError )
+    {
+        logError() << "Error writing " << filename << ": " << file.errorString() << endl;
+        return false;
+    }
+
+    logInfo() << "Wrote commit timeline to " << filename << endl;
+
+    return true;
+}
+
+
+bool PkgCommitTimeline::writeCsv( const QString & filename ) const
+{
+    QFile file( filename );
+
+    if ( ! file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+    {
+        logError() << "Can't open " << filename << endl;
+        return false;
+    }
+
+    QTextStream str( &file );
+    str << "package,phase,start_ms,end_ms,duration_ms\n";
+
+    for ( const Span & span: spans() )
+    {
+        str << span.pkgName << ","
+            << span.phase   << ","
+            << QString::number( span.startUsec / 1000.0, 'f', 3 ) << ","
+            << QString::number( ( span.startUsec + span.durationUsec ) / 1000.0, 'f', 3 ) << ","
+            << QString::number( span.durationUsec / 1000.0, 'f', 3 ) << "\n";
+    }
+
+    str.flush();
+
+    if ( file.error() != QFileDevice::NoError )
+    {
+        logError() << "Error writing " << filename << ": " << file.errorString() << endl;
+        return false;
+    }
+
+    logInfo() << "Wrote commit timeline to " << filename << endl;
+
+    return true;
+}
+
+
+QStringList PkgCommitTimeline::slowestPackages( int maxCount ) const
+{
+    struct PkgTime
+    {
+        QString pkgName;
+        qint64  downloadUsec = 0;
+        qint64  actionUsec   = 0;
+
+        qint64 totalUsec() const { return downloadUsec + actionUsec; }
+    };
+
+    QHash<QString, PkgTime> pkgTimes;
+
+    for ( const Span & span: spans() )
+    {
+        if ( span.pkgName.isEmpty() )   // file conflicts check
+            continue;
+
+        PkgTime & pkgTime = pkgTimes[ span.pkgName ];
+        pkgTime.pkgName = span.pkgName;
+
+        if ( span.phase == "download" )
+            pkgTime.downloadUsec += span.durationUsec;
+        else
+            pkgTime.actionUsec   += span.durationUsec;
+    }
+
+    QStringList lines;
+
+    if ( pkgTimes.isEmpty() )
+        return lines;
+
+    QList<PkgTime> sorted = pkgTimes.values();
+
+    std::sort( sorted.begin(), sorted.end(),
+               []( const PkgTime & a, const PkgTime & b )
+               {
+                   return a.totalUsec() > b.totalUsec();
+               } );
+
+    lines << _( "Slowest packages:" );
+    lines << "";
+
+    for ( int i=0; i < sorted.size() && i < maxCount; ++i )
+    {
+        const PkgTime & pkgTime = sorted.at( i );
+
+        lines << QString( "  - " )
+            + _( "%1: %2 s (download %3 s, install / remove %4 s)" )
+            .arg( pkgTime.pkgName )
+            .arg( pkgTime.totalUsec()  / 1000000.0, 0, 'f', 1 )
+            .arg( pkgTime.downloadUsec / 1000000.0, 0, 'f', 1 )
+            .arg( pkgTime.actionUsec   / 1000000.0, 0, 'f', 1 );
+    }
+
+    lines << "";
+
+    return lines;
+}
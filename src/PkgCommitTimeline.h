@@ -0,0 +1,150 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef PkgCommitTimeline_h
+#define PkgCommitTimeline_h
+
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QStringList>
+
+
+/**
+ * Recorder for the per-package events of a package commit with monotonic
+ * time stamps: Download start / end, cache hits, install / remove start /
+ * end, errors and the file conflicts check.
+ *
+ * After the commit, this can write the timeline as a Chrome trace_event JSON
+ * file (to be opened with chrome://tracing or https://ui.perfetto.dev) and as
+ * a CSV file, and it can summarize the slowest packages.
+ *
+ * Events may be added from any thread, in particular from the commit thread
+ * (see PkgCommitSignalForwarder).
+ *
+ * This is a singleton class.
+ **/
+class PkgCommitTimeline
+{
+public:
+
+    enum EventType
+    {
+        DownloadStart,
+        DownloadEnd,
+        CacheHit,
+        InstallStart,
+        InstallEnd,
+        RemoveStart,
+        RemoveEnd,
+        PkgError,
+        FileConflictsStart,
+        FileConflictsEnd
+    };
+
+    /**
+     * Return the singleton of this class. Create it if it doesn't exist yet.
+     **/
+    static PkgCommitTimeline * instance();
+
+    /**
+     * Clear all events and start the clock. Call this before the commit
+     * starts.
+     **/
+    void start();
+
+    /**
+     * Add an event with the current time stamp.
+     * 'pkgName' is empty for the file conflicts check.
+     *
+     * This is thread-safe.
+     **/
+    void addEvent( EventType type, const QString & pkgName = QString() );
+
+    /**
+     * Return 'true' if there are no events.
+     **/
+    bool isEmpty() const;
+
+    /**
+     * Write the timeline to 'dir'/commit-trace.json (Chrome trace_event
+     * format) and 'dir'/commit-trace.csv. Return 'true' on success, 'false'
+     * on error.
+     **/
+    bool writeTraceFiles( const QString & dir ) const;
+
+    /**
+     * Return text lines for the summary page with the 'maxCount' packages
+     * that took the longest time in total (download plus install or remove).
+     * Return an empty list if there are no events.
+     **/
+    QStringList slowestPackages( int maxCount ) const;
+
+
+protected:
+
+    /**
+     * Constructor. Use instance() instead.
+     **/
+    PkgCommitTimeline() {}
+
+    struct Event
+    {
+        qint64    usec;         // since start()
+        EventType type;
+        QString   pkgName;
+    };
+
+    /**
+     * A completed phase of a package or the file conflicts check:
+     * From a ...Start to the matching ...End event.
+     **/
+    struct Span
+    {
+        QString   pkgName;
+        QString   phase;        // "download", "install", "remove", "file conflicts"
+        qint64    startUsec;
+        qint64    durationUsec;
+    };
+
+    /**
+     * Return a copy of the events under the mutex.
+     **/
+    QList<Event> events() const;
+
+    /**
+     * Pair the start and end events to spans. Unfinished phases (e.g. after
+     * an error) are ignored.
+     **/
+    QList<Span> spans() const;
+
+    bool writeChromeTrace( const QString & filename ) const;
+    bool writeCsv        ( const QString & filename ) const;
+
+
+    mutable QMutex _mutex;
+    QElapsedTimer  _clock;
+    QList<Event>   _events;
+
+    static PkgCommitTimeline * _instance;
+};
+
+
+#endif // PkgCommitTimeline_h
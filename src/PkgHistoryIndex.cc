@@ -0,0 +1,276 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <algorithm>    // std::sort()
+
+#include <QFile>
+
+#include <zypp/HistoryLogData.h>
+
+#include "Exception.h"
+#include "Logger.h"
+#include "PkgHistoryIndex.h"
+
+
+#define HISTORY_FILENAME        "/var/log/zypp/history"
+
+
+PkgHistoryIndex * PkgHistoryIndex::_instance = 0;
+
+
+PkgHistoryIndex::PkgHistoryIndex()
+    : QObject()
+    , _filename( HISTORY_FILENAME )
+    , _reader( 0 )
+    , _loaded( false )
+    , _updatePending( false )
+    , _endOffset( 0 )
+    , _packageNamesDirty( false )
+{
+}
+
+
+PkgHistoryIndex::~PkgHistoryIndex()
+{
+    delete _reader;
+
+    if ( _instance == this )
+        _instance = 0;
+}
+
+
+PkgHistoryIndex *
+PkgHistoryIndex::instance()
+{
+    if ( ! _instance )
+    {
+        _instance = new PkgHistoryIndex();
+        CHECK_NEW( _instance );
+    }
+
+    return _instance;
+}
+
+
+void
+PkgHistoryIndex::update()
+{
+    if ( _reader )
+    {
+        _updatePending = true;
+        return;
+    }
+
+    if ( ! _loaded )
+    {
+        startReader( -1 );
+    }
+    else if ( ! isTailPositionValid() )
+    {
+        logInfo() << _filename << " was truncated or replaced; reading it again" << endl;
+
+        clear();
+        startReader( -1 );
+    }
+    else if ( QFile( _filename ).size() > _endOffset )
+    {
+        startReader( _endOffset );
+    }
+}
+
+
+void
+PkgHistoryIndex::clear()
+{
+    delete _reader;
+    _reader        = 0;
+    _updatePending = false;
+
+    _actions.clear();
+    _packageEvents.clear();
+    _packageNames.clear();
+    _packageNamesDirty = false;
+    _dateOffsets.clear();
+    _loaded    = false;
+    _endOffset = 0;
+
+    emit cleared();
+}
+
+
+void
+PkgHistoryIndex::startReader( qint64 tailOffset )
+{
+    _reader = new PkgHistoryReader( _filename, tailOffset );
+    CHECK_NEW( _reader );
+
+    connect( _reader, SIGNAL( actionsAvailable() ),
+             this,    SLOT  ( readActions()      ) );
+
+    connect( _reader, SIGNAL( finished()         ),
+             this,    SLOT  ( readerFinished()   ) );
+
+    _readTimer.start();
+    _reader->start();
+}
+
+
+void
+PkgHistoryIndex::readActions()
+{
+    if ( ! _reader )
+        return;
+
+    PkgHistoryActionList actions = _reader->takeActions();
+
+    if ( actions.isEmpty() )
+        return;
+
+    addToIndex( actions );
+
+    if ( _reader->isTailing() )
+    {
+        _actions = actions + _actions;
+        emit newerActionsAdded( actions );
+    }
+    else
+    {
+        _actions += actions;
+        emit olderActionsAdded( actions );
+    }
+}
+
+
+void
+PkgHistoryIndex::readerFinished()
+{
+    readActions();
+
+    PkgHistoryReader * reader = _reader;
+    _reader = 0;
+
+    logInfo() << ( reader->isTailing() ? "Tailed " : "Read " )
+              << reader->filename() << " up to offset " << reader->endOffset()
+              << " in " << _readTimer.elapsed() << " millisec; "
+              << _actions.size() << " actions, "
+              << _packageEvents.size() << " packages, "
+              << _dateOffsets.size() << " dates" << endl;
+
+    if ( reader->invalidLines() > 0 )
+    {
+        logWarning() << "Skipped " << reader->invalidLines()
+                     << " invalid lines in " << reader->filename() << endl;
+    }
+
+    _endOffset = reader->endOffset();
+    _loaded    = true;
+
+    if ( reader->failed() )
+    {
+        logWarning() << reader->errorMessage() << endl;
+        emit readError( reader->errorMessage() );
+    }
+
+    reader->deleteLater();
+    emit readingFinished();
+
+    if ( _updatePending )
+    {
+        _updatePending = false;
+        update();
+    }
+}
+
+
+bool
+PkgHistoryIndex::isTailPositionValid() const
+{
+    QFile file( _filename );
+
+    if ( file.size() < _endOffset )
+        return false;
+
+    if ( _dateOffsets.isEmpty() || ! file.open( QIODevice::ReadOnly ) )
+        return true; // Nothing to check; the reader will report any error
+
+    // Each line starts with the local date and time: "2025-03-14 12:34:56|..."
+
+    QByteArray expected = _dateOffsets.lastKey().toString( Qt::ISODate ).toLatin1();
+
+    return file.seek( _dateOffsets.last() ) && file.read( expected.size() ) == expected;
+}
+
+
+void
+PkgHistoryIndex::addToIndex( const PkgHistoryActionList & actions )
+{
+    for ( const PkgHistoryAction & action: actions )
+    {
+        if ( action.actionId == zypp::HistoryActionID::INSTALL_e ||
+             action.actionId == zypp::HistoryActionID::REMOVE_e     )
+        {
+            PkgHistoryActionList & events = _packageEvents[ action.name ];
+
+            if ( events.isEmpty() )
+                _packageNamesDirty = true;
+
+            events.append( action );
+        }
+
+        QMap<QDate, qint64>::iterator it = _dateOffsets.find( action.date );
+
+        if ( it == _dateOffsets.end() )
+            _dateOffsets.insert( action.date, action.offset );
+        else if ( action.offset < it.value() )
+            it.value() = action.offset;
+    }
+}
+
+
+PkgHistoryActionList
+PkgHistoryIndex::packageEvents( const QString & name ) const
+{
+    PkgHistoryActionList events = _packageEvents.value( name );
+
+    // The offsets are in file order, i.e. chronological
+
+    std::sort( events.begin(), events.end(),
+               []( const PkgHistoryAction & a, const PkgHistoryAction & b )
+               {
+                   return a.offset > b.offset;
+               } );
+
+    return events;
+}
+
+
+QStringList
+PkgHistoryIndex::findPackages( const QString & text ) const
+{
+    if ( _packageNamesDirty )
+    {
+        _packageNames = _packageEvents.keys();
+        _packageNames.sort();
+        _packageNamesDirty = false;
+    }
+
+    if ( text.isEmpty() )
+        return _packageNames;
+
+    return _packageNames.filter( text, Qt::CaseInsensitive );
+}
@@ -0,0 +1,214 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef PkgHistoryIndex_h
+#define PkgHistoryIndex_h
+
+
+#include <QDate>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QMap>
+#include <QObject>
+#include <QString>
+#include <QStringList>
+
+#include "PkgHistoryReader.h"   // PkgHistoryAction, PkgHistoryActionList
+
+
+/**
+ * In-memory index of the zypp history file (/var/log/zypp/history):
+ * All actions (newest first), the install and remove actions of each
+ * package by package name, and the file offset of the first line of each
+ * date.
+ *
+ * The index is built in the background with a PkgHistoryReader the first
+ * time update() is called. After that, update() only reads the lines that
+ * were appended to the file since the last time (e.g. after a package
+ * commit); the file is only read completely again if it was truncated or
+ * replaced. That is checked with the date offsets: The first line of the
+ * newest date has to be still where it was.
+ *
+ * The index stays in memory once it is built, so opening the history dialog
+ * again is instant.
+ **/
+class PkgHistoryIndex: public QObject
+{
+    Q_OBJECT
+
+protected:
+
+    /**
+     * Constructor. Use instance() instead.
+     **/
+    PkgHistoryIndex();
+
+public:
+
+    /**
+     * Destructor.
+     **/
+    virtual ~PkgHistoryIndex();
+
+    /**
+     * Return the instance of this class. Create it if it doesn't exist yet.
+     **/
+    static PkgHistoryIndex * instance();
+
+    /**
+     * Return 'true' if the instance was already created, i.e. if anybody
+     * was interested in the history so far.
+     **/
+    static bool hasInstance() { return _instance != 0; }
+
+    /**
+     * Return the name of the history file.
+     **/
+    const QString & filename() const { return _filename; }
+
+    /**
+     * Return 'true' if a reader is currently busy.
+     **/
+    bool isReading() const { return _reader != 0; }
+
+    /**
+     * Return all actions that are in the index so far, newest first.
+     **/
+    const PkgHistoryActionList & actions() const { return _actions; }
+
+    /**
+     * Return the install and remove actions of package 'name', newest
+     * first.
+     **/
+    PkgHistoryActionList packageEvents( const QString & name ) const;
+
+    /**
+     * Return the sorted names of all packages that contain 'text' (case
+     * insensitive) and that have any events.
+     **/
+    QStringList findPackages( const QString & text ) const;
+
+    /**
+     * Return the file offset of the first line of 'date' with an action
+     * or -1 if there is none.
+     **/
+    qint64 dateOffset( const QDate & date ) const
+        { return _dateOffsets.value( date, -1 ); }
+
+
+public slots:
+
+    /**
+     * Bring the index up to date with the history file in the background:
+     * Read the whole file the first time, later only the new lines.
+     *
+     * If a reader is busy, this is done again when it is finished.
+     **/
+    void update();
+
+    /**
+     * Discard all index data and stop any reader.
+     **/
+    void clear();
+
+
+signals:
+
+    /**
+     * Emitted when actions were added that are older than all others
+     * (while reading the whole file), newest first.
+     **/
+    void olderActionsAdded( const PkgHistoryActionList & actions );
+
+    /**
+     * Emitted when actions were added that are newer than all others
+     * (after tailing the file), newest first.
+     **/
+    void newerActionsAdded( const PkgHistoryActionList & actions );
+
+    /**
+     * Emitted when all index data were discarded.
+     **/
+    void cleared();
+
+    /**
+     * Emitted when a reader is finished.
+     **/
+    void readingFinished();
+
+    /**
+     * Emitted when the history file could not be read.
+     **/
+    void readError( const QString & message );
+
+
+protected slots:
+
+    /**
+     * Add the actions that the reader read so far.
+     **/
+    void readActions();
+
+    /**
+     * Clean up after the reader is finished.
+     **/
+    void readerFinished();
+
+
+protected:
+
+    /**
+     * Start a reader from 'tailOffset' or for the whole file if that is -1.
+     **/
+    void startReader( qint64 tailOffset );
+
+    /**
+     * Return 'true' if the history file still continues where the index
+     * ended, i.e. if it is safe to read only the new lines.
+     **/
+    bool isTailPositionValid() const;
+
+    /**
+     * Add 'actions' to the package and date indexes.
+     **/
+    void addToIndex( const PkgHistoryActionList & actions );
+
+
+    //
+    // Data members
+    //
+
+    QString                              _filename;
+    PkgHistoryReader *                   _reader;
+    bool                                 _loaded;
+    bool                                 _updatePending;
+    qint64                               _endOffset;
+    QElapsedTimer                        _readTimer;
+
+    PkgHistoryActionList                 _actions;       // newest first
+    QHash<QString, PkgHistoryActionList> _packageEvents; // name -> events
+    QMap<QDate, qint64>                  _dateOffsets;   // date -> offset
+
+    mutable QStringList                  _packageNames;  // sorted, cached
+    mutable bool                         _packageNamesDirty;
+
+    static PkgHistoryIndex *             _instance;
+};
+
+
+#endif // PkgHistoryIndex_h
@@ -0,0 +1,334 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <algorithm>    // std::reverse()
+#include <iterator>     // std::back_inserter
+
+#include <QDateTime>
+#include <QFile>
+#include <QMutexLocker>
+
+#include <zypp-core/base/Exception.h>
+#include <zypp-core/base/String.h>
+#include <zypp/HistoryLogData.h>
+
+#include "FlightRecorder.h"
+#include "utf8.h"
+#include "PkgHistoryReader.h"
+
+
+#define READ_BLOCK_SIZE         ( 256 * 1024 )  // Bytes
+#define FIRST_BATCH_SIZE        200             // actions
+#define MAX_BATCH_SIZE          20000           // actions
+
+
+/**
+ * Return the version part of an edition string "[epoch:]version[-release]"
+ * like zypp::Edition::version() does, but without creating a zypp::Edition.
+ **/
+static QString editionVersion( const QString & edition )
+{
+    int start = edition.indexOf( ':' ) + 1;
+    int end   = edition.lastIndexOf( '-' );
+
+    if ( end < start )
+        end = edition.size();
+
+    return edition.mid( start, end - start );
+}
+
+
+/**
+ * Fill 'action' from a parsed history item.
+ * Return 'false' if this is not an action to show to the user.
+ **/
+static bool fillAction( const zypp::HistoryLogData::Ptr & item_ptr,
+                        PkgHistoryAction &                action )
+{
+    action.time     = item_ptr->date();
+    action.date     = QDateTime::fromSecsSinceEpoch( action.time ).date();
+    action.actionId = item_ptr->action().toEnum();
+
+    switch ( item_ptr->action().toEnum() )
+    {
+        case zypp::HistoryActionID::INSTALL_e:
+            action.name    = fromUTF8( item_ptr->optionalAt( zypp::HistoryLogDataInstall::NAME_INDEX ) );
+            action.edition = fromUTF8( item_ptr->optionalAt( zypp::HistoryLogDataInstall::EDITION_INDEX ) );
+            action.detail  = editionVersion( action.edition );
+            return true;
+
+        case zypp::HistoryActionID::REMOVE_e:
+            action.name    = fromUTF8( item_ptr->optionalAt( zypp::HistoryLogDataRemove::NAME_INDEX ) );
+            action.edition = fromUTF8( item_ptr->optionalAt( zypp::HistoryLogDataRemove::EDITION_INDEX ) );
+            action.detail  = editionVersion( action.edition );
+            return true;
+
+        case zypp::HistoryActionID::REPO_ADD_e:
+            {
+                zypp::HistoryLogDataRepoAdd * item =
+                    static_cast <zypp::HistoryLogDataRepoAdd *>( item_ptr.get() );
+
+                action.name   = fromUTF8( item->alias() );
+                action.detail = fromUTF8( item->url().asString() );
+            }
+            return true;
+
+        case zypp::HistoryActionID::REPO_REMOVE_e:
+            {
+                zypp::HistoryLogDataRepoRemove * item =
+                    static_cast <zypp::HistoryLogDataRepoRemove *>( item_ptr.get() );
+
+                action.name = fromUTF8( item->alias() );
+            }
+            return true;
+
+        case zypp::HistoryActionID::REPO_CHANGE_ALIAS_e:
+            {
+                zypp::HistoryLogDataRepoAliasChange * item =
+                    static_cast <zypp::HistoryLogDataRepoAliasChange *>( item_ptr.get() );
+
+                action.name = fromUTF8( item->oldAlias() ) + " -> " + fromUTF8( item->newAlias() );
+            }
+            return true;
+
+        case zypp::HistoryActionID::REPO_CHANGE_URL_e:
+            {
+                zypp::HistoryLogDataRepoUrlChange * item =
+                    static_cast <zypp::HistoryLogDataRepoUrlChange *>( item_ptr.get() );
+
+                action.name   = fromUTF8( item->alias() );
+                action.detail = fromUTF8( item->newUrl().asString() );
+            }
+            return true;
+
+        default:
+            return false;
+    }
+}
+
+
+
+
+PkgHistoryReader::PkgHistoryReader( const QString & filename,
+                                    qint64          tailOffset,
+                                    QObject *       parent )
+    : QThread( parent )
+    , _filename( filename )
+    , _tailOffset( tailOffset )
+    , _endOffset( qMax( tailOffset, (qint64) 0 ) )
+    , _failed( false )
+    , _invalidLines( 0 )
+    , _batchSize( FIRST_BATCH_SIZE )
+{
+}
+
+
+PkgHistoryReader::~PkgHistoryReader()
+{
+    requestInterruption();
+    wait();
+}
+
+
+void PkgHistoryReader::run()
+{
+    // No logging here: The logger is only used from the GUI thread.
+
+    FlightRecorder::installAltStack();
+
+    QFile file( _filename );
+
+    if ( ! file.open( QIODevice::ReadOnly ) )
+    {
+        setError( file );
+        return;
+    }
+
+    if ( isTailing() )
+        readTail( file );
+    else
+        readBackwards( file );
+
+    if ( ! _batch.isEmpty() )
+        deliverBatch();
+}
+
+
+void PkgHistoryReader::readBackwards( QFile & file )
+{
+    // The file is in chronological order, so read it in blocks from the end
+    // and split each block into lines from the end.
+
+    qint64     pos = file.size();
+    QByteArray rest;    // incomplete first line of the previous block
+    bool       inLastLine = true;
+
+    while ( pos > 0 && ! isInterruptionRequested() )
+    {
+        qint64 blockSize = qMin( (qint64) READ_BLOCK_SIZE, pos );
+        pos -= blockSize;
+
+        QByteArray block;
+
+        if ( file.seek( pos ) )
+            block = file.read( blockSize );
+
+        if ( block.size() != blockSize )
+        {
+            setError( file );
+            return;
+        }
+
+        block += rest;
+        qsizetype end = block.size();
+
+        if ( inLastLine )
+        {
+            // Leave a last line that is still being written for tailing
+
+            qsizetype newline = block.lastIndexOf( '\n' );
+
+            if ( newline < 0 )
+            {
+                rest.clear();
+                continue;
+            }
+
+            end        = newline + 1;
+            _endOffset = pos + end;
+            inLastLine = false;
+        }
+
+        while ( end > 0 )
+        {
+            qsizetype newline = block.lastIndexOf( '\n', end - 1 );
+
+            if ( newline < 0 )
+                break;
+
+            processLine( block.mid( newline + 1, end - newline - 1 ), pos + newline + 1 );
+            end = newline;
+        }
+
+        rest = block.left( end );
+    }
+
+    if ( pos == 0 && ! isInterruptionRequested() )
+        processLine( rest, 0 ); // the first line of the file
+}
+
+
+void PkgHistoryReader::readTail( QFile & file )
+{
+    if ( ! file.seek( _tailOffset ) )
+    {
+        setError( file );
+        return;
+    }
+
+    // This is only what was added since the last time, so simply collect
+    // everything and deliver it newest first at the end.
+
+    QByteArray data = file.readAll();
+    qint64     pos  = 0;
+
+    while ( ! isInterruptionRequested() )
+    {
+        qsizetype newline = data.indexOf( '\n', pos );
+
+        if ( newline < 0 )
+            break;
+
+        processLine( data.mid( pos, newline - pos ), _tailOffset + pos );
+        pos = newline + 1;
+    }
+
+    _endOffset = _tailOffset + pos;
+    std::reverse( _batch.begin(), _batch.end() );
+}
+
+
+void PkgHistoryReader::setError( const QFile & file )
+{
+    _failed       = true;
+    _errorMessage = QString( "%1: %2" ).arg( _filename ).arg( file.errorString() );
+}
+
+
+void PkgHistoryReader::processLine( const QByteArray & line, qint64 offset )
+{
+    if ( line.isEmpty() || line.startsWith( '#' ) )
+        return;
+
+    zypp::HistoryLogData::FieldVector fields;
+    zypp::str::splitEscaped( line.toStdString(), std::back_inserter( fields ), "|", true );
+
+    try
+    {
+        PkgHistoryAction action;
+
+        if ( fillAction( zypp::HistoryLogData::create( fields ), action ) )
+        {
+            action.offset = offset;
+            _batch.append( action );
+        }
+    }
+    catch ( const zypp::Exception & )
+    {
+        ++_invalidLines;
+    }
+
+    // When tailing, deliver everything at once at the end
+
+    if ( ! isTailing() && _batch.size() >= _batchSize )
+        deliverBatch();
+}
+
+
+void PkgHistoryReader::deliverBatch()
+{
+    bool wasEmpty;
+
+    {
+        QMutexLocker locker( &_mutex );
+
+        wasEmpty = _pending.isEmpty();
+
+        if ( wasEmpty )
+            _pending.swap( _batch );
+        else
+            _pending += _batch;
+    }
+
+    _batch.clear();
+    _batchSize = qMin( 2 * _batchSize, MAX_BATCH_SIZE );
+
+    if ( wasEmpty )
+        emit actionsAvailable();
+}
+
+
+PkgHistoryActionList PkgHistoryReader::takeActions()
+{
+    QMutexLocker locker( &_mutex );
+
+    PkgHistoryActionList actions;
+    actions.swap( _pending );
+
+    return actions;
+}
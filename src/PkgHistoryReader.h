@@ -0,0 +1,205 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef PkgHistoryReader_h
+#define PkgHistoryReader_h
+
+
+#include <ctime>        // time_t
+
+#include <QByteArray>
+#include <QDate>
+#include <QMutex>
+#include <QString>
+#include <QThread>
+#include <QVector>
+
+class QFile;
+
+
+/**
+ * One action from the zypp history file in a form that is cheap to copy
+ * between threads and to store in large numbers.
+ **/
+struct PkgHistoryAction
+{
+    time_t  time;       // seconds since the epoch
+    QDate   date;       // local date of 'time'
+    qint64  offset;     // file offset of the line
+    int     actionId;   // zypp::HistoryActionID::ID
+    QString name;       // package name or repo alias
+    QString detail;     // package version or repo URL
+    QString edition;    // complete package edition
+};
+
+typedef QVector<PkgHistoryAction> PkgHistoryActionList;
+
+
+/**
+ * Thread for reading the zypp history file (/var/log/zypp/history).
+ *
+ * That file grows with every package transaction; on a system that has been
+ * kept up to date for years it easily has hundreds of thousands of lines.
+ * This reads it from the end backwards, so the newest actions are found
+ * first, and hands them over to the GUI thread in batches while it is still
+ * reading: actionsAvailable() is emitted when there are new actions, and the
+ * GUI thread fetches them with takeActions(). The first batches are small so
+ * there is something to show right away; later ones get bigger to keep the
+ * overhead down.
+ *
+ * Alternatively, it reads only the lines that were appended to the file
+ * after a known offset ("tailing"), e.g. after a package commit, and
+ * delivers them all at once when it is done, also newest first.
+ *
+ * Only the actions that are useful to show to the user are delivered
+ * (package install and remove and the repo actions). Only complete lines
+ * are read, i.e. lines that end with a newline.
+ *
+ * This does not use zypp::parser::HistoryLogReader since that can only read
+ * the file from the start. The lines are parsed with
+ * zypp::HistoryLogData::create() just like there, but nothing is used that
+ * would touch the sat pool (zypp::Edition, zypp::Arch): The GUI thread may
+ * use that at the same time.
+ **/
+class PkgHistoryReader: public QThread
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructor. Use start() to start reading 'filename'.
+     *
+     * If 'tailOffset' is 0 or more, read only from that offset to the end
+     * of the file; otherwise read the whole file backwards.
+     **/
+    PkgHistoryReader( const QString & filename,
+                      qint64          tailOffset = -1,
+                      QObject *       parent     = 0 );
+
+    /**
+     * Destructor. This stops reading and waits until the thread is finished.
+     **/
+    virtual ~PkgHistoryReader();
+
+    /**
+     * Return the name of the file to read.
+     **/
+    const QString & filename() const { return _filename; }
+
+    /**
+     * Return 'true' if this only reads the lines after an offset.
+     **/
+    bool isTailing() const { return _tailOffset >= 0; }
+
+    /**
+     * Return the file offset after the last line that was read, i.e. where
+     * to continue with tailing the next time.
+     * Only meaningful after the thread is finished.
+     **/
+    qint64 endOffset() const { return _endOffset; }
+
+    /**
+     * Take the actions that were read since the last call, newest first.
+     * When reading backwards, the actions of each call are older than those
+     * of the previous call.
+     *
+     * This may be called from any thread at any time.
+     **/
+    PkgHistoryActionList takeActions();
+
+    /**
+     * Return 'true' if the file could not be read.
+     * Only meaningful after the thread is finished.
+     **/
+    bool failed() const { return _failed; }
+
+    /**
+     * Return the error message if the file could not be read.
+     **/
+    const QString & errorMessage() const { return _errorMessage; }
+
+    /**
+     * Return the number of lines that could not be parsed.
+     * Only meaningful after the thread is finished.
+     **/
+    int invalidLines() const { return _invalidLines; }
+
+
+signals:
+
+    /**
+     * Emitted from the reader thread when new actions are available for
+     * takeActions(). This is not emitted again until they are taken.
+     **/
+    void actionsAvailable();
+
+
+protected:
+
+    /**
+     * The thread function.
+     *
+     * Reimplemented from QThread.
+     **/
+    virtual void run() override;
+
+    /**
+     * Read the whole file backwards from the end.
+     **/
+    void readBackwards( QFile & file );
+
+    /**
+     * Read the file forward from _tailOffset to the end.
+     **/
+    void readTail( QFile & file );
+
+    /**
+     * Set the error message from the file's error.
+     **/
+    void setError( const QFile & file );
+
+    /**
+     * Parse one line of the history file that starts at file offset
+     * 'offset' and add the action to the current batch if it is one to
+     * show.
+     **/
+    void processLine( const QByteArray & line, qint64 offset );
+
+    /**
+     * Hand over the current batch to the GUI thread.
+     **/
+    void deliverBatch();
+
+
+    QString              _filename;
+    qint64               _tailOffset;
+    qint64               _endOffset;
+    bool                 _failed;
+    QString              _errorMessage;
+    int                  _invalidLines;
+
+    PkgHistoryActionList _batch;        // only used in the reader thread
+    int                  _batchSize;
+
+    QMutex               _mutex;        // protects _pending
+    PkgHistoryActionList _pending;
+};
+
+
+#endif // PkgHistoryReader_h
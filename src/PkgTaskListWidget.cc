@@ -32,6 +32,7 @@ PkgTaskListWidget::addTaskItem( PkgTask * task )
 {
     PkgTaskListWidgetItem * item = new PkgTaskListWidgetItem( task, this );
     CHECK_NEW( item );
+    _itemIndex.insert( task, item );
 
     if ( _autoScrollToLast )
         scrollToItem( item, QAbstractItemView::PositionAtBottom );
@@ -43,22 +44,13 @@ PkgTaskListWidget::addTaskItem( PkgTask * task )
 PkgTaskListWidgetItem *
 PkgTaskListWidget::findTaskItem( PkgTask * task ) const
 {
-    for ( int row=0; row < count(); ++row )
-    {
-        PkgTaskListWidgetItem * it =
-            dynamic_cast<PkgTaskListWidgetItem *>( item( row ) );
-
-        if ( it && it->task() == task )
-            return it;
-    }
-
-    return 0;
+    return _itemIndex.value( task, 0 );
 }
 
 
 void PkgTaskListWidget::removeTaskItem( PkgTask * task )
 {
-    PkgTaskListWidgetItem * item = findTaskItem( task );
+    PkgTaskListWidgetItem * item = _itemIndex.take( task );
 
     if ( item )
     {
@@ -72,6 +64,13 @@ void PkgTaskListWidget::removeTaskItem( PkgTask * task )
 }
 
 
+void PkgTaskListWidget::clear()
+{
+    _itemIndex.clear();
+    QListWidget::clear();
+}
+
+
 
 
 PkgTaskListWidgetItem::PkgTaskListWidgetItem( PkgTask *           task,
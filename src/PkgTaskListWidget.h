@@ -20,6 +20,7 @@
 
 
 #include <QListWidget>
+#include <QHash>
 #include "PkgTasks.h"
 
 class PkgTaskListWidgetItem;
@@ -62,10 +63,20 @@ public:
      * Find the list widget item for a task and return it.
      * Return 0 if not found.
      *
+     * This uses a hash index of the items that were added with addTaskItem(),
+     * so it does not need to iterate over all items.
+     *
      * Ownership of the item remains with the list widget.
      **/
     PkgTaskListWidgetItem * findTaskItem( PkgTask * task ) const;
 
+    /**
+     * Remove all items and clear the item index.
+     *
+     * This hides the non-virtual QListWidget::clear().
+     **/
+    void clear();
+
     /**
      * Return 'true' if the sort order should always be the item insertion
      * order, 'false' if default sort order.
@@ -101,6 +112,8 @@ protected:
     int  _nextSerial;
     bool _sortByInsertionSequence;
     bool _autoScrollToLast;
+
+    QHash<PkgTask *, PkgTaskListWidgetItem *> _itemIndex;
 };
 
 
@@ -15,7 +15,7 @@
  */
 
 
-#include <algorithm>    // std::sort()
+#include <algorithm>    // std::sort(), std::lower_bound()
 
 #include "Logger.h"
 #include "Exception.h"
@@ -25,6 +25,107 @@
 
 
 
+PkgTask::PkgTask( const QString &  pkgName,
+                  PkgTaskAction    pkgAction,
+                  PkgTaskRequester requester )
+    : _name( pkgName )
+    , _ident( toUTF8( pkgName ) )
+    , _action( pkgAction )
+    , _requester( requester )
+    , _downloadSize ( -1.0 )
+    , _installedSize( -1.0 )
+    , _downloadedPercent( -1 )
+    , _completedPercent( -1 )
+    , _list( 0 )
+    , _listSeq( -1 )
+{
+}
+
+
+PkgTask::PkgTask( const PkgTask & other )
+    : _name( other._name )
+    , _ident( other._ident )
+    , _action( other._action )
+    , _requester( other._requester )
+    , _downloadSize ( other._downloadSize  )
+    , _installedSize( other._installedSize )
+    , _downloadedPercent( other._downloadedPercent )
+    , _completedPercent ( other._completedPercent  )
+    , _list( 0 )
+    , _listSeq( -1 )
+{
+}
+
+
+void PkgTask::setDownloadSize( ByteCount value )
+{
+    ByteCount oldDownloaded = downloadedSize();
+    ByteCount oldInstalled  = completedInstalledSize();
+
+    _downloadSize = value;
+    updateListSums( oldDownloaded, oldInstalled );
+}
+
+
+void PkgTask::setInstalledSize( ByteCount value )
+{
+    ByteCount oldDownloaded = downloadedSize();
+    ByteCount oldInstalled  = completedInstalledSize();
+
+    _installedSize = value;
+    updateListSums( oldDownloaded, oldInstalled );
+}
+
+
+void PkgTask::setDownloadedPercent( int value )
+{
+    ByteCount oldDownloaded = downloadedSize();
+    ByteCount oldInstalled  = completedInstalledSize();
+
+    _downloadedPercent = value;
+    updateListSums( oldDownloaded, oldInstalled );
+}
+
+
+void PkgTask::setCompletedPercent( int value )
+{
+    ByteCount oldDownloaded = downloadedSize();
+    ByteCount oldInstalled  = completedInstalledSize();
+
+    _completedPercent = value;
+    updateListSums( oldDownloaded, oldInstalled );
+}
+
+
+ByteCount PkgTask::downloadedSize() const
+{
+    if ( ( _action & PkgAdd ) && _downloadSize > 0 && _downloadedPercent > 0 )
+        return ByteCount( (ByteCount::SizeType) ( _downloadSize * ( _downloadedPercent / 100.0 ) ) );
+
+    return ByteCount( 0 );
+}
+
+
+ByteCount PkgTask::completedInstalledSize() const
+{
+    if ( _installedSize > 0 && _completedPercent > 0 )
+        return ByteCount( (ByteCount::SizeType) ( _installedSize * ( _completedPercent / 100.0 ) ) );
+
+    return ByteCount( 0 );
+}
+
+
+void PkgTask::updateListSums( ByteCount oldDownloadedSize,
+                              ByteCount oldCompletedInstalledSize )
+{
+    if ( _list )
+    {
+        _list->addToSums( downloadedSize()         - oldDownloadedSize,
+                          completedInstalledSize() - oldCompletedInstalledSize );
+    }
+}
+
+
 bool PkgTask::matches( const QString &  name,
                        PkgTaskAction    action,
                        PkgTaskRequester requester ) const
@@ -112,6 +213,9 @@ LogStream & operator<<( LogStream & str, PkgTask * task )
 PkgTaskList::PkgTaskList( const QString & listName )
         : QList<PkgTask *>()
         , _name( listName )
+        , _nextSeq( 0 )
+        , _downloadSizeSum( 0 )
+        , _installedSizeSum( 0 )
 {
 }
 
@@ -150,20 +254,134 @@ PkgTaskList::find( const PkgTask & filter ) const
 
 
 PkgTask *
-PkgTaskList::find( ZyppRes zyppRes ) const
+PkgTaskList::find( zypp::IdString ident ) const
 {
-    QString resName = fromUTF8( zyppRes->name() );
+    PkgTask * task = _identIndex.value( ident.id(), 0 );
 
-    for ( PkgTask * task: *this )
+    if ( task && indexOfTask( task ) >= 0 )
+        return task;
+
+    if ( _identIndex.size() == size() ) // All tasks are in the index
+        return 0;
+
+    // Some tasks were added with the plain QList API: Fall back to a linear
+    // search.
+
+    for ( PkgTask * candidate: *this )
     {
-        if ( task && task->name() == resName )
-            return task;
+        if ( candidate && candidate->ident() == ident )
+            return candidate;
     }
 
     return 0;
 }
 
 
+void PkgTaskList::insertTask( PkgTask * task )
+{
+    CHECK_PTR( task );
+
+    task->_list    = this;
+    task->_listSeq = _nextSeq++;
+
+    append( task );
+    _identIndex.insert( task->ident().id(), task );
+    addToSums( task->downloadedSize(), task->completedInstalledSize() );
+}
+
+
+bool PkgTaskList::removeTask( PkgTask * task )
+{
+    int index = indexOfTask( task );
+
+    if ( index < 0 )
+        return false;
+
+    // Keep the order: Moving the last task into the gap would be cheaper, but
+    // the progress lists show the tasks in this order.
+
+    removeAt( index );
+
+    if ( _identIndex.value( task->ident().id(), 0 ) == task )
+        _identIndex.remove( task->ident().id() );
+
+    if ( task->_list == this )
+        addToSums( - task->downloadedSize(), - task->completedInstalledSize() );
+
+    task->_list    = 0;
+    task->_listSeq = -1;
+
+    return true;
+}
+
+
+int PkgTaskList::indexOfTask( PkgTask * task ) const
+{
+    if ( ! task )
+        return -1;
+
+    if ( task->_list == this )
+    {
+        // The order numbers ascend along the list, and removing tasks doesn't
+        // change them: Binary search.
+
+        auto it = std::lower_bound( begin(), end(), task->_listSeq,
+                                    []( const PkgTask * listTask, qint64 seq )
+                                    {
+                                        return listTask && listTask->_listSeq < seq;
+                                    });
+
+        if ( it != end() && *it == task )
+            return (int) ( it - begin() );
+    }
+
+    // Not added with insertTask() or moved around with the plain QList API
+
+    return indexOf( task );
+}
+
+
+void PkgTaskList::clear()
+{
+    // Detach the tasks so they no longer update the running sums of this list
+
+    for ( PkgTask * task: *this )
+    {
+        if ( task && task->_list == this )
+        {
+            task->_list    = 0;
+            task->_listSeq = -1;
+        }
+    }
+
+    _identIndex.clear();
+    _downloadSizeSum  = 0;
+    _installedSizeSum = 0;
+
+    QList<PkgTask *>::clear();
+}
+
+
+void PkgTaskList::addToSums( ByteCount::SizeType downloadSizeDelta,
+                             ByteCount::SizeType installedSizeDelta )
+{
+    _downloadSizeSum  += downloadSizeDelta;
+    _installedSizeSum += installedSizeDelta;
+}
+
+
+void PkgTaskList::reindex()
+{
+    _nextSeq = 0;
+
+    for ( PkgTask * task: *this )
+    {
+        if ( task && task->_list == this )
+            task->_listSeq = _nextSeq++;
+    }
+}
+
+
 PkgTaskList
 PkgTaskList::filtered( PkgTaskAction    filterAction,
                        PkgTaskRequester filterRequester )
@@ -175,7 +393,7 @@ PkgTaskList::filtered( PkgTaskAction    filterAction,
         if ( ( task->action()    & filterAction    ) &&
              ( task->requester() & filterRequester )    )
         {
-            result.append( new PkgTask( *task ) );
+            result.insertTask( new PkgTask( *task ) );
         }
     }
 
@@ -189,14 +407,7 @@ PkgTaskList::downloadSizeSum() const
     ByteCount sum(0);
 
     for ( const PkgTask * task: *this )
-    {
-        if ( ( task->action() & PkgAdd )    &&
-             task->downloadSize()      > 0  &&
-             task->downloadedPercent() > 0 )
-        {
-            sum += task->downloadSize() * ( task->downloadedPercent() / 100.0 );
-        }
-    }
+        sum += task->downloadedSize();
 
     return sum;
 }
@@ -208,10 +419,7 @@ PkgTaskList::installedSizeSum() const
     ByteCount sum(0);
 
     for ( const PkgTask * task: *this )
-    {
-        if ( task->installedSize() > 0 && task->completedPercent() > 0 )
-            sum += task->installedSize() * ( task->completedPercent() / 100.0 );
-    }
+        sum += task->completedInstalledSize();
 
     return sum;
 }
@@ -232,6 +440,7 @@ void PkgTaskList::sort()
     // ignored, std::sort() just compares the pointer values (!) in that case.
 
     std::sort( begin(), end(), compareFunctor );
+    reindex();
 }
 
 
@@ -275,8 +484,11 @@ void PkgTasks::nuke( PkgTaskList & list )
                    << "\"  size:" << list.size()
                    << endl;
 
-        qDeleteAll( list );
+        // Clear the list first: That still touches the tasks.
+
+        QList<PkgTask *> tasks = list;
         list.clear();
+        qDeleteAll( tasks );
     }
 }
 
@@ -285,15 +497,13 @@ void PkgTasks::moveTask( PkgTask *      task,
                          PkgTaskList &  fromList,
                          PkgTaskList &  toList )
 {
-    int index = fromList.indexOf( task );
-
-    if ( index < 0 )
+    if ( ! fromList.removeTask( task ) )
     {
         logError() << "Task " << task->name() << " not found in this list" << endl;
         return;
     }
 
-    toList.append( fromList.takeAt( index ) );
+    toList.insertTask( task );
 }
 
 
@@ -362,7 +572,7 @@ void PkgTasks::initFromZypp()
             }
 
             logInfo() << "New task " << task << endl;
-            _todo.append( task );
+            _todo.insertTask( task );
         }
     }
 }
@@ -21,15 +21,19 @@
 
 #include <QString>
 #include <QList>
+#include <QHash>
 #include <QTextStream>
 #include <QMutex>
 
 #include <zypp-core/ByteCount.h>
+#include <zypp/IdString.h>
 #include "YQZypp.h"     // ZyppRes
 
 
 using zypp::ByteCount;
 
+class PkgTaskList;
+
 /**
  * Types of actions for a package task.
  *
@@ -80,7 +84,8 @@ enum PkgTaskRequester
  * fields are just for convenience during the package commit stage.
  *
  * The status of each task is implicit by what list it is in: todo, doing,
- * downloads, done, failed.
+ * downloads, done, failed. Each task knows that list (see list()) so it can
+ * be moved to another one in constant time.
  **/
 class PkgTask
 {
@@ -91,21 +96,31 @@ public:
      **/
     PkgTask( const QString &  pkgName,
              PkgTaskAction    pkgAction,
-             PkgTaskRequester requester ) // PkgReqUser or PkgReqDep
-        : _name( pkgName )
-        , _action( pkgAction )
-        , _requester( requester )
-        , _downloadSize ( -1.0 )
-        , _installedSize( -1.0 )
-        , _downloadedPercent( -1 )
-        , _completedPercent( -1 )
-        {}
+             PkgTaskRequester requester ); // PkgReqUser or PkgReqDep
+
+    /**
+     * Copy constructor. The copy is not a member of any task list.
+     **/
+    PkgTask( const PkgTask & other );
 
     /**
      * Return the package name.
      **/
     const QString & name() const { return _name; }
 
+    /**
+     * Return the sat ident of the package, i.e. the package name as an
+     * interned libzypp string. This is the key for looking up a task for a
+     * ZyppRes without any string conversion.
+     **/
+    zypp::IdString ident() const { return _ident; }
+
+    /**
+     * Return the task list this task was last inserted into with
+     * PkgTaskList::insertTask() or 0 if none.
+     **/
+    PkgTaskList * list() const { return _list; }
+
     /**
      * Return the action that is to do or done: Install, update, remove.
      **/
@@ -141,7 +156,7 @@ public:
     /**
      * Set the download size in bytes.
      **/
-    void setDownloadSize( ByteCount value ) { _downloadSize = value; }
+    void setDownloadSize( ByteCount value );
 
     /**
      * Return the installed size in bytes or -1.0 (< 0.0) if unknown.
@@ -151,7 +166,7 @@ public:
     /**
      * Set the installed size in bytes.
      **/
-    void setInstalledSize( ByteCount value ) { _installedSize = value; }
+    void setInstalledSize( ByteCount value );
 
     /**
      * Return the downloaded percent (0..100) or -1 if unknown.
@@ -162,7 +177,7 @@ public:
     /**
      * Set the downloaded percent (0..100).
      **/
-    void setDownloadedPercent( int value ) { _downloadedPercent = value; }
+    void setDownloadedPercent( int value );
 
     /**
      * Return percent (0..100) to which this task is completed or -1 if
@@ -173,7 +188,20 @@ public:
     /**
      * Set the completed percent (0..100).
      **/
-    void setCompletedPercent( int value ) { _completedPercent = value; }
+    void setCompletedPercent( int value );
+
+    /**
+     * Return the part of the download size that is already downloaded
+     * according to downloadedPercent(), or 0 if that is unknown or if this is
+     * not a PkgAdd (PkgInstall | PkgUpdate) task.
+     **/
+    ByteCount downloadedSize() const;
+
+    /**
+     * Return the part of the installed size that is completed according to
+     * completedPercent(), or 0 if that is unknown.
+     **/
+    ByteCount completedInstalledSize() const;
 
     /**
      * Return 'true' if this action matches the specified name, action and
@@ -205,7 +233,18 @@ public:
 
 protected:
 
+    /**
+     * Notify the task list this task is in that downloadedSize() and / or
+     * completedInstalledSize() may have changed from the old values.
+     **/
+    void updateListSums( ByteCount oldDownloadedSize,
+                         ByteCount oldCompletedInstalledSize );
+
+
+    friend class PkgTaskList;
+
     QString          _name;
+    zypp::IdString   _ident;
     PkgTaskAction    _action;
     PkgTaskRequester _requester;
 
@@ -213,11 +252,31 @@ protected:
     ByteCount        _installedSize;
     int              _downloadedPercent;  // 0..100 or -1 for unknown
     int              _completedPercent;   // 0..100 or -1 for unknown
+
+    PkgTaskList *    _list;               // intrusive list membership
+    qint64           _listSeq;            // ascending order number in _list
 };
 
 
 /**
  * A list of package tasks.
+ *
+ * Tasks that are added with insertTask() are also stored in a hash index by
+ * their sat ident, and they carry an order number that ascends along the
+ * list, so looking them up by ZyppRes is O(1), and finding their position for
+ * removing them is a binary search, O(log n). Removing them is still O(n):
+ * The tasks behind them move up by one to keep the order, but that is just
+ * one memmove() of pointers instead of a linear search comparing every
+ * task. This is important during the package commit where every libzypp
+ * callback needs to find its task, and most of them move it to another list.
+ *
+ * The list also keeps running sums of the downloaded and the completed
+ * installed sizes of its tasks that are updated whenever a task is inserted,
+ * removed or changes its sizes or percent values, so the progress of the
+ * package commit can be calculated in O(1).
+ *
+ * The plain QList API still works, but tasks added that way are only found by
+ * a linear search, and they are not part of the running sums.
  **/
 class PkgTaskList: public QList<PkgTask *>
 {
@@ -253,12 +312,57 @@ public:
     PkgTask * find( const PkgTask & filter ) const;
 
     /**
-     * Find the first task where the name matches the name of the 'zyppRes'
-     * Zypp resolvable.
+     * Find the task for the 'zyppRes' Zypp resolvable, i.e. the task with the
+     * same sat ident.
      *
      * Return the task if found, 0 if not found.
      **/
-    PkgTask * find( ZyppRes zyppRes ) const;
+    PkgTask * find( ZyppRes zyppRes ) const { return find( zyppRes->ident() ); }
+
+    /**
+     * Find the task with sat ident 'ident'.
+     *
+     * Return the task if found, 0 if not found.
+     **/
+    PkgTask * find( zypp::IdString ident ) const;
+
+    /**
+     * Append a task to this list and add it to the ident index.
+     *
+     * The task should not be in any other list; use PkgTasks::moveTask() to
+     * move it from one list to another.
+     **/
+    void insertTask( PkgTask * task );
+
+    /**
+     * Remove a task from this list without deleting it.
+     *
+     * The order of the remaining tasks is preserved: The progress lists on the
+     * commit page display them as they are. For tasks that were added with
+     * insertTask(), finding the position is a binary search, O(log n);
+     * closing the gap is O(n), but it only moves pointers.
+     *
+     * Return 'true' if the task was in this list, 'false' if not.
+     **/
+    bool removeTask( PkgTask * task );
+
+    /**
+     * Return the index of 'task' in this list or -1 if it is not in this
+     * list.
+     **/
+    int indexOfTask( PkgTask * task ) const;
+
+    /**
+     * Remove all tasks from this list without deleting them.
+     **/
+    void clear();
+
+    /**
+     * Add deltas to the running sums. This is called by the tasks in this list
+     * when their sizes or percent values change.
+     **/
+    void addToSums( ByteCount::SizeType downloadSizeDelta,
+                    ByteCount::SizeType installedSizeDelta );
 
     /**
      * Return a new list from origList filtered by action and requester.
@@ -273,15 +377,31 @@ public:
      * Calculate and return the sum of all download sizes for PkgAdd tasks
      * (PkgInstall | PkgUpdate), taking 'downloadedPercent()' of each task into
      * account.
+     *
+     * This iterates over all tasks; see also runningDownloadSizeSum().
      **/
     ByteCount downloadSizeSum() const;
 
     /**
      * Calculate and return the sum of all installed sizes for all tasks in
      * this list, taking 'completedPercent()' of each task into account.
+     *
+     * This iterates over all tasks; see also runningInstalledSizeSum().
      **/
     ByteCount installedSizeSum() const;
 
+    /**
+     * Return the same as downloadSizeSum() in O(1) from the running sum of
+     * the tasks that were added with insertTask().
+     **/
+    ByteCount runningDownloadSizeSum() const { return _downloadSizeSum; }
+
+    /**
+     * Return the same as installedSizeSum() in O(1) from the running sum of
+     * the tasks that were added with insertTask().
+     **/
+    ByteCount runningInstalledSizeSum() const { return _installedSizeSum; }
+
     /**
      * Sort the list.
      **/
@@ -295,7 +415,18 @@ public:
 
 protected:
 
-    QString _name;
+    /**
+     * Renumber all tasks that belong to this list in their current order,
+     * e.g. after sorting.
+     **/
+    void reindex();
+
+
+    QString                                 _name;
+    QHash<zypp::IdString::IdType, PkgTask*> _identIndex;
+    qint64                                  _nextSeq;
+    ByteCount                               _downloadSizeSum;
+    ByteCount                               _installedSizeSum;
 };
 
 
@@ -350,6 +481,10 @@ public:
 
     /**
      * Move a task from one list to another.
+     *
+     * For tasks that were added with PkgTaskList::insertTask(), this is
+     * O(log n) for finding the task in 'fromList' plus O(n) pointer moves for
+     * closing the gap there, and amortized O(1) for appending it to 'toList'.
      **/
     static void moveTask( PkgTask *      task,
                           PkgTaskList &  fromList,
@@ -0,0 +1,331 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <QSet>
+
+#include <zypp/Package.h>
+#include <zypp/sat/Pool.h>
+#include <zypp/sat/WhatProvides.h>
+
+#include "Exception.h"
+#include "Logger.h"
+#include "ReverseDepIndex.h"
+
+
+// Time slice for building the index from the event loop
+#define BUILD_SLICE_MILLISEC    20
+
+// Check the time only every so many items: QElapsedTimer is not free
+#define ITEMS_PER_TIME_CHECK    64
+
+
+ReverseDepIndex * ReverseDepIndex::_instance = 0;
+
+
+ReverseDepIndex::ReverseDepIndex()
+    : QObject()
+    , _phase( Idle )
+    , _nextIndex( 0 )
+    , _complete( false )
+    , _suspended( false )
+    , _buildPending( false )
+{
+    _timer.setInterval( 0 );
+
+    connect( &_timer, SIGNAL( timeout()    ),
+             this,    SLOT  ( buildSlice() ) );
+}
+
+
+ReverseDepIndex::~ReverseDepIndex()
+{
+    _timer.stop();
+
+    if ( _instance == this )
+        _instance = 0;
+}
+
+
+ReverseDepIndex *
+ReverseDepIndex::instance()
+{
+    if ( ! _instance )
+    {
+        _instance = new ReverseDepIndex();
+        CHECK_NEW( _instance );
+    }
+
+    return _instance;
+}
+
+
+bool
+ReverseDepIndex::isReady() const
+{
+    return _complete
+        && _phase == Idle
+        && ! poolChanged();
+}
+
+
+void
+ReverseDepIndex::clear()
+{
+    _timer.stop();
+
+    _phase        = Idle;
+    _nextIndex    = 0;
+    _complete     = false;
+    _buildPending = false;
+
+    _solvables.clear();
+    _capIds.clear();
+    _capIndex.clear();
+    _providerIndex.clear();
+}
+
+
+void
+ReverseDepIndex::startBuild()
+{
+    clear();
+
+    if ( _suspended )
+    {
+        // Don't even take the snapshot of the solvables now: resume() will
+        // start the build.
+
+        _buildPending = true;
+        return;
+    }
+
+    zypp::sat::Pool satPool = zypp::sat::Pool::instance();
+    _poolSerial.remember( satPool.serial() );
+
+    for ( const zypp::sat::Solvable & solvable: satPool.solvables() )
+    {
+        if ( solvable.isKind<zypp::Package>() )
+            _solvables << solvable;
+    }
+
+    logDebug() << "Building reverse dependency index for "
+               << _solvables.size() << " packages in the background"
+               << endl;
+
+    _phase = CollectRequires;
+    _buildTimer.start();
+    _timer.start();
+}
+
+
+void
+ReverseDepIndex::suspend()
+{
+    if ( _suspended )
+        return;
+
+    _suspended = true;
+    _timer.stop();
+
+    if ( _phase != Idle )
+        logDebug() << "Reverse dependency index build suspended" << endl;
+}
+
+
+void
+ReverseDepIndex::resume()
+{
+    if ( ! _suspended )
+        return;
+
+    _suspended = false;
+
+    if ( _buildPending || ( _phase != Idle && poolChanged() ) )
+    {
+        // The solvables that were collected so far might be gone
+        startBuild();
+    }
+    else if ( _phase != Idle )
+    {
+        logDebug() << "Resuming reverse dependency index build" << endl;
+        _timer.start();
+    }
+}
+
+
+void
+ReverseDepIndex::ensureReady()
+{
+    if ( isReady() || _suspended )
+        return;
+
+    // A build in progress that was started on an older sat pool would only
+    // deliver an outdated index: Discard it and start again.
+
+    if ( _phase == Idle || poolChanged() )
+        startBuild();
+
+    build( -1 );  // No time limit
+}
+
+
+void
+ReverseDepIndex::buildSlice()
+{
+    if ( poolChanged() )
+    {
+        logDebug() << "Sat pool changed; restarting reverse dependency index build" << endl;
+        startBuild();
+
+        return;
+    }
+
+    build( BUILD_SLICE_MILLISEC );
+}
+
+
+bool
+ReverseDepIndex::poolChanged() const
+{
+    return _poolSerial.isDirty( zypp::sat::Pool::instance().serial() );
+}
+
+
+void
+ReverseDepIndex::build( int maxMillisec )
+{
+    QElapsedTimer sliceTimer;
+    sliceTimer.start();
+    int count = 0;
+
+    while ( _phase != Idle )
+    {
+        if ( _phase == CollectRequires )
+        {
+            if ( _nextIndex < _solvables.size() )
+            {
+                collectRequires( _solvables[ _nextIndex++ ] );
+            }
+            else // Next phase
+            {
+                _capIds    = _capIndex.keys();
+                _nextIndex = 0;
+                _phase     = ResolveProviders;
+                _solvables.clear();
+            }
+        }
+        else if ( _phase == ResolveProviders )
+        {
+            if ( _nextIndex < _capIds.size() )
+            {
+                resolveProviders( _capIds[ _nextIndex++ ] );
+            }
+            else // Done
+            {
+                _timer.stop();
+                _capIds.clear();
+                _nextIndex = 0;
+                _phase     = Idle;
+                _complete  = true;
+
+                logInfo() << "Reverse dependency index built in "
+                          << _buildTimer.elapsed() / 1000.0 << " sec: "
+                          << _capIndex.size() << " capabilities, "
+                          << _providerIndex.size() << " providers"
+                          << endl;
+
+                emit ready();
+                return;
+            }
+        }
+
+        if ( maxMillisec >= 0
+             && ++count % ITEMS_PER_TIME_CHECK == 0
+             && sliceTimer.elapsed() >= maxMillisec )
+        {
+            return;  // Continue in the next time slice
+        }
+    }
+}
+
+
+void
+ReverseDepIndex::collectRequires( const zypp::sat::Solvable & solvable )
+{
+    for ( const zypp::Capability & cap: solvable.requires() )
+        _capIndex[ cap.id() ].append( solvable.id() );
+}
+
+
+void
+ReverseDepIndex::resolveProviders( SatId capId )
+{
+    const QVector<SatId> requirers = _capIndex.value( capId );
+
+    for ( const zypp::sat::Solvable & provider: zypp::sat::WhatProvides( zypp::Capability( capId ) ) )
+    {
+        QVector<SatId> & providerRequirers = _providerIndex[ provider.id() ];
+
+        for ( SatId requirer: requirers )
+        {
+            if ( requirer != provider.id() )  // Packages requiring themselves
+                providerRequirers.append( requirer );
+        }
+    }
+}
+
+
+SolvableList
+ReverseDepIndex::requiredBy( const zypp::Capability & cap ) const
+{
+    if ( ! isReady() )
+        return SolvableList();
+
+    return toSolvableList( _capIndex.value( cap.id() ) );
+}
+
+
+SolvableList
+ReverseDepIndex::requiredBy( const zypp::sat::Solvable & provider ) const
+{
+    if ( ! isReady() )
+        return SolvableList();
+
+    return toSolvableList( _providerIndex.value( provider.id() ) );
+}
+
+
+SolvableList
+ReverseDepIndex::toSolvableList( const QVector<SatId> & ids )
+{
+    // A package that requires several capabilities of the same provider is
+    // listed several times in the provider index; report it only once.
+
+    SolvableList  result;
+    QSet<SatId>   seen;
+
+    for ( SatId id: ids )
+    {
+        if ( ! seen.contains( id ) )
+        {
+            seen.insert( id );
+            result << zypp::sat::Solvable( id );
+        }
+    }
+
+    return result;
+}
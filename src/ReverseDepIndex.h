@@ -0,0 +1,226 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#ifndef ReverseDepIndex_h
+#define ReverseDepIndex_h
+
+#include <QObject>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QList>
+#include <QTimer>
+#include <QVector>
+
+#include <zypp/Capability.h>
+#include <zypp/base/SerialNumber.h>
+#include <zypp/sat/Solvable.h>
+
+
+typedef zypp::sat::detail::IdType         SatId;
+typedef QList<zypp::sat::Solvable>        SolvableList;
+
+
+/**
+ * Reverse dependency index for the sat pool: Which packages require a
+ * capability, and which packages require a given package (via any of the
+ * capabilities that it provides).
+ *
+ * Finding that out on demand with a zypp::PoolQuery over solvable:requires is
+ * a full text scan over the whole pool. This index is built once after the
+ * repos are loaded: First all requires of all packages are collected in a
+ * capability -> requiring solvables map, then each of those capabilities is
+ * resolved once through the sat pool's whatprovides index to build the
+ * provider -> requiring solvables map.
+ *
+ * libzypp is not thread-safe, so the index is built in the background in
+ * small time slices from the Qt event loop so the GUI remains responsive.
+ *
+ * The index is automatically invalidated when the sat pool changes,
+ * i.e. when repos are added, removed or reloaded.
+ **/
+class ReverseDepIndex: public QObject
+{
+    Q_OBJECT
+
+protected:
+
+    /**
+     * Constructor. Use instance() instead.
+     **/
+    ReverseDepIndex();
+
+public:
+
+    /**
+     * Destructor.
+     **/
+    virtual ~ReverseDepIndex();
+
+    /**
+     * Return the instance of this class. Create it if it doesn't exist yet.
+     **/
+    static ReverseDepIndex * instance();
+
+    /**
+     * Return 'true' if the index is completely built and still up to date
+     * with the sat pool.
+     **/
+    bool isReady() const;
+
+    /**
+     * Return 'true' if the index is currently being built in the background.
+     **/
+    bool isBuilding() const { return _phase != Idle; }
+
+    /**
+     * Return 'true' if building the index is suspended.
+     **/
+    bool isSuspended() const { return _suspended; }
+
+    /**
+     * Return the packages that require the capability 'cap' exactly as
+     * written in their requires. This returns an empty list if the index is
+     * not ready.
+     **/
+    SolvableList requiredBy( const zypp::Capability & cap ) const;
+
+    /**
+     * Return the packages that require any capability that 'provider'
+     * provides, i.e. the packages that would be satisfied by 'provider'.
+     * This does not include 'provider' itself. This returns an empty list if
+     * the index is not ready.
+     **/
+    SolvableList requiredBy( const zypp::sat::Solvable & provider ) const;
+
+
+public slots:
+
+    /**
+     * Start building the index in the background. If a build is already in
+     * progress, it is discarded and started again from scratch.
+     *
+     * The ready() signal is emitted when the build is finished.
+     **/
+    void startBuild();
+
+    /**
+     * Make sure the index is ready: Start a build if the index is outdated,
+     * and finish the build synchronously (blocking) if one is in progress.
+     *
+     * Use this only in response to an explicit user request.
+     **/
+    void ensureReady();
+
+    /**
+     * Discard all index data.
+     **/
+    void clear();
+
+    /**
+     * Stop working on a build in progress until resume() is called.
+     *
+     * Use this while something else changes the sat pool, e.g. while the
+     * package commit is running in another thread.
+     **/
+    void suspend();
+
+    /**
+     * Continue a build that was stopped with suspend(), or start it again
+     * from scratch if the sat pool changed in the meantime.
+     **/
+    void resume();
+
+
+signals:
+
+    /**
+     * Emitted when building the index is finished.
+     **/
+    void ready();
+
+
+protected slots:
+
+    /**
+     * Do one time slice of work for building the index.
+     * This is called from the Qt event loop with a zero-timeout timer.
+     **/
+    void buildSlice();
+
+
+protected:
+
+    enum BuildPhase
+    {
+        Idle,
+        CollectRequires,
+        ResolveProviders
+    };
+
+    /**
+     * Return 'true' if the sat pool changed since the current or the last
+     * build was started.
+     **/
+    bool poolChanged() const;
+
+    /**
+     * Work on the current build phase until 'maxMillisec' have elapsed or
+     * until the build is finished. A negative value means no time limit.
+     **/
+    void build( int maxMillisec );
+
+    /**
+     * Collect the requires of one solvable into _capIndex.
+     **/
+    void collectRequires( const zypp::sat::Solvable & solvable );
+
+    /**
+     * Resolve one required capability through whatprovides and add its
+     * requirers to _providerIndex.
+     **/
+    void resolveProviders( SatId capId );
+
+    /**
+     * Convert a list of solvable IDs to a SolvableList.
+     **/
+    static SolvableList toSolvableList( const QVector<SatId> & ids );
+
+
+    //
+    // Data members
+    //
+
+    BuildPhase                    _phase;
+    QTimer                        _timer;
+    QElapsedTimer                 _buildTimer;
+    QVector<zypp::sat::Solvable>  _solvables;
+    QVector<SatId>                _capIds;
+    int                           _nextIndex;
+    bool                          _complete;
+    bool                          _suspended;
+    bool                          _buildPending;
+
+    QHash<SatId, QVector<SatId> > _capIndex;      // capability -> requirers
+    QHash<SatId, QVector<SatId> > _providerIndex; // provider   -> requirers
+
+    zypp::SerialNumberWatcher     _poolSerial;
+
+    static ReverseDepIndex *      _instance;
+};
+
+
+#endif // ReverseDepIndex_h
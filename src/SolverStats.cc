@@ -0,0 +1,203 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include "Exception.h"
+#include "FlightRecorder.h"
+#include "Logger.h"
+#include "YQZypp.h"
+#include "YQi18n.h"
+#include "utf8.h"
+#include "SolverStats.h"
+
+
+// Log solver runs that take longer than this as a warning
+#define SLOW_SOLVER_RUN_MILLISEC        3000
+
+
+SolverStats * SolverStats::_instance = 0;
+
+
+SolverStats * SolverStats::instance()
+{
+    if ( ! _instance )
+    {
+        _instance = new SolverStats();
+        CHECK_NEW( _instance );
+    }
+
+    return _instance;
+}
+
+
+SolverStats::SolverStats()
+    : QObject()
+    , _totalCount( 0 )
+    , _totalDurationUsec( 0 )
+    , _maxDurationUsec( 0 )
+    , _collectTransactions( false )
+{
+}
+
+
+const SolverRun &
+SolverStats::record( SolverRunKind kind,
+                     qint64        durationUsec,
+                     bool          success,
+                     int           problemCount )
+{
+    SolverRun run;
+
+    run.kind          = kind;
+    run.time          = QDateTime::currentDateTime();
+    run.durationUsec  = durationUsec;
+    run.success       = success;
+    run.problemCount  = problemCount;
+
+    collectTransaction( run );
+    logRun( run );
+
+    ++_totalCount;
+    _totalDurationUsec += durationUsec;
+    _maxDurationUsec    = qMax( _maxDurationUsec, durationUsec );
+
+    if ( _runs.size() >= SOLVER_STATS_MAX_RUNS )
+        _runs.removeFirst();
+
+    _runs << run;
+    emit runAdded();
+
+    return _runs.last();
+}
+
+
+void SolverStats::collectTransaction( SolverRun & run )
+{
+    ByteCount::SizeType downloadSize       = 0;
+    ByteCount::SizeType installedSizeDelta = 0;
+
+    run.transactionKnown = _collectTransactions;
+    run.userChanges      = 0;
+    run.solverChanges    = 0;
+
+    if ( ! _collectTransactions )
+        return;
+
+    for ( ZyppPoolIterator it = zyppPkgBegin(); it != zyppPkgEnd(); ++it )
+    {
+        ZyppSel selectable = *it;
+        bool    add        = false;
+        bool    remove     = false;
+
+        switch ( selectable->status() )
+        {
+            case S_Install:     ++run.userChanges;   add = true;                break;
+            case S_Update:      ++run.userChanges;   add = true; remove = true; break;
+            case S_Del:         ++run.userChanges;   remove = true;             break;
+
+            case S_AutoInstall: ++run.solverChanges; add = true;                break;
+            case S_AutoUpdate:  ++run.solverChanges; add = true; remove = true; break;
+            case S_AutoDel:     ++run.solverChanges; remove = true;             break;
+
+            case S_NoInst:
+            case S_KeepInstalled:
+            case S_Protected:
+            case S_Taboo:
+                break;
+
+                // Intentionally omitting 'default' branch so the compiler can
+                // catch unhandled enum states
+        }
+
+        if ( add && selectable->candidateObj() )
+        {
+            downloadSize       += (ByteCount::SizeType) selectable->candidateObj()->downloadSize();
+            installedSizeDelta += (ByteCount::SizeType) selectable->candidateObj()->installSize();
+        }
+
+        if ( remove && selectable->installedObj() )
+            installedSizeDelta -= (ByteCount::SizeType) selectable->installedObj()->installSize();
+    }
+
+    run.downloadSize       = ByteCount( downloadSize );
+    run.installedSizeDelta = ByteCount( installedSizeDelta );
+}
+
+
+void SolverStats::logRun( const SolverRun & run )
+{
+    QString text = QString( "Solver run #%1: %2 took %3 millisec; %4, %5 problems" )
+        .arg( _totalCount + 1 )
+        .arg( kindLogName( run.kind ) )
+        .arg( run.durationUsec / 1000.0, 0, 'f', 1 )
+        .arg( QString( run.success ? "success" : "failure" ) )
+        .arg( run.problemCount );
+
+    if ( run.transactionKnown )
+    {
+        text += QString( "; %1 packages changed by the user, %2 by the solver; "
+                         "download size %3, installed size change %4" )
+            .arg( run.userChanges )
+            .arg( run.solverChanges )
+            .arg( fromUTF8( run.downloadSize.asString() ) )
+            .arg( fromUTF8( run.installedSizeDelta.asString() ) );
+    }
+
+    if ( run.durationUsec / 1000 > SLOW_SOLVER_RUN_MILLISEC )
+        logWarning() << "SLOW " << text << endl;
+    else
+        logInfo() << text << endl;
+
+    FlightRecorder::instance()->record( "solver-stats",
+                                        kindLogName( run.kind ),
+                                        run.userChanges + run.solverChanges,
+                                        run.durationUsec );
+}
+
+
+QString SolverStats::kindName( SolverRunKind kind )
+{
+    switch ( kind )
+    {
+        case SolverResolve:     return _( "Dependency Check" );
+        case SolverVerify:      return _( "System Verification" );
+        case SolverUpdate:      return _( "Package Update" );
+        case SolverDistUpgrade: return _( "Distribution Upgrade" );
+
+            // Intentionally omitting 'default' branch so the compiler can
+            // catch unhandled enum values
+    }
+
+    return QString();
+}
+
+
+const char * SolverStats::kindLogName( SolverRunKind kind )
+{
+    switch ( kind )
+    {
+        case SolverResolve:     return "resolve";
+        case SolverVerify:      return "verify";
+        case SolverUpdate:      return "update";
+        case SolverDistUpgrade: return "dist-upgrade";
+
+            // Intentionally omitting 'default' branch so the compiler can
+            // catch unhandled enum values
+    }
+
+    return "";
+}
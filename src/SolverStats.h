@@ -0,0 +1,180 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef SolverStats_h
+#define SolverStats_h
+
+
+#include <QDateTime>
+#include <QList>
+#include <QObject>
+#include <QString>
+
+#include <zypp-core/ByteCount.h>
+
+using zypp::ByteCount;
+
+
+// Number of solver runs that are kept
+#define SOLVER_STATS_MAX_RUNS   200
+
+
+/**
+ * The different kinds of solver runs that YQPkgConflictDialog starts.
+ **/
+enum SolverRunKind
+{
+    SolverResolve,      // solveAndShowConflicts()
+    SolverVerify,       // verifySystem()
+    SolverUpdate,       // doPackageUpdate()
+    SolverDistUpgrade   // doDistUpgrade()
+};
+
+
+/**
+ * Statistics about one solver run.
+ **/
+struct SolverRun
+{
+    SolverRunKind kind;
+    QDateTime     time;                 // when the run was finished
+    qint64        durationUsec;
+    bool          success;
+    int           problemCount;
+    bool          transactionKnown;     // the next four fields are valid
+    int           userChanges;          // packages changed by the user
+    int           solverChanges;        // packages changed by the solver
+    ByteCount     downloadSize;         // for all packages to be installed
+    ByteCount     installedSizeDelta;   // may be negative
+};
+
+
+/**
+ * Statistics for every solver run: Kind, duration, number of problems, the
+ * size of the resulting transaction. This is meant to spot pathological
+ * solver runs on specific hosts.
+ *
+ * Each run is also logged, with a warning if it took unusually long. Only
+ * the last SOLVER_STATS_MAX_RUNS runs are kept.
+ *
+ * Collecting the transaction size has to go through the whole pool, so this
+ * is only done while somebody is interested (see setCollectTransactions()).
+ *
+ * This is a singleton class.
+ **/
+class SolverStats: public QObject
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Return the singleton of this class. Create it if it doesn't exist yet.
+     **/
+    static SolverStats * instance();
+
+    /**
+     * Record a solver run that was just finished. If enabled, this collects
+     * the transaction size from the pool, so call it before the conflict
+     * dialog is shown and the user can change anything.
+     **/
+    const SolverRun & record( SolverRunKind kind,
+                              qint64        durationUsec,
+                              bool          success,
+                              int           problemCount );
+
+    /**
+     * Enable or disable collecting the transaction size of the solver runs.
+     * This is off by default; the solver statistics dialog switches it on
+     * while it is open.
+     **/
+    void setCollectTransactions( bool collect ) { _collectTransactions = collect; }
+
+    /**
+     * Return the recorded solver runs, the oldest first.
+     **/
+    const QList<SolverRun> & runs() const { return _runs; }
+
+    /**
+     * Return the total number of solver runs since the program start,
+     * including the ones that are no longer kept.
+     **/
+    int totalCount() const { return _totalCount; }
+
+    /**
+     * Return the total duration of all solver runs since the program start.
+     **/
+    qint64 totalDurationUsec() const { return _totalDurationUsec; }
+
+    /**
+     * Return the duration of the slowest solver run since the program start.
+     **/
+    qint64 maxDurationUsec() const { return _maxDurationUsec; }
+
+    /**
+     * Return a translated, user-readable name for a solver run kind.
+     **/
+    static QString kindName( SolverRunKind kind );
+
+    /**
+     * Return the untranslated name of a solver run kind for the log.
+     **/
+    static const char * kindLogName( SolverRunKind kind );
+
+
+signals:
+
+    /**
+     * Emitted after a solver run was recorded. The new run is the last one
+     * in runs().
+     **/
+    void runAdded();
+
+
+protected:
+
+    /**
+     * Constructor. Use instance() instead.
+     **/
+    SolverStats();
+
+    /**
+     * Count the packages that are changed by the user and by the solver and
+     * sum up their sizes.
+     **/
+    void collectTransaction( SolverRun & run );
+
+    /**
+     * Write a solver run to the log.
+     **/
+    void logRun( const SolverRun & run );
+
+
+    // Data members
+
+    QList<SolverRun> _runs;
+    int              _totalCount;
+    qint64           _totalDurationUsec;
+    qint64           _maxDurationUsec;
+    bool             _collectTransactions;
+
+    static SolverStats * _instance;
+};
+
+
+#endif // SolverStats_h
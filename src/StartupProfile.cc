@@ -0,0 +1,227 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <time.h>               // clock_gettime()
+#include <sys/resource.h>       // getrusage()
+#include <iostream>             // cerr
+
+#include <QEvent>
+#include <QTimer>
+#include <QWidget>
+
+#include "Exception.h"
+#include "Logger.h"
+#include "StartupProfile.h"
+
+
+StartupProfile * StartupProfile::instance()
+{
+    static StartupProfile * instance = 0;
+
+    if ( ! instance )
+    {
+        instance = new StartupProfile();
+        CHECK_NEW( instance );
+    }
+
+    return instance;
+}
+
+
+StartupProfile::StartupProfile()
+    : _enabled( false )
+    , _finished( false )
+    , _ignoredDepth( 0 )
+{
+    _timer.start();
+}
+
+
+void StartupProfile::setEnabled( bool enabled )
+{
+    _enabled = enabled;
+
+    if ( _enabled )
+        _timer.restart();
+}
+
+
+void StartupProfile::beginPhase( const QString & name )
+{
+    if ( ! isEnabled() )
+    {
+        // Keep the nesting balanced for the matching endPhase() even if the
+        // profile is enabled in between
+
+        ++_ignoredDepth;
+        return;
+    }
+
+    Phase phase;
+    phase.name          = name;
+    phase.depth         = _openPhases.size();
+    phase.startWallUsec = _timer.nsecsElapsed() / 1000;
+    phase.startCpuUsec  = cpuMicrosec();
+    phase.wallUsec      = -1; // not ended yet
+    phase.cpuUsec       = -1;
+    phase.peakRssKB     = -1;
+
+    _openPhases << _phases.size();
+    _phases << phase;
+}
+
+
+void StartupProfile::endPhase()
+{
+    if ( _ignoredDepth > 0 )
+    {
+        --_ignoredDepth;
+        return;
+    }
+
+    if ( _openPhases.isEmpty() )
+        return;
+
+    Phase & phase = _phases[ _openPhases.takeLast() ];
+
+    phase.wallUsec  = _timer.nsecsElapsed() / 1000 - phase.startWallUsec;
+    phase.cpuUsec   = cpuMicrosec() - phase.startCpuUsec;
+    phase.peakRssKB = peakRssKB();
+}
+
+
+void StartupProfile::finish()
+{
+    if ( ! isEnabled() )
+        return;
+
+    while ( ! _openPhases.isEmpty() )
+        endPhase();
+
+    _finished = true;
+
+    for ( const QString & line: report() )
+    {
+        std::cerr << qPrintable( line ) << std::endl;
+        logInfo() << line << endl;
+    }
+}
+
+
+namespace
+{
+    /**
+     * Event filter that finishes the startup profile after the first paint
+     * of the widget it is installed on and then deletes itself.
+     **/
+    class FirstPaintFilter: public QObject
+    {
+    public:
+
+        FirstPaintFilter( QWidget * widget )
+            : QObject( widget )
+            { widget->installEventFilter( this ); }
+
+    protected:
+
+        virtual bool eventFilter( QObject * watched, QEvent * event ) override
+        {
+            if ( event->type() == QEvent::Paint )
+            {
+                watched->removeEventFilter( this );
+
+                // The children are painted after this widget in the same
+                // paint pass; the zero timer fires when that is complete.
+
+                QTimer::singleShot( 0, []() { StartupProfile::instance()->finish(); } );
+                deleteLater();
+            }
+
+            return false; // Don't filter out the event
+        }
+    };
+}
+
+
+void StartupProfile::finishAfterFirstPaint( QWidget * widget )
+{
+    if ( ! isEnabled() || ! widget )
+        return;
+
+    new FirstPaintFilter( widget );
+}
+
+
+QStringList StartupProfile::report() const
+{
+    QStringList lines;
+    const int nameWidth = 44;
+
+    lines << QString( "Startup profile:" ).leftJustified( nameWidth )
+        + QString( "wall ms" ).rightJustified( 10 )
+        + QString( "CPU ms"  ).rightJustified( 10 )
+        + QString( "RSS MB"  ).rightJustified( 10 );
+
+    qint64 totalWallUsec = 0;
+
+    for ( const Phase & phase: _phases )
+    {
+        QString name = QString( 2 * ( phase.depth + 1 ), ' ' ) + phase.name;
+
+        if ( phase.wallUsec < 0 )
+        {
+            lines << name.leftJustified( nameWidth ) + "  (not finished)";
+            continue;
+        }
+
+        lines << name.leftJustified( nameWidth )
+            + QString::number( phase.wallUsec  / 1000.0, 'f', 1 ).rightJustified( 10 )
+            + QString::number( phase.cpuUsec   / 1000.0, 'f', 1 ).rightJustified( 10 )
+            + QString::number( phase.peakRssKB / 1024.0, 'f', 1 ).rightJustified( 10 );
+
+        if ( phase.depth == 0 )
+            totalWallUsec += phase.wallUsec;
+    }
+
+    lines << QString( "  Total of the toplevel phases" ).leftJustified( nameWidth )
+        + QString::number( totalWallUsec / 1000.0, 'f', 1 ).rightJustified( 10 );
+
+    return lines;
+}
+
+
+qint64 StartupProfile::cpuMicrosec()
+{
+    struct timespec cpuTime;
+
+    if ( clock_gettime( CLOCK_PROCESS_CPUTIME_ID, &cpuTime ) != 0 )
+        return 0;
+
+    return (qint64) cpuTime.tv_sec * 1000000 + cpuTime.tv_nsec / 1000;
+}
+
+
+qint64 StartupProfile::peakRssKB()
+{
+    struct rusage usage;
+
+    if ( getrusage( RUSAGE_SELF, &usage ) != 0 )
+        return 0;
+
+    return usage.ru_maxrss; // kB on Linux
+}
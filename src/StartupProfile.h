@@ -0,0 +1,153 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef StartupProfile_h
+#define StartupProfile_h
+
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QString>
+#include <QStringList>
+
+class QWidget;
+
+/**
+ * Hierarchical wall clock / CPU time profile of the phases of the program
+ * startup for the --startup-profile command line option.
+ *
+ * Phases are begun and ended in strict nesting order, usually with a
+ * StartupPhase instance on the stack. If the profile is not enabled, this
+ * does nothing.
+ *
+ * This is only intended to be used from the GUI thread.
+ **/
+class StartupProfile
+{
+public:
+
+    /**
+     * Return the singleton of this class. Create it if it doesn't exist yet.
+     **/
+    static StartupProfile * instance();
+
+    /**
+     * Enable or disable the profile. Phases that are begun while the profile
+     * is disabled are not recorded.
+     **/
+    void setEnabled( bool enabled = true );
+
+    /**
+     * Return 'true' if the profile is enabled and not finished yet.
+     **/
+    bool isEnabled() const { return _enabled && ! _finished; }
+
+    /**
+     * Begin a new phase. It becomes a child of the innermost phase that is
+     * still open.
+     **/
+    void beginPhase( const QString & name );
+
+    /**
+     * End the innermost open phase.
+     **/
+    void endPhase();
+
+    /**
+     * End all phases that are still open and write the report to stderr and
+     * to the log. Any later phases are ignored.
+     **/
+    void finish();
+
+    /**
+     * Call finish() when 'widget' is painted for the first time, after that
+     * paint pass is complete.
+     **/
+    void finishAfterFirstPaint( QWidget * widget );
+
+    /**
+     * Return the report as text lines: A tree of all phases with their wall
+     * clock time, CPU time and the peak RSS at the end of each phase.
+     **/
+    QStringList report() const;
+
+    /**
+     * Return the CPU time of this process so far (all threads) in
+     * microseconds.
+     **/
+    static qint64 cpuMicrosec();
+
+    /**
+     * Return the peak resident set size of this process so far in kB.
+     **/
+    static qint64 peakRssKB();
+
+
+protected:
+
+    /**
+     * Constructor. Use instance() instead.
+     **/
+    StartupProfile();
+
+
+    struct Phase
+    {
+        QString name;
+        int     depth;
+        qint64  startWallUsec;
+        qint64  startCpuUsec;
+        qint64  wallUsec;
+        qint64  cpuUsec;
+        qint64  peakRssKB;
+    };
+
+    //
+    // Data members
+    //
+
+    QElapsedTimer   _timer;
+    QList<Phase>    _phases;
+    QList<int>      _openPhases;   // Indices into _phases
+    bool            _enabled;
+    bool            _finished;
+    int             _ignoredDepth; // Phases begun while disabled
+};
+
+
+/**
+ * Profile phase for the lifetime of an instance of this class:
+ *
+ *     {
+ *         StartupPhase phase( "Load repos" );
+ *         ...
+ *     }
+ **/
+class StartupPhase
+{
+public:
+
+    StartupPhase( const QString & name )
+        { StartupProfile::instance()->beginPhase( name ); }
+
+    ~StartupPhase()
+        { StartupProfile::instance()->endPhase(); }
+};
+
+
+#endif // StartupProfile_h
@@ -24,6 +24,8 @@
 #include "Logger.h"
 #include "MainWindow.h"
 #include "MyrlynApp.h"
+#include "PkgCommitPage.h"
+#include "PkgCommitTimeline.h"
 #include "PkgTasks.h"
 #include "MyrlynApp.h"
 #include "YQi18n.h"
@@ -274,8 +276,10 @@ void SummaryPage::fakeDoneList()
 {
     // --fake-summary:  Move all remaining tasks from "todo" to "done".
 
-    pkgTasks()->done() << pkgTasks()->todo();
-    pkgTasks()->todo().clear();
+    PkgTaskList & todo = pkgTasks()->todo();
+
+    while ( ! todo.isEmpty() )
+        PkgTasks::moveTask( todo.last(), todo, pkgTasks()->done() );
 }
 
 
@@ -306,6 +310,11 @@ QString SummaryPage::longSummary( int byUserMax, int byDepMax )
     lines << listSummary( updatedByDep,    _( "Packages updated because of dependencies: %1"   ), byDepMax  );
     lines << listSummary( todoPkg,         _( "To do: %1"                                      ), byDepMax  );
 
+    if ( PkgCommitPage::instance() )
+        lines << PkgCommitPage::instance()->commitStats();
+
+    lines << PkgCommitTimeline::instance()->slowestPackages( 10 );
+
     return lines.join( "\n" );
 }
 
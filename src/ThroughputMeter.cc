@@ -0,0 +1,102 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include "ThroughputMeter.h"
+
+
+ThroughputMeter::ThroughputMeter( int windowMillisec,
+                                  int maxGapMillisec )
+    : _windowMillisec( windowMillisec )
+    , _maxGapMillisec( maxGapMillisec )
+{
+    reset();
+}
+
+
+void ThroughputMeter::reset()
+{
+    _timer.invalidate();
+    _lastMillisec      = 0;
+    _firstBytes        = 0;
+    _lastBytes         = 0;
+    _activeMillisec    = 0;
+    _windowBytes       = 0;
+    _windowMillisecSum = 0;
+    _window.clear();
+}
+
+
+void ThroughputMeter::addSample( qint64 totalBytes )
+{
+    if ( ! _timer.isValid() )
+    {
+        // The first sample only provides the starting point
+
+        _timer.start();
+        _lastMillisec = 0;
+        _firstBytes   = totalBytes;
+        _lastBytes    = totalBytes;
+
+        return;
+    }
+
+    qint64 deltaBytes = totalBytes - _lastBytes;
+
+    if ( deltaBytes <= 0 )
+        return; // Keep the old time stamp: The time until the next change counts
+
+    qint64 now      = _timer.elapsed();
+    qint64 millisec = qMin( now - _lastMillisec, (qint64) _maxGapMillisec );
+
+    _lastMillisec    = now;
+    _lastBytes       = totalBytes;
+    _activeMillisec += millisec;
+
+    _window.append( { deltaBytes, millisec } );
+    _windowBytes       += deltaBytes;
+    _windowMillisecSum += millisec;
+
+    // Drop the oldest samples that are outside the window, but keep at least
+    // one
+
+    while ( _window.size() > 1 &&
+            _windowMillisecSum - _window.first().millisec >= _windowMillisec )
+    {
+        _windowBytes       -= _window.first().bytes;
+        _windowMillisecSum -= _window.first().millisec;
+        _window.removeFirst();
+    }
+}
+
+
+double ThroughputMeter::bytesPerSecond() const
+{
+    if ( _windowMillisecSum <= 0 )
+        return 0.0;
+
+    return ( 1000.0 * _windowBytes ) / _windowMillisecSum;
+}
+
+
+double ThroughputMeter::averageBytesPerSecond() const
+{
+    if ( _activeMillisec <= 0 )
+        return 0.0;
+
+    return ( 1000.0 * ( _lastBytes - _firstBytes ) ) / _activeMillisec;
+}
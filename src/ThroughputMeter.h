@@ -0,0 +1,109 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef ThroughputMeter_h
+#define ThroughputMeter_h
+
+
+#include <QElapsedTimer>
+#include <QList>
+
+
+/**
+ * Class to measure the throughput (bytes per second) of an ongoing operation
+ * like downloading or installing packages from samples of the cumulative
+ * number of bytes done so far.
+ *
+ * The current rate is calculated over a moving window of the most recent
+ * samples. Gaps between samples are only counted up to a maximum, so the
+ * rate doesn't drop to nearly zero just because this operation was idle for a
+ * while, e.g. because downloads and installations alternate.
+ **/
+class ThroughputMeter
+{
+public:
+
+    /**
+     * Constructor.
+     *
+     * 'windowMillisec' is the length of the moving window for the current
+     * rate, 'maxGapMillisec' the maximum time that is counted between two
+     * samples.
+     **/
+    ThroughputMeter( int windowMillisec = 10000,
+                     int maxGapMillisec =  5000 );
+
+    /**
+     * Clear all samples and start over.
+     **/
+    void reset();
+
+    /**
+     * Add a sample: 'totalBytes' is the cumulative number of bytes done so
+     * far, not a delta.
+     **/
+    void addSample( qint64 totalBytes );
+
+    /**
+     * Return the current rate over the moving window in bytes per second or
+     * 0.0 if there are not enough samples yet.
+     **/
+    double bytesPerSecond() const;
+
+    /**
+     * Return the average rate over the whole active time in bytes per second
+     * or 0.0 if there was no active time.
+     **/
+    double averageBytesPerSecond() const;
+
+    /**
+     * Return the cumulative number of bytes of the last sample.
+     **/
+    qint64 totalBytes() const { return _lastBytes; }
+
+    /**
+     * Return the total active time in milliseconds, i.e. the sum of all the
+     * (capped) gaps between samples that added some bytes.
+     **/
+    qint64 activeMillisec() const { return _activeMillisec; }
+
+
+protected:
+
+    struct Sample
+    {
+        qint64 bytes;           // delta to the previous sample
+        qint64 millisec;        // (capped) delta to the previous sample
+    };
+
+    int             _windowMillisec;
+    int             _maxGapMillisec;
+
+    QElapsedTimer   _timer;
+    qint64          _lastMillisec;
+    qint64          _firstBytes;
+    qint64          _lastBytes;
+    qint64          _activeMillisec;
+
+    QList<Sample>   _window;
+    qint64          _windowBytes;
+    qint64          _windowMillisecSum;
+};
+
+
+#endif // ThroughputMeter_h
@@ -33,9 +33,11 @@
 #include <QBoxLayout>
 
 #include "BusyPopup.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
 #include "MainWindow.h"
 #include "QY2LayoutUtils.h"
+#include "SolverStats.h"
 #include "WindowSettings.h"
 #include "YQPkgConflictList.h"
 #include "YQPkgConflictDialog.h"
@@ -173,11 +175,14 @@ YQPkgConflictDialog::solveAndShowConflicts()
     prepareSolving();
     // logInfo() << "Resolving dependencies..." << endl;
 
-    bool success = zypp::getZYpp()->resolver()->resolvePool();
+    qint64 startUsec = FlightRecorder::usecNow();
+    bool   success   = zypp::getZYpp()->resolver()->resolvePool();
+
+    qint64 durationUsec = recordSolverRun( "solver-resolve", startUsec, success );
 
     // logDebug() << "Resolving dependencies done." << endl;
 
-    return processSolverResult( success );
+    return processSolverResult( SolverResolve, durationUsec, success );
 }
 
 
@@ -193,14 +198,17 @@ YQPkgConflictDialog::verifySystem( bool showBusyPopup )
     prepareSolving();
     logInfo() << "Verifying all system dependencies..." << endl;
 
-    bool success = zypp::getZYpp()->resolver()->verifySystem();
+    qint64 startUsec = FlightRecorder::usecNow();
+    bool   success   = zypp::getZYpp()->resolver()->verifySystem();
+
+    qint64 durationUsec = recordSolverRun( "solver-verify", startUsec, success );
 
     logDebug() << "System dependencies verified." << endl;
 
     if ( busyPopup )
         delete busyPopup;
 
-    return processSolverResult( success );
+    return processSolverResult( SolverVerify, durationUsec, success );
 }
 
 
@@ -218,12 +226,15 @@ YQPkgConflictDialog::doPackageUpdate()
     prepareSolving();
     logInfo() << "Starting a global package update ('zypper up' counterpart)..." << endl;
 
-    bool success = true;
+    bool   success   = true;
+    qint64 startUsec = FlightRecorder::usecNow();
     zypp::getZYpp()->resolver()->doUpdate(); // No return value, assume success.
 
+    qint64 durationUsec = recordSolverRun( "solver-update", startUsec, success );
+
     logDebug() << "Package update done." << endl;
 
-    return processSolverResult( success );
+    return processSolverResult( SolverUpdate, durationUsec, success );
 }
 
 
@@ -233,11 +244,27 @@ YQPkgConflictDialog::doDistUpgrade()
     prepareSolving();
     logInfo() << "Starting a dist upgrade ('zypper dup' counterpart)" << endl;
 
-    bool success = zypp::getZYpp()->resolver()->doUpgrade();
+    qint64 startUsec = FlightRecorder::usecNow();
+    bool   success   = zypp::getZYpp()->resolver()->doUpgrade();
+
+    qint64 durationUsec = recordSolverRun( "solver-dist-upgrade", startUsec, success );
 
     logDebug() << "Dist upgrade done." << endl;
 
-    return processSolverResult( success );
+    return processSolverResult( SolverDistUpgrade, durationUsec, success );
+}
+
+
+qint64
+YQPkgConflictDialog::recordSolverRun( const char *  event,
+                                      qint64        startUsec,
+                                      bool          success )
+{
+    qint64 durationUsec = FlightRecorder::usecNow() - startUsec;
+
+    FlightRecorder::instance()->record( event, 0, success, durationUsec );
+
+    return durationUsec;
 }
 
 
@@ -264,8 +291,21 @@ YQPkgConflictDialog::prepareSolving()
 
 
 int
-YQPkgConflictDialog::processSolverResult( bool success )
+YQPkgConflictDialog::processSolverResult( SolverRunKind kind,
+                                          qint64        durationUsec,
+                                          bool          success )
 {
+    // Fetching the problems is not for free, and there are none if the
+    // solver was successful.
+
+    ZyppProblemList problems;
+
+    if ( ! success )
+        problems = zypp::getZYpp()->resolver()->problems();
+
+    // Record this before the user can change anything in the conflict dialog
+    SolverStats::instance()->record( kind, durationUsec, success, (int) problems.size() );
+
     // Package states may have changed: The solver may have set packages to
     // autoInstall or autoUpdate. Make those changes known.
     emit updatePackages();
@@ -285,7 +325,7 @@ YQPkgConflictDialog::processSolverResult( bool success )
         logDebug() << "Dependency conflict!" << endl;
         busyCursor();
 
-        _conflictList->fill( zypp::getZYpp()->resolver()->problems() );
+        _conflictList->fill( problems );
         normalCursor();
 
         if ( ! isVisible() )
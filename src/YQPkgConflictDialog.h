@@ -21,6 +21,8 @@
 
 #include <QDialog>
 
+#include "SolverStats.h"
+
 class YQPkgConflictList;
 class QMenu;
 
@@ -146,11 +148,23 @@ protected:
     void prepareSolving();
 
     /**
-     * Process the result of solving: Post conflict dialog, if neccessary.
+     * Process the result of solving: Record it in the solver statistics
+     * and post the conflict dialog, if neccessary.
      * 'success' is the return value of the preceding solver call.
      * Returns either QDialog::Accepted or QDialog::Rejected.
      **/
-    int  processSolverResult( bool success );
+    int  processSolverResult( SolverRunKind kind,
+                              qint64        durationUsec,
+                              bool          success );
+
+    /**
+     * Record a solver run that was started at 'startUsec' (from
+     * FlightRecorder::usecNow()) in the flight recorder and return its
+     * duration. 'event' has to be a string literal.
+     **/
+    qint64 recordSolverRun( const char * event,
+                            qint64       startUsec,
+                            bool         success );
 
 
     //
@@ -14,21 +14,52 @@
     Textdomain "qt-pkg"
  */
 
+
+#include <QHeaderView>
+#include <QTabWidget>
+
 #include <zypp/Capability.h>
 #include <zypp/Dep.h>
 #include <zypp/Edition.h>
 #include <zypp/PoolItem.h>
+#include <zypp/Repository.h>
 #include <zypp/ResObject.h>
 #include <zypp/ResTraits.h>
+#include <zypp/sat/Solvable.h>
+#include <zypp/sat/WhatProvides.h>
 #include <zypp/ui/Selectable.h>
 
+#include "Logger.h"
 #include "YQi18n.h"
+#include "utf8.h"
 #include "YQPkgDependenciesView.h"
 
+#ifndef VERBOSE_DETAILS_VIEWS
+#  define VERBOSE_DETAILS_VIEWS  0
+#endif
+
 
 YQPkgDependenciesView::YQPkgDependenciesView( QWidget * parent )
-    : YQPkgGenericDetailsView( parent )
+    : QTreeWidget( parent )
+    , _selectable( 0 )
 {
+    setFrameStyle( QFrame::NoFrame );
+    setColumnCount( 2 );
+    setHeaderLabels( QStringList() << _( "Dependency" ) << _( "Details" ) );
+    setRootIsDecorated( true );
+    setAllColumnsShowFocus( true );
+    header()->setSectionResizeMode( 0, QHeaderView::ResizeToContents );
+
+    _parentTab = dynamic_cast<QTabWidget *>( parent );
+
+    if ( _parentTab )
+    {
+        connect( _parentTab, SIGNAL( currentChanged( int ) ),
+                 this,       SLOT  ( reloadTab     ( int ) ) );
+    }
+
+    connect( this, SIGNAL( itemExpanded( QTreeWidgetItem * ) ),
+             this, SLOT  ( populateItem( QTreeWidgetItem * ) ) );
 }
 
 
@@ -38,143 +69,233 @@ YQPkgDependenciesView::~YQPkgDependenciesView()
 }
 
 
+QSize
+YQPkgDependenciesView::minimumSizeHint() const
+{
+    return QSize( 0, 0 );
+}
+
+
 void
-YQPkgDependenciesView::showDetails( ZyppSel selectable )
+YQPkgDependenciesView::reloadTab( int newCurrent )
+{
+    if ( _parentTab && _parentTab->widget( newCurrent ) == this )
+        showDetailsIfVisible( _selectable );
+}
+
+
+void
+YQPkgDependenciesView::showDetailsIfVisible( ZyppSel selectable )
 {
     _selectable = selectable;
 
-    if ( ! selectable )
+    if ( _parentTab )  // Is this view embedded into a tab widget?
     {
-	clear();
-	return;
+        if ( _parentTab->currentWidget() == this )  // Is this page the topmost?
+        {
+#if VERBOSE_DETAILS_VIEWS
+
+            logVerbose() << "Showing "
+                         << ( selectable ? selectable->name() : "NULL" )
+                         << endl;
+#endif
+            showDetails( selectable );
+        }
     }
+    else  // No tab parent - simply show data unconditionally.
+    {
+        showDetails( selectable );
+    }
+}
+
+
+void
+YQPkgDependenciesView::showDetails( ZyppSel selectable )
+{
+    _selectable = selectable;
+    clear();
 
-    QString html_text = htmlStart();
-    html_text += htmlHeading( selectable );
+    if ( ! selectable )
+        return;
 
     ZyppObj candidate = selectable->candidateObj();
     ZyppObj installed = selectable->installedObj();
 
     if ( candidate && installed && candidate != installed )
     {
-	html_text += complexTable( installed, candidate );
+        addVersionItem( candidate, _( "Alternate Version" ) );
+        addVersionItem( installed, _( "Installed Version" ) );
     }
     else
     {
-	if ( candidate )
-	    html_text += simpleTable( candidate );
+        if ( candidate )
+            addVersionItem( candidate, _( "Version" ) );
+
+        if ( installed && installed != candidate )
+            addVersionItem( installed, _( "Installed Version" ) );
+    }
+}
+
+
+void
+YQPkgDependenciesView::addVersionItem( ZyppObj zyppObj, const QString & text )
+{
+    QTreeWidgetItem * versionItem = new QTreeWidgetItem( this );
+    versionItem->setText( 0, text );
+    versionItem->setText( 1, fromUTF8( zyppObj->name() ) + "-" +
+                          fromUTF8( zyppObj->edition().asString() ) );
+
+    QFont font = versionItem->font( 0 );
+    font.setBold( true );
+    versionItem->setFont( 0, font );
+
+    // Only the dependency kinds are created here; they are all collapsed, so
+    // nothing below them is fetched from the pool until the user opens them.
+
+    struct
+    {
+        QString   label;
+        zypp::Dep dep;
+    }
+    depKinds[] =
+    {
+        { _( "Provides:"     ), zypp::Dep::PROVIDES    },
+        { _( "Prerequires:"  ), zypp::Dep::PREREQUIRES },
+        { _( "Requires:"     ), zypp::Dep::REQUIRES    },
+        { _( "Conflicts:"    ), zypp::Dep::CONFLICTS   },
+        { _( "Obsoletes:"    ), zypp::Dep::OBSOLETES   },
+        { _( "Recommends:"   ), zypp::Dep::RECOMMENDS  },
+        { _( "Suggests:"     ), zypp::Dep::SUGGESTS    },
+        { _( "Enhances:"     ), zypp::Dep::ENHANCES    },
+        { _( "Supplements:"  ), zypp::Dep::SUPPLEMENTS }
+    };
+
+    for ( const auto & depKind: depKinds )
+    {
+        ZyppCap capSet = zyppObj->dep( depKind.dep );
 
-	if ( installed )
-	    html_text += simpleTable( installed );
+        if ( ! capSet.empty() )
+            new YQPkgDepKindItem( versionItem, depKind.label, capSet );
     }
 
-    html_text += htmlEnd();
+    versionItem->setExpanded( true );
+}
+
 
-    setHtml( html_text );
+void
+YQPkgDependenciesView::populateItem( QTreeWidgetItem * item )
+{
+    YQPkgLazyDependencyItem * lazyItem = dynamic_cast<YQPkgLazyDependencyItem *>( item );
+
+    if ( lazyItem && ! lazyItem->isPopulated() )
+    {
+        setUpdatesEnabled( false );
+        lazyItem->populate();
+        setUpdatesEnabled( true );
+    }
 }
 
 
-QString
-YQPkgDependenciesView::simpleTable( ZyppObj pkg )
+
+
+YQPkgLazyDependencyItem::YQPkgLazyDependencyItem( QTreeWidgetItem * parent )
+    : QTreeWidgetItem( parent )
+    , _populated( false )
 {
-    QString html = "<br>" +
-	table(
-	      row( hcell( _( "Version:" ) ) + cell( pkg->edition().asString()	) ) +
+    setChildIndicatorPolicy( QTreeWidgetItem::ShowIndicator );
+}
 
-	      row( _("Provides:"),	pkg->dep( zypp::Dep::PROVIDES		) ) +
-	      row( _("Prerequires:"),	pkg->dep( zypp::Dep::PREREQUIRES	) ) +
-	      row( _("Requires:"),	pkg->dep( zypp::Dep::REQUIRES		) ) +
-	      row( _("Conflicts:"),	pkg->dep( zypp::Dep::CONFLICTS		) ) +
-	      row( _("Obsoletes:"),	pkg->dep( zypp::Dep::OBSOLETES		) ) +
-	      row( _("Recommends:"),	pkg->dep( zypp::Dep::RECOMMENDS		) ) +
-	      row( _("Suggests:"),	pkg->dep( zypp::Dep::SUGGESTS		) ) +
-	      row( _("Enhances:"),	pkg->dep( zypp::Dep::ENHANCES		) ) +
-	      row( _("Supplements:"),	pkg->dep( zypp::Dep::SUPPLEMENTS	) )
-	      );
 
-    return html;
+YQPkgLazyDependencyItem::~YQPkgLazyDependencyItem()
+{
+    // NOP
 }
 
 
-QString
-YQPkgDependenciesView::complexTable( ZyppObj installed, ZyppObj candidate )
+void
+YQPkgLazyDependencyItem::populate()
 {
-    ZyppObj p1 = candidate;
-    ZyppObj p2 = installed;
+    if ( _populated )
+        return;
 
-    QString p1_header = _( "<b>Alternate Version</b>" );
-    QString p2_header = _( "<b>Installed Version</b>" );
+    _populated = true;
+    addChildren();
+    setChildIndicatorPolicy( QTreeWidgetItem::DontShowIndicatorWhenChildless );
+}
 
-    QString html = "<br>" +
-	table(
-	      row( hcell( QString( "" ) ) + hcell( "<b>" + p1_header + "</b>"	    ) + hcell( "<b>" + p2_header + "</b>" ) ) +
 
-	      row( hcell( _( "Version:" ) ) + cell( p1->edition().asString()	) + cell( p2->edition().asString()	) ) +
 
-	      row( _("Provides:"),	p1->dep( zypp::Dep::PROVIDES	), p2->dep( zypp::Dep::PROVIDES		) ) +
-	      row( _("Prerequires:"),	p1->dep( zypp::Dep::PREREQUIRES	), p2->dep( zypp::Dep::PREREQUIRES	) ) +
-	      row( _("Requires:"),	p1->dep( zypp::Dep::REQUIRES	), p2->dep( zypp::Dep::REQUIRES		) ) +
-	      row( _("Conflicts:"),	p1->dep( zypp::Dep::CONFLICTS	), p2->dep( zypp::Dep::CONFLICTS	) ) +
-	      row( _("Obsoletes:"),	p1->dep( zypp::Dep::OBSOLETES	), p2->dep( zypp::Dep::OBSOLETES	) ) +
-	      row( _("Recommends:"),	p1->dep( zypp::Dep::RECOMMENDS	), p2->dep( zypp::Dep::RECOMMENDS	) ) +
-	      row( _("Suggests:"),	p1->dep( zypp::Dep::SUGGESTS	), p2->dep( zypp::Dep::SUGGESTS		) ) +
-	      row( _("Enhances:"),	p1->dep( zypp::Dep::ENHANCES	), p2->dep( zypp::Dep::ENHANCES		) ) +
-	      row( _("Supplements:"),	p1->dep( zypp::Dep::SUPPLEMENTS	), p2->dep( zypp::Dep::SUPPLEMENTS	) )
-	      );
 
-    return html;
+YQPkgDepKindItem::YQPkgDepKindItem( QTreeWidgetItem * parent,
+                                    const QString &   label,
+                                    const ZyppCap &   capSet )
+    : YQPkgLazyDependencyItem( parent )
+    , _capSet( capSet )
+{
+    setText( 0, label );
+    setText( 1, QString::number( capSet.size() ) );
 }
 
 
-QString
-YQPkgDependenciesView::row( const QString & heading,
-			    const ZyppCap & capSet )
+YQPkgDepKindItem::~YQPkgDepKindItem()
 {
-    QString content = htmlLines( capSet );
+    // NOP
+}
 
-    if ( content.isEmpty() )
-	return "";
 
-    return QString( "<tr>" ) +
-	hcell( heading ) +
-	"<td>" + content + "</td>"
-	+ "</tr>";
+void
+YQPkgDepKindItem::addChildren()
+{
+    for ( const zypp::Capability & cap: _capSet )
+        new YQPkgCapabilityItem( this, cap );
 }
 
 
-QString
-YQPkgDependenciesView::row( const QString & heading,
-			    const ZyppCap & capSet1,
-			    const ZyppCap & capSet2 )
+
+
+YQPkgCapabilityItem::YQPkgCapabilityItem( QTreeWidgetItem *        parent,
+                                          const zypp::Capability & cap )
+    : YQPkgLazyDependencyItem( parent )
+    , _cap( cap )
 {
-    QString content1 = htmlLines( capSet1 );
-    QString content2 = htmlLines( capSet2 );
+    setText( 0, fromUTF8( cap.asString() ) );
+}
 
-    if ( content1.isEmpty() && content2.isEmpty() )
-	return "";
 
-    return QString( "<tr>" ) +
-	hcell( heading ) +
-	"<td>" + content1 + "</td>" +
-	"<td>" + content2 + "</td>" +
-	"</tr>";
+YQPkgCapabilityItem::~YQPkgCapabilityItem()
+{
+    // NOP
 }
 
 
-QString
-YQPkgDependenciesView::htmlLines( const ZyppCap & capSet )
+void
+YQPkgCapabilityItem::addChildren()
 {
-    QString html;
+    // Only now look up the providers in the sat pool's whatprovides index
 
-    for ( ZyppCap::const_iterator it = capSet.begin();
-	  it != capSet.end();
-	  ++it )
+    zypp::sat::WhatProvides providers( _cap );
+
+    for ( const zypp::sat::Solvable & solvable: providers )
     {
-	if ( ! html.isEmpty() )
-	    html += "<br>";
+        QTreeWidgetItem * item = new QTreeWidgetItem( this );
+
+        item->setText( 0, fromUTF8( solvable.name() ) );
 
-	html += htmlEscape( ( *it).asString().c_str() );
+        QString details = fromUTF8( solvable.edition().asString() ) + "."
+            + fromUTF8( solvable.arch().asString() );
+
+        if ( solvable.isSystem() )
+            details += " " + _( "(installed)" );
+        else
+            details += " " + QString( "(%1)" ).arg( fromUTF8( solvable.repository().name() ) );
+
+        item->setText( 1, details );
     }
 
-    return html;
+    if ( providers.empty() )
+    {
+        QTreeWidgetItem * item = new QTreeWidgetItem( this );
+        item->setText( 0, _( "(no provider)" ) );
+        item->setDisabled( true );
+    }
 }
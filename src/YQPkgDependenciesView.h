@@ -18,19 +18,36 @@
 #ifndef YQPkgDependenciesView_h
 #define YQPkgDependenciesView_h
 
+#include <QTreeWidget>
+
+#include <zypp/Capability.h>
+#include <zypp/Dep.h>
+
 #include "YQZypp.h"
-#include "YQPkgGenericDetailsView.h"
 
 
+class QTabWidget;
+
 typedef zypp::Capabilities ZyppCap;
 
 
 /**
- * Display technical details ( very much like 'rpm -qi' ) for a zypp::Package
- * object - the installed instance, the candidate instance or both ( in two
- * columns ) if both exist. All other available instances are ignored.
+ * Display the dependencies (provides, requires, conflicts etc.) of a
+ * zypp::Package object - the installed instance, the candidate instance or
+ * both if both exist. All other available instances are ignored.
+ *
+ * This is a tree: There is one toplevel item for each package instance, one
+ * collapsed item for each dependency kind below that, and below that one item
+ * for each capability. Each capability can again be expanded to show which
+ * solvables provide it.
+ *
+ * All this is done lazily: The capabilities of a dependency kind are only
+ * fetched and rendered when the user opens that branch of the tree, and the
+ * providers of a capability are only looked up in the sat pool's whatprovides
+ * index when the user opens that capability. This is important for packages
+ * with hundreds or thousands of provides (perl, python, kernel).
  **/
-class YQPkgDependenciesView : public YQPkgGenericDetailsView
+class YQPkgDependenciesView : public QTreeWidget
 {
     Q_OBJECT
 
@@ -41,72 +58,167 @@ public:
      **/
     YQPkgDependenciesView( QWidget * parent );
 
-
     /**
      * Destructor
      **/
     virtual ~YQPkgDependenciesView();
 
+    /**
+     * Return the minimum size required for this widget.
+     * Inherited from QWidget.
+     **/
+    virtual QSize minimumSizeHint() const override;
+
+
+public slots:
+
+    /**
+     * Show details for the specified package.
+     * Delayed ( optimized ) display if this is embedded into a QTabWidget
+     * parent: In this case, wait until this page becomes visible.
+     **/
+    void showDetailsIfVisible( ZyppSel selectable );
+
+    /**
+     * Show the dependency tree for the specified selectable.
+     **/
+    void showDetails( ZyppSel selectable );
+
+
+protected slots:
+
+    /**
+     * Show data for the current package if 'newCurrent' is the index of this
+     * page in the parent tab widget.
+     **/
+    void reloadTab( int newCurrent );
+
+    /**
+     * Create the children of 'item' if they weren't created yet.
+     * This is connected to the itemExpanded() signal.
+     **/
+    void populateItem( QTreeWidgetItem * item );
+
 
 protected:
 
     /**
-     * Show details for the specified selectable:
-     * In this case technical data, very much like "rpm -qi".
-     *
-     * Reimplemented from YQPkgGenericDetailsView.
+     * Add a toplevel item for one package instance with one child item
+     * for each dependency kind that is not empty.
      **/
-    virtual void showDetails( ZyppSel selectable ) override;
+    void addVersionItem( ZyppObj zyppObj, const QString & text );
+
+
+    // Data members
+
+    QTabWidget * _parentTab;
+    ZyppSel      _selectable;
+};
+
+
+/**
+ * Abstract base class for items in the dependencies tree whose children are
+ * only created when the item is expanded for the first time.
+ **/
+class YQPkgLazyDependencyItem: public QTreeWidgetItem
+{
+public:
 
     /**
-     * Returns a string containing a HTML table for technical details for one
-     * package.
+     * Constructor. This sets the child indicator so the user can open the
+     * item even though it doesn't have any children yet.
      **/
-    QString simpleTable( ZyppObj pkg );
+    YQPkgLazyDependencyItem( QTreeWidgetItem * parent );
 
+    /**
+     * Destructor.
+     **/
+    virtual ~YQPkgLazyDependencyItem();
 
     /**
-     * Returns a string containing a HTML table for technical details for two
-     * package instances: The installed instance and an alternate instance.
-     * (usually the candidate instance).
+     * Create the children of this item if this wasn't done yet.
      **/
-    QString complexTable( ZyppObj installed,
-			  ZyppObj candidate );
+    void populate();
 
     /**
-     * Format a zypp::CapSet (describing zypp::Dep::REQUIRES etc.)
-     * with a heading in HTML lines.
-     *
-     * Returns an empty string if capSet is empty.
+     * Return 'true' if the children of this item were already created.
      **/
-    static QString row( const QString &	heading,
-			const ZyppCap & capSet );
+    bool isPopulated() const { return _populated; }
 
+protected:
 
     /**
-     * Format two ZyppCap (describing zypp::Dep::REQUIRES etc.)
-     * with a heading in HTML lines.
-     *
-     * Returns an empty string both capSets are empty.
+     * Create the children of this item.
+     * Derived classes are required to implement this.
+     **/
+    virtual void addChildren() = 0;
+
+    bool _populated;
+};
+
+
+/**
+ * Item for one dependency kind (zypp::Dep::PROVIDES, zypp::Dep::REQUIRES,
+ * ...) of one package instance. Its children are YQPkgCapabilityItems.
+ **/
+class YQPkgDepKindItem: public YQPkgLazyDependencyItem
+{
+public:
+
+    /**
+     * Constructor.
      **/
-    static QString row( const QString & heading,
-			const ZyppCap & capSet1,
-			const ZyppCap & capSet2 );
+    YQPkgDepKindItem( QTreeWidgetItem * parent,
+                      const QString &   label,
+                      const ZyppCap &   capSet );
+
+    /**
+     * Destructor.
+     **/
+    virtual ~YQPkgDepKindItem();
+
+protected:
 
     /**
-     * Returns a string containing a HTML table row with 'contents'.
+     * Add one YQPkgCapabilityItem child for each capability.
      *
-     * Required here to avoid inheritance ambiguities.
+     * Implemented from YQPkgLazyDependencyItem.
      **/
-    static QString row( const QString & contents )
-	{ return YQPkgGenericDetailsView::row( contents ); }
+    virtual void addChildren() override;
+
+    ZyppCap _capSet;
+};
+
+
+/**
+ * Item for one capability. Its children are the solvables that provide this
+ * capability, as found in the sat pool's whatprovides index.
+ **/
+class YQPkgCapabilityItem: public YQPkgLazyDependencyItem
+{
+public:
+
+    /**
+     * Constructor.
+     **/
+    YQPkgCapabilityItem( QTreeWidgetItem *        parent,
+                         const zypp::Capability & cap );
 
     /**
-     * Format a ZyppCap (describing zypp::Dep::REQUIRES etc.)
-     * in HTML lines, separated with <BR>.
-     * Returns an empty string if capSet is empty.
+     * Destructor.
      **/
-    static QString htmlLines( const ZyppCap & capSet );
+    virtual ~YQPkgCapabilityItem();
+
+protected:
+
+    /**
+     * Add one child for each solvable that provides this capability.
+     *
+     * Implemented from YQPkgLazyDependencyItem.
+     **/
+    virtual void addChildren() override;
+
+    zypp::Capability _cap;
 };
 
 
@@ -16,7 +16,7 @@
 
 #include <zypp/ZYpp.h>
 #include <zypp/ZYppFactory.h>
-#include <boost/multiprecision/cpp_int.hpp> // arbitrary precision integer
+#include <zypp/ResPool.h>
 
 #include <QStyle>
 #include <QHeaderView>
@@ -51,6 +51,10 @@ using std::set;
 #define OVERFLOW_MB_WARN        0
 #define OVERFLOW_MB_PROXIMITY   300
 
+// Quiet period after the last status change before the disk usage is
+// recalculated
+#define UPDATE_DELAY_MILLISEC   200
+
 
 typedef zypp::DiskUsageCounter::MountPointSet           ZyppDuSet;
 
@@ -59,9 +63,18 @@ typedef zypp::DiskUsageCounter::MountPointSet           ZyppDuSet;
 YQPkgDiskUsageList::YQPkgDiskUsageList( QWidget * parent,
                                         int       thresholdPercent )
     : QY2DiskUsageList( parent, true )
+    , _updatePending( false )
+    , _updatesSuspended( false )
+    , _transactionKnown( false )
+    , _resizePending( false )
 {
     _debug = false;
 
+    _updateTimer.setSingleShot( true );
+
+    connect( &_updateTimer, SIGNAL( timeout()            ),
+             this,          SLOT  ( updateDiskUsageNow() ) );
+
     ZyppDuSet diskUsage = zypp::getZYpp()->diskUsage();
 
     if ( diskUsage.empty() )
@@ -96,6 +109,39 @@ YQPkgDiskUsageList::YQPkgDiskUsageList( QWidget * parent,
 void
 YQPkgDiskUsageList::updateDiskUsage()
 {
+    _updatePending = true;
+
+    if ( ! _updatesSuspended )
+        _updateTimer.start( UPDATE_DELAY_MILLISEC );
+}
+
+
+void
+YQPkgDiskUsageList::updateDiskUsageNow()
+{
+    _updateTimer.stop();
+    _updatePending = true;
+
+    if ( _updatesSuspended )
+        return; // resumeUpdates() will catch up
+
+    // Recalculate even while the list is not showing: The user still needs
+    // the warnings if the disk space is running out.
+
+    _updatePending = false;
+
+    // Recalculating the disk usage is expensive: zypp goes over the whole
+    // transaction for every mount point. Don't do that if the transaction
+    // didn't change, e.g. for status changes that were undone again.
+
+    QVector<int> transaction = currentTransaction();
+
+    if ( _transactionKnown && transaction == _lastTransaction )
+        return;
+
+    _lastTransaction  = transaction;
+    _transactionKnown = true;
+
     runningOutWarning.clear();
     overflowWarning.clear();
 
@@ -111,11 +157,25 @@ YQPkgDiskUsageList::updateDiskUsage()
             logError() << "No entry for mount point " << partitionDu.dir << endl;
     }
 
-    resizeColumnToContents( totalSizeCol() );
+    if ( isShowing() )
+        resizeColumnToContents( totalSizeCol() );
+    else
+        _resizePending = true; // showEvent() or resizeEvent() will catch up
+
     postPendingWarnings();
 }
 
 
+void
+YQPkgDiskUsageList::invalidateTransaction()
+{
+    _lastTransaction.clear();
+    _transactionKnown = false;
+
+    updateDiskUsage();
+}
+
+
 void
 YQPkgDiskUsageList::postPendingWarnings()
 {
@@ -143,6 +203,80 @@ YQPkgDiskUsageList::postPendingWarnings()
 }
 
 
+void
+YQPkgDiskUsageList::suspendUpdates()
+{
+    _updatesSuspended = true;
+    _updateTimer.stop(); // _updatePending remains
+}
+
+
+void
+YQPkgDiskUsageList::resumeUpdates()
+{
+    _updatesSuspended = false;
+
+    if ( _updatePending )
+        updateDiskUsage();
+}
+
+
+bool
+YQPkgDiskUsageList::isShowing() const
+{
+    return isVisible() && width() > 0 && height() > 0;
+}
+
+
+QVector<int>
+YQPkgDiskUsageList::currentTransaction() const
+{
+    QVector<int> transaction;
+
+    for ( auto it = zypp::ResPool::instance().byKindBegin<zypp::Package>();
+          it != zypp::ResPool::instance().byKindEnd<zypp::Package>();
+          ++it )
+    {
+        const zypp::PoolItem & item = *it;
+
+        if ( item.status().transacts() )
+        {
+            int id = (int) item.satSolvable().id();
+            transaction << ( item.status().isInstalled() ? -id : id );
+        }
+    }
+
+    return transaction;
+}
+
+
+void
+YQPkgDiskUsageList::showEvent( QShowEvent * event )
+{
+    QY2DiskUsageList::showEvent( event );
+    catchUpResize();
+}
+
+
+void
+YQPkgDiskUsageList::resizeEvent( QResizeEvent * event )
+{
+    QY2DiskUsageList::resizeEvent( event );
+    catchUpResize();
+}
+
+
+void
+YQPkgDiskUsageList::catchUpResize()
+{
+    if ( _resizePending && isShowing() )
+    {
+        _resizePending = false;
+        resizeColumnToContents( totalSizeCol() );
+    }
+}
+
+
 QSize
 YQPkgDiskUsageList::sizeHint() const
 {
@@ -270,8 +404,17 @@ YQPkgDiskUsageListItem::name() const
 void
 YQPkgDiskUsageListItem::updateDuData( const ZyppPartitionDu & fromData )
 {
+    // Most status changes only affect one or two partitions: Don't
+    // recalculate and repaint the others.
+
+    bool changed = fromData.pkg_size   != _partitionDu.pkg_size ||
+                   fromData.total_size != _partitionDu.total_size;
+
     _partitionDu = fromData;
-    updateData();
+
+    if ( changed )
+        updateData();
+
     checkRemainingDiskSpace();
 }
 
@@ -280,8 +423,9 @@ void
 YQPkgDiskUsageListItem::checkRemainingDiskSpace()
 {
     int percent = usedPercent();
-    // free size in MiB
-    boost::multiprecision::cpp_int free = freeSize().in_unit( FSize::Unit::M );
+    // free size in MiB, truncated like FSize::in_unit(), but without
+    // leaving the FSize fast path
+    FSize free = freeSize() / FSize( 1, FSize::Unit::M );
 
 #if 0
     logDebug() << "Partition " << _partitionDu.dir
@@ -296,23 +440,23 @@ YQPkgDiskUsageListItem::checkRemainingDiskSpace()
         // Modern hard disks can be huge, so a warning based on percentage only
         // can be misleading - check the absolute value, too.
 
-        if ( free < MIN_FREE_MB_PROXIMITY )
+        if ( free < FSize( MIN_FREE_MB_PROXIMITY ) )
             _pkgDiskUsageList->runningOutWarning.enterProximity();
 
-        if ( free < MIN_FREE_MB_WARN )
+        if ( free < FSize( MIN_FREE_MB_WARN ) )
             _pkgDiskUsageList->runningOutWarning.enterRange();
     }
 
-    if ( free < MIN_FREE_MB_PROXIMITY )
+    if ( free < FSize( MIN_FREE_MB_PROXIMITY ) )
     {
         if ( percent > MIN_PERCENT_PROXIMITY )
             _pkgDiskUsageList->runningOutWarning.enterProximity();
     }
 
-    if ( free < OVERFLOW_MB_WARN )
+    if ( free < FSize( OVERFLOW_MB_WARN ) )
         _pkgDiskUsageList->overflowWarning.enterRange();
 
-    if ( free < OVERFLOW_MB_PROXIMITY )
+    if ( free < FSize( OVERFLOW_MB_PROXIMITY ) )
         _pkgDiskUsageList->overflowWarning.enterProximity();
 }
 
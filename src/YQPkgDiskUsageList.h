@@ -20,6 +20,8 @@
 
 #include <QKeyEvent>
 #include <QMap>
+#include <QTimer>
+#include <QVector>
 
 #include <zypp/DiskUsageCounter.h>
 
@@ -166,16 +168,44 @@ public:
 public slots:
 
     /**
-     * Update all statistical data in the list.
+     * Update all statistical data in the list soon: This only (re-)starts a
+     * short timer, so a burst of status changes results in only one
+     * recalculation.
      **/
     void updateDiskUsage();
 
+    /**
+     * Update all statistical data in the list right away and post any disk
+     * space warnings if the package transaction changed since the last
+     * time. This is also done while the list is not visible; only adjusting
+     * the column widths waits until it becomes visible.
+     **/
+    void updateDiskUsageNow();
+
+    /**
+     * Forget the last package transaction, so the next update recalculates
+     * everything. Call this when the pool was reloaded: The solvable IDs of
+     * the new pool might be the same as the old ones.
+     **/
+    void invalidateTransaction();
+
     /**
      * Post all pending disk space warnings based on the warning range
      * notifiers.
      **/
     void postPendingWarnings();
 
+    /**
+     * Don't recalculate anything until resumeUpdates() is called; just
+     * remember that an update is pending.
+     **/
+    void suspendUpdates();
+
+    /**
+     * Undo suspendUpdates() and catch up with a pending update.
+     **/
+    void resumeUpdates();
+
 
 protected:
 
@@ -187,11 +217,50 @@ protected:
      **/
     virtual void keyPressEvent( QKeyEvent * ev ) override;
 
+    /**
+     * Catch up with skipped column resizing when the list becomes visible.
+     *
+     * Reimplemented from QWidget.
+     **/
+    virtual void showEvent( QShowEvent * event ) override;
+
+    /**
+     * Catch up with skipped column resizing when the list becomes visible
+     * because it is no longer collapsed in its splitter.
+     *
+     * Reimplemented from QWidget.
+     **/
+    virtual void resizeEvent( QResizeEvent * event ) override;
+
+    /**
+     * Adjust the column widths if that was skipped while the list was not
+     * showing and it is showing now.
+     **/
+    void catchUpResize();
+
+    /**
+     * Return 'true' if the list can be seen by the user, i.e. it is visible
+     * and not collapsed to zero size in its splitter.
+     **/
+    bool isShowing() const;
+
+    /**
+     * Return the solvable IDs of all packages that will be installed
+     * (positive) or removed (negative) in the current transaction.
+     **/
+    QVector<int> currentTransaction() const;
+
 
     // Data members
 
     QMap<QString, YQPkgDiskUsageListItem*> _items;
     bool                                   _debug;
+    QTimer                                 _updateTimer;
+    bool                                   _updatePending;
+    bool                                   _updatesSuspended;
+    QVector<int>                           _lastTransaction;
+    bool                                   _transactionKnown;
+    bool                                   _resizePending;
 };
 
 
@@ -18,6 +18,7 @@
 #include <utility>
 #include <vector>
 
+#include <QElapsedTimer>
 #include <QHBoxLayout>
 #include <QMenu>
 #include <QPushButton>
@@ -31,6 +32,7 @@
 #include "Exception.h"
 #include "Logger.h"
 #include "PopupLogo.h"
+#include "StartupProfile.h"
 #include "YQIconPool.h"
 #include "YQPkgDiskUsageList.h"
 #include "YQPkgSelector.h"
@@ -291,14 +293,40 @@ YQPkgFilterTab::addPage( const QString &      pageLabel,
                                                   internalName );
     CHECK_NEW( page );
 
-    pages().push_back( page );
     _priv->filtersWidgetStack->addWidget( pageContent );
+    addPage( page, hotkey );
+}
+
+
+void
+YQPkgFilterTab::addPage( const QString &        pageLabel,
+                         YQPkgFilterPageFactory factory,
+                         const QString &        internalName,
+                         const QKeySequence &   hotkey   )
+{
+    YQPkgFilterPage * page = new YQPkgFilterPage( pageLabel,
+                                                  factory,
+                                                  internalName );
+    CHECK_NEW( page );
+
+    addPage( page, hotkey );
+}
+
+
+void
+YQPkgFilterTab::addPage( YQPkgFilterPage *    page,
+                         const QKeySequence & hotkey )
+{
+    pages().push_back( page );
 
     if ( _priv->viewButton && _priv->viewButton->menu() )
     {
-        page->action = new QAction( pageLabel, YQPkgSelector::instance() );
+        // Use the internal name, not the content widget: That might not
+        // exist yet.
+
+        page->action = new QAction( page->label, YQPkgSelector::instance() );
         CHECK_NEW( page->action );
-        page->action->setData( QVariant::fromValue( pageContent ) );
+        page->action->setData( page->id );
 
         if ( ! hotkey.isEmpty() )
             page->action->setShortcut( hotkey );
@@ -308,6 +336,31 @@ YQPkgFilterTab::addPage( const QString &      pageLabel,
 }
 
 
+void
+YQPkgFilterTab::createPageContent( YQPkgFilterPage * page )
+{
+    if ( page->content )
+        return;
+
+    CHECK_PTR( page->factory );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    {
+        StartupPhase phase( QString( "Create page \"%1\"" ).arg( page->id ) );
+
+        page->content = page->factory();
+        CHECK_PTR( page->content );
+    }
+
+    _priv->filtersWidgetStack->addWidget( page->content );
+
+    logInfo() << "Created page " << page->id
+              << " in " << timer.elapsed() << " millisec" << endl;
+}
+
+
 void
 YQPkgFilterTab::showPage( QWidget * pageContent )
 {
@@ -346,8 +399,7 @@ YQPkgFilterTab::showPage( QAction * action )
     if ( ! action )
         return;
 
-    QWidget * pageContent = action->data().value<QWidget *>();
-    showPage( pageContent );
+    showPage( action->data().toString() );
 }
 
 
@@ -357,17 +409,63 @@ YQPkgFilterTab::showPage( YQPkgFilterPage * page )
     CHECK_PTR( page );
     QSignalBlocker sigBlocker( tabBar() );
 
+    openPage( page );
+    createPageContent( page );
+
+    _priv->filtersWidgetStack->setCurrentWidget( page->content );
+    tabBar()->setCurrentIndex( page->tabIndex );
+    _priv->tabContextMenuPage = page;
+
+    emit currentChanged( page->content );
+}
+
+
+void
+YQPkgFilterTab::openPage( const QString & internalName )
+{
+    YQPkgFilterPage * page = findPage( internalName );
+
+    if ( page )
+        openPage( page );
+    else
+        logWarning() << "No page with ID \"" << internalName << "\"" << endl;
+}
+
+
+void
+YQPkgFilterTab::openPage( YQPkgFilterPage * page )
+{
     if ( page->tabIndex < 0 ) // No corresponding tab yet?
     {
         // Add a tab for that page
+
+        QSignalBlocker sigBlocker( tabBar() );
         page->tabIndex = tabBar()->addTab( page->label );
     }
+}
 
-    _priv->filtersWidgetStack->setCurrentWidget( page->content );
-    tabBar()->setCurrentIndex( page->tabIndex );
-    _priv->tabContextMenuPage = page;
 
-    emit currentChanged( page->content );
+void
+YQPkgFilterTab::recreatePageContent( const QString & internalName )
+{
+    YQPkgFilterPage * page = findPage( internalName );
+
+    if ( ! page || ! page->content || ! page->factory )
+        return;
+
+    logDebug() << "Recreating page " << page->id << endl;
+
+    bool isCurrent = _priv->filtersWidgetStack->currentWidget() == page->content;
+
+    _priv->filtersWidgetStack->removeWidget( page->content );
+    delete page->content;
+    page->content = 0;
+
+    if ( isCurrent )
+    {
+        createPageContent( page );
+        _priv->filtersWidgetStack->setCurrentWidget( page->content );
+    }
 }
 
 
@@ -398,6 +496,21 @@ YQPkgFilterTab::setPageLabel( QWidget * pageContent, const QString & newLabel )
 }
 
 
+void
+YQPkgFilterTab::setPageLabel( const QString & internalName, const QString & newLabel )
+{
+    YQPkgFilterPage * page = findPage( internalName );
+
+    if ( page )
+    {
+        page->label = newLabel;
+
+        if ( page->tabIndex >= 0 )
+            tabBar()->setTabText( page->tabIndex, newLabel );
+    }
+}
+
+
 void
 YQPkgFilterTab::closeAllPages()
 {
@@ -414,6 +527,9 @@ YQPkgFilterTab::closeAllPages()
 YQPkgFilterPage *
 YQPkgFilterTab::findPage( QWidget * pageContent ) const
 {
+    if ( ! pageContent )
+        return 0;
+
     for ( YQPkgFilterPage * page: constPages() )
     {
         if ( page->content == pageContent )
@@ -460,6 +576,18 @@ YQPkgFilterTab::tabCount() const
 }
 
 
+QStringList
+YQPkgFilterTab::pageIds() const
+{
+    QStringList ids;
+
+    for ( YQPkgFilterPage * page: constPages() )
+        ids << page->id;
+
+    return ids;
+}
+
+
 const YQPkgFilterPageVector &
 YQPkgFilterTab::constPages() const
 {
@@ -676,35 +804,42 @@ YQPkgFilterTab::readSettings()
     logInfo() << "Restoring pages " << savedPages << endl;
     logInfo() << "Current page:   " << currentPageId << endl;
 
-    {
-        // Prevent an event cascade as pages are added: Each one would cause
-        // the package list to get filled, only to get cleared and filled again
-        // by the next page.
-        //
-        // The signals are unblocked when the sigBlocker goes out of scope.
+    // Only open the tabs; the content of a page is only created when it is
+    // shown, so this is cheap. This also doesn't emit any signals yet that
+    // would cause the package list to get filled, only to get cleared and
+    // filled again by the next page.
 
-        QSignalBlocker sigBlocker( this );
+    YQPkgFilterPage * lastPage = 0;
 
-        for ( QString pageId: savedPages )
-        {
-            YQPkgFilterPage * page = findPage( pageId );
+    for ( QString pageId: savedPages )
+    {
+        YQPkgFilterPage * page = findPage( pageId );
 
-            if ( page )
-                showPage( page );
-            else
-                logWarning() << "No page with ID \"" << pageId << "\"" << endl;
+        if ( page )
+        {
+            openPage( page );
+            lastPage = page;
+        }
+        else
+        {
+            logWarning() << "No page with ID \"" << pageId << "\"" << endl;
         }
     }
 
+    YQPkgFilterPage * currentPage = lastPage;
+
     if ( ! currentPageId.isEmpty() )
     {
         YQPkgFilterPage * page = findPage( currentPageId );
 
         if ( page )
-            showPage( page ); // We want this to emit signals to fill the pkg list
+            currentPage = page;
         else
             logWarning() << "Can't restore current page with ID \"" << currentPageId << "\"" << endl;
     }
+
+    if ( currentPage )
+        showPage( currentPage ); // We want this to emit signals to fill the pkg list
 }
 
 
@@ -19,11 +19,13 @@
 #define YQPkgFilterTab_h
 
 
+#include <functional>
 #include <memory>
 
 #include <QAction>
 #include <QHash>
 #include <QKeySequence>
+#include <QStringList>
 #include <QWidget>
 #include <QTabWidget>
 
@@ -32,6 +34,7 @@ class YQPkgFilterPage;
 class YQPkgDiskUsageList;
 
 typedef std::vector<YQPkgFilterPage *> YQPkgFilterPageVector;
+typedef std::function<QWidget * ()>     YQPkgFilterPageFactory;
 
 
 /**
@@ -65,6 +68,10 @@ typedef std::vector<YQPkgFilterPage *> YQPkgFilterPageVector;
  *
  * The left (filter page) and right panes are separated with a user-moveable
  * splitter.
+ *
+ * The content of a filter page can also be created lazily by a factory
+ * function when that page is shown for the first time, so filter pages that
+ * the user never looks at cost nothing.
  **/
 class YQPkgFilterTab: public QTabWidget
 {
@@ -93,6 +100,18 @@ public:
                   const QString &      internalName,
                   const QKeySequence & hotkey = QKeySequence() );
 
+    /**
+     * Add a page whose content widget is only created by calling 'factory'
+     * when the page is shown for the first time.
+     *
+     * The widget returned by 'factory' will be reparented to a subwidget of
+     * this class.
+     **/
+    void addPage( const QString &           pageLabel,
+                  YQPkgFilterPageFactory    factory,
+                  const QString &           internalName,
+                  const QKeySequence &      hotkey = QKeySequence() );
+
     /**
      * Return the right pane.
      **/
@@ -105,7 +124,7 @@ public:
 
     /**
      * Find a filter page by its content widget (the widget that was passed
-     * to addPage() ).
+     * to addPage() or that its factory created).
      * Return 0 if there is no such page.
      **/
     YQPkgFilterPage * findPage( QWidget * pageContent ) const;
@@ -127,6 +146,12 @@ public:
      **/
     int tabCount() const;
 
+    /**
+     * Return the internal names of all pages in the order they were added,
+     * no matter if they have an open tab.
+     **/
+    QStringList pageIds() const;
+
     /**
      * Event filter to catch mouse right clicks on open tabs for the tab
      * context menu. Returns 'true' if the event is processed and consumed,
@@ -160,6 +185,13 @@ public slots:
      * This can be used to add a numeric value like "Patches (17)".
      **/
     void setPageLabel( QWidget * pageContent, const QString & newLabel );
+    void setPageLabel( const QString & internalName, const QString & newLabel );
+
+    /**
+     * Open a tab for a page without switching to it. Unlike showPage(), this
+     * does not create the page content yet.
+     **/
+    void openPage( const QString & internalName );
 
     /**
      * Reload the current page: Send a currentChange() signal with the current
@@ -189,6 +221,14 @@ public slots:
      **/
     void closeAllPages();
 
+    /**
+     * Discard the content of a page that was created by its factory: It is
+     * created again when the page is shown the next time, or right away if
+     * it is the current page. Use this for pages whose widgets refer to
+     * objects that went away.
+     **/
+    void recreatePageContent( const QString & internalName );
+
 
 protected slots:
 
@@ -235,6 +275,23 @@ protected:
      **/
     void showPage( YQPkgFilterPage * page );
 
+    /**
+     * Add a page that was already created to the pages and to the "View"
+     * menu.
+     **/
+    void addPage( YQPkgFilterPage *    page,
+                  const QKeySequence & hotkey );
+
+    /**
+     * Open a tab for a page if it doesn't have one yet.
+     **/
+    void openPage( YQPkgFilterPage * page );
+
+    /**
+     * Create the content of a page from its factory if that wasn't done yet.
+     **/
+    void createPageContent( YQPkgFilterPage * page );
+
     /**
      * Open the tab context menu for the tab at the specified position.
      * Return 'true' upon success (i.e., there is a tab at that position),
@@ -273,6 +330,18 @@ public:
         , action( 0 )
         {}
 
+    YQPkgFilterPage( const QString &        pageLabel,
+                     YQPkgFilterPageFactory factory,
+                     const QString &        internalName )
+        : content( 0 )
+        , factory( factory )
+        , label( pageLabel )
+        , id( internalName )
+        , closeEnabled( true )
+        , tabIndex( -1 )
+        , action( 0 )
+        {}
+
     virtual ~YQPkgFilterPage()
         {
             if ( action )
@@ -280,12 +349,13 @@ public:
         }
 
 
-    QWidget *   content;
-    QString     label;          // user visible text
-    QString     id;             // internal name
-    bool        closeEnabled;
-    int         tabIndex;       // index of the corresponding tab or -1 if none
-    QAction *   action;
+    QWidget *              content;      // 0 until the factory created it
+    YQPkgFilterPageFactory factory;      // only for lazily created pages
+    QString                label;        // user visible text
+    QString                id;           // internal name
+    bool                   closeEnabled;
+    int                    tabIndex;     // index of the corresponding tab or -1 if none
+    QAction *              action;
 };
 
 
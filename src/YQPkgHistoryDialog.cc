@@ -16,27 +16,26 @@
 
 
 #include <QBoxLayout>
-#include <QEventLoop>
 #include <QHBoxLayout>
+#include <QHeaderView>
 #include <QLabel>
-#include <QList>
+#include <QLineEdit>
+#include <QListWidget>
 #include <QMessageBox>
 #include <QPushButton>
-#include <QSignalBlocker>
 #include <QSplitter>
+#include <QTabWidget>
+#include <QTreeView>
 #include <QTreeWidget>
 
 #include <zypp-core/Date.h>
-#include <zypp-core/Pathname.h>
-#include <zypp-core/Url.h>
-#include <zypp-core/base/Exception.h>
-#include <zypp/parser/HistoryLogReader.h>
-#include <zypp/Edition.h>
+#include <zypp/HistoryLogData.h>
 
 #include "Logger.h"
 #include "MainWindow.h"
-#include "QY2CursorHelper.h"
+#include "PkgHistoryIndex.h"
 #include "YQIconPool.h"
+#include "YQPkgHistoryModel.h"
 #include "YQi18n.h"
 #include "utf8.h"
 
@@ -46,7 +45,10 @@
 #define SPACING         4	// between subwidgets
 #define MARGIN		9	// around the widget
 
-#define FILENAME	"/var/log/zypp/history"
+// Item data roles in the timeline tree
+
+#define DateRole        Qt::UserRole
+#define OffsetRole      ( Qt::UserRole + 1 )
 
 
 
@@ -69,33 +71,59 @@ YQPkgHistoryDialog::YQPkgHistoryDialog( QWidget * parent )
     layout->setSpacing( SPACING );
 
 
-    // Heading
+    // Heading with the reading status on the right
+
+    QHBoxLayout * headingBox = new QHBoxLayout();
+    Q_CHECK_PTR( headingBox );
+    layout->addLayout( headingBox );
 
     QLabel * label = new QLabel( _( "Package History (/var/log/zypp/history)" ), this );
     label->setFixedHeight( label->sizeHint().height() );
-    layout->addWidget( label );
+    headingBox->addWidget( label );
+    headingBox->addStretch();
+
+    _statusLabel = new QLabel( this );
+    Q_CHECK_PTR( _statusLabel );
+    headingBox->addWidget( _statusLabel );
+
+
+    // Models
+
+    _actionsModel = new YQPkgHistoryModel( this );
+    Q_CHECK_PTR( _actionsModel );
+
+    _datesModel = new YQPkgHistoryDatesModel( _actionsModel, this );
+    Q_CHECK_PTR( _datesModel );
+
 
+    // Tabs for the whole history and for the package timeline
 
-    // Splitter between the trees
+    _tabs = new QTabWidget( this );
+    Q_CHECK_PTR( _tabs );
+    layout->addWidget( _tabs );
 
-    QSplitter * splitter = new QSplitter( Qt::Horizontal, this );
+
+    // History tab: Splitter between the trees
+
+    QSplitter * splitter = new QSplitter( Qt::Horizontal, _tabs );
     Q_CHECK_PTR( splitter );
-    layout->addWidget( splitter );
+    _historyPage = splitter;
+    _tabs->addTab( _historyPage, _( "History" ) );
 
 
     // Flat list for the dates
 
-    _datesTree = new QTreeWidget( splitter);
-    _datesTree->setColumnCount( 1 );
-    _datesTree->setHeaderLabels( QStringList( _( "Date" ) ) );
+    _datesTree = new QTreeView( splitter );
+    _datesTree->setModel( _datesModel );
     _datesTree->setRootIsDecorated( false );
+    _datesTree->setUniformRowHeights( true );
 
 
     // Tree for the actions: Action items below a date item parent
 
-    _actionsTree = new QTreeWidget( splitter );
-    _actionsTree->setColumnCount( 2 );
-    _actionsTree->setHeaderLabels( QStringList( _( "Action" ) ) << _( "Version/URL" ) );
+    _actionsTree = new QTreeView( splitter );
+    _actionsTree->setModel( _actionsModel );
+    _actionsTree->setUniformRowHeights( true );
     _actionsTree->setColumnWidth( 0, 350 );
 
 
@@ -105,6 +133,45 @@ YQPkgHistoryDialog::YQPkgHistoryDialog( QWidget * parent )
     splitter->setStretchFactor( 1, 3 );
 
 
+    // Package timeline tab: Search field above the package list and the
+    // timeline of the current package
+
+    _packagesPage = new QWidget( _tabs );
+    Q_CHECK_PTR( _packagesPage );
+    _tabs->addTab( _packagesPage, _( "Package Timeline" ) );
+
+    QVBoxLayout * packagesLayout = new QVBoxLayout( _packagesPage );
+    Q_CHECK_PTR( packagesLayout );
+    packagesLayout->setContentsMargins( SPACING, SPACING, SPACING, SPACING );
+    packagesLayout->setSpacing( SPACING );
+
+    _searchField = new QLineEdit( _packagesPage );
+    Q_CHECK_PTR( _searchField );
+    _searchField->setPlaceholderText( _( "Package name" ) );
+    _searchField->setClearButtonEnabled( true );
+    packagesLayout->addWidget( _searchField );
+
+    QSplitter * packagesSplitter = new QSplitter( Qt::Horizontal, _packagesPage );
+    Q_CHECK_PTR( packagesSplitter );
+    packagesLayout->addWidget( packagesSplitter );
+
+    _packageList = new QListWidget( packagesSplitter );
+    Q_CHECK_PTR( _packageList );
+
+    _timelineTree = new QTreeWidget( packagesSplitter );
+    Q_CHECK_PTR( _timelineTree );
+    _timelineTree->setHeaderLabels( QStringList()
+                                    << _( "Time"    )
+                                    << _( "Action"  )
+                                    << _( "Version" ) );
+    _timelineTree->setRootIsDecorated( false );
+    _timelineTree->setAllColumnsShowFocus( true );
+    _timelineTree->header()->setSectionResizeMode( QHeaderView::ResizeToContents );
+
+    packagesSplitter->setStretchFactor( 0, 1 );
+    packagesSplitter->setStretchFactor( 1, 3 );
+
+
     // Button box to center the single button
 
     QHBoxLayout * hbox = new QHBoxLayout();
@@ -125,11 +192,47 @@ YQPkgHistoryDialog::YQPkgHistoryDialog( QWidget * parent )
     connect( okButton,          SIGNAL( clicked() ),
 	     this,              SLOT  ( accept()  ) );
 
-    connect( _datesTree,        SIGNAL( itemSelectionChanged() ),
-	    this,               SLOT  ( selectDate()           ) );
+    connect( _datesTree->selectionModel(),   SIGNAL( currentChanged( QModelIndex, QModelIndex ) ),
+	     this,                           SLOT  ( selectDate()                               ) );
+
+    connect( _actionsTree->selectionModel(), SIGNAL( currentChanged( QModelIndex, QModelIndex ) ),
+	     this,                           SLOT  ( selectAction()                             ) );
+
+    connect( _actionsTree,      SIGNAL( doubleClicked    ( QModelIndex ) ),
+	     this,              SLOT  ( showActionPackage( QModelIndex ) ) );
+
+    connect( _searchField,      SIGNAL( textChanged   ( QString ) ),
+	     this,              SLOT  ( searchPackages()        ) );
+
+    connect( _packageList,      SIGNAL( currentItemChanged ( QListWidgetItem *, QListWidgetItem * ) ),
+	     this,              SLOT  ( showPackageTimeline()                                    ) );
+
+    connect( _timelineTree,     SIGNAL( itemDoubleClicked ( QTreeWidgetItem *, int ) ),
+	     this,              SLOT  ( showTimelineAction( QTreeWidgetItem *      ) ) );
 
-    connect( _actionsTree,      SIGNAL( itemSelectionChanged() ),
-	    this,               SLOT  ( selectAction()         ) );
+
+    PkgHistoryIndex * index = PkgHistoryIndex::instance();
+
+    connect( index,             SIGNAL( olderActionsAdded( PkgHistoryActionList ) ),
+	     this,              SLOT  ( addOlderActions  ( PkgHistoryActionList ) ) );
+
+    connect( index,             SIGNAL( newerActionsAdded( PkgHistoryActionList ) ),
+	     this,              SLOT  ( addNewerActions  ( PkgHistoryActionList ) ) );
+
+    connect( index,             SIGNAL( cleared()      ),
+	     this,              SLOT  ( clearActions() ) );
+
+    connect( index,             SIGNAL( readingFinished() ),
+	     this,              SLOT  ( readingFinished() ) );
+
+    connect( index,             SIGNAL( readError             ( QString ) ),
+	     this,              SLOT  ( showReadHistoryWarning( QString ) ) );
+}
+
+
+YQPkgHistoryDialog::~YQPkgHistoryDialog()
+{
+    // NOP
 }
 
 
@@ -138,18 +241,9 @@ YQPkgHistoryDialog::showHistoryDialog( QWidget* parent)
 {
     YQPkgHistoryDialog dialog( parent );
 
-    // Give instant feedback: Show the dialog and process the "show" event
-    // immediately so the window opens immediately (albeit empty)
-
-    dialog.show();
-    QEventLoop eventLoop;
-    eventLoop.processEvents( QEventLoop::ExcludeUserInputEvents,
-			     200 ); // millisec
-
-    busyCursor();
-    dialog.populate(); // This takes a moment
-    normalCursor();
+    // The trees are filled in the background while the dialog is open
 
+    dialog.populate();
     dialog.exec();
 }
 
@@ -157,22 +251,85 @@ YQPkgHistoryDialog::showHistoryDialog( QWidget* parent)
 void
 YQPkgHistoryDialog::populate()
 {
-    YQPkgHistoryItemCollector itemCollector( _datesTree, _actionsTree );
-    zypp::parser::HistoryLogReader reader( FILENAME,
-                                           zypp::parser::HistoryLogReader::Options(),
-                                           boost::ref( itemCollector ) );
-    try
+    PkgHistoryIndex * index = PkgHistoryIndex::instance();
+
+    // Whatever the index already has from the last time (or from a reader
+    // that is still busy) is instantly available; update() then adds only
+    // what is new since then.
+
+    addOlderActions( index->actions() );
+    searchPackages();
+
+    index->update();
+    updateStatus();
+}
+
+
+void
+YQPkgHistoryDialog::updateStatus()
+{
+    if ( PkgHistoryIndex::instance()->isReading() )
     {
-	reader.readAll();
+        _statusLabel->setText( _( "Reading... %1 actions" )
+                               .arg( _actionsModel->actionCount() ) );
     }
-    catch (  const zypp::Exception & exception )
+    else
     {
-        logWarning() << "CAUGHT zypp exception: " << exception.asUserHistory() << endl;
-        showReadHistoryWarning( fromUTF8( exception.asUserHistory() ) );
+        _statusLabel->clear();
     }
 }
 
 
+void
+YQPkgHistoryDialog::addOlderActions( const PkgHistoryActionList & actions )
+{
+    if ( actions.isEmpty() )
+        return;
+
+    int firstNewDate = _actionsModel->dateCount();
+    _actionsModel->appendActions( actions );
+
+    // Like before, show the actions of all dates
+
+    for ( int row = firstNewDate; row < _actionsModel->dateCount(); ++row )
+        _actionsTree->expand( _actionsModel->index( row, 0 ) );
+
+    updateStatus();
+}
+
+
+void
+YQPkgHistoryDialog::addNewerActions( const PkgHistoryActionList & actions )
+{
+    if ( actions.isEmpty() )
+        return;
+
+    int oldDateCount = _actionsModel->dateCount();
+    _actionsModel->prependActions( actions );
+
+    for ( int row = 0; row < _actionsModel->dateCount() - oldDateCount; ++row )
+        _actionsTree->expand( _actionsModel->index( row, 0 ) );
+
+    searchPackages();
+}
+
+
+void
+YQPkgHistoryDialog::clearActions()
+{
+    _actionsModel->clear();
+    searchPackages();
+}
+
+
+void
+YQPkgHistoryDialog::readingFinished()
+{
+    updateStatus();
+    searchPackages(); // now with all packages
+}
+
+
 void
 YQPkgHistoryDialog::showReadHistoryWarning( const QString & message )
 {
@@ -200,16 +357,22 @@ YQPkgHistoryDialog::showReadHistoryWarning( const QString & message )
 void
 YQPkgHistoryDialog::selectDate()
 {
-    QString item = _datesTree->selectedItems().first()->text( 0 );
-    QList<QTreeWidgetItem *> items = _actionsTree->findItems( item, Qt::MatchExactly, 0);
+    int row = _datesTree->currentIndex().row();
 
-    if ( items.size() > 0 )
-    {
-        QSignalBlocker sigBlocker( this );
+    // Nothing to do if the current action is already one of that date;
+    // in particular, don't move away from it when selectAction() synced the
+    // dates tree to it.
 
-	_actionsTree->expandItem( items.first() );
-	_actionsTree->setCurrentItem( items.first() );
-	_actionsTree->scrollToItem( items.first(), QAbstractItemView::PositionAtTop );
+    if ( row < 0 || _actionsModel->dateRow( _actionsTree->currentIndex() ) == row )
+        return;
+
+    QModelIndex dateIndex = _actionsModel->index( row, 0 );
+
+    if ( dateIndex.isValid() )
+    {
+	_actionsTree->expand( dateIndex );
+	_actionsTree->setCurrentIndex( dateIndex );
+	_actionsTree->scrollTo( dateIndex, QAbstractItemView::PositionAtTop );
     }
 }
 
@@ -217,161 +380,152 @@ YQPkgHistoryDialog::selectDate()
 void
 YQPkgHistoryDialog::selectAction()
 {
-    QTreeWidgetItem * item = _actionsTree->selectedItems().first();
+    // For an action, pick the date it belongs to
 
-    // if this is not a top-level item, better pick a top-level one
+    int row = _actionsModel->dateRow( _actionsTree->currentIndex() );
 
-    if ( item->parent() )
-	item = item->parent();
+    if ( row < 0 || _datesTree->currentIndex().row() == row )
+        return;
 
-    QList<QTreeWidgetItem *> items = _datesTree->findItems( item->text( 0 ),
-                                                            Qt::MatchExactly | Qt::MatchRecursive,
-                                                            0 );
-    if (  items.size() > 0 )
-    {
-        QSignalBlocker sigBlocker( this );
-	_datesTree->setCurrentItem( items.first());
-    }
-}
-
-
-//
-//----------------------------------------------------------------------
-//
+    QModelIndex dateIndex = _datesModel->index( row, 0 );
 
-
-YQPkgHistoryItemCollector::YQPkgHistoryItemCollector( QTreeWidget * datesTree,
-                                                      QTreeWidget * actionsTree )
-    : _datesTree( datesTree )
-    , _actionsTree( actionsTree )
-{
-    // NOP
+    if ( dateIndex.isValid() )
+	_datesTree->setCurrentIndex( dateIndex );
 }
 
 
-bool
-YQPkgHistoryItemCollector::operator() ( const zypp::HistoryLogData::Ptr & item_ptr )
+void
+YQPkgHistoryDialog::searchPackages()
 {
-    QString actionDate = fromUTF8( item_ptr->date().form( "%e %B %Y" ) );
+    QString text    = _searchField->text().trimmed();
+    QString current = _packageList->currentItem() ?
+        _packageList->currentItem()->text() : QString();
 
-    if ( actionDate != _lastDate ) // First action for a new date?
-    {
-        addDatesTreeItem( actionDate );
-        addActionsDateItem( actionDate );
+    QStringList names = PkgHistoryIndex::instance()->findPackages( text );
 
-        _lastDate = actionDate;
-    }
+    _packageList->clear();
+    _packageList->addItems( names );
 
-    QStringList columns = actionColumns( item_ptr );
+    // Pick the package that matches exactly, or keep the current one
 
-    if ( ! columns.isEmpty() )
-    {
-        QTreeWidgetItem * actionItem = new QTreeWidgetItem( _actionsDateItem, columns );
-        actionItem->setIcon( 0, actionIcon( item_ptr->action() ) );
-    }
+    int row = names.indexOf( text );
 
-    return true;
+    if ( row < 0 )
+        row = names.indexOf( current );
+
+    if ( row >= 0 )
+        _packageList->setCurrentRow( row );
 }
 
 
 void
-YQPkgHistoryItemCollector::addDatesTreeItem( const QString & actionDate )
+YQPkgHistoryDialog::showPackageTimeline()
 {
-    new QTreeWidgetItem( _datesTree, QStringList( actionDate ) );
-}
+    _timelineTree->clear();
 
+    QListWidgetItem * packageItem = _packageList->currentItem();
 
-void
-YQPkgHistoryItemCollector::addActionsDateItem( const QString & actionDate )
-{
-    _actionsDateItem = new QTreeWidgetItem( _actionsTree, QStringList( actionDate ) );
-    _actionsDateItem->setExpanded( true );
-}
+    if ( ! packageItem )
+        return;
 
+    PkgHistoryActionList events =
+        PkgHistoryIndex::instance()->packageEvents( packageItem->text() );
 
-QStringList
-YQPkgHistoryItemCollector::actionColumns( const zypp::HistoryLogData::Ptr & item_ptr )
-{
-    QStringList columns;
+    // zypp logs an update as an install of the new version, so go through
+    // the events in chronological order to tell an update from an install
+
+    QList<QTreeWidgetItem *> items;
+    bool    installed = false;
+    QString lastEdition;
 
-    switch ( item_ptr->action().toEnum() )
+    for ( int i = events.size() - 1; i >= 0; --i )
     {
-        case zypp::HistoryActionID::INSTALL_e:
+        const PkgHistoryAction & event = events.at( i );
+        QString actionText;
+        QPixmap icon;
+
+        if ( event.actionId == zypp::HistoryActionID::REMOVE_e )
+        {
+            actionText = _( "Remove" );
+            icon       = YQIconPool::pkgDel();
+            installed  = false;
+        }
+        else
+        {
+            if ( ! installed )
             {
-                zypp::HistoryLogDataInstall * item =
-                    static_cast <zypp::HistoryLogDataInstall *>( item_ptr.get() );
-
-                columns << fromUTF8( item->name() );
-                columns << fromUTF8( item->edition().version() );
+                actionText = _( "Install" );
+                icon       = YQIconPool::pkgInstall();
             }
-            break;
-
-        case zypp::HistoryActionID::REMOVE_e:
+            else if ( event.edition == lastEdition )
             {
-                zypp::HistoryLogDataRemove * item =
-                    static_cast <zypp::HistoryLogDataRemove *>( item_ptr.get() );
-
-                columns << fromUTF8( item->name() );
-                columns << fromUTF8( item->edition().version() );
+                actionText = _( "Reinstall" );
+                icon       = YQIconPool::pkgInstall();
             }
-            break;
-
-        case zypp::HistoryActionID::REPO_ADD_e:
+            else
             {
-                zypp::HistoryLogDataRepoAdd * item =
-                    static_cast <zypp::HistoryLogDataRepoAdd *>( item_ptr.get() );
-
-                columns << fromUTF8( item->alias() );
-                columns << fromUTF8( item->url().asString() );
+                actionText = _( "Update" );
+                icon       = YQIconPool::pkgUpdate();
             }
-            break;
 
-        case zypp::HistoryActionID::REPO_REMOVE_e:
-            {
-                zypp::HistoryLogDataRepoRemove * item =
-                    static_cast <zypp::HistoryLogDataRepoRemove *>( item_ptr.get() );
+            installed   = true;
+            lastEdition = event.edition;
+        }
 
-                columns << fromUTF8( item->alias() );
-            }
-            break;
+        QStringList columns;
+        columns << fromUTF8( zypp::Date( event.time ).form( "%Y-%m-%d %H:%M:%S" ) )
+                << actionText
+                << event.edition;
 
-        case zypp::HistoryActionID::REPO_CHANGE_ALIAS_e:
-            {
-                zypp::HistoryLogDataRepoAliasChange * item =
-                    static_cast <zypp::HistoryLogDataRepoAliasChange *>( item_ptr.get() );
+        QTreeWidgetItem * item = new QTreeWidgetItem( columns );
+        Q_CHECK_PTR( item );
+        item->setIcon( 1, icon );
+        item->setData( 0, DateRole,   event.date   );
+        item->setData( 0, OffsetRole, event.offset );
 
-                columns << fromUTF8( item->oldAlias() ) + " -> " + fromUTF8( item->newAlias() );
-            }
-            break;
+        items.prepend( item ); // newest first
+    }
 
-        case zypp::HistoryActionID::REPO_CHANGE_URL_e:
-            {
-                zypp::HistoryLogDataRepoUrlChange * item =
-                    static_cast <zypp::HistoryLogDataRepoUrlChange *>( item_ptr.get() );
+    _timelineTree->addTopLevelItems( items );
+}
 
-                columns << fromUTF8( item->alias() );
-                columns << fromUTF8( item->newUrl().asString() );
-            }
-            break;
 
-        default:
-            break;
+void
+YQPkgHistoryDialog::showActionPackage( const QModelIndex & index )
+{
+    const PkgHistoryAction * action = _actionsModel->action( index );
+
+    if ( action &&
+         ( action->actionId == zypp::HistoryActionID::INSTALL_e ||
+           action->actionId == zypp::HistoryActionID::REMOVE_e     ) )
+    {
+        showPackage( action->name );
     }
+}
+
 
-    return columns;
+void
+YQPkgHistoryDialog::showPackage( const QString & name )
+{
+    _tabs->setCurrentWidget( _packagesPage );
+    _searchField->setText( name ); // this selects it via searchPackages()
 }
 
 
-QPixmap
-YQPkgHistoryItemCollector::actionIcon( zypp::HistoryActionID id )
+void
+YQPkgHistoryDialog::showTimelineAction( QTreeWidgetItem * item )
 {
-    switch ( id.toEnum() )
-    {
-        case zypp::HistoryActionID::INSTALL_e:     return YQIconPool::pkgInstall();
-        case zypp::HistoryActionID::REMOVE_e:      return YQIconPool::pkgDel();
-        case zypp::HistoryActionID::REPO_REMOVE_e: return YQIconPool::treeMinus();
-        case zypp::HistoryActionID::REPO_ADD_e:    return YQIconPool::treePlus();
+    if ( ! item )
+        return;
 
-        default: return QPixmap();
-    }
+    QModelIndex index = _actionsModel->actionIndex( item->data( 0, DateRole   ).toDate(),
+                                                    item->data( 0, OffsetRole ).toLongLong() );
+    if ( ! index.isValid() )
+        return;
+
+    _tabs->setCurrentWidget( _historyPage );
+
+    _actionsTree->expand( index.parent() );
+    _actionsTree->setCurrentIndex( index ); // selectAction() syncs the dates tree
+    _actionsTree->scrollTo( index, QAbstractItemView::PositionAtCenter );
 }
@@ -19,16 +19,31 @@
 #define YQPkgHistoryDialog_h
 
 #include <QDialog>
-#include <zypp/HistoryLogData.h>
 
-class QObject;
+#include "PkgHistoryReader.h"   // PkgHistoryActionList
+
+class QLabel;
+class QLineEdit;
+class QListWidget;
+class QModelIndex;
+class QTabWidget;
+class QTreeView;
 class QTreeWidget;
 class QTreeWidgetItem;
 class QWidget;
+class YQPkgHistoryModel;
+class YQPkgHistoryDatesModel;
 
 
 /**
  * Pkg status and History as a standalone popup dialog.
+ *
+ * The content comes from the PkgHistoryIndex which reads the history file
+ * in the background, newest first; the trees are filled while it is being
+ * read, so the dialog opens immediately even if the file is huge.
+ *
+ * The "Package Timeline" tab shows when a package was installed, updated or
+ * removed.
  **/
 class YQPkgHistoryDialog : public QDialog
 {
@@ -51,14 +66,25 @@ protected:
     YQPkgHistoryDialog( QWidget * parent );
 
     /**
-     * Fill the trees with content.
+     * Destructor.
+     **/
+    virtual ~YQPkgHistoryDialog();
+
+    /**
+     * Fill the trees with what the history index already has and bring the
+     * index up to date in the background.
      **/
     void populate();
 
     /**
-     * Show a warning pop-up if there was an error reading the history file.
+     * Show the reading status in the status label.
      **/
-    void showReadHistoryWarning( const QString & message );
+    void updateStatus();
+
+    /**
+     * Switch to the package timeline tab and show package 'name'.
+     **/
+    void showPackage( const QString & name );
 
 
 protected slots:
@@ -66,75 +92,68 @@ protected slots:
     void selectDate();
     void selectAction();
 
+    /**
+     * Show a warning pop-up if there was an error reading the history file.
+     **/
+    void showReadHistoryWarning( const QString & message );
 
-protected:
-
-    // Data members
-
-    QTreeWidget * _datesTree;   // Flat list for dates
-    QTreeWidget * _actionsTree; // Tree with action items below date items
-};
-
-
-/**
- * Helper class to populate both tree widgets in this dialog with zypp history
- * actions.
- *
- * This is used as a functor for a zypp::parser::HistoryLogReader where it is
- * called for each history item found while parsing the history file.
- **/
-class YQPkgHistoryItemCollector
-{
-public:
+    /**
+     * Add actions from the history index that are older than all others.
+     **/
+    void addOlderActions( const PkgHistoryActionList & actions );
 
     /**
-     * Constructor. This stores the widget pointers so items can later be added
-     * to those trees when libzypp calls operator() for each history item.
+     * Add actions from the history index that are newer than all others.
      **/
-    YQPkgHistoryItemCollector( QTreeWidget * datesTree,
-                               QTreeWidget * actionsTree );
+    void addNewerActions( const PkgHistoryActionList & actions );
 
     /**
-     * Functor method that is called by zypp::parser::HistoryLogReader for each
-     * history item (for each action). This will add an item for the action
-     * and, if needed, a parent item for the date and an item in the dates
-     * tree.
+     * Remove all actions after the history index was cleared.
      **/
-    bool operator() ( const zypp::HistoryLogData::Ptr & item_ptr );
+    void clearActions();
 
-protected:
+    /**
+     * Update the status and the package list after the index is done
+     * reading.
+     **/
+    void readingFinished();
 
     /**
-     * Add one item in the "dates" tree for the specified date.
+     * Fill the package list with the packages that match the search field.
      **/
-    void addDatesTreeItem  ( const QString & actionDate );
+    void searchPackages();
 
     /**
-     * Add one item in the "actions" tree for the specified date.
-     * This item will act as the parent item for all actions on that date.
+     * Show the timeline of the current package in the package list.
      **/
-    void addActionsDateItem( const QString & actionDate );
+    void showPackageTimeline();
 
     /**
-     * Format columns for one action, depending on the action type.
-     *
-     * Return an empty QStringList if this is not an action that is suitable to
-     * be shown to the user.
+     * Show the timeline of the package of an action in the actions tree.
      **/
-    QStringList actionColumns( const zypp::HistoryLogData::Ptr & item_ptr );
+    void showActionPackage( const QModelIndex & index );
 
     /**
-     * Return a suitable icon for an action.
+     * Show the action of a timeline item in the actions tree.
      **/
-    QPixmap actionIcon( zypp::HistoryActionID id );
+    void showTimelineAction( QTreeWidgetItem * item );
 
 
+protected:
+
     // Data members
 
-    QTreeWidget *     _datesTree;
-    QTreeWidget *     _actionsTree;
-    QTreeWidgetItem * _actionsDateItem;  // parent item for all actions of this date
-    QString           _lastDate;         // initialized empty like all QStrings
+    QTabWidget *             _tabs;
+    QWidget *                _historyPage;
+    QWidget *                _packagesPage;
+    QTreeView *              _datesTree;    // Flat list for dates
+    QTreeView *              _actionsTree;  // Tree with action items below date items
+    QLineEdit *              _searchField;
+    QListWidget *            _packageList;
+    QTreeWidget *            _timelineTree;
+    QLabel *                 _statusLabel;
+    YQPkgHistoryModel *      _actionsModel;
+    YQPkgHistoryDatesModel * _datesModel;
 };
 
 
@@ -0,0 +1,440 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <algorithm>    // std::lower_bound()
+
+#include <QPixmap>
+
+#include <zypp-core/Date.h>
+#include <zypp/HistoryLogData.h>
+
+#include "YQIconPool.h"
+#include "YQi18n.h"
+#include "utf8.h"
+#include "YQPkgHistoryModel.h"
+
+
+// The internal ID of a model index is 0 for a date row and the Julian day of
+// the parent date for an action row. Unlike the row of the parent date, that
+// doesn't change when newer dates are prepended, so persistent indexes of
+// actions stay valid. No valid date has Julian day 0 (that is in 4713 BC).
+
+#define DATE_ROW_ID     0
+
+
+YQPkgHistoryModel::YQPkgHistoryModel( QObject * parent )
+    : QAbstractItemModel( parent )
+    , _actionCount( 0 )
+{
+}
+
+
+YQPkgHistoryModel::~YQPkgHistoryModel()
+{
+}
+
+
+void YQPkgHistoryModel::clear()
+{
+    beginResetModel();
+    _dates.clear();
+    _actionCount = 0;
+    endResetModel();
+}
+
+
+void YQPkgHistoryModel::appendActions( const PkgHistoryActionList & actions )
+{
+    int i = 0;
+
+    // Older actions on the last date that is already in the model
+
+    if ( ! _dates.isEmpty() )
+    {
+        while ( i < actions.size() && actions.at( i ).date == _dates.last().date )
+            ++i;
+
+        if ( i > 0 )
+        {
+            int        row      = _dates.size() - 1;
+            DateItem & lastDate = _dates[ row ];
+
+            beginInsertRows( index( row, 0 ),
+                             lastDate.actions.size(),
+                             lastDate.actions.size() + i - 1 );
+            lastDate.actions += actions.mid( 0, i );
+            endInsertRows();
+        }
+    }
+
+    // All other actions go to new dates at the end
+
+    QVector<DateItem> newDates = createDateItems( actions.mid( i ) );
+
+    if ( ! newDates.isEmpty() )
+    {
+        beginInsertRows( QModelIndex(),
+                         _dates.size(),
+                         _dates.size() + newDates.size() - 1 );
+        _dates += newDates;
+        endInsertRows();
+    }
+
+    _actionCount += actions.size();
+}
+
+
+void YQPkgHistoryModel::prependActions( const PkgHistoryActionList & actions )
+{
+    int i = actions.size();
+
+    // Newer actions on the first date that is already in the model
+
+    if ( ! _dates.isEmpty() )
+    {
+        while ( i > 0 && actions.at( i - 1 ).date == _dates.first().date )
+            --i;
+
+        if ( i < actions.size() )
+        {
+            DateItem & firstDate = _dates.first();
+
+            beginInsertRows( index( 0, 0 ), 0, actions.size() - i - 1 );
+            firstDate.actions = actions.mid( i ) + firstDate.actions;
+            endInsertRows();
+        }
+    }
+
+    // All other actions go to new dates at the start
+
+    QVector<DateItem> newDates = createDateItems( actions.mid( 0, i ) );
+
+    if ( ! newDates.isEmpty() )
+    {
+        beginInsertRows( QModelIndex(), 0, newDates.size() - 1 );
+        _dates = newDates + _dates;
+        endInsertRows();
+    }
+
+    _actionCount += actions.size();
+}
+
+
+QVector<YQPkgHistoryModel::DateItem>
+YQPkgHistoryModel::createDateItems( const PkgHistoryActionList & actions )
+{
+    QVector<DateItem> dateItems;
+
+    for ( const PkgHistoryAction & action: actions )
+    {
+        if ( dateItems.isEmpty() || action.date != dateItems.last().date )
+        {
+            DateItem dateItem;
+            dateItem.date = action.date;
+            dateItem.text = fromUTF8( zypp::Date( action.time ).form( "%e %B %Y" ) );
+
+            dateItems.append( dateItem );
+        }
+
+        dateItems.last().actions.append( action );
+    }
+
+    return dateItems;
+}
+
+
+QString YQPkgHistoryModel::dateText( int row ) const
+{
+    if ( row < 0 || row >= _dates.size() )
+        return QString();
+
+    return _dates.at( row ).text;
+}
+
+
+int YQPkgHistoryModel::dateRow( const QDate & date ) const
+{
+    // The dates are sorted newest first
+
+    auto it = std::lower_bound( _dates.cbegin(), _dates.cend(), date,
+                                []( const DateItem & dateItem, const QDate & date )
+                                {
+                                    return dateItem.date > date;
+                                } );
+
+    if ( it == _dates.cend() || it->date != date )
+        return -1;
+
+    return it - _dates.cbegin();
+}
+
+
+quintptr YQPkgHistoryModel::dateId( int row ) const
+{
+    return (quintptr) _dates.at( row ).date.toJulianDay();
+}
+
+
+const PkgHistoryAction *
+YQPkgHistoryModel::action( const QModelIndex & index ) const
+{
+    if ( ! index.isValid() || index.internalId() == DATE_ROW_ID )
+        return 0;
+
+    int row = dateRow( index );
+
+    if ( row < 0 )
+        return 0;
+
+    return &_dates.at( row ).actions.at( index.row() );
+}
+
+
+QModelIndex YQPkgHistoryModel::actionIndex( const QDate & date, qint64 offset ) const
+{
+    int row = dateRow( date );
+
+    if ( row < 0 )
+        return QModelIndex();
+
+    const PkgHistoryActionList & actions = _dates.at( row ).actions;
+
+    for ( int i=0; i < actions.size(); ++i )
+    {
+        if ( actions.at( i ).offset == offset )
+            return createIndex( i, 0, dateId( row ) );
+    }
+
+    return QModelIndex();
+}
+
+
+int YQPkgHistoryModel::dateRow( const QModelIndex & index ) const
+{
+    if ( ! index.isValid() )
+        return -1;
+
+    if ( index.internalId() == DATE_ROW_ID )
+        return index.row();
+
+    return dateRow( QDate::fromJulianDay( (qint64) index.internalId() ) );
+}
+
+
+QModelIndex YQPkgHistoryModel::index( int                 row,
+                                      int                 column,
+                                      const QModelIndex & parent ) const
+{
+    if ( ! hasIndex( row, column, parent ) )
+        return QModelIndex();
+
+    if ( ! parent.isValid() )
+        return createIndex( row, column, (quintptr) DATE_ROW_ID );
+
+    return createIndex( row, column, dateId( parent.row() ) );
+}
+
+
+QModelIndex YQPkgHistoryModel::parent( const QModelIndex & index ) const
+{
+    if ( ! index.isValid() || index.internalId() == DATE_ROW_ID )
+        return QModelIndex();
+
+    int row = dateRow( index );
+
+    if ( row < 0 )
+        return QModelIndex();
+
+    return createIndex( row, 0, (quintptr) DATE_ROW_ID );
+}
+
+
+int YQPkgHistoryModel::rowCount( const QModelIndex & parent ) const
+{
+    if ( ! parent.isValid() )
+        return _dates.size();
+
+    if ( parent.internalId() == DATE_ROW_ID && parent.column() == 0 )
+        return _dates.at( parent.row() ).actions.size();
+
+    return 0;   // actions don't have children
+}
+
+
+int YQPkgHistoryModel::columnCount( const QModelIndex & parent ) const
+{
+    Q_UNUSED( parent );
+
+    return 2;
+}
+
+
+QVariant YQPkgHistoryModel::data( const QModelIndex & index, int role ) const
+{
+    if ( ! index.isValid() )
+        return QVariant();
+
+    if ( index.internalId() == DATE_ROW_ID )
+    {
+        if ( role == Qt::DisplayRole && index.column() == 0 )
+            return _dates.at( index.row() ).text;
+
+        return QVariant();
+    }
+
+    const PkgHistoryAction * actionPtr = action( index );
+
+    if ( ! actionPtr )
+        return QVariant();
+
+    const PkgHistoryAction & action = *actionPtr;
+
+    switch ( role )
+    {
+        case Qt::DisplayRole:
+            return index.column() == 0 ? action.name : action.detail;
+
+        case Qt::DecorationRole:
+            if ( index.column() == 0 )
+            {
+                QPixmap icon = actionIcon( action.actionId );
+
+                if ( ! icon.isNull() )
+                    return icon;
+            }
+            break;
+
+        default:
+            break;
+    }
+
+    return QVariant();
+}
+
+
+QVariant YQPkgHistoryModel::headerData( int             section,
+                                        Qt::Orientation orientation,
+                                        int             role ) const
+{
+    if ( orientation != Qt::Horizontal || role != Qt::DisplayRole )
+        return QVariant();
+
+    switch ( section )
+    {
+        case 0:  return _( "Action" );
+        case 1:  return _( "Version/URL" );
+        default: return QVariant();
+    }
+}
+
+
+QPixmap YQPkgHistoryModel::actionIcon( int actionId )
+{
+    switch ( actionId )
+    {
+        case zypp::HistoryActionID::INSTALL_e:     return YQIconPool::pkgInstall();
+        case zypp::HistoryActionID::REMOVE_e:      return YQIconPool::pkgDel();
+        case zypp::HistoryActionID::REPO_REMOVE_e: return YQIconPool::treeMinus();
+        case zypp::HistoryActionID::REPO_ADD_e:    return YQIconPool::treePlus();
+
+        default: return QPixmap();
+    }
+}
+
+
+//
+//----------------------------------------------------------------------
+//
+
+
+YQPkgHistoryDatesModel::YQPkgHistoryDatesModel( YQPkgHistoryModel * actionsModel,
+                                                QObject *           parent )
+    : QAbstractListModel( parent )
+    , _actionsModel( actionsModel )
+{
+    connect( _actionsModel, SIGNAL( rowsAboutToBeInserted       ( QModelIndex, int, int ) ),
+             this,          SLOT  ( actionsRowsAboutToBeInserted( QModelIndex, int, int ) ) );
+
+    connect( _actionsModel, SIGNAL( rowsInserted       ( QModelIndex, int, int ) ),
+             this,          SLOT  ( actionsRowsInserted( QModelIndex           ) ) );
+
+    connect( _actionsModel, SIGNAL( modelAboutToBeReset()   ),
+             this,          SLOT  ( actionsAboutToBeReset() ) );
+
+    connect( _actionsModel, SIGNAL( modelReset()   ),
+             this,          SLOT  ( actionsReset() ) );
+}
+
+
+YQPkgHistoryDatesModel::~YQPkgHistoryDatesModel()
+{
+}
+
+
+int YQPkgHistoryDatesModel::rowCount( const QModelIndex & parent ) const
+{
+    return parent.isValid() ? 0 : _actionsModel->dateCount();
+}
+
+
+QVariant YQPkgHistoryDatesModel::data( const QModelIndex & index, int role ) const
+{
+    if ( ! index.isValid() || role != Qt::DisplayRole )
+        return QVariant();
+
+    return _actionsModel->dateText( index.row() );
+}
+
+
+QVariant YQPkgHistoryDatesModel::headerData( int             section,
+                                             Qt::Orientation orientation,
+                                             int             role ) const
+{
+    if ( section != 0 || orientation != Qt::Horizontal || role != Qt::DisplayRole )
+        return QVariant();
+
+    return _( "Date" );
+}
+
+
+void YQPkgHistoryDatesModel::actionsRowsAboutToBeInserted( const QModelIndex & parent,
+                                                           int                 first,
+                                                           int                 last )
+{
+    if ( ! parent.isValid() ) // new dates
+        beginInsertRows( QModelIndex(), first, last );
+}
+
+
+void YQPkgHistoryDatesModel::actionsRowsInserted( const QModelIndex & parent )
+{
+    if ( ! parent.isValid() )
+        endInsertRows();
+}
+
+
+void YQPkgHistoryDatesModel::actionsAboutToBeReset()
+{
+    beginResetModel();
+}
+
+
+void YQPkgHistoryDatesModel::actionsReset()
+{
+    endResetModel();
+}
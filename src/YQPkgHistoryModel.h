@@ -0,0 +1,216 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef YQPkgHistoryModel_h
+#define YQPkgHistoryModel_h
+
+
+#include <QAbstractItemModel>
+#include <QAbstractListModel>
+#include <QVector>
+
+#include "PkgHistoryReader.h"   // PkgHistoryAction
+
+class QPixmap;
+
+
+/**
+ * Item model for the actions tree of the package history dialog: One
+ * top-level row for each date, newest first, with one child row for each
+ * action on that date, also newest first. Columns are the action (package
+ * name or repo alias) and the version or URL.
+ *
+ * Unlike a QTreeWidget with one QTreeWidgetItem for each action, this only
+ * stores the compact PkgHistoryAction data; the views ask only for the rows
+ * they actually show.
+ **/
+class YQPkgHistoryModel: public QAbstractItemModel
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructor.
+     **/
+    YQPkgHistoryModel( QObject * parent = 0 );
+
+    /**
+     * Destructor.
+     **/
+    virtual ~YQPkgHistoryModel();
+
+    /**
+     * Add actions that are all older than the ones that are already in the
+     * model. 'actions' are expected newest first, just like
+     * PkgHistoryReader::takeActions() delivers them.
+     **/
+    void appendActions( const PkgHistoryActionList & actions );
+
+    /**
+     * Add actions that are all newer than the ones that are already in the
+     * model, newest first.
+     **/
+    void prependActions( const PkgHistoryActionList & actions );
+
+    /**
+     * Remove all actions.
+     **/
+    void clear();
+
+    /**
+     * Return the number of dates (top-level rows).
+     **/
+    int dateCount() const { return _dates.size(); }
+
+    /**
+     * Return the display text for the date in top-level row 'row'.
+     **/
+    QString dateText( int row ) const;
+
+    /**
+     * Return the total number of actions.
+     **/
+    int actionCount() const { return _actionCount; }
+
+    /**
+     * Return the top-level row of 'date' or -1 if there is none.
+     **/
+    int dateRow( const QDate & date ) const;
+
+    /**
+     * Return the action of an index or 0 if this is not an action index.
+     **/
+    const PkgHistoryAction * action( const QModelIndex & index ) const;
+
+    /**
+     * Return the index of the action in the history file line at 'offset'
+     * on 'date' or an invalid index if there is none.
+     **/
+    QModelIndex actionIndex( const QDate & date, qint64 offset ) const;
+
+    /**
+     * Return the row of the date of an index: its own row for a date index,
+     * the parent's row for an action index. Return -1 for an invalid index.
+     **/
+    int dateRow( const QModelIndex & index ) const;
+
+
+    // Reimplemented from QAbstractItemModel
+
+    virtual QModelIndex index( int                 row,
+                               int                 column,
+                               const QModelIndex & parent = QModelIndex() ) const override;
+
+    virtual QModelIndex parent( const QModelIndex & index ) const override;
+
+    virtual int rowCount   ( const QModelIndex & parent = QModelIndex() ) const override;
+    virtual int columnCount( const QModelIndex & parent = QModelIndex() ) const override;
+
+    virtual QVariant data( const QModelIndex & index,
+                           int                 role = Qt::DisplayRole ) const override;
+
+    virtual QVariant headerData( int             section,
+                                 Qt::Orientation orientation,
+                                 int             role = Qt::DisplayRole ) const override;
+
+
+protected:
+
+    struct DateItem
+    {
+        QDate                date;
+        QString              text;
+        PkgHistoryActionList actions;
+    };
+
+    /**
+     * Return the internal ID for the action rows of the date in top-level
+     * row 'row'. This stays the same when rows are inserted.
+     **/
+    quintptr dateId( int row ) const;
+
+    /**
+     * Group 'actions' (sorted newest first) into date items.
+     **/
+    static QVector<DateItem> createDateItems( const PkgHistoryActionList & actions );
+
+    /**
+     * Return a suitable icon for an action.
+     **/
+    static QPixmap actionIcon( int actionId );
+
+
+    //
+    // Data members
+    //
+
+    QVector<DateItem> _dates;
+    int               _actionCount;
+};
+
+
+/**
+ * Flat list model of the dates of a YQPkgHistoryModel for the dates list of
+ * the package history dialog. This follows the top-level rows of that model.
+ **/
+class YQPkgHistoryDatesModel: public QAbstractListModel
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructor.
+     **/
+    YQPkgHistoryDatesModel( YQPkgHistoryModel * actionsModel,
+                            QObject *           parent = 0 );
+
+    /**
+     * Destructor.
+     **/
+    virtual ~YQPkgHistoryDatesModel();
+
+
+    // Reimplemented from QAbstractItemModel
+
+    virtual int rowCount( const QModelIndex & parent = QModelIndex() ) const override;
+
+    virtual QVariant data( const QModelIndex & index,
+                           int                 role = Qt::DisplayRole ) const override;
+
+    virtual QVariant headerData( int             section,
+                                 Qt::Orientation orientation,
+                                 int             role = Qt::DisplayRole ) const override;
+
+
+protected slots:
+
+    void actionsRowsAboutToBeInserted( const QModelIndex & parent, int first, int last );
+    void actionsRowsInserted         ( const QModelIndex & parent );
+    void actionsAboutToBeReset();
+    void actionsReset();
+
+
+protected:
+
+    YQPkgHistoryModel * _actionsModel;
+};
+
+
+#endif // YQPkgHistoryModel_h
@@ -0,0 +1,178 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <QElapsedTimer>
+#include <QLabel>
+#include <QLineEdit>
+#include <QPushButton>
+#include <QVBoxLayout>
+
+#include <zypp/PoolItem.h>
+#include <zypp/ResKind.h>
+
+#include "Exception.h"
+#include "Logger.h"
+#include "QY2CursorHelper.h"
+#include "YQi18n.h"
+#include "utf8.h"
+#include "YQPkgRequiredByFilterView.h"
+
+#ifndef VERBOSE_FILTER_VIEWS
+#  define VERBOSE_FILTER_VIEWS  0
+#endif
+
+
+YQPkgRequiredByFilterView::YQPkgRequiredByFilterView( QWidget * parent )
+    : QWidget( parent )
+{
+    QVBoxLayout * layout = new QVBoxLayout( this );
+    CHECK_NEW( layout );
+
+    QLabel * label = new QLabel( _( "Packages that &require:" ), this );
+    CHECK_NEW( label );
+    layout->addWidget( label );
+
+    _searchText = new QLineEdit( this );
+    CHECK_NEW( _searchText );
+    _searchText->setPlaceholderText( _( "Package name or capability" ) );
+    _searchText->setClearButtonEnabled( true );
+    label->setBuddy( _searchText );
+    layout->addWidget( _searchText );
+
+    _searchButton = new QPushButton( _( "&Search" ), this );
+    CHECK_NEW( _searchButton );
+    layout->addWidget( _searchButton );
+    layout->addStretch();
+
+    connect( _searchButton, SIGNAL( clicked() ),
+             this,          SLOT  ( filter()  ) );
+
+    connect( _searchText,   SIGNAL( returnPressed() ),
+             this,          SLOT  ( filter()        ) );
+}
+
+
+YQPkgRequiredByFilterView::~YQPkgRequiredByFilterView()
+{
+    // NOP
+}
+
+
+void
+YQPkgRequiredByFilterView::setFocus()
+{
+    _searchText->setFocus();
+}
+
+
+void
+YQPkgRequiredByFilterView::showFilter( QWidget * newFilter )
+{
+    if ( newFilter == this )
+    {
+        filter();
+        _searchText->setFocus();
+    }
+}
+
+
+void
+YQPkgRequiredByFilterView::filter()
+{
+#if VERBOSE_FILTER_VIEWS
+    logVerbose() << "Filtering" << endl;
+#endif
+
+    emit filterStart();
+    _matched.clear();
+
+    QString text = _searchText->text().trimmed();
+
+    if ( ! text.isEmpty() )
+    {
+        ReverseDepIndex * index = ReverseDepIndex::instance();
+
+        if ( ! index->isReady() )
+        {
+            // The user explicitly asked for this, so it's okay to block
+            // until the background build is finished.
+
+            busyCursor();
+            index->ensureReady();
+            normalCursor();
+        }
+
+        QElapsedTimer timer;
+        timer.start();
+
+        ZyppSel selectable = zypp::ui::Selectable::get( zypp::ResKind::package, toUTF8( text ) );
+
+        if ( selectable )
+        {
+            // A package with that name: Whatever requires any of its provides
+
+            for ( zypp::ui::Selectable::available_iterator it = selectable->availableBegin();
+                  it != selectable->availableEnd();
+                  ++it )
+            {
+                emitMatches( index->requiredBy( it->satSolvable() ) );
+            }
+
+            for ( zypp::ui::Selectable::installed_iterator it = selectable->installedBegin();
+                  it != selectable->installedEnd();
+                  ++it )
+            {
+                emitMatches( index->requiredBy( it->satSolvable() ) );
+            }
+        }
+        else
+        {
+            // No such package: Take it literally as a capability
+
+            emitMatches( index->requiredBy( zypp::Capability( toUTF8( text ) ) ) );
+        }
+
+        logDebug() << _matched.size() << " packages require " << text
+                   << " (" << timer.elapsed() << " millisec)" << endl;
+    }
+
+    emit filterFinished();
+}
+
+
+void
+YQPkgRequiredByFilterView::emitMatches( const SolvableList & requirers )
+{
+    for ( const zypp::sat::Solvable & solvable: requirers )
+    {
+        // Several instances of the same package might require it;
+        // add each package to the list only once.
+
+        SatId ident = solvable.ident().id();
+
+        if ( _matched.contains( ident ) )
+            continue;
+
+        _matched.insert( ident );
+
+        ZyppSel selectable = zypp::ui::Selectable::get( solvable );
+        ZyppPkg zyppPkg    = tryCastToZyppPkg( zypp::PoolItem( solvable ).resolvable() );
+
+        if ( selectable && zyppPkg )
+            emit filterMatch( selectable, zyppPkg );
+    }
+}
@@ -0,0 +1,120 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#ifndef YQPkgRequiredByFilterView_h
+#define YQPkgRequiredByFilterView_h
+
+#include <QWidget>
+#include <QSet>
+
+#include "YQZypp.h"
+#include "ReverseDepIndex.h"
+
+
+class QLineEdit;
+class QPushButton;
+
+
+/**
+ * Filter view for packages that require a package ("what requires this"):
+ * The user enters a package name or a capability, and all packages that
+ * require that package (via any of its provides) or that capability are
+ * shown.
+ *
+ * This uses the ReverseDepIndex which is built in the background after the
+ * repos are loaded, so this is a matter of milliseconds, unlike a
+ * zypp::PoolQuery over solvable:requires.
+ **/
+class YQPkgRequiredByFilterView : public QWidget
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructor
+     **/
+    YQPkgRequiredByFilterView( QWidget * parent );
+
+    /**
+     * Destructor
+     **/
+    virtual ~YQPkgRequiredByFilterView();
+
+
+public slots:
+
+    /**
+     * Notification that a new filter is the one to be shown.
+     **/
+    void showFilter( QWidget * newFilter );
+
+    /**
+     * Filter according to the view's rules and current selection.
+     * Emits those signals:
+     *    filterStart()
+     *    filterMatch() for each pkg that matches the filter
+     *    filterFinished()
+     **/
+    void filter();
+
+    /**
+     * Set the keyboard focus into this view's input field.
+     **/
+    void setFocus();
+
+
+signals:
+
+    /**
+     * Emitted when the filtering starts. Use this to clear package lists
+     * etc. prior to adding new entries.
+     **/
+    void filterStart();
+
+    /**
+     * Emitted during filtering for each pkg that matches the filter.
+     **/
+    void filterMatch( ZyppSel selectable,
+                      ZyppPkg pkg );
+
+    /**
+     * Emitted when filtering is finished.
+     **/
+    void filterFinished();
+
+
+protected:
+
+    /**
+     * Emit filterMatch() for each package in 'requirers' that was not
+     * emitted yet during this filter run (by package name).
+     **/
+    void emitMatches( const SolvableList & requirers );
+
+
+    //
+    // Data members
+    //
+
+    QLineEdit *    _searchText;
+    QPushButton *  _searchButton;
+    QSet<SatId>    _matched;       // idents of packages emitted so far
+};
+
+
+#endif // ifndef YQPkgRequiredByFilterView_h
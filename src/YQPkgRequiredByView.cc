@@ -0,0 +1,127 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <QMap>
+
+#include <zypp/Repository.h>
+#include <zypp/sat/Solvable.h>
+
+#include "ReverseDepIndex.h"
+#include "YQi18n.h"
+#include "utf8.h"
+#include "YQPkgRequiredByView.h"
+
+
+YQPkgRequiredByView::YQPkgRequiredByView( QWidget * parent )
+    : YQPkgGenericDetailsView( parent )
+{
+    connect( ReverseDepIndex::instance(), SIGNAL( ready()      ),
+             this,                        SLOT  ( indexReady() ) );
+}
+
+
+YQPkgRequiredByView::~YQPkgRequiredByView()
+{
+    // NOP
+}
+
+
+void
+YQPkgRequiredByView::indexReady()
+{
+    showDetailsIfVisible( _selectable );
+}
+
+
+void
+YQPkgRequiredByView::showDetails( ZyppSel selectable )
+{
+    _selectable = selectable;
+
+    if ( ! selectable )
+    {
+        clear();
+        return;
+    }
+
+    QString html = htmlStart();
+    html += htmlHeading( selectable );
+
+    ReverseDepIndex * index = ReverseDepIndex::instance();
+
+    if ( ! index->isReady() )
+    {
+        if ( ! index->isBuilding() )
+            index->startBuild();
+
+        // indexReady() will show the real content when it's done
+
+        html += "<p class=\"note\">" + _( "Building the reverse dependency index..." ) + "</p>";
+    }
+    else
+    {
+        ZyppObj candidate = selectable->candidateObj();
+        ZyppObj installed = selectable->installedObj();
+
+        if ( installed )
+            html += requiredByTable( installed, _( "Installed Version" ) );
+
+        if ( candidate && candidate != installed )
+            html += requiredByTable( candidate, _( "Alternate Version" ) );
+    }
+
+    html += htmlEnd();
+    setHtml( html );
+}
+
+
+QString
+YQPkgRequiredByView::requiredByTable( ZyppObj zyppObj, const QString & heading )
+{
+    SolvableList requirers = ReverseDepIndex::instance()->requiredBy( zyppObj->satSolvable() );
+
+    QString html = "<p><b>" + heading + " " + htmlEscape( fromUTF8( zyppObj->edition().asString() ) ) + "</b></p>";
+
+    if ( requirers.isEmpty() )
+    {
+        html += "<p class=\"note\">" + _( "Not required by any package." ) + "</p>";
+        return html;
+    }
+
+    // Use a QMultiMap to sort the rows by package name
+
+    QMultiMap<QString, QString> rows;
+
+    for ( const zypp::sat::Solvable & solvable: requirers )
+    {
+        QString name = fromUTF8( solvable.name() );
+        QString repo = solvable.isSystem() ?
+            _( "Installed" ) : fromUTF8( solvable.repository().name() );
+
+        rows.insert( name,
+                     row( cell( name ) +
+                          cell( solvable.edition().asString() ) +
+                          cell( repo ) ) );
+    }
+
+    html += table( rows.values().join( "" ) );
+
+    // %1 is the number of packages
+    html += "<p>" + _( "%1 package", "%1 packages", requirers.size() ).arg( requirers.size() ) + "</p>";
+
+    return html;
+}
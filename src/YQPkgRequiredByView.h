@@ -0,0 +1,74 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#ifndef YQPkgRequiredByView_h
+#define YQPkgRequiredByView_h
+
+#include "YQPkgGenericDetailsView.h"
+
+
+/**
+ * Display the packages that require a package: Those that require any of the
+ * capabilities that the installed or the candidate instance provides.
+ *
+ * This uses the ReverseDepIndex. If it is not ready yet, a note is displayed,
+ * and the view is updated when the index becomes ready.
+ **/
+class YQPkgRequiredByView : public YQPkgGenericDetailsView
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Constructor
+     **/
+    YQPkgRequiredByView( QWidget * parent );
+
+    /**
+     * Destructor
+     **/
+    virtual ~YQPkgRequiredByView();
+
+    /**
+     * Show the packages that require the specified selectable.
+     *
+     * Reimplemented from YQPkgGenericDetailsView.
+     **/
+    virtual void showDetails( ZyppSel selectable ) override;
+
+
+protected slots:
+
+    /**
+     * Show the current selectable again after the ReverseDepIndex became
+     * ready.
+     **/
+    void indexReady();
+
+
+protected:
+
+    /**
+     * Return a HTML table of the packages that require 'zyppObj' with
+     * 'heading' above it.
+     **/
+    QString requiredByTable( ZyppObj zyppObj, const QString & heading );
+};
+
+
+#endif // ifndef YQPkgRequiredByView_h
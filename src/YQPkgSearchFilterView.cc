@@ -83,6 +83,15 @@ YQPkgSearchFilterView::~YQPkgSearchFilterView()
 }
 
 
+void
+YQPkgSearchFilterView::search( const QString & searchText )
+{
+    _ui->searchText->setText( searchText );
+    updateDetectedFilterMode();
+    filter();
+}
+
+
 SearchFilter
 YQPkgSearchFilterView::buildSearchFilterFromWidgets()
 {
@@ -96,6 +96,12 @@ public slots:
      **/
     void setFocus();
 
+    /**
+     * Search for 'searchText' with the other search settings unchanged as if
+     * the user had typed it and clicked the "Search" button.
+     **/
+    void search( const QString & searchText );
+
 
 protected slots:
 
@@ -47,11 +47,14 @@
 #include <QVBoxLayout>
 
 #include "Exception.h"
+#include "FlightRecorder.h"
 #include "LicenseCache.h"
 #include "Logger.h"
 #include "QY2CursorHelper.h"
 #include "MyrlynApp.h"
+#include "MyrlynRepoManager.h"
 #include "RepoConfigDialog.h"
+#include "StartupProfile.h"
 #include "YQPkgChangeLogView.h"
 #include "YQPkgChangesDialog.h"
 #include "YQPkgClassificationFilterView.h"
@@ -69,8 +72,11 @@
 #include "YQPkgPatternList.h"
 #include "YQPkgProductDialog.h"
 #include "YQPkgRepoFilterView.h"
+#include "YQPkgRequiredByFilterView.h"
+#include "YQPkgRequiredByView.h"
 #include "YQPkgSearchFilterView.h"
 #include "YQPkgServiceFilterView.h"
+#include "YQPkgSolverStatsDialog.h"
 #include "YQPkgStatusFilterView.h"
 #include "YQPkgTechnicalDetailsView.h"
 #include "YQPkgUpdatesFilterView.h"
@@ -109,10 +115,13 @@ YQPkgSelector::YQPkgSelector( QWidget * parent )
     , _patternList(0)
     , _statusFilterView(0)
     , _langList(0)
+    , _requiredByFilterView(0)
     , _pkgVersionsView(0)
     , _notificationsArea(0)
     , _switchToRepoLabel(0)
     , _cancelSwitchingToRepoLabel(0)
+    , _repoRefreshLabel(0)
+    , _resolvePendingLabel(0)
     , _menuBar(0)
     , _pkgMenu(0)
     , _patchMenu(0)
@@ -125,6 +134,7 @@ YQPkgSelector::YQPkgSelector( QWidget * parent )
     , _allowVendorChangeAction(0)
     , _excludeDevelPkgs(0)
     , _excludeDebugInfoPkgs(0)
+    , _filterStartUsec(0)
 {
     _instance = this;
 
@@ -134,25 +144,40 @@ YQPkgSelector::YQPkgSelector( QWidget * parent )
 
     logDebug() << "Creating YQPkgSelector..." << endl;
 
-    basicLayout();
-    addMenus();         // Only after all widgets are created!
-    readSettings();     // Only after menus are created!
-    makeConnections();
-    _filters->readSettings();
-
-    if ( _filters->tabCount() == 0 )
     {
-        logDebug() << "No page configuration saved, using fallbacks" << endl;
-        showFallbackPages();
+        StartupPhase phase( "Create widgets" );
+
+        basicLayout();
+        addMenus();         // Only after all widgets are created!
+        readSettings();     // Only after menus are created!
+        makeConnections();
     }
 
-    overrideInitialPage(); // Only for very important special cases!
+    {
+        StartupPhase phase( "Show filter views" );
+        _filters->readSettings();
+
+        if ( _filters->tabCount() == 0 )
+        {
+            logDebug() << "No page configuration saved, using fallbacks" << endl;
+            showFallbackPages();
+        }
+
+        overrideInitialPage(); // Only for very important special cases!
+    }
 
     if ( _filters->diskUsageList() )
-        _filters->diskUsageList()->updateDiskUsage();
+    {
+        StartupPhase phase( "Disk usage" );
+        _filters->diskUsageList()->updateDiskUsageNow();
+    }
 
     _blockResolver = false;
-    firstSolverRun();
+
+    {
+        StartupPhase phase( "First solver run" );
+        firstSolverRun();
+    }
 
     logDebug() << "YQPkgSelector init done" << endl;
 }
@@ -171,21 +196,25 @@ YQPkgSelector::~YQPkgSelector()
 
 void YQPkgSelector::showFallbackPages()
 {
+    // Only open the tabs; this doesn't create the filter views yet, and it
+    // doesn't send any signals.
+
+    QStringList pageIds;
+    pageIds << "search"
+            << "patches"
+            << "updates"
+            << "repos"
+            << "services"
+            << "patterns"
+            << "inst_summary";
+
+    for ( const QString & pageId: pageIds )
     {
-        // New scope for the signal blocker:
-        // Prevent a signal cascade for each page as it is shown.
-        QSignalBlocker sigBlocker( _filters );
-
-        if ( _searchFilterView  ) _filters->showPage( _searchFilterView  );
-        if ( _patchFilterView   ) _filters->showPage( _patchFilterView   );
-        if ( _updatesFilterView ) _filters->showPage( _updatesFilterView );
-        if ( _repoFilterView    ) _filters->showPage( _repoFilterView    );
-        if ( _serviceFilterView ) _filters->showPage( _serviceFilterView );
-        if ( _patternList       ) _filters->showPage( _patternList       );
-        if ( _statusFilterView  ) _filters->showPage( _statusFilterView  );
+        if ( _filters->findPage( pageId ) ) // Some are optional
+            _filters->openPage( pageId );
     }
 
-    // Signals are no longer blocked; now trigger one for the first page
+    // Now create the first page and trigger a signal for it
 
     _filters->showPage( 0 );
 }
@@ -198,14 +227,21 @@ void YQPkgSelector::overrideInitialPage()
     // Don't add any generic fallback here; that would kill the effect of
     // writing and reading the page configuration to and from the settings.
 
-    if ( _pkgClassificationFilterView && anyRetractedPkgInstalled() )
+    bool retractedPkgInstalled = false;
+
+    {
+        StartupPhase phase( "Check for retracted packages" );
+        retractedPkgInstalled = anyRetractedPkgInstalled();
+    }
+
+    if ( retractedPkgInstalled )
     {
         // Exceptional case: If the system has any retracted package installed,
         // switch to that filter view and show those packages.  This should
         // happen only very, very rarely.
 
         logInfo() << "Found installed retracted packages; switching to that view" << endl;
-        _filters->showPage( _pkgClassificationFilterView );
+        _filters->showPage( "package_classification" ); // This creates the view
         _pkgClassificationFilterView->showPkgClass( YQPkgClassRetractedInstalled );
 
         // Also show a pop-up warning?
@@ -219,9 +255,9 @@ void YQPkgSelector::overrideInitialPage()
         // inform the user when such a change occurs.
     }
 #if FORCE_SHOW_NEEDED_PATCHES
-    else if ( _patchFilterView && YQPkgPatchList::haveNeededPatches() )
+    else if ( _filters->findPage( "patches" ) && YQPkgPatchList::haveNeededPatches() )
     {
-        _filters->showPage( _patchFilterView );
+        _filters->showPage( "patches" ); // This creates the view
         _patchFilterView->patchList()->selectSomething();
     }
 #endif
@@ -283,6 +319,7 @@ void YQPkgSelector::createFilterViews()
 
     createPkgClassificationFilterView();
     createLanguagesFilterView();
+    createRequiredByFilterView();
 
     // This should be the last one
     createStatusFilterView();        // a.k.a. intallation summary
@@ -291,11 +328,19 @@ void YQPkgSelector::createFilterViews()
 
 void YQPkgSelector::createSearchFilterView()
 {
-    _searchFilterView = new YQPkgSearchFilterView( this );
-    CHECK_NEW( _searchFilterView );
+    _filters->addPage( _( "&Search" ), [ this ]()
+        {
+            _searchFilterView = new YQPkgSearchFilterView( this );
+            CHECK_NEW( _searchFilterView );
+
+            connectFilter( _searchFilterView, _pkgList, false );
+
+            connect( _searchFilterView, SIGNAL( message( const QString & ) ),
+                     _pkgList,          SLOT  ( message( const QString & ) ) );
 
-    _filters->addPage( _( "&Search" ), _searchFilterView,
-                       "search", Qt::CTRL | Qt::SHIFT | Qt::Key_S );
+            return _searchFilterView;
+        },
+        "search", Qt::CTRL | Qt::SHIFT | Qt::Key_S );
 }
 
 
@@ -303,13 +348,18 @@ void YQPkgSelector::createPatchFilterView( bool force )
 {
     if ( YQPkgPatchList::haveAnyPatches() || force )
     {
-        if ( ! _patchFilterView )
+        if ( ! _filters->findPage( "patches" ) )
         {
-            _patchFilterView = new YQPkgPatchFilterView( this );
-            CHECK_NEW( _patchFilterView );
+            _filters->addPage( _( "Patc&hes" ), [ this ]()
+                {
+                    _patchFilterView = new YQPkgPatchFilterView( this );
+                    CHECK_NEW( _patchFilterView );
 
-            _filters->addPage( _( "Patc&hes" ), _patchFilterView,
-                               "patches", Qt::CTRL | Qt::SHIFT | Qt::Key_H  );
+                    connectPatchFilterView();
+
+                    return _patchFilterView;
+                },
+                "patches", Qt::CTRL | Qt::SHIFT | Qt::Key_H  );
         }
     }
 }
@@ -317,22 +367,39 @@ void YQPkgSelector::createPatchFilterView( bool force )
 
 void YQPkgSelector::createUpdatesFilterView()
 {
-    _updatesFilterView = new YQPkgUpdatesFilterView( this );
-    CHECK_NEW( _updatesFilterView );
+    _filters->addPage( _( "&Updates" ), [ this ]()
+        {
+            _updatesFilterView = new YQPkgUpdatesFilterView( this );
+            CHECK_NEW( _updatesFilterView );
+
+            connectFilter( _updatesFilterView, _pkgList, false );
 
-    _filters->addPage( _( "&Updates" ), _updatesFilterView,
-                       "updates", Qt::CTRL | Qt::SHIFT | Qt::Key_U );
+            return _updatesFilterView;
+        },
+        "updates", Qt::CTRL | Qt::SHIFT | Qt::Key_U );
 }
 
 
 void YQPkgSelector::createRepoFilterView()
 {
-    _repoFilterView = new YQPkgRepoFilterView( this );
-    CHECK_NEW( _repoFilterView );
+    _filters->addPage( _( "&Repositories" ), [ this ]()
+        {
+            _repoFilterView = new YQPkgRepoFilterView( this );
+            CHECK_NEW( _repoFilterView );
+
+            connectFilter( _repoFilterView, _pkgList, false );
+
+            connect( _repoFilterView, SIGNAL( filterNearMatch  ( ZyppSel, ZyppPkg ) ),
+                     _pkgList,        SLOT  ( addPkgItemDimmed ( ZyppSel, ZyppPkg ) ) );
 
-    _filters->addPage( _( "&Repositories" ), _repoFilterView,
-                       "repos", Qt::CTRL | Qt::SHIFT | Qt::Key_R );
+            // Hide and show the upgrade label when the user selects repositories
 
+            connect( _repoFilterView, SIGNAL( filterStart()           ),
+                     this,            SLOT  ( updateSwitchRepoLabels() ) );
+
+            return _repoFilterView;
+        },
+        "repos", Qt::CTRL | Qt::SHIFT | Qt::Key_R );
 }
 
 
@@ -340,10 +407,19 @@ void YQPkgSelector::createServiceFilterView()
 {
     if ( YQPkgServiceFilterView::any_service() ) // Only if a service is present
     {
-        _serviceFilterView = new YQPkgServiceFilterView( this );
-        CHECK_NEW( _serviceFilterView );
+        _filters->addPage( _( "Ser&vices" ), [ this ]()
+            {
+                _serviceFilterView = new YQPkgServiceFilterView( this );
+                CHECK_NEW( _serviceFilterView );
+
+                connectFilter( _serviceFilterView, _pkgList, false );
+
+                connect( _serviceFilterView, SIGNAL( filterNearMatch  ( ZyppSel, ZyppPkg ) ),
+                         _pkgList,           SLOT  ( addPkgItemDimmed ( ZyppSel, ZyppPkg ) ) );
 
-        _filters->addPage( _( "Ser&vices" ), _serviceFilterView, "services" );
+                return _serviceFilterView;
+            },
+            "services" );
 
         // No shortcut - this isn't used nearly enough to waste another
         // key combination on it. There are only 26 to choose from.
@@ -355,43 +431,82 @@ void YQPkgSelector::createPatternsFilterView()
 {
     if ( ! zyppPool().empty<zypp::Pattern>() )
     {
-        _patternList = new YQPkgPatternList( this );
-        CHECK_NEW( _patternList );
+        _filters->addPage( _( "Pa&tterns" ), [ this ]()
+            {
+                _patternList = new YQPkgPatternList( this );
+                CHECK_NEW( _patternList );
+
+                connectFilter( _patternList, _pkgList );
+                connectPatternList();
 
-        _filters->addPage( _( "Pa&tterns" ), _patternList,
-                           "patterns", Qt::CTRL | Qt::SHIFT | Qt::Key_T );
+                return _patternList;
+            },
+            "patterns", Qt::CTRL | Qt::SHIFT | Qt::Key_T );
     }
 }
 
 
 void YQPkgSelector::createPkgClassificationFilterView()
 {
-    _pkgClassificationFilterView = new YQPkgClassificationFilterView( this );
-    CHECK_NEW( _pkgClassificationFilterView );
+    _filters->addPage( _( "Package Classi&fication" ), [ this ]()
+        {
+            _pkgClassificationFilterView = new YQPkgClassificationFilterView( this );
+            CHECK_NEW( _pkgClassificationFilterView );
 
-    _filters->addPage( _( "Package Classi&fication" ), _pkgClassificationFilterView,
-                       "package_classification", Qt::CTRL | Qt::SHIFT | Qt::Key_F );
+            connectFilter( _pkgClassificationFilterView, _pkgList, false );
+
+            return _pkgClassificationFilterView;
+        },
+        "package_classification", Qt::CTRL | Qt::SHIFT | Qt::Key_F );
 }
 
 
 void YQPkgSelector::createLanguagesFilterView()
 {
-    _langList = new YQPkgLangList( this );
-    CHECK_NEW( _langList );
-    _langList->setSizePolicy( QSizePolicy( QSizePolicy::Ignored, QSizePolicy::Ignored ) ); // hor/vert
+    _filters->addPage( _( "&Languages" ), [ this ]()
+        {
+            _langList = new YQPkgLangList( this );
+            CHECK_NEW( _langList );
+            _langList->setSizePolicy( QSizePolicy( QSizePolicy::Ignored, QSizePolicy::Ignored ) ); // hor/vert
+
+            connectFilter( _langList, _pkgList );
+
+            connect( _langList, SIGNAL( statusChanged()           ),
+                     this,      SLOT  ( autoResolveDependencies() ) );
+
+            return _langList;
+        },
+        "languages", Qt::CTRL | Qt::SHIFT | Qt::Key_L );
+}
+
+
+void YQPkgSelector::createRequiredByFilterView()
+{
+    _filters->addPage( _( "Re&quired By" ), [ this ]()
+        {
+            _requiredByFilterView = new YQPkgRequiredByFilterView( this );
+            CHECK_NEW( _requiredByFilterView );
 
-    _filters->addPage( _( "&Languages" ), _langList,
-                       "languages", Qt::CTRL | Qt::SHIFT | Qt::Key_L );
+            connectFilter( _requiredByFilterView, _pkgList, false );
+
+            return _requiredByFilterView;
+        },
+        "required_by" );
 }
 
 
 void YQPkgSelector::createStatusFilterView()
 {
-    _statusFilterView = new YQPkgStatusFilterView( this );
-    CHECK_NEW( _statusFilterView );
+    _filters->addPage( _( "Installation Su&mmary" ), [ this ]()
+        {
+            _statusFilterView = new YQPkgStatusFilterView( this );
+            CHECK_NEW( _statusFilterView );
+
+            connectFilter( _statusFilterView, _pkgList, false );
 
-    _filters->addPage( _( "Installation Su&mmary" ), _statusFilterView,
-                       "inst_summary", Qt::CTRL | Qt::SHIFT | Qt::Key_M );
+            return _statusFilterView;
+        },
+        "inst_summary", Qt::CTRL | Qt::SHIFT | Qt::Key_M );
 }
 
 
@@ -549,6 +664,19 @@ YQPkgSelector::layoutDetailsViews( QWidget * parent )
              pkgDependenciesView, SLOT  ( showDetailsIfVisible( ZyppSel ) ) );
 
 
+    //
+    // Required By (reverse dependencies)
+    //
+
+    YQPkgRequiredByView * pkgRequiredByView = new YQPkgRequiredByView( detailsViews );
+    CHECK_NEW( pkgRequiredByView );
+
+    detailsViews->addTab( pkgRequiredByView, _( "Required By" ) );
+
+    connect( _pkgList,          SIGNAL( currentItemChanged  ( ZyppSel ) ),
+             pkgRequiredByView, SLOT  ( showDetailsIfVisible( ZyppSel ) ) );
+
+
 
     //
     // Versions
@@ -611,6 +739,24 @@ YQPkgSelector::layoutButtons( QWidget *parent )
 
     button_box->setLayout( layout );
     layout->setContentsMargins( 2, 2, 2, 2 ); // left / right / top / bottom
+
+    // Non-modal status of the background repo refresh
+
+    _repoRefreshLabel = new QLabel( button_box );
+    CHECK_NEW( _repoRefreshLabel );
+    layout->addWidget( _repoRefreshLabel );
+    _repoRefreshLabel->hide();
+
+    // Indicator for a coalesced solver run that is about to happen
+
+    _resolvePendingLabel = new QLabel( _( "Dependency check pending..." ), button_box );
+    CHECK_NEW( _resolvePendingLabel );
+    layout->addWidget( _resolvePendingLabel );
+    _resolvePendingLabel->hide();
+
+    connect( this,                 SIGNAL( resolvePendingChanged( bool ) ),
+             _resolvePendingLabel, SLOT  ( setVisible           ( bool ) ) );
+
     layout->addStretch();
 
     QPushButton * cancel_button = new QPushButton( _( "&Cancel" ), button_box );
@@ -836,6 +982,7 @@ YQPkgSelector::addMenus()
     extrasMenu->addAction( _( "Show &Products"         ), this, SLOT( showProducts()    ) );
     extrasMenu->addAction( _( "Show Package &Changes"  ), this, SLOT( showAutoPkgList() ) );
     extrasMenu->addAction( _( "Show &History"          ), this, SLOT( showHistory()     ) );
+    extrasMenu->addAction( _( "Show &Solver Statistics" ), this, SLOT( showSolverStats() ) );
 
     extrasMenu->addSeparator();
 
@@ -912,6 +1059,9 @@ YQPkgSelector::connectFilter( QWidget * filter,
     connect( filter,    SIGNAL( filterStart()   ),
              this,      SLOT  ( busyCursor()            ) );
 
+    connect( filter,    SIGNAL( filterStart()   ),
+             this,      SLOT  ( recordFilterStart()     ) );
+
     connect( filter,    SIGNAL( filterMatch( ZyppSel, ZyppPkg ) ),
              pkgList,   SLOT  ( addPkgItem ( ZyppSel, ZyppPkg ) ) );
 
@@ -927,6 +1077,18 @@ YQPkgSelector::connectFilter( QWidget * filter,
     connect( filter,    SIGNAL( filterFinished()       ),
              this,      SLOT  ( normalCursor() ) );
 
+    connect( filter,    SIGNAL( filterFinished()       ),
+             this,      SLOT  ( recordFilterEnd() ) );
+
+    // Filters like the package classification or the installation summary
+    // depend on the solver results, so a scheduled solver run has to happen
+    // before they can be trusted. Not while the filter is still filling the
+    // package list, though: The solver might open the conflict dialog.
+
+    connect( filter,    SIGNAL( filterFinished()                ),
+             this,      SLOT  ( flushPendingResolveAfterFilter() ),
+             Qt::QueuedConnection );
+
 
     if ( hasUpdateSignal && _filters->diskUsageList() )
     {
@@ -945,42 +1107,8 @@ YQPkgSelector::connectFilter( QWidget * filter,
 void
 YQPkgSelector::makeConnections()
 {
-    connectFilter( _searchFilterView,            _pkgList, false );
-    connectFilter( _updatesFilterView,           _pkgList, false );
-    connectFilter( _repoFilterView,              _pkgList, false );
-    connectFilter( _serviceFilterView,           _pkgList, false );
-    connectFilter( _patternList,                 _pkgList );
-    connectFilter( _pkgClassificationFilterView, _pkgList, false );
-    connectFilter( _langList,                    _pkgList );
-    connectFilter( _statusFilterView,            _pkgList, false );
-
-    connectPatchFilterView();
-    connectPatternList();
-
-    if ( _searchFilterView && _pkgList )
-    {
-        connect( _searchFilterView,     SIGNAL( message( const QString & ) ),
-                 _pkgList,              SLOT  ( message( const QString & ) ) );
-    }
-
-    if ( _repoFilterView && _pkgList )
-    {
-        connect( _repoFilterView,       SIGNAL( filterNearMatch  ( ZyppSel, ZyppPkg ) ),
-                 _pkgList,              SLOT  ( addPkgItemDimmed ( ZyppSel, ZyppPkg ) ) );
-    }
-
-    if ( _serviceFilterView && _pkgList )
-    {
-        connect( _serviceFilterView,    SIGNAL( filterNearMatch  ( ZyppSel, ZyppPkg ) ),
-                 _pkgList,              SLOT  ( addPkgItemDimmed ( ZyppSel, ZyppPkg ) ) );
-    }
-
-
-    if ( _langList )
-    {
-        connect( _langList, SIGNAL( statusChanged()           ),
-                 this,      SLOT  ( autoResolveDependencies() ) );
-    }
+    // The filter views are connected when they are created on demand
+    // (see createFilterViews()).
 
     if ( _pkgList && _filters->diskUsageList() )
     {
@@ -989,19 +1117,11 @@ YQPkgSelector::makeConnections()
     }
 
 
-
-    // Hide and show the upgrade label when tabs change, or when the user
-    // selects repositories
+    // Hide and show the upgrade label when tabs change
 
     connect( _filters, SIGNAL( currentChanged( QWidget * ) ),
              this,     SLOT  ( updateSwitchRepoLabels()    ) );
 
-    if ( _repoFilterView )
-    {
-        connect( _repoFilterView, SIGNAL( filterStart()           ),
-                 this,            SLOT  ( updateSwitchRepoLabels() ) );
-    }
-
 
     //
     // Connect package conflict dialog
@@ -1015,12 +1135,6 @@ YQPkgSelector::makeConnections()
                      _pkgList,                  SLOT  ( updateItemStates() ) );
         }
 
-        if ( _patternList )
-        {
-            connect( _pkgConflictDialog,        SIGNAL( updatePackages()   ),
-                     _patternList,              SLOT  ( updateItemStates() ) );
-        }
-
         if ( _filters->diskUsageList() )
         {
             connect( _pkgConflictDialog,        SIGNAL( updatePackages()   ),
@@ -1066,6 +1180,46 @@ YQPkgSelector::makeConnections()
         connect( _patchMenu,                    SIGNAL( aboutToShow()   ),
                  _patchFilterView->patchList(), SLOT  ( updateActions() ) );
     }
+
+
+    //
+    // Background repo refresh
+    //
+
+    MyrlynRepoManager * repoMan = MyrlynApp::instance()->repoManager();
+
+    connect( repoMan, SIGNAL( backgroundRefreshStarted ( int ) ),
+             this,    SLOT  ( backgroundRefreshStarted ( int ) ) );
+
+    connect( repoMan, SIGNAL( backgroundRefreshProgress( int, int ) ),
+             this,    SLOT  ( backgroundRefreshProgress( int, int ) ) );
+
+    connect( repoMan, SIGNAL( backgroundRefreshFinished( int, int ) ),
+             this,    SLOT  ( backgroundRefreshFinished( int, int ) ) );
+
+    connect( repoMan, SIGNAL( aboutToReloadRepos() ),
+             this,    SLOT  ( aboutToReloadRepos() ) );
+
+    connect( repoMan, SIGNAL( reposReloaded() ),
+             this,    SLOT  ( reposReloaded() ) );
+}
+
+
+bool
+YQPkgSelector::autoCheckDependencies() const
+{
+    return _autoDependenciesAction && _autoDependenciesAction->isChecked();
+}
+
+
+void
+YQPkgSelector::setAutoCheckDependencies( bool autoCheck )
+{
+    if ( _autoDependenciesAction )
+        _autoDependenciesAction->setChecked( autoCheck );
+
+    if ( ! autoCheck )
+        cancelPendingResolve();
 }
 
 
@@ -1075,7 +1229,9 @@ YQPkgSelector::autoResolveDependencies()
     if ( _autoDependenciesAction && ! _autoDependenciesAction->isChecked() )
         return;
 
-    resolveDependencies();
+    // Coalesce bursts of status changes into one solver run
+
+    scheduleResolveDependencies();
 }
 
 
@@ -1088,6 +1244,8 @@ YQPkgSelector::manualResolvePackageDependencies()
         return QDialog::Accepted;
     }
 
+    cancelPendingResolve(); // This is a full solver run anyway
+
     busyCursor();
     int result = _pkgConflictDialog->solveAndShowConflicts();
     normalCursor();
@@ -1109,15 +1267,15 @@ YQPkgSelector::manualResolvePackageDependencies()
 void
 YQPkgSelector::hotkeyAddPatchFilterView()
 {
-    if ( ! _patchFilterView )
+    if ( ! _filters->findPage( "patches" ) )
     {
         logInfo() << "Activating patches filter view" << endl;
 
         createPatchFilterView( true ); // force
-        connectPatchFilterView();
+        updatePageLabels();
     }
 
-    _filters->showPage( _patchFilterView );
+    _filters->showPage( "patches" ); // This creates the view
 }
 
 
@@ -1219,6 +1377,14 @@ YQPkgSelector::configRepos()
             return;
     }
 
+    // The repo configuration may download keys and metadata with the
+    // libzypp MediaManager and KeyRing; the background refresh must not use
+    // them at the same time.
+
+    busyCursor();
+    MyrlynApp::instance()->repoManager()->waitForBackgroundRefresh( true ); // reload
+    normalCursor();
+
     RepoConfigDialog dialog;
     dialog.exec();
 }
@@ -1227,22 +1393,22 @@ YQPkgSelector::configRepos()
 void
 YQPkgSelector::updatePageLabels()
 {
-    updatePageLabel( _( "Patc&hes" ), _patchFilterView,   YQPkgPatchList::countNeededPatches()   );
-    updatePageLabel( _( "&Updates" ), _updatesFilterView, YQPkgUpdatesFilterView::countUpdates() );
+    updatePageLabel( _( "Patc&hes" ), "patches", YQPkgPatchList::countNeededPatches()   );
+    updatePageLabel( _( "&Updates" ), "updates", YQPkgUpdatesFilterView::countUpdates() );
 }
 
 
 void
-YQPkgSelector::updatePageLabel( const QString & rawLabel, QWidget * page, int count )
+YQPkgSelector::updatePageLabel( const QString & rawLabel, const QString & pageId, int count )
 {
-    if ( page && _filters )
+    if ( _filters && _filters->findPage( pageId ) )
     {
         QString label = rawLabel;
 
         if ( count > 0 )
             label += QString( " (%1)" ).arg( count );
 
-        _filters->setPageLabel( page, label );
+        _filters->setPageLabel( pageId, label );
     }
 }
 
@@ -1273,9 +1439,10 @@ YQPkgSelector::globalUpdatePkg( bool force )
     (void) _pkgList->globalSetPkgStatus( S_Update, force,
                                          false ); // countOnly
 
+    _filters->showPage( "inst_summary" ); // This creates the view if needed
+
     if ( _statusFilterView )
     {
-        _filters->showPage( _statusFilterView );
         _statusFilterView->writeSettings();
         _statusFilterView->clear();
         _statusFilterView->showTransactions();
@@ -1409,6 +1576,13 @@ YQPkgSelector::showHistory()
 }
 
 
+void
+YQPkgSelector::showSolverStats()
+{
+    YQPkgSolverStatsDialog::showSolverStatsDialog( this );
+}
+
+
 void
 YQPkgSelector::installDevelPkgs()
 {
@@ -1436,10 +1610,8 @@ YQPkgSelector::installRecommendedPkgs()
     zypp::getZYpp()->resolver()->setIgnoreAlreadyRecommended( false );
     resolveDependencies();
 
-    if ( _filters && _statusFilterView )
-    {
-        _filters->showPage( _statusFilterView );
-    }
+    if ( _filters )
+        _filters->showPage( "inst_summary" );
 
     YQPkgChangesDialog::showChangesDialog( this,
                                            _( "Added Subpackages:" ),
@@ -1588,10 +1760,8 @@ YQPkgSelector::installSubPkgs( const QString & suffix )
     }
 
 
-    if ( _filters && _statusFilterView )
-    {
-        _filters->showPage( _statusFilterView );
-    }
+    if ( _filters )
+        _filters->showPage( "inst_summary" );
 
     YQPkgChangesDialog::showChangesDialog( this,
                                            _( "Added Subpackages:" ),
@@ -1731,6 +1901,152 @@ YQPkgSelector::writeResolverSettings()
 }
 
 
+void YQPkgSelector::backgroundRefreshStarted( int repoCount )
+{
+    backgroundRefreshProgress( 0, repoCount );
+}
+
+
+void YQPkgSelector::backgroundRefreshProgress( int doneCount, int totalCount )
+{
+    if ( ! _repoRefreshLabel )
+        return;
+
+    _repoRefreshLabel->setText( _( "Refreshing repositories in the background: %1 / %2" )
+                                .arg( doneCount ).arg( totalCount ) );
+    _repoRefreshLabel->show();
+}
+
+
+void YQPkgSelector::backgroundRefreshFinished( int changedCount, int failedCount )
+{
+    if ( ! _repoRefreshLabel )
+        return;
+
+    QString text = changedCount > 0 ?
+        _( "Loading new repository data..." ) :
+        _( "Repositories are up to date." );
+
+    if ( failedCount > 0 )
+    {
+        text += " ";
+        text += _( "%1 repository could not be refreshed.",
+                   "%1 repositories could not be refreshed.",
+                   failedCount ).arg( failedCount );
+    }
+
+    _repoRefreshLabel->setText( text );
+    _repoRefreshLabel->show();
+
+    if ( changedCount == 0 )
+        QTimer::singleShot( 5000, _repoRefreshLabel, SLOT( hide() ) );
+}
+
+
+void YQPkgSelector::aboutToReloadRepos()
+{
+    busyCursor();
+
+    // The solver runs again for the reloaded pool in reposReloaded()
+
+    cancelPendingResolve();
+
+    // The items of the package list refer to pool items that are about to go away
+
+    if ( _pkgList )
+        _pkgList->clear();
+}
+
+
+void YQPkgSelector::reposReloaded()
+{
+    // Like reset(), but keeping the user's selections. The details views
+    // already forgot their package when the package list was cleared in
+    // aboutToReloadRepos().
+
+    recreatePoolFilterViews();
+
+    if ( _filters )
+        _filters->reloadCurrentPage();
+
+    if ( _filters && _filters->diskUsageList() )
+        _filters->diskUsageList()->invalidateTransaction();
+
+    updatePageLabels();
+    emit resetNotify();
+
+    autoResolveDependencies();
+    normalCursor();
+
+    if ( _repoRefreshLabel )
+    {
+        _repoRefreshLabel->setText( _( "Repository data updated." ) );
+        _repoRefreshLabel->show();
+        QTimer::singleShot( 5000, _repoRefreshLabel, SLOT( hide() ) );
+    }
+}
+
+
+void YQPkgSelector::recreatePoolFilterViews()
+{
+    if ( ! _filters )
+        return;
+
+    // Recreating the page content of the current page sets the pointer again
+
+    _repoFilterView    = 0;
+    _serviceFilterView = 0;
+    _patternList       = 0;
+    _patchFilterView   = 0;
+    _langList          = 0;
+
+    for ( const QString & id: QStringList( { "repos", "services", "patterns", "patches", "languages" } ) )
+        _filters->recreatePageContent( id );
+}
+
+
+void YQPkgSelector::recordFilterStart()
+{
+    _filterStartUsec = FlightRecorder::usecNow();
+
+    FlightRecorder::instance()->record( "filter-start",
+                                        sender() ? sender()->metaObject()->className() : 0 );
+}
+
+
+void YQPkgSelector::recordFilterEnd()
+{
+    qint64 duration = _filterStartUsec > 0 ? FlightRecorder::usecNow() - _filterStartUsec : 0;
+
+    FlightRecorder::instance()->record( "filter-end",
+                                        sender() ? sender()->metaObject()->className() : 0,
+                                        _pkgList ? _pkgList->topLevelItemCount() : 0,
+                                        duration );
+    _filterStartUsec = 0;
+}
+
+
+void YQPkgSelector::flushPendingResolveAfterFilter()
+{
+    if ( ! resolvePending() )
+        return;
+
+    QObject * filter = sender();
+
+    if ( flushPendingResolve() != QDialog::Accepted || ! filter )
+        return;
+
+    // The filter matched the packages before the solver run; let it match
+    // them again with the new package states. The solver run is done now,
+    // so this doesn't get here again.
+
+    logDebug() << "Filtering again after the solver run: "
+               << filter->metaObject()->className() << endl;
+
+    QMetaObject::invokeMethod( filter, "filter" );
+}
+
+
 void YQPkgSelector::busyCursor()
 {
     ::busyCursor();
@@ -41,6 +41,7 @@ class YQPkgClassificationFilterView;
 class YQPkgPatchFilterView;
 class YQPkgPatternList;
 class YQPkgRepoFilterView;
+class YQPkgRequiredByFilterView;
 class YQPkgSearchFilterView;
 class YQPkgServiceFilterView;
 class YQPkgStatusFilterView;
@@ -79,6 +80,23 @@ public:
      **/
     YQPkgList * pkgList() const { return _pkgList; }
 
+    /**
+     * Return the filter tab with the filter view pages.
+     **/
+    YQPkgFilterTab * filters() const { return _filters; }
+
+    /**
+     * Return 'true' if the dependencies are checked automatically after
+     * status changes ("Autocheck" in the "Dependencies" menu).
+     **/
+    bool autoCheckDependencies() const;
+
+    /**
+     * Switch checking the dependencies automatically on or off. Switching it
+     * off also drops a solver run that is already scheduled.
+     **/
+    void setAutoCheckDependencies( bool autoCheck );
+
 
 public slots:
 
@@ -102,6 +120,9 @@ public slots:
     /**
      * Automatically resolve package dependencies if desired
      * (if the "auto check" checkbox is on).
+     *
+     * This only schedules a solver run so a burst of status changes results
+     * in only one solver run; see scheduleResolveDependencies().
      **/
     void autoResolveDependencies();
 
@@ -228,11 +249,48 @@ protected slots:
      **/
     void showHistory();
 
+    /**
+     * Show the statistics of all solver runs
+     **/
+    void showSolverStats();
+
     /**
      * a link in the repo upgrade label was clicked
      **/
     void switchToRepo( const QString & url );
 
+    /**
+     * Show the status of the background repo refresh in the button box.
+     **/
+    void backgroundRefreshStarted ( int repoCount );
+    void backgroundRefreshProgress( int doneCount, int totalCount );
+    void backgroundRefreshFinished( int changedCount, int failedCount );
+
+    /**
+     * The repo manager is about to replace the pool content of refreshed
+     * repos: Drop all list items that refer to it.
+     **/
+    void aboutToReloadRepos();
+
+    /**
+     * The repo manager reloaded refreshed repos: Fill the views again and
+     * run the resolver for the restored user selections.
+     **/
+    void reposReloaded();
+
+    /**
+     * Record the start and the end of a filter run with the number of
+     * packages and the duration in the flight recorder.
+     **/
+    void recordFilterStart();
+    void recordFilterEnd();
+
+    /**
+     * Run a solver run that is still pending after a filter has filled the
+     * package list, then let that filter (the sender) run again.
+     **/
+    void flushPendingResolveAfterFilter();
+
     /**
      * Show the busy cursor (clock)
      */
@@ -286,7 +344,9 @@ protected:
     void        layoutMenuBar      ( QWidget * parent );
 
 
-    // Create the various filter views
+    // Register the various filter views with the filter tab. Each one is
+    // only created and connected when its page is shown for the first time,
+    // so the corresponding member variable remains 0 until then.
 
     void createSearchFilterView();
     void createPatchFilterView( bool force = false );
@@ -296,8 +356,16 @@ protected:
     void createPatternsFilterView();
     void createPkgClassificationFilterView();
     void createLanguagesFilterView();
+    void createRequiredByFilterView();
     void createStatusFilterView();
 
+    /**
+     * Discard the filter views whose list items refer to repos, services,
+     * patterns, patches or languages of the pool, so they are created again
+     * with the current pool content.
+     **/
+    void recreatePoolFilterViews();
+
     /**
      * Update the tab labels of filter views that can have a numeric value with
      * that number: "Patches (4)", "Updates (17)"
@@ -309,7 +377,7 @@ protected:
      * if the number is < 1:  "Patches (4)", "Updates (17)".
      **/
     void updatePageLabel( const QString & rawLabel,
-                          QWidget *       page,
+                          const QString & pageId,
                           int             count );
 
     /**
@@ -406,12 +474,15 @@ protected:
     YQPkgPatternList *                  _patternList;
     YQPkgStatusFilterView *             _statusFilterView;
     YQPkgLangList *                     _langList;
+    YQPkgRequiredByFilterView *         _requiredByFilterView;
 
     // Other widgets
     YQPkgVersionsView *                 _pkgVersionsView;
     QWidget *                           _notificationsArea;
     QLabel *                            _switchToRepoLabel;
     QLabel *                            _cancelSwitchingToRepoLabel;
+    QLabel *                            _repoRefreshLabel;
+    QLabel *                            _resolvePendingLabel;
 
     // Menus
     QMenuBar *                          _menuBar;
@@ -430,6 +501,8 @@ protected:
     YQPkgObjList::ExcludeRule *         _excludeDevelPkgs;
     YQPkgObjList::ExcludeRule *         _excludeDebugInfoPkgs;
 
+    qint64                              _filterStartUsec;
+
     static YQPkgSelector *              _instance;
 };
 
@@ -39,9 +39,17 @@
 using std::string;
 
 
+// Quiet period after the last status change before the solver runs
+#define RESOLVE_DELAY_MILLISEC          250
+
+// Don't postpone the solver run any longer than this during a long burst
+#define RESOLVE_MAX_DELAY_MILLISEC      1000
+
+
 YQPkgSelectorBase::YQPkgSelectorBase( QWidget * parent )
     : QFrame( parent )
     , _blockResolver( true )
+    , _poolAccessSuspended( false )
 {
     _showChangesDialog          = false;
     _pkgConflictDialog          = 0;
@@ -58,6 +66,11 @@ YQPkgSelectorBase::YQPkgSelectorBase( QWidget * parent )
     zyppPool().saveState<zypp::Pattern>();
     zyppPool().saveState<zypp::Patch  >();
 
+    _resolveTimer.setSingleShot( true );
+
+    connect( &_resolveTimer, SIGNAL( timeout()               ),
+             this,           SLOT  ( resolveDependencies()   ) );
+
     _blockResolver = false;
     logInfo() << "PackageSelectorBase init done" << endl;
 }
@@ -80,6 +93,14 @@ void YQPkgSelectorBase::resetResolver()
 
 int YQPkgSelectorBase::resolveDependencies()
 {
+    if ( _poolAccessSuspended )
+    {
+        logWarning() << "Pool access suspended; keeping the solver run pending" << endl;
+        return QDialog::Rejected;
+    }
+
+    cancelPendingResolve();
+
     if ( _blockResolver )
         return QDialog::Rejected;
 
@@ -102,6 +123,83 @@ int YQPkgSelectorBase::resolveDependencies()
 }
 
 
+void YQPkgSelectorBase::scheduleResolveDependencies()
+{
+    if ( _blockResolver )
+        return;
+
+    if ( ! _resolvePendingSince.isValid() )
+    {
+        _resolvePendingSince.start();
+        emit resolvePendingChanged( true );
+    }
+
+    // Restart the timer with every new status change, but never beyond the
+    // maximum delay since the first one of this burst
+
+    if ( _poolAccessSuspended )
+        return; // resumePoolAccess() will start the timer
+
+    qint64 remaining = RESOLVE_MAX_DELAY_MILLISEC - _resolvePendingSince.elapsed();
+    _resolveTimer.start( (int) qBound( (qint64) 0, remaining, (qint64) RESOLVE_DELAY_MILLISEC ) );
+}
+
+
+int YQPkgSelectorBase::flushPendingResolve()
+{
+    if ( ! resolvePending() )
+        return QDialog::Accepted;
+
+    logDebug() << "Flushing pending solver run" << endl;
+
+    return resolveDependencies();
+}
+
+
+void YQPkgSelectorBase::cancelPendingResolve()
+{
+    _resolveTimer.stop();
+
+    if ( _resolvePendingSince.isValid() )
+    {
+        _resolvePendingSince.invalidate();
+        emit resolvePendingChanged( false );
+    }
+}
+
+
+void YQPkgSelectorBase::suspendPoolAccess()
+{
+    if ( _poolAccessSuspended )
+        return;
+
+    logDebug() << "Suspending pool access" << endl;
+
+    _poolAccessSuspended = true;
+    _resolveTimer.stop(); // resolvePending() remains true
+
+    if ( _diskUsageList )
+        _diskUsageList->suspendUpdates();
+}
+
+
+void YQPkgSelectorBase::resumePoolAccess()
+{
+    if ( ! _poolAccessSuspended )
+        return;
+
+    logDebug() << "Resuming pool access" << endl;
+
+    _poolAccessSuspended = false;
+
+    if ( resolvePending() )
+        _resolveTimer.start( RESOLVE_DELAY_MILLISEC );
+
+    if ( _diskUsageList )
+        _diskUsageList->resumeUpdates();
+}
+
+
 int YQPkgSelectorBase::verifySystem()
 {
     if ( ! _pkgConflictDialog )
@@ -133,6 +231,12 @@ int YQPkgSelectorBase::checkDiskUsage()
         return QDialog::Accepted;
     }
 
+    // The disk usage updates are delayed: Don't check old numbers that are
+    // missing the last changes, e.g. the solver's auto-installs. This also
+    // stops the pending update timer.
+
+    _diskUsageList->updateDiskUsageNow();
+
     if ( ! _diskUsageList->overflowWarning.inRange() )
         return QDialog::Accepted;
 
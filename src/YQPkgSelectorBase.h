@@ -18,7 +18,9 @@
 #ifndef YQPkgSelectorBase_h
 #define YQPkgSelectorBase_h
 
+#include <QElapsedTimer>
 #include <QFrame>
+#include <QTimer>
 
 #include "YQZypp.h"
 
@@ -72,6 +74,40 @@ public slots:
      **/
     int resolveDependencies();
 
+    /**
+     * Resolve dependencies soon, but not right away: Status changes that
+     * come in a quick burst (the user clicking many packages in a row) are
+     * coalesced into one single solver run after a short quiet period.
+     *
+     * Anything that needs a resolved pool has to call
+     * flushPendingResolve() first.
+     **/
+    void scheduleResolveDependencies();
+
+    /**
+     * Run a scheduled solver run right now if there is one.
+     *
+     * Returns the result of resolveDependencies() or QDialog::Accepted if
+     * nothing was pending.
+     **/
+    int flushPendingResolve();
+
+    /**
+     * Stop everything that reads the pool from the event loop on its own:
+     * Scheduled solver runs and the disk usage recalculation. A solver run
+     * that is scheduled in the meantime only stays pending.
+     *
+     * Use this while something else changes the pool, e.g. while the
+     * package commit is running in another thread.
+     **/
+    void suspendPoolAccess();
+
+    /**
+     * Undo suspendPoolAccess() and catch up with anything that was
+     * postponed.
+     **/
+    void resumePoolAccess();
+
     /**
      * Verifies dependencies of the currently installed system.
      *
@@ -122,6 +158,13 @@ public slots:
      **/
     void notImplemented();
 
+public:
+
+    /**
+     * Return 'true' if a solver run is scheduled, but did not happen yet.
+     **/
+    bool resolvePending() const { return _resolvePendingSince.isValid(); }
+
 
 signals:
 
@@ -136,6 +179,12 @@ signals:
      **/
     void resolvingFinished();
 
+    /**
+     * Emitted when a coalesced solver run is scheduled ('true') and when it
+     * is done or cancelled ('false').
+     **/
+    void resolvePendingChanged( bool pending );
+
     /**
      * Emitted when the user accepted and solved all pending dependency
      * problems: Commit the package transactions.
@@ -195,13 +244,22 @@ protected:
      **/
     virtual void closeEvent( QCloseEvent * event ) override;
 
+    /**
+     * Stop the timer of a scheduled solver run because a solver run is
+     * about to happen anyway.
+     **/
+    void cancelPendingResolve();
+
 
     // Data members
 
     bool                  _blockResolver;
+    bool                  _poolAccessSuspended;
     bool                  _showChangesDialog;
     YQPkgConflictDialog * _pkgConflictDialog;
     YQPkgDiskUsageList *  _diskUsageList;
+    QTimer                _resolveTimer;
+    QElapsedTimer         _resolvePendingSince;
 };
 
 
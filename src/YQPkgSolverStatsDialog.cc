@@ -0,0 +1,212 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#include <QHBoxLayout>
+#include <QHeaderView>
+#include <QLabel>
+#include <QPushButton>
+#include <QTreeWidget>
+#include <QVBoxLayout>
+
+#include "Exception.h"
+#include "MainWindow.h"
+#include "SolverStats.h"
+#include "YQi18n.h"
+#include "utf8.h"
+#include "YQPkgSolverStatsDialog.h"
+
+
+#define SPACING    4  // between subwidgets
+#define MARGIN    10  // around the widget
+
+
+// Columns of the runs tree
+
+enum SolverStatsColumn
+{
+    TimeCol = 0,
+    KindCol,
+    DurationCol,
+    ProblemsCol,
+    UserChangesCol,
+    SolverChangesCol,
+    DownloadSizeCol,
+    InstalledSizeCol
+};
+
+
+YQPkgSolverStatsDialog * YQPkgSolverStatsDialog::_instance = 0;
+
+
+YQPkgSolverStatsDialog::YQPkgSolverStatsDialog( QWidget * parent )
+    : QDialog( parent ? parent : MainWindow::instance() )
+{
+    setWindowTitle( _( "Solver Statistics" ) );
+
+    setSizeGripEnabled( true );
+    setMinimumSize( 800, 400 );
+    setAttribute( Qt::WA_DeleteOnClose );
+
+    QVBoxLayout * layout = new QVBoxLayout();
+    Q_CHECK_PTR( layout );
+    setLayout( layout );
+    layout->setSpacing( SPACING );
+    layout->setContentsMargins( MARGIN, MARGIN, MARGIN, MARGIN );
+
+    _summary = new QLabel( this );
+    Q_CHECK_PTR( _summary );
+    layout->addWidget( _summary );
+
+
+    // List of solver runs, the newest first
+
+    _runsTree = new QTreeWidget( this );
+    Q_CHECK_PTR( _runsTree );
+    layout->addWidget( _runsTree );
+
+    _runsTree->setHeaderLabels( QStringList()
+                                << _( "Time"              )
+                                << _( "Kind"              )
+                                << _( "Duration"          )
+                                << _( "Problems"          )
+                                << _( "By User"           )
+                                << _( "By Solver"         )
+                                << _( "Download Size"     )
+                                << _( "Installed Size +/-" ) );
+    _runsTree->setRootIsDecorated( false );
+    _runsTree->setAllColumnsShowFocus( true );
+    _runsTree->header()->setSectionResizeMode( QHeaderView::ResizeToContents );
+
+    for ( const SolverRun & run: SolverStats::instance()->runs() )
+        addRun( run );
+
+    updateSummary();
+
+    connect( SolverStats::instance(), SIGNAL( runAdded()   ),
+             this,                    SLOT  ( addLastRun() ) );
+
+    // Going through the whole pool after each solver run is only worthwhile
+    // while somebody is watching
+
+    SolverStats::instance()->setCollectTransactions( true );
+
+
+    // Button box (to center the single button)
+
+    QHBoxLayout * hbox = new QHBoxLayout();
+    Q_CHECK_PTR( hbox );
+    hbox->setSpacing( SPACING );
+    hbox->setContentsMargins( MARGIN, MARGIN, MARGIN, MARGIN );
+    layout->addLayout( hbox );
+    hbox->addStretch();
+
+    QPushButton * button = new QPushButton( _( "&Close" ), this );
+    Q_CHECK_PTR( button );
+    hbox->addWidget( button );
+    button->setDefault( true );
+
+    connect( button,    SIGNAL( clicked() ),
+             this,      SLOT  ( accept()  ) );
+
+    hbox->addStretch();
+}
+
+
+YQPkgSolverStatsDialog::~YQPkgSolverStatsDialog()
+{
+    SolverStats::instance()->setCollectTransactions( false );
+
+    if ( _instance == this )
+        _instance = 0;
+}
+
+
+void
+YQPkgSolverStatsDialog::showSolverStatsDialog( QWidget * parent )
+{
+    if ( ! _instance )
+    {
+        _instance = new YQPkgSolverStatsDialog( parent );
+        CHECK_NEW( _instance );
+    }
+
+    _instance->show();
+    _instance->raise();
+    _instance->activateWindow();
+}
+
+
+void
+YQPkgSolverStatsDialog::addLastRun()
+{
+    if ( ! SolverStats::instance()->runs().isEmpty() )
+        addRun( SolverStats::instance()->runs().last() );
+
+    updateSummary();
+}
+
+
+void
+YQPkgSolverStatsDialog::addRun( const SolverRun & run )
+{
+    QStringList columns;
+
+    columns << run.time.toString( "hh:mm:ss" )
+            << SolverStats::kindName( run.kind )
+            << _( "%1 ms" ).arg( run.durationUsec / 1000.0, 0, 'f', 1 )
+            << QString::number( run.problemCount );
+
+    if ( run.transactionKnown )
+    {
+        columns << QString::number( run.userChanges )
+                << QString::number( run.solverChanges )
+                << fromUTF8( run.downloadSize.asString() )
+                << fromUTF8( run.installedSizeDelta.asString() );
+    }
+    // else: Not collected while this dialog was closed; leave those empty
+
+    QTreeWidgetItem * item = new QTreeWidgetItem( columns );
+    CHECK_NEW( item );
+
+    for ( int col = DurationCol; col <= InstalledSizeCol; ++col )
+        item->setTextAlignment( col, Qt::AlignRight | Qt::AlignVCenter );
+
+    if ( ! run.success )
+        item->setForeground( ProblemsCol, Qt::red );
+
+    _runsTree->insertTopLevelItem( 0, item );
+
+    // Keep the list in sync with the runs that SolverStats keeps
+
+    while ( _runsTree->topLevelItemCount() > SOLVER_STATS_MAX_RUNS )
+        delete _runsTree->takeTopLevelItem( _runsTree->topLevelItemCount() - 1 );
+}
+
+
+void
+YQPkgSolverStatsDialog::updateSummary()
+{
+    SolverStats * stats = SolverStats::instance();
+    int count = stats->totalCount();
+
+    _summary->setText( _( "%1 solver runs, total %2 ms, average %3 ms, slowest %4 ms" )
+                       .arg( count )
+                       .arg( stats->totalDurationUsec() / 1000.0, 0, 'f', 1 )
+                       .arg( count > 0 ? stats->totalDurationUsec() / 1000.0 / count : 0.0, 0, 'f', 1 )
+                       .arg( stats->maxDurationUsec() / 1000.0, 0, 'f', 1 ) );
+}
@@ -0,0 +1,88 @@
+/*  ---------------------------------------------------------
+               __  __            _
+              |  \/  |_   _ _ __| |_   _ _ __
+              | |\/| | | | | '__| | | | | '_ \
+              | |  | | |_| | |  | | |_| | | | |
+              |_|  |_|\__, |_|  |_|\__, |_| |_|
+                      |___/        |___/
+    ---------------------------------------------------------
+
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) Stefan Hundhammer <Stefan.Hundhammer@gmx.de>
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+
+#ifndef YQPkgSolverStatsDialog_h
+#define YQPkgSolverStatsDialog_h
+
+#include <QDialog>
+
+
+class QLabel;
+class QTreeWidget;
+struct SolverRun;
+
+
+/**
+ * Non-modal dialog with the statistics of all solver runs: Kind, duration,
+ * number of problems, number of packages changed by the user and by the
+ * solver, transaction size. New solver runs are added while it is open.
+ **/
+class YQPkgSolverStatsDialog : public QDialog
+{
+    Q_OBJECT
+
+public:
+
+    /**
+     * Static convenience method: Show the dialog or, if it is already open,
+     * raise it.
+     **/
+    static void showSolverStatsDialog( QWidget * parent = 0 );
+
+    /**
+     * Destructor.
+     **/
+    virtual ~YQPkgSolverStatsDialog();
+
+
+protected slots:
+
+    /**
+     * Add the newest solver run from SolverStats to the list.
+     **/
+    void addLastRun();
+
+
+protected:
+
+    /**
+     * Constructor. Use showSolverStatsDialog() instead.
+     **/
+    YQPkgSolverStatsDialog( QWidget * parent );
+
+    /**
+     * Add one solver run to the list.
+     **/
+    void addRun( const SolverRun & run );
+
+    /**
+     * Update the summary line above the list.
+     **/
+    void updateSummary();
+
+
+    // Data members
+
+    QLabel *      _summary;
+    QTreeWidget * _runsTree;
+
+    static YQPkgSolverStatsDialog * _instance;
+};
+
+
+#endif // ifndef YQPkgSolverStatsDialog_h
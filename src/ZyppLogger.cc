@@ -39,25 +39,16 @@ ZyppLogger::~ZyppLogger()
 {
     logInfo() << "Uninstalling the zypp logger" << endl;
 
-    // Avoid error "QMutex: destroying locked mutex" in the (main) log:
-    // The zypp thread might still be writing log messages.
-    // Give it some time to complete that.
-
-    bool locked = _mutex.tryLock( 1000 ); // millisec
-
     zypp::base::LogControl::instance().setLineFormater( 0 );
     zypp::base::LogControl::instance().setLineWriter  ( 0 );
 
-    if ( locked )
-        _mutex.unlock();
+    // The destructor of _zyppThreadLogger writes the remaining lines
 }
 
 
 void ZyppLogger::logLine( const std::string & message )
 {
-    QMutexLocker locker( &_mutex );
-
-    _zyppThreadLogger.logStream() << message << endl;
+    _zyppThreadLogger.logRaw( message );
 }
 
 
@@ -21,7 +21,6 @@
 
 #include <memory>
 #include <string>
-#include <QMutex>
 
 #include <zypp-core/base/Logger.h>
 #include <zypp-core/base/LogControl.h>
@@ -74,7 +73,9 @@ public:
     ~ZyppLogger();
 
     /**
-     * Write a single line to the zypp log file, protected by a mutex.
+     * Write a single line to the zypp log file. This is safe to call from any
+     * thread without waiting for other threads: The logger's background
+     * thread does the actual writing.
      **/
     void logLine( const std::string & message );
 
@@ -84,7 +85,6 @@ private:
     zypp::shared_ptr<ZyppLogLineWriter>    _lineWriter;
     zypp::shared_ptr<ZyppLogLineFormatter> _lineFormatter;
 
-    QMutex _mutex;
     Logger _zyppThreadLogger;
 };
 
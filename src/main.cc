@@ -18,10 +18,17 @@
 #include <iostream>	// cerr
 
 #include <QApplication>
+#include <QDir>
 #include <QObject>
+#include <QSettings>
 
+#include "Benchmark.h"
+#include "Exception.h"
+#include "FlightRecorder.h"
 #include "Logger.h"
 #include "MyrlynApp.h"
+#include "MyrlynRepoManager.h"
+#include "StartupProfile.h"
 
 
 using std::cerr;
@@ -43,7 +50,12 @@ void usage()
 	 << "  -r | --read-only (default for non-root users)\n"
 	 << "  -n | --dry-run\n"
 	 << "  -d | --download-only\n"
+	 << "  --download-in-advance\n"
+	 << "  --download-in-heaps\n"
+	 << "  --download-as-needed\n"
          << "  -f | --no-repo-refresh\n"
+	 << "  --background-refresh\n"
+	 << "  --root <dir>  (use the repos and the target below <dir>)\n"
 	 << "  -h | --help \n"
 	 << "\n"
 	 << "Debugging options:\n"
@@ -52,6 +64,9 @@ void usage()
 	 << "  --fake-commit\n"
 	 << "  --fake-summary\n"
          << "  --slow-repo-refresh\n"
+	 << "  --startup-profile\n"
+	 << "  --benchmark <scenario>\n"
+	 << "    (scenarios: " << qPrintable( Benchmark::scenarios().join( ", " ) ) << ")\n"
 	 << "\n"
 	 << std::endl;
 
@@ -86,6 +101,35 @@ bool commandLineOption( const QString & longName,
 }
 
 
+/**
+ * Extract a command line option with a parameter ("--benchmark all") from the
+ * command line and remove both from 'argList'. Return the parameter or an
+ * empty string if there is no such option.
+ **/
+QString commandLineArg( const QString & longName,
+                        QStringList   & argList )
+{
+    int index = argList.indexOf( longName );
+
+    if ( index < 0 )
+        return QString();
+
+    if ( index + 1 >= argList.size() )
+    {
+        logError() << "FATAL: Missing parameter for " << longName << endl;
+        usage();
+    }
+
+    QString value = argList.at( index + 1 );
+    argList.removeAt( index + 1 );
+    argList.removeAt( index );
+
+    logDebug() << "Found " << longName << " " << value << endl;
+
+    return value;
+}
+
+
 MyrlynAppOptions
 parseCommandLineOptions( QStringList & argList )
 {
@@ -95,12 +139,48 @@ parseCommandLineOptions( QStringList & argList )
     if ( commandLineOption( "--dry-run",            "-n", argList ) ) optFlags |= OptDryRun;
     if ( commandLineOption( "--download-only",      "-d", argList ) ) optFlags |= OptDownloadOnly;
     if ( commandLineOption( "--no-repo-refresh",    "-f", argList ) ) optFlags |= OptNoRepoRefresh;
+    if ( commandLineOption( "--background-refresh", "" ,  argList ) ) optFlags |= OptBackgroundRepoRefresh;
+    if ( commandLineOption( "--download-in-advance", "", argList ) ) optFlags |= OptDownloadInAdvance;
+    if ( commandLineOption( "--download-in-heaps",  "" ,  argList ) ) optFlags |= OptDownloadInHeaps;
+    if ( commandLineOption( "--download-as-needed", "" ,  argList ) ) optFlags |= OptDownloadAsNeeded;
     if ( commandLineOption( "--fake-root",          "" ,  argList ) ) optFlags |= OptFakeRoot;
     if ( commandLineOption( "--fake-commit",        "" ,  argList ) ) optFlags |= OptFakeCommit;
     if ( commandLineOption( "--fake-summary",       "" ,  argList ) ) optFlags |= OptFakeSummary;
     if ( commandLineOption( "--slow-repo-refresh",  "" ,  argList ) ) optFlags |= OptSlowRepoRefresh;
+    if ( commandLineOption( "--startup-profile",    "" ,  argList ) ) optFlags |= OptStartupProfile;
     if ( commandLineOption( "--help",               "-h", argList ) ) usage(); // this will exit
 
+    QString rootDir = commandLineArg( "--root", argList );
+
+    if ( ! rootDir.isEmpty() )
+    {
+        QDir dir( rootDir );
+
+        if ( ! dir.exists() )
+        {
+            logError() << "FATAL: Root directory " << rootDir << " does not exist" << endl;
+            usage();
+        }
+
+        MyrlynRepoManager::setRootDir( dir.absolutePath() );
+    }
+
+    QString benchmarkScenario = commandLineArg( "--benchmark", argList );
+
+    if ( ! benchmarkScenario.isEmpty() )
+    {
+        if ( ! Benchmark::scenarios().contains( benchmarkScenario ) )
+        {
+            logError() << "FATAL: Unknown benchmark scenario " << benchmarkScenario << endl;
+            usage();
+        }
+
+        // Never change anything on the system, and always use the same repos
+
+        Benchmark::setScenario( benchmarkScenario );
+        optFlags |= OptBenchmark | OptReadOnly | OptNoRepoRefresh;
+    }
+
     if ( ! argList.isEmpty() )
     {
         logError() << "FATAL: Bad command line args: " << argList.join( " " ) << endl;
@@ -122,10 +202,38 @@ void logVersion()
 }
 
 
+void readLoggerSettings()
+{
+    // The log file is already open at this point, so this only affects the
+    // rotation at runtime, not the one at program start.
+
+    QSettings settings;
+    settings.beginGroup( "Logger" );
+
+    qint64 maxLogFileSizeMB = settings.value( "maxLogFileSizeMB", 50  ).toLongLong();
+    qint64 logDirBudgetMB   = settings.value( "logDirBudgetMB",   200 ).toLongLong();
+
+    Logger::setMaxLogFileSize( maxLogFileSizeMB * 1024 * 1024 );
+    Logger::setLogDirBudget  ( logDirBudgetMB   * 1024 * 1024 );
+
+    // Write them back so they can be found and edited in the config file,
+    // but only if they are not there yet: Don't rewrite it on every start.
+
+    if ( ! settings.contains( "maxLogFileSizeMB" ) )
+        settings.setValue( "maxLogFileSizeMB", maxLogFileSizeMB );
+
+    if ( ! settings.contains( "logDirBudgetMB" ) )
+        settings.setValue( "logDirBudgetMB", logDirBudgetMB );
+
+    settings.endGroup();
+}
+
+
 int main( int argc, char *argv[] )
 {
     Logger logger( "/tmp/myrlyn-$USER", "myrlyn.log" );
     logVersion();
+    FlightRecorder::instance()->install( Logger::lastLogDir() );
 
     // Set org/app name for QSettings
     QCoreApplication::setOrganizationName( "openSUSE" ); // ~/.cache/openSUSE
@@ -141,14 +249,45 @@ int main( int argc, char *argv[] )
     argList.removeFirst(); // Remove the program name
     MyrlynAppOptions optFlags = parseCommandLineOptions( argList );
 
+    if ( optFlags & OptStartupProfile )
+        StartupProfile::instance()->setEnabled();
+
+    if ( optFlags & OptBenchmark )
+    {
+        // Start with the default settings and don't clobber the user's
+        // settings, so the benchmark results are comparable
+
+        QCoreApplication::setApplicationName( "Myrlyn-benchmark" );
+        QSettings().clear();
+    }
+
+    readLoggerSettings();
+
+    int exitCode = 0;
+
+    try
     {
         // New scope to minimize the life time of this instance
 
         MyrlynApp app( optFlags );
-        app.run();
+        exitCode = app.run();
+    }
+    catch ( const Exception & exception )
+    {
+        logError() << "Uncaught exception: " << exception.what() << endl;
+        FlightRecorder::instance()->dump( "Exception in main()" );
+        exitCode = 1;
+    }
+    catch ( const std::exception & exception )
+    {
+        // This includes zypp::Exception
+
+        logError() << "Uncaught exception: " << exception.what() << endl;
+        FlightRecorder::instance()->dump( "Exception in main()" );
+        exitCode = 1;
     }
 
     logDebug() << "MyrlynApp finished." << endl;
 
-    return 0;
+    return exitCode;
 }
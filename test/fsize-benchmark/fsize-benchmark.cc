@@ -0,0 +1,243 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <random>       // std::mt19937
+#include <vector>
+
+#include <QApplication>
+#include <QElapsedTimer>
+#include <QPixmap>
+
+#include <boost/multiprecision/cpp_int.hpp>
+
+#include "../../src/Logger.h"
+#include "../../src/Exception.h"
+#include "../../src/FSize.h"
+#include "../../src/QY2DiskUsageList.h"
+
+
+// Time the FSize operations that the disk usage list does for every
+// partition whenever a package status changes: free size, used percent,
+// the free MiB checks for the warnings and the formatted size texts.
+// The same arithmetic is timed once more with plain cpp_int values like the
+// old FSize implementation did it. Then time a real QY2DiskUsageList with
+// synthetic partitions through updateData() and painting.
+//
+// Usage:
+//
+//   fsize-benchmark -platform offscreen [partitions] [rounds]
+
+
+using boost::multiprecision::cpp_int;
+
+
+struct Partition
+{
+    long long used;
+    long long total;
+};
+
+
+class BenchmarkDiskUsageItem: public QY2DiskUsageListItem
+{
+public:
+
+    BenchmarkDiskUsageItem( QY2DiskUsageList * parent,
+                            const QString &    name,
+                            const Partition &  partition )
+        : QY2DiskUsageListItem( parent )
+        , _name( name )
+        , _used( partition.used )
+        , _total( partition.total )
+        {}
+
+    virtual FSize   usedSize()  const override { return _used;  }
+    virtual FSize   totalSize() const override { return _total; }
+    virtual QString name()      const override { return _name;  }
+
+    void setUsedSize( const FSize & used ) { _used = used; }
+
+protected:
+
+    QString _name;
+    FSize   _used;
+    FSize   _total;
+};
+
+
+static std::vector<Partition> createPartitions( int count )
+{
+    std::mt19937 random( 42 );
+    std::vector<Partition> partitions;
+
+    for ( int i=0; i < count; ++i )
+    {
+        // 1 GiB .. 16 TiB, 10% .. 99% used
+
+        long long total = ( 1LL << 30 ) + (long long) ( random() % ( 1ULL << 44 ) );
+        long long used  = total / 100 * ( 10 + random() % 90 );
+
+        partitions.push_back( { used, total } );
+    }
+
+    return partitions;
+}
+
+
+/**
+ * Do the FSize work of YQPkgDiskUsageListItem::updateDuData() and
+ * checkRemainingDiskSpace() plus the formatting of init() for all
+ * partitions 'rounds' times. Return the elapsed time in microseconds.
+ **/
+static qint64 benchmarkFSize( const std::vector<Partition> & partitions,
+                              int                            rounds,
+                              long long &                    checkSum )
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    for ( int round=0; round < rounds; ++round )
+    {
+        for ( const Partition & partition: partitions )
+        {
+            FSize used ( partition.used + round * 4096LL );
+            FSize total( partition.total );
+            FSize free = total - used;
+
+            int percent = total != 0 ? int( ( 100 * used ) / total ) : 0;
+            FSize freeMB = free / FSize( 1, FSize::Unit::M );
+
+            if ( freeMB < FSize( 700 ) )
+                ++checkSum;
+
+            checkSum += percent;
+            checkSum += free.form( 0, 1, true ).size();
+        }
+    }
+
+    return timer.nsecsElapsed() / 1000;
+}
+
+
+/**
+ * The arithmetic part of benchmarkFSize() with plain cpp_int values, i.e. what
+ * every FSize operation used to cost. Return the elapsed time in microseconds.
+ **/
+static qint64 benchmarkCppInt( const std::vector<Partition> & partitions,
+                               int                            rounds,
+                               long long &                    checkSum )
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    for ( int round=0; round < rounds; ++round )
+    {
+        for ( const Partition & partition: partitions )
+        {
+            cpp_int used ( partition.used + round * 4096LL );
+            cpp_int total( partition.total );
+            cpp_int free = total - used;
+
+            int percent = total != 0 ? int( ( 100 * used ) / total ) : 0;
+            cpp_int freeMB = free / ( 1024 * 1024 );
+
+            if ( freeMB < 700 )
+                ++checkSum;
+
+            checkSum += percent;
+        }
+    }
+
+    return timer.nsecsElapsed() / 1000;
+}
+
+
+/**
+ * Update and paint a QY2DiskUsageList with all partitions 'rounds' times.
+ * Return the elapsed time in microseconds.
+ **/
+static qint64 benchmarkList( const std::vector<Partition> & partitions,
+                             int                            rounds )
+{
+    QY2DiskUsageList list( 0 );
+    std::vector<BenchmarkDiskUsageItem *> items;
+
+    for ( size_t i=0; i < partitions.size(); ++i )
+    {
+        BenchmarkDiskUsageItem * item =
+            new BenchmarkDiskUsageItem( &list, QString( "/mnt/part%1" ).arg( i ), partitions[ i ] );
+        CHECK_NEW( item );
+
+        item->updateData();
+        items.push_back( item );
+    }
+
+    list.resize( 600, 400 );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for ( int round=0; round < rounds; ++round )
+    {
+        for ( size_t i=0; i < items.size(); ++i )
+        {
+            items[ i ]->setUsedSize( FSize( partitions[ i ].used + round * 4096LL ) );
+            items[ i ]->updateData();
+        }
+
+        QPixmap pixmap = list.grab(); // paints all visible items
+        Q_UNUSED( pixmap );
+    }
+
+    return timer.nsecsElapsed() / 1000;
+}
+
+
+static void logResult( const QString & name, qint64 elapsed, long long ops )
+{
+    logInfo() << name << ": "
+              << elapsed / 1000.0 << " millisec ("
+              << ( ops > 0 ? 1000.0 * elapsed / (double) ops : 0.0 )
+              << " nanosec per partition)" << endl;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Logger logger( "/tmp/myrlyn-$USER", "fsize-benchmark.log" );
+    QApplication app( argc, argv ); // Removes the Qt options from argv
+
+    int partitionCount = app.arguments().size() > 1 ?
+        app.arguments().at( 1 ).toInt() : 20;
+
+    int rounds = app.arguments().size() > 2 ?
+        app.arguments().at( 2 ).toInt() : 10000;
+
+    std::vector<Partition> partitions = createPartitions( partitionCount );
+    long long ops = (long long) partitionCount * rounds;
+    long long checkSum = 0;
+
+    logInfo() << partitionCount << " partitions, " << rounds << " rounds" << endl;
+
+    logResult( "FSize arithmetic and formatting",
+               benchmarkFSize ( partitions, rounds, checkSum ), ops );
+    logResult( "cpp_int arithmetic only",
+               benchmarkCppInt( partitions, rounds, checkSum ), ops );
+
+    // Painting is so much more expensive that fewer rounds will do
+
+    int listRounds = qMax( 1, rounds / 100 );
+    logResult( QString( "QY2DiskUsageList update and paint (%1 rounds)" ).arg( listRounds ),
+               benchmarkList( partitions, listRounds ),
+               (long long) partitionCount * listRounds );
+
+    logDebug() << "Check sum: " << checkSum << endl;
+
+    return 0;
+}
@@ -0,0 +1,201 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QPersistentModelIndex>
+#include <QString>
+
+#include <zypp/HistoryLogData.h>
+
+#include "../../src/Logger.h"
+#include "../../src/Exception.h"
+#include "../../src/YQPkgHistoryModel.h"
+
+
+// Check that persistent indexes of YQPkgHistoryModel still refer to the same
+// dates and actions after newer actions were prepended, both on new dates and
+// on the newest date that is already in the model, and after older actions
+// were appended. This is what happens while the package history dialog is
+// open and the history file is read backwards or tailed.
+
+
+static int errorCount = 0;
+static qint64 nextOffset = 0;
+
+
+/**
+ * Return 'count' actions on day 'day', newest first, with file offsets that
+ * are unique in this test.
+ **/
+static PkgHistoryActionList actionsOfDay( int day, int count )
+{
+    PkgHistoryActionList actions;
+    QDate date = QDate( 2020, 1, 1 ).addDays( day );
+
+    for ( int i = count - 1; i >= 0; --i )
+    {
+        PkgHistoryAction action;
+        action.time     = QDateTime( date, QTime( 12, 0 ).addSecs( i ) ).toSecsSinceEpoch();
+        action.date     = date;
+        action.offset   = nextOffset++;
+        action.actionId = zypp::HistoryActionID::INSTALL_e;
+        action.name     = QString( "pkg-%1-%2" ).arg( day ).arg( i );
+        action.detail   = QString( "1.%1-%2" ).arg( day ).arg( i );
+
+        actions << action;
+    }
+
+    return actions;
+}
+
+
+/**
+ * Check that persistent index 'index' is still an action index with file
+ * offset 'offset' on 'date'.
+ **/
+static void checkAction( const QString &               label,
+                         const YQPkgHistoryModel &     model,
+                         const QPersistentModelIndex & index,
+                         const QDate &                 date,
+                         qint64                        offset )
+{
+    const PkgHistoryAction * action = model.action( index );
+
+    if ( ! action )
+    {
+        logError() << label << ": no action for the persistent index" << endl;
+        ++errorCount;
+        return;
+    }
+
+    if ( action->offset != offset || action->date != date )
+    {
+        logError() << label << ": action " << action->name
+                   << " at " << action->offset << " instead of offset " << offset << endl;
+        ++errorCount;
+    }
+
+    int dateRow = model.dateRow( date );
+
+    if ( index.parent().row() != dateRow || model.dateRow( QModelIndex( index ) ) != dateRow )
+    {
+        logError() << label << ": parent row " << index.parent().row()
+                   << " instead of " << dateRow << endl;
+        ++errorCount;
+    }
+
+    if ( model.actionIndex( date, offset ) != QModelIndex( index ) )
+    {
+        logError() << label << ": actionIndex() doesn't match the persistent index" << endl;
+        ++errorCount;
+    }
+
+    if ( model.data( index ).toString() != action->name )
+    {
+        logError() << label << ": wrong display text " << model.data( index ).toString() << endl;
+        ++errorCount;
+    }
+}
+
+
+/**
+ * Check that parent() and index() agree for all action rows.
+ **/
+static void checkParents( const QString & label, const YQPkgHistoryModel & model )
+{
+    for ( int row = 0; row < model.rowCount(); ++row )
+    {
+        QModelIndex dateIndex = model.index( row, 0 );
+
+        for ( int i = 0; i < model.rowCount( dateIndex ); ++i )
+        {
+            if ( model.parent( model.index( i, 1, dateIndex ) ) != dateIndex )
+            {
+                logError() << label << ": wrong parent for action " << i
+                           << " of date row " << row << endl;
+                ++errorCount;
+                return;
+            }
+        }
+    }
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Logger logger( "/tmp/myrlyn-$USER", "history-model-test.log" );
+    QCoreApplication app( argc, argv );
+
+    YQPkgHistoryModel model;
+
+    // Days 10 and 9 as the reader delivers them: newest first
+
+    model.appendActions( actionsOfDay( 10, 3 ) + actionsOfDay( 9, 4 ) );
+
+    QDate       day9      = QDate( 2020, 1, 1 ).addDays( 9 );
+    QDate       day10     = QDate( 2020, 1, 1 ).addDays( 10 );
+    QModelIndex day9Index = model.index( model.dateRow( day9 ), 0 );
+
+    QPersistentModelIndex oldAction  ( model.index( 2, 0, day9Index ) );
+    QPersistentModelIndex newestDate ( model.index( 0, 0 ) );
+    QPersistentModelIndex day10Action( model.index( 1, 0, newestDate ) );
+
+    qint64 oldOffset   = model.action( oldAction   )->offset;
+    qint64 day10Offset = model.action( day10Action )->offset;
+
+    checkAction( "initial", model, oldAction,   day9,  oldOffset   );
+    checkAction( "initial", model, day10Action, day10, day10Offset );
+
+
+    // Newer actions: two more on day 10 and two new days before it
+
+    model.prependActions( actionsOfDay( 12, 2 ) + actionsOfDay( 11, 5 ) + actionsOfDay( 10, 2 ) );
+
+    checkAction( "prepended", model, oldAction,   day9,  oldOffset   );
+    checkAction( "prepended", model, day10Action, day10, day10Offset );
+
+    if ( newestDate.row() != model.dateRow( day10 ) || newestDate.parent().isValid() )
+    {
+        logError() << "prepended: date row " << newestDate.row()
+                   << " instead of " << model.dateRow( day10 ) << endl;
+        ++errorCount;
+    }
+
+    if ( day10Action.row() != 3 )
+    {
+        logError() << "prepended: day 10 action in row " << day10Action.row()
+                   << " instead of 3" << endl;
+        ++errorCount;
+    }
+
+    checkParents( "prepended", model );
+
+
+    // Older actions: more on day 9 and one more day
+
+    model.appendActions( actionsOfDay( 9, 2 ) + actionsOfDay( 8, 3 ) );
+
+    checkAction( "appended", model, oldAction,   day9,  oldOffset   );
+    checkAction( "appended", model, day10Action, day10, day10Offset );
+    checkParents( "appended", model );
+
+    if ( model.actionCount() != 3 + 4 + 2 + 5 + 2 + 2 + 3 )
+    {
+        logError() << "Wrong action count " << model.actionCount() << endl;
+        ++errorCount;
+    }
+
+    if ( errorCount > 0 )
+        logError() << errorCount << " errors" << endl;
+    else
+        logInfo() << "All persistent indexes OK" << endl;
+
+    return errorCount > 0 ? 1 : 0;
+}
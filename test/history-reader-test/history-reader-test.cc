@@ -0,0 +1,231 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <QCoreApplication>
+#include <QDateTime>
+#include <QFile>
+#include <QString>
+#include <QTemporaryDir>
+
+#include <zypp/HistoryLogData.h>
+
+#include "../../src/Logger.h"
+#include "../../src/Exception.h"
+#include "../../src/PkgHistoryReader.h"
+
+
+// Check that PkgHistoryReader delivers the same actions with the same file
+// offsets when it reads a synthetic history file backwards as when the file
+// is written forward, with block boundaries anywhere in the lines, and that
+// tailing after more lines were appended picks up exactly the new complete
+// lines.
+//
+// Usage:
+//
+//   history-reader-test [days]
+
+
+static int errorCount = 0;
+
+
+struct ExpectedAction
+{
+    qint64  offset;
+    QString name;
+    int     actionId;
+};
+
+
+/**
+ * Append the lines of one day to 'file' and the actions to show to
+ * 'expected' (chronological).
+ **/
+static void writeDay( QFile & file, int day, QList<ExpectedAction> & expected )
+{
+    QDateTime time = QDateTime( QDate( 2020, 1, 1 ).addDays( day ), QTime( 12, 0 ) );
+
+    for ( int i=0; i < 1 + day % 7; ++i )
+    {
+        QString date = time.addSecs( i ).toString( "yyyy-MM-dd hh:mm:ss" );
+        QString name = QString( "pkg-%1" ).arg( ( day * 7 + i ) % 500 );
+        QString line;
+        int     actionId = -1;
+
+        switch ( i % 4 )
+        {
+            case 0:
+                line = QString( "%1|install|%2|1.%3-%4.1|x86_64|root@host|repo-oss|0123456789abcdef|" )
+                    .arg( date ).arg( name ).arg( day ).arg( i );
+                actionId = zypp::HistoryActionID::INSTALL_e;
+                break;
+
+            case 1:
+                line = QString( "%1|command|root@host|'zypper' 'in' '%2'|" ).arg( date ).arg( name );
+                break;
+
+            case 2:
+                line = QString( "%1|remove |%2|2:1.%3-%4.1|x86_64|root@host|" )
+                    .arg( date ).arg( name ).arg( day ).arg( i );
+                actionId = zypp::HistoryActionID::REMOVE_e;
+                break;
+
+            case 3:
+                line = QString( "# A comment for %1" ).arg( date );
+                break;
+        }
+
+        if ( actionId >= 0 )
+            expected << ExpectedAction { file.pos(), name, actionId };
+
+        file.write( line.toUtf8() + '\n' );
+    }
+}
+
+
+/**
+ * Run 'reader' until it is finished and return all its actions.
+ **/
+static PkgHistoryActionList readAll( PkgHistoryReader & reader )
+{
+    PkgHistoryActionList actions;
+
+    reader.start();
+
+    while ( ! reader.wait( 10 ) ) // millisec
+        actions += reader.takeActions();
+
+    actions += reader.takeActions();
+
+    return actions;
+}
+
+
+/**
+ * Compare 'actions' (newest first) with the first 'count' actions of
+ * 'expected' (chronological) after 'skip' ones.
+ **/
+static void checkActions( const QString &               label,
+                          const PkgHistoryActionList &  actions,
+                          const QList<ExpectedAction> & expected,
+                          int                           skip,
+                          int                           count )
+{
+    if ( actions.size() != count )
+    {
+        logError() << label << ": " << actions.size() << " actions instead of " << count << endl;
+        ++errorCount;
+        return;
+    }
+
+    for ( int i=0; i < count; ++i )
+    {
+        const PkgHistoryAction & action = actions.at( i );
+        const ExpectedAction &   exp    = expected.at( skip + count - 1 - i );
+
+        if ( action.offset != exp.offset || action.name != exp.name || action.actionId != exp.actionId )
+        {
+            logError() << label << ": action #" << i << ": "
+                       << action.name << " at " << action.offset
+                       << " instead of "
+                       << exp.name << " at " << exp.offset << endl;
+            ++errorCount;
+            return;
+        }
+
+        if ( i > 0 && action.time > actions.at( i - 1 ).time )
+        {
+            logError() << label << ": action #" << i << " is newer than the one before" << endl;
+            ++errorCount;
+            return;
+        }
+    }
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Logger logger( "/tmp/myrlyn-$USER", "history-reader-test.log" );
+    QCoreApplication app( argc, argv );
+
+    int days = app.arguments().size() > 1 ?
+        app.arguments().at( 1 ).toInt() : 3000;
+
+    QTemporaryDir tmpDir;
+    QString filename = tmpDir.filePath( "history" );
+    QFile   file( filename );
+
+    if ( ! file.open( QIODevice::WriteOnly ) )
+    {
+        logError() << "Can't create " << filename << endl;
+        return 1;
+    }
+
+    QList<ExpectedAction> expected;
+    file.write( "# zypp history file\n" );
+
+    for ( int day=0; day < days; ++day )
+        writeDay( file, day, expected );
+
+    // A last line that is still being written, early on the next day
+
+    QString nextDay = QDateTime( QDate( 2020, 1, 1 ).addDays( days ), QTime( 6, 0 ) )
+        .toString( "yyyy-MM-dd hh:mm:ss" );
+
+    qint64 completeSize = file.pos();
+    file.write( QString( "%1|install|incompl" ).arg( nextDay ).toUtf8() );
+    file.flush();
+
+    int oldCount = expected.size();
+    logInfo() << "Wrote " << completeSize << " bytes with " << oldCount << " actions" << endl;
+
+
+    // Read the whole file backwards
+
+    PkgHistoryReader reader( filename );
+    checkActions( "backwards", readAll( reader ), expected, 0, oldCount );
+
+    if ( reader.endOffset() != completeSize )
+    {
+        logError() << "End offset " << reader.endOffset() << " instead of " << completeSize << endl;
+        ++errorCount;
+    }
+
+
+    // Complete the last line, add some more days, and read only the new lines
+
+    file.write( "|1.0-1.1|x86_64|root@host|repo-oss||\n" );
+    expected << ExpectedAction { completeSize, "incompl", zypp::HistoryActionID::INSTALL_e };
+
+    for ( int day=days; day < days + 10; ++day )
+        writeDay( file, day, expected );
+
+    file.flush();
+
+    PkgHistoryReader tailReader( filename, reader.endOffset() );
+    checkActions( "tail", readAll( tailReader ), expected, oldCount, expected.size() - oldCount );
+
+    if ( tailReader.endOffset() != file.pos() )
+    {
+        logError() << "Tail end offset " << tailReader.endOffset() << " instead of " << file.pos() << endl;
+        ++errorCount;
+    }
+
+    if ( reader.invalidLines() + tailReader.invalidLines() > 0 )
+    {
+        logError() << reader.invalidLines() + tailReader.invalidLines() << " invalid lines" << endl;
+        ++errorCount;
+    }
+
+    if ( errorCount > 0 )
+        logError() << errorCount << " errors" << endl;
+    else
+        logInfo() << "All " << expected.size() << " actions OK" << endl;
+
+    return errorCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,119 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QString>
+
+#include "../../src/Logger.h"
+
+
+// Measure what a log statement below the current log level costs, compared
+// with an empty loop and with a log statement that is actually written.
+//
+// The disabled statements use arguments that would be expensive to evaluate;
+// they count how often they are called, which has to be never.
+//
+// Usage:
+//
+//   log-benchmark [iterations]
+
+
+static int evalCount = 0;
+
+// Keep the compiler from optimizing the loops away
+static volatile int sink = 0;
+
+
+static QString expensiveArg( int i )
+{
+    ++evalCount;
+
+    return QString( "pkg-%1-%2" ).arg( i ).arg( QString( 100, 'x' ) );
+}
+
+
+static double nsecPerIteration( qint64 nsec, int iterations )
+{
+    return iterations > 0 ? nsec / (double) iterations : 0.0;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Logger logger( "/tmp/myrlyn-$USER", "log-benchmark.log" );
+    QCoreApplication app( argc, argv );
+
+    int iterations = app.arguments().size() > 1 ?
+        app.arguments().at( 1 ).toInt() : 10000000;
+
+    logger.setLogLevel( LogSeverityInfo );
+    QElapsedTimer timer;
+
+
+    // Baseline: Just the loop
+
+    timer.start();
+
+    for ( int i=0; i < iterations; ++i )
+        sink = sink + i;
+
+    qint64 baseline = timer.nsecsElapsed();
+
+
+    // Disabled log statements
+
+    timer.start();
+
+    for ( int i=0; i < iterations; ++i )
+    {
+        sink = sink + i;
+        logVerbose() << "Checking " << expensiveArg( i ) << ": " << i << endl;
+    }
+
+    qint64 disabled = timer.nsecsElapsed();
+
+
+    // Enabled log statements. Much fewer: This fills the log file.
+
+    int enabledIterations = qMin( iterations, 100000 );
+    timer.start();
+
+    for ( int i=0; i < enabledIterations; ++i )
+    {
+        sink = sink + i;
+        logInfo() << "Checking pkg-" << i << endl;
+    }
+
+    qint64 enabled = timer.nsecsElapsed();
+    logger.flush();
+    qint64 enabledFlushed = timer.nsecsElapsed();
+
+    logger.setLogLevel( LogSeverityVerbose );
+
+    logInfo() << "Empty loop:        "
+              << nsecPerIteration( baseline, iterations ) << " nsec per iteration" << endl;
+
+    logInfo() << "Disabled logging:  "
+              << nsecPerIteration( disabled, iterations ) << " nsec per iteration" << endl;
+
+    logInfo() << "Enabled logging:   "
+              << nsecPerIteration( enabled, enabledIterations ) << " nsec per iteration; "
+              << nsecPerIteration( enabledFlushed, enabledIterations )
+              << " nsec including writing the log file" << endl;
+
+    if ( evalCount > 0 )
+    {
+        logError() << "Disabled log statements evaluated their arguments "
+                   << evalCount << " times" << endl;
+        return 1;
+    }
+
+    return 0;
+}
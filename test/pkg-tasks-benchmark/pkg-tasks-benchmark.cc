@@ -0,0 +1,162 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <algorithm>    // std::shuffle()
+#include <random>       // std::mt19937
+
+#include <QApplication>
+#include <QElapsedTimer>
+
+#include "../../src/Logger.h"
+#include "../../src/Exception.h"
+#include "../../src/PkgTasks.h"
+#include "../../src/PkgTaskListWidget.h"
+#include "../../src/PkgCommitTaskMover.h"
+
+
+// Replay a large package commit through the same PkgCommitTaskMover that
+// PkgCommitPage uses for the libzypp callbacks and for fakeCommit(), with the
+// same task lookups as the callbacks, just without the simulated delays and
+// without the icons and the progress display of the commit page, and report
+// the time it took.
+//
+// Usage:
+//
+//   pkg-tasks-benchmark -platform offscreen [task-count]
+
+
+static void createTasks( PkgTasks & pkgTasks, int taskCount )
+{
+    for ( int i=0; i < taskCount; ++i )
+    {
+        PkgTaskAction    action = ( i % 7 == 0 )  ? PkgRemove  : PkgUpdate;
+        PkgTaskRequester req    = ( i % 10 == 0 ) ? PkgReqUser : PkgReqDep;
+
+        PkgTask * task = new PkgTask( QString( "benchmark-pkg-%1" ).arg( i, 5, 10, QChar( '0' ) ),
+                                      action, req );
+        CHECK_NEW( task );
+
+        task->setCompletedPercent( 0 );
+        task->setInstalledSize( 1024 * 1024 );
+
+        if ( action & PkgAdd )
+        {
+            task->setDownloadSize( 256 * 1024 );
+            task->setDownloadedPercent( 0 );
+        }
+
+        pkgTasks.todo().insertTask( task );
+    }
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Logger logger( "/tmp/myrlyn-$USER", "pkg-tasks-benchmark.log" );
+    QApplication app( argc, argv ); // Removes the Qt options from argv
+
+    int taskCount = app.arguments().size() > 1 ?
+        app.arguments().at( 1 ).toInt() : 10000;
+
+    PkgTasks pkgTasks;
+    createTasks( pkgTasks, taskCount );
+
+    PkgTaskListWidget todoList( 0 );
+    PkgTaskListWidget downloadsList( 0 );
+    PkgTaskListWidget doingList( 0 );
+    PkgTaskListWidget doneList( 0 );
+
+    todoList.setSortByInsertionSequence( false );
+    todoList.setAutoScrollToLast( false );
+    todoList.addTaskItems( pkgTasks.todo() );
+
+    PkgCommitTaskMover taskMover( &pkgTasks,
+                                  &todoList,
+                                  &downloadsList,
+                                  &doingList,
+                                  &doneList );
+
+
+    // libzypp does not commit the packages in the order of the todo list,
+    // and the callbacks only know the ZyppRes, so look up every task by its
+    // sat ident in a random (but reproducible) order.
+
+    QList<zypp::IdString> commitOrder;
+
+    for ( const PkgTask * task: pkgTasks.todo() )
+        commitOrder << task->ident();
+
+    std::shuffle( commitOrder.begin(), commitOrder.end(), std::mt19937( 42 ) );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    for ( const zypp::IdString & ident: commitOrder )
+    {
+        // The same sequence as in PkgCommitPage::fakeCommit() with
+        // zypp::DownloadAsNeeded, with the lookups of the PkgCommitPage
+        // callback slots
+
+        PkgTask * task = pkgTasks.todo().find( ident );
+        CHECK_PTR( task );
+
+        PkgTaskAction action = task->action();
+
+        if ( action & PkgAdd )
+        {
+            // pkgDownloadStart()
+
+            taskMover.downloadStart( task, false );
+
+            // pkgDownloadEnd()
+
+            task = pkgTasks.downloads().find( ident );
+            CHECK_PTR( task );
+            CHECK_PTR( taskMover.downloadEnd( task ) );
+        }
+
+        // pkgActionStart()
+
+        task = 0;
+
+        if ( action & PkgAdd )
+            task = pkgTasks.downloads().find( ident );
+
+        if ( ! task ) // PkgRemove or no download needed
+            task = pkgTasks.todo().find( ident );
+
+        CHECK_PTR( task );
+        taskMover.actionStart( task );
+
+        // pkgActionEnd()
+
+        task = pkgTasks.doing().find( ident );
+        CHECK_PTR( task );
+        taskMover.actionEnd( task );
+    }
+
+    qint64 elapsed = timer.nsecsElapsed() / 1000; // microseconds
+
+    logInfo() << "Replayed " << taskCount << " tasks in "
+              << elapsed / 1000.0 << " millisec ("
+              << ( taskCount > 0 ? elapsed / (double) taskCount : 0.0 )
+              << " microsec per task)" << endl;
+
+    bool ok = pkgTasks.done().size() == taskCount &&
+        pkgTasks.todo().isEmpty()      &&
+        pkgTasks.downloads().isEmpty() &&
+        pkgTasks.doing().isEmpty()     &&
+        doneList.count() == taskCount  &&
+        todoList.count() == 0;
+
+    if ( ! ok )
+        logError() << "Task lists are inconsistent after the replay" << endl;
+
+    return ok ? 0 : 1;
+}
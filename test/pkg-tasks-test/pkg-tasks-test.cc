@@ -0,0 +1,192 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <random>       // std::mt19937
+
+#include <QString>
+
+#include "../../src/Logger.h"
+#include "../../src/Exception.h"
+#include "../../src/PkgTasks.h"
+
+
+// Check that the running download and installed size sums of the task lists
+// that PkgCommitPage uses for the total progress always agree with the sums
+// that are recalculated from all the tasks in a list, no matter in which
+// order tasks are moved between the lists and their percent values change.
+// Also check that moving tasks out of a list keeps the order of the others.
+
+
+static int errorCount = 0;
+
+
+static void checkSums( const PkgTaskList & list, int step )
+{
+    if ( list.runningDownloadSizeSum() != list.downloadSizeSum() )
+    {
+        logError() << "Step " << step << ": list " << list.name()
+                   << ": running download size sum "
+                   << (qint64) list.runningDownloadSizeSum()
+                   << " != recalculated "
+                   << (qint64) list.downloadSizeSum()
+                   << endl;
+        ++errorCount;
+    }
+
+    if ( list.runningInstalledSizeSum() != list.installedSizeSum() )
+    {
+        logError() << "Step " << step << ": list " << list.name()
+                   << ": running installed size sum "
+                   << (qint64) list.runningInstalledSizeSum()
+                   << " != recalculated "
+                   << (qint64) list.installedSizeSum()
+                   << endl;
+        ++errorCount;
+    }
+}
+
+
+static void checkOrder( const PkgTaskList & list, const QList<PkgTask *> & expected, int step )
+{
+    if ( list != expected )
+    {
+        logError() << "Step " << step << ": list " << list.name()
+                   << ": wrong task order" << endl;
+        ++errorCount;
+    }
+}
+
+
+static void checkAllSums( PkgTasks & pkgTasks, int step )
+{
+    checkSums( pkgTasks.todo(),      step );
+    checkSums( pkgTasks.downloads(), step );
+    checkSums( pkgTasks.doing(),     step );
+    checkSums( pkgTasks.done(),      step );
+    checkSums( pkgTasks.failed(),    step );
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Q_UNUSED( argc );
+    Q_UNUSED( argv );
+
+    Logger logger( "/tmp/myrlyn-$USER", "pkg-tasks-test.log" );
+
+    const int taskCount = 1000;
+
+    std::mt19937 random( 42 );
+    PkgTasks pkgTasks;
+
+    for ( int i=0; i < taskCount; ++i )
+    {
+        PkgTaskAction action = ( i % 5 == 0 ) ? PkgRemove : PkgInstall;
+        PkgTask * task = new PkgTask( QString( "test-pkg-%1" ).arg( i ), action, PkgReqDep );
+        CHECK_NEW( task );
+
+        // Odd sizes to provoke rounding differences between the running and
+        // the recalculated sums
+
+        task->setInstalledSize( 1000 + random() % 10000007 );
+        task->setCompletedPercent( 0 );
+
+        if ( action & PkgAdd )
+        {
+            task->setDownloadSize( 1000 + random() % 3000017 );
+            task->setDownloadedPercent( 0 );
+        }
+        else
+        {
+            task->setDownloadSize( 0.0 );
+        }
+
+        pkgTasks.todo().insertTask( task );
+    }
+
+    checkAllSums( pkgTasks, 0 );
+    int step = 0;
+
+    // What the todo and the done list should look like
+    QList<PkgTask *> todoOrder = pkgTasks.todo();
+    QList<PkgTask *> doneOrder;
+
+    while ( ! pkgTasks.todo().isEmpty() || ! pkgTasks.downloads().isEmpty() || ! pkgTasks.doing().isEmpty() )
+    {
+        ++step;
+
+        // Pick a random task from a random non-empty list and advance it like
+        // the libzypp commit callbacks would
+
+        PkgTaskList * lists[] = { &pkgTasks.todo(), &pkgTasks.downloads(), &pkgTasks.doing() };
+        PkgTaskList * list = lists[ random() % 3 ];
+
+        if ( list->isEmpty() )
+            continue;
+
+        PkgTask * task = list->at( random() % list->size() );
+        int percent    = random() % 101;
+
+        if ( list == &pkgTasks.todo() )
+        {
+            todoOrder.removeOne( task );
+
+            if ( task->action() & PkgAdd )
+            {
+                PkgTasks::moveTask( task, pkgTasks.todo(), pkgTasks.downloads() );
+                task->setDownloadedPercent( 0 );
+            }
+            else
+            {
+                PkgTasks::moveTask( task, pkgTasks.todo(), pkgTasks.doing() );
+                task->setCompletedPercent( 0 );
+            }
+        }
+        else if ( list == &pkgTasks.downloads() )
+        {
+            if ( percent > task->downloadedPercent() )
+                task->setDownloadedPercent( percent );
+            else if ( percent % 13 == 0 )
+                PkgTasks::moveTask( task, pkgTasks.downloads(), pkgTasks.failed() );
+            else
+                PkgTasks::moveTask( task, pkgTasks.downloads(), pkgTasks.doing() );
+        }
+        else // doing
+        {
+            if ( percent > task->completedPercent() )
+            {
+                task->setCompletedPercent( percent );
+            }
+            else
+            {
+                task->setCompletedPercent( 100 );
+                PkgTasks::moveTask( task, pkgTasks.doing(), pkgTasks.done() );
+                doneOrder << task;
+            }
+        }
+
+        checkAllSums( pkgTasks, step );
+        checkOrder( pkgTasks.todo(), todoOrder, step );
+        checkOrder( pkgTasks.done(), doneOrder, step );
+    }
+
+    // Clearing a list must also reset its running sums
+
+    pkgTasks.done().sort();
+    checkAllSums( pkgTasks, ++step );
+    pkgTasks.clearAll();
+    checkAllSums( pkgTasks, ++step );
+
+    if ( errorCount > 0 )
+        logError() << errorCount << " errors in " << step << " steps" << endl;
+    else
+        logInfo() << "All sums OK after " << step << " steps" << endl;
+
+    return errorCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,608 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <random>       // std::mt19937
+#include <iostream>     // cerr
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSet>
+#include <QTextStream>
+
+#include <zypp/RepoInfo.h>
+#include <zypp/RepoManager.h>
+#include <zypp/Url.h>
+#include <zypp/repo/RepoType.h>
+
+#include "../../src/Logger.h"
+#include "../../src/Exception.h"
+#include "../../src/utf8.h"
+
+
+// Generate local rpm-md repos with a synthetic pool of a configurable size
+// and shape below a root directory, register them in that root's
+// etc/zypp/repos.d and build their caches, so Myrlyn can load them with
+//
+//   myrlyn --root <root-dir> [--benchmark <scenario> -platform offscreen]
+//
+// without root permissions and without network access.
+//
+// The output only depends on the options (including the random seed), so it
+// can be regenerated on any machine for repeatable performance tests.
+//
+// Usage:
+//
+//   pool-generator [<options>] <root-dir>
+//
+// Options:
+//
+//   --packages <n>   number of different package names   (default 100000)
+//   --repos <n>      number of repos                     (default 4)
+//   --versions <n>   maximum versions per package        (default 3)
+//   --requires <n>   average requires per package        (default 6)
+//   --patterns <n>   number of patterns                  (default 200)
+//   --seed <n>       random seed                         (default 42)
+//   --no-cache       don't build the caches
+
+
+struct PoolShape
+{
+    int      pkgCount      = 100000;
+    int      repoCount     = 4;
+    int      maxVersions   = 3;
+    int      requiresCount = 6;
+    int      patterns      = 200;
+    unsigned seed          = 42;
+    bool     buildCache    = true;
+};
+
+
+// A fixed time stamp so the generated metadata don't change between runs
+#define TIME_STAMP      "1700000000"
+
+
+static std::mt19937 randomGen;
+
+
+static const char * wordList[] =
+{
+    "alpha",   "array",   "audio",    "backup",  "binary",  "block",   "buffer",
+    "cache",   "canvas",  "channel",  "cipher",  "client",  "cloud",   "codec",
+    "color",   "config",  "console",  "core",    "crypto",  "cursor",  "daemon",
+    "data",    "debug",   "desktop",  "device",  "disk",    "display", "driver",
+    "editor",  "engine",  "event",    "export",  "filter",  "font",    "format",
+    "frame",   "gadget",  "graph",    "green",   "handler", "image",   "index",
+    "input",   "kernel",  "layout",   "ledger",  "light",   "link",    "logger",
+    "magic",   "media",   "memory",   "menu",    "mirror",  "module",  "monitor",
+    "network", "notify",  "object",   "office",  "packet",  "panel",   "parser",
+    "pixel",   "plugin",  "policy",   "portal",  "power",   "print",   "process",
+    "proxy",   "python",  "query",    "queue",   "record",  "render",  "report",
+    "runtime", "sample",  "scanner",  "schema",  "screen",  "script",  "server",
+    "session", "shell",   "signal",   "socket",  "sound",   "source",  "storage",
+    "stream",  "style",   "syntax",   "system",  "table",   "theme",   "thread",
+    "token",   "tools",   "tracker",  "update",  "user",    "vector",  "video",
+    "viewer",  "volume",  "widget",   "window",  "worker",  "xml",     "zone",
+    0
+};
+
+static int wordCount = 0;
+
+
+static const char * prefixes[] =
+{
+    "", "", "", "lib", "lib", "python3-", "perl-", "ruby-", "golang-", "texlive-", 0
+};
+
+static const char * suffixes[] =
+{
+    "", "", "", "", "-devel", "-doc", "-lang", "-tools", "-32bit", 0
+};
+
+
+static int count( const char ** list )
+{
+    int i = 0;
+
+    while ( list[ i ] )
+        ++i;
+
+    return i;
+}
+
+
+static QString randomWord()
+{
+    return wordList[ randomGen() % wordCount ];
+}
+
+
+/**
+ * Return a text of 'minWords' to 'maxWords' random words, split into
+ * sentences.
+ **/
+static QString randomText( int minWords, int maxWords )
+{
+    int words = minWords + randomGen() % ( maxWords - minWords + 1 );
+    QString text;
+    bool newSentence = true;
+
+    for ( int i=0; i < words; ++i )
+    {
+        QString word = randomWord();
+
+        if ( newSentence )
+        {
+            word[0] = word[0].toUpper();
+            newSentence = false;
+        }
+
+        text += word;
+
+        if ( i == words - 1 )
+            text += ".";
+        else if ( randomGen() % 12 == 0 )
+        {
+            text += ". ";
+            newSentence = true;
+        }
+        else
+            text += " ";
+    }
+
+    return text;
+}
+
+
+static QStringList createPkgNames( int pkgCount )
+{
+    int prefixCount = count( prefixes );
+    int suffixCount = count( suffixes );
+
+    QStringList   names;
+    QSet<QString> used;
+
+    names.reserve( pkgCount );
+
+    while ( names.size() < pkgCount )
+    {
+        QString name = QString( prefixes[ randomGen() % prefixCount ] ) + randomWord();
+
+        if ( randomGen() % 2 )
+            name += "-" + randomWord();
+
+        name += suffixes[ randomGen() % suffixCount ];
+
+        if ( used.contains( name ) )
+            name += QString::number( names.size() );
+
+        used.insert( name );
+        names << name;
+    }
+
+    return names;
+}
+
+
+static bool isLib( const QString & name )
+{
+    return name.startsWith( "lib" ) && ! name.contains( '-' );
+}
+
+
+/**
+ * Return the capability that other packages require to get 'name': The
+ * library soname for libraries, otherwise the package name itself.
+ **/
+static QString requiredCap( const QString & name )
+{
+    if ( isLib( name ) )
+        return name + ".so.1()(64bit)";
+    else
+        return name;
+}
+
+
+static QString archOf( const QString & name )
+{
+    if ( name.endsWith( "-doc" ) || name.endsWith( "-lang" ) || name.startsWith( "texlive-" ) )
+        return "noarch";
+    else
+        return "x86_64";
+}
+
+
+static void writePkgHeader( QTextStream &   str,
+                            const QString & name,
+                            const QString & arch,
+                            const QString & version,
+                            const QString & summary,
+                            const QString & description )
+{
+    QString release = "150700.1.1";
+    QString nvra    = QString( "%1-%2-%3.%4" ).arg( name ).arg( version ).arg( release ).arg( arch );
+    QString pkgId   = QCryptographicHash::hash( nvra.toUtf8(), QCryptographicHash::Sha256 ).toHex();
+
+    qint64 pkgSize       = 4096 + randomGen() % ( 20 * 1024 * 1024 );
+    qint64 installedSize = pkgSize * ( 2 + randomGen() % 3 );
+
+    str << "<package type=\"rpm\">\n"
+        << "  <name>" << name << "</name>\n"
+        << "  <arch>" << arch << "</arch>\n"
+        << "  <version epoch=\"0\" ver=\"" << version << "\" rel=\"" << release << "\"/>\n"
+        << "  <checksum type=\"sha256\" pkgid=\"YES\">" << pkgId << "</checksum>\n"
+        << "  <summary>" << summary.toHtmlEscaped() << "</summary>\n"
+        << "  <description>" << description.toHtmlEscaped() << "</description>\n"
+        << "  <packager>https://bugs.opensuse.org</packager>\n"
+        << "  <url>https://example.org/" << name << "</url>\n"
+        << "  <time file=\"" TIME_STAMP "\" build=\"" TIME_STAMP "\"/>\n"
+        << "  <size package=\"" << pkgSize << "\" installed=\"" << installedSize
+        << "\" archive=\"" << installedSize << "\"/>\n"
+        << "  <location href=\"" << arch << "/" << nvra << ".rpm\"/>\n"
+        << "  <format>\n"
+        << "    <rpm:license>GPL-2.0-or-later</rpm:license>\n"
+        << "    <rpm:group>Synthetic/" << randomWord() << "</rpm:group>\n";
+}
+
+
+static void writeEntries( QTextStream &       str,
+                          const QString &     tag,
+                          const QStringList & entries )
+{
+    if ( entries.isEmpty() )
+        return;
+
+    str << "    <rpm:" << tag << ">\n";
+
+    for ( const QString & entry: entries )
+        str << "      " << entry << "\n";
+
+    str << "    </rpm:" << tag << ">\n";
+}
+
+
+static QString entry( const QString & name, const QString & version = QString() )
+{
+    if ( version.isEmpty() )
+        return QString( "<rpm:entry name=\"%1\"/>" ).arg( name.toHtmlEscaped() );
+    else
+        return QString( "<rpm:entry name=\"%1\" flags=\"EQ\" epoch=\"0\" ver=\"%2\"/>" )
+            .arg( name.toHtmlEscaped() ).arg( version.toHtmlEscaped() );
+}
+
+
+/**
+ * Write the primary.xml of one repo and return the number of packages in it.
+ **/
+static int writePrimary( const QString &     fileName,
+                         int                 repoNo,
+                         const PoolShape &   shape,
+                         const QStringList & names,
+                         const QList<int> &  versionCounts )
+{
+    QFile file( fileName );
+
+    if ( ! file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+        THROW( Exception( "Can't open " + fileName ) );
+
+    // The number of packages is only known at the end, and libsolv doesn't
+    // need it
+
+    QTextStream str( &file );
+    str << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<metadata xmlns=\"http://linux.duke.edu/metadata/common\""
+        << " xmlns:rpm=\"http://linux.duke.edu/metadata/rpm\">\n";
+
+    int pkgCount = 0;
+
+    for ( int i=0; i < names.size(); ++i )
+    {
+        const QString & name = names.at( i );
+
+        // Version 0 of every package is in repo 0, so all requires can always
+        // be resolved; newer versions are spread over all repos.
+
+        for ( int ver=0; ver < versionCounts.at( i ); ++ver )
+        {
+            if ( ver % shape.repoCount != repoNo )
+                continue;
+
+            QString version = QString( "%1.%2.%3" ).arg( 1 + i % 7 ).arg( i % 13 ).arg( ver );
+            QString arch    = archOf( name );
+
+            writePkgHeader( str, name, arch, version,
+                            randomText( 4, 9 ),       // summary
+                            randomText( 40, 220 ) );  // description
+
+            QStringList provides;
+            provides << entry( name, version );
+
+            if ( isLib( name ) )
+                provides << entry( requiredCap( name ) );
+
+            QStringList requiresList;
+            int reqCount = shape.requiresCount > 0 ? randomGen() % ( 2 * shape.requiresCount + 1 ) : 0;
+
+            for ( int r=0; r < reqCount; ++r )
+            {
+                int target = randomGen() % names.size();
+
+                if ( target != i )
+                    requiresList << entry( requiredCap( names.at( target ) ) );
+            }
+
+            requiresList.removeDuplicates();
+
+            writeEntries( str, "provides", provides );
+            writeEntries( str, "requires", requiresList );
+
+            str << "  </format>\n"
+                << "</package>\n";
+
+            ++pkgCount;
+        }
+    }
+
+    if ( repoNo == 0 )
+    {
+        // Patterns are packages that provide "pattern() = <name>"; their
+        // requires and recommends are the pattern's content.
+
+        for ( int i=0; i < shape.patterns; ++i )
+        {
+            QString patternName = QString( "%1-%2" ).arg( randomWord() ).arg( i );
+            QString name        = "patterns-synthetic-" + patternName;
+
+            writePkgHeader( str, name, "noarch", "1.0",
+                            QString( "Synthetic pattern %1" ).arg( patternName ),
+                            randomText( 20, 60 ) );
+
+            QStringList provides;
+            provides << entry( name, "1.0" )
+                     << entry( "pattern()", patternName )
+                     << entry( "pattern-visible()" )
+                     << entry( "pattern-category()", "Synthetic" )
+                     << entry( "pattern-order()", QString::number( 1000 + i ) );
+
+            QStringList requiresList;
+            QStringList recommendsList;
+
+            for ( int r=0; r < 3; ++r )
+                requiresList << entry( requiredCap( names.at( randomGen() % names.size() ) ) );
+
+            int recommendsCount = 20 + randomGen() % 41;
+
+            for ( int r=0; r < recommendsCount; ++r )
+                recommendsList << entry( requiredCap( names.at( randomGen() % names.size() ) ) );
+
+            requiresList.removeDuplicates();
+            recommendsList.removeDuplicates();
+
+            writeEntries( str, "provides",   provides       );
+            writeEntries( str, "requires",   requiresList   );
+            writeEntries( str, "recommends", recommendsList );
+
+            str << "  </format>\n"
+                << "</package>\n";
+
+            ++pkgCount;
+        }
+    }
+
+    str << "</metadata>\n";
+
+    return pkgCount;
+}
+
+
+static QString sha256( const QString & fileName )
+{
+    QFile file( fileName );
+
+    if ( ! file.open( QIODevice::ReadOnly ) )
+        THROW( Exception( "Can't open " + fileName ) );
+
+    QCryptographicHash hash( QCryptographicHash::Sha256 );
+    hash.addData( &file );
+
+    return hash.result().toHex();
+}
+
+
+static void writeRepoMd( const QString & repoDataDir )
+{
+    QString primary = repoDataDir + "/primary.xml";
+    QString checksum = sha256( primary );
+    qint64  size     = QFileInfo( primary ).size();
+
+    QFile file( repoDataDir + "/repomd.xml" );
+
+    if ( ! file.open( QIODevice::WriteOnly | QIODevice::Truncate ) )
+        THROW( Exception( "Can't open " + file.fileName() ) );
+
+    // The primary.xml is not compressed: libsolv doesn't need it, and
+    // this avoids a dependency to zlib just for this tool.
+
+    QTextStream str( &file );
+    str << "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        << "<repomd xmlns=\"http://linux.duke.edu/metadata/repo\""
+        << " xmlns:rpm=\"http://linux.duke.edu/metadata/rpm\">\n"
+        << "  <revision>" TIME_STAMP "</revision>\n"
+        << "  <data type=\"primary\">\n"
+        << "    <checksum type=\"sha256\">" << checksum << "</checksum>\n"
+        << "    <open-checksum type=\"sha256\">" << checksum << "</open-checksum>\n"
+        << "    <location href=\"repodata/primary.xml\"/>\n"
+        << "    <timestamp>" TIME_STAMP "</timestamp>\n"
+        << "    <size>" << size << "</size>\n"
+        << "    <open-size>" << size << "</open-size>\n"
+        << "  </data>\n"
+        << "</repomd>\n";
+}
+
+
+/**
+ * Add the repos to the repos.d of 'rootDir' and build their caches.
+ **/
+static void addRepos( const QString & rootDir, const PoolShape & shape )
+{
+    zypp::RepoManager repoManager( zypp::RepoManagerOptions( toUTF8( rootDir ) ) );
+
+    for ( int repoNo=0; repoNo < shape.repoCount; ++repoNo )
+    {
+        QString alias   = QString( "synthetic-%1" ).arg( repoNo );
+        QString repoDir = rootDir + "/repos/" + alias;
+
+        zypp::RepoInfo repo;
+        repo.setAlias( toUTF8( alias ) );
+        repo.setName ( toUTF8( QString( "Synthetic Repo %1" ).arg( repoNo ) ) );
+        repo.setBaseUrl( zypp::Url( toUTF8( "dir://" + repoDir ) ) );
+        repo.setType( zypp::repo::RepoType::RPMMD );
+        repo.setEnabled( true );
+        repo.setAutorefresh( false );
+        repo.setGpgCheck( false ); // The metadata are not signed
+        repo.setPriority( 99 - repoNo );
+
+        if ( repoManager.hasRepo( repo.alias() ) )
+            repoManager.removeRepository( repo );
+
+        repoManager.addRepository( repo );
+
+        if ( shape.buildCache )
+        {
+            logInfo() << "Building the cache for " << alias << endl;
+
+            repoManager.refreshMetadata( repo, zypp::RepoManager::RefreshForced );
+            repoManager.buildCache( repo, zypp::RepoManager::BuildForced );
+        }
+    }
+}
+
+
+static void usage( const QString & progName )
+{
+    std::cerr << "\n"
+              << "Usage: " << qPrintable( progName ) << " [<options>] <root-dir>\n"
+              << "\n"
+              << "Options:\n"
+              << "\n"
+              << "  --packages <n>   number of different package names   (default 100000)\n"
+              << "  --repos <n>      number of repos                     (default 4)\n"
+              << "  --versions <n>   maximum versions per package        (default 3)\n"
+              << "  --requires <n>   average requires per package        (default 6)\n"
+              << "  --patterns <n>   number of patterns                  (default 200)\n"
+              << "  --seed <n>       random seed                         (default 42)\n"
+              << "  --no-cache       don't build the caches\n"
+              << std::endl;
+
+    exit( 1 );
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Logger logger( "/tmp/myrlyn-$USER", "pool-generator.log" );
+    QCoreApplication app( argc, argv );
+
+    QStringList args     = app.arguments();
+    QString     progName = args.takeFirst();
+    PoolShape   shape;
+    QString     rootDir;
+
+    while ( ! args.isEmpty() )
+    {
+        QString arg = args.takeFirst();
+
+        if ( arg == "--no-cache" )
+        {
+            shape.buildCache = false;
+            continue;
+        }
+
+        if ( ! arg.startsWith( "--" ) )
+        {
+            if ( ! rootDir.isEmpty() )
+                usage( progName );
+
+            rootDir = arg;
+            continue;
+        }
+
+        if ( args.isEmpty() )
+            usage( progName );
+
+        bool ok   = false;
+        int value = args.takeFirst().toInt( &ok );
+
+        if ( ! ok || value < 0 )
+            usage( progName );
+
+        if      ( arg == "--packages" ) shape.pkgCount    = value;
+        else if ( arg == "--repos"    ) shape.repoCount   = value;
+        else if ( arg == "--versions" ) shape.maxVersions = value;
+        else if ( arg == "--requires" ) shape.requiresCount = value;
+        else if ( arg == "--patterns" ) shape.patterns    = value;
+        else if ( arg == "--seed"     ) shape.seed        = value;
+        else usage( progName );
+    }
+
+    if ( rootDir.isEmpty() || shape.pkgCount < 1 || shape.repoCount < 1 || shape.maxVersions < 1 )
+        usage( progName );
+
+    rootDir   = QDir( rootDir ).absolutePath();
+    wordCount = count( wordList );
+    randomGen.seed( shape.seed );
+
+    try
+    {
+        QStringList names = createPkgNames( shape.pkgCount );
+        QList<int>  versionCounts;
+
+        for ( int i=0; i < names.size(); ++i )
+            versionCounts << 1 + randomGen() % shape.maxVersions;
+
+        int totalCount = 0;
+
+        for ( int repoNo=0; repoNo < shape.repoCount; ++repoNo )
+        {
+            QString repoDataDir = QString( "%1/repos/synthetic-%2/repodata" ).arg( rootDir ).arg( repoNo );
+            QDir().mkpath( repoDataDir );
+
+            int pkgCount = writePrimary( repoDataDir + "/primary.xml", repoNo,
+                                         shape, names, versionCounts );
+            writeRepoMd( repoDataDir );
+
+            logInfo() << "Repo synthetic-" << repoNo << ": " << pkgCount << " packages" << endl;
+            totalCount += pkgCount;
+        }
+
+        addRepos( rootDir, shape );
+
+        logInfo() << "Generated " << totalCount << " packages with "
+                  << names.size() << " different names in "
+                  << shape.repoCount << " repos below " << rootDir << endl;
+    }
+    catch ( const zypp::Exception & exception )
+    {
+        logError() << "Caught zypp exception: " << exception.asString() << endl;
+        return 1;
+    }
+    catch ( const Exception & exception )
+    {
+        logError() << "Caught exception: " << exception.what() << endl;
+        return 1;
+    }
+
+    std::cerr << "Start Myrlyn with\n\n"
+              << "  myrlyn --root " << qPrintable( rootDir ) << "\n"
+              << std::endl;
+
+    return 0;
+}
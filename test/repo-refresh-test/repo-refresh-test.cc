@@ -0,0 +1,393 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <QCoreApplication>
+#include <QCryptographicHash>
+#include <QDir>
+#include <QElapsedTimer>
+#include <QHash>
+#include <QHostAddress>
+#include <QTcpServer>
+#include <QTcpSocket>
+#include <QTimer>
+
+#include <zypp/RepoInfo.h>
+#include <zypp/RepoManager.h>
+#include <zypp/Url.h>
+#include <zypp/repo/RepoType.h>
+
+#include "../../src/Logger.h"
+#include "../../src/Exception.h"
+#include "../../src/utf8.h"
+#include "../../src/ParallelRepoRefresher.h"
+
+
+// Refresh a number of empty rpm-md repos from a local HTTP server that
+// answers the requests for repomd.xml slowly with the ParallelRepoRefresher
+// and check that
+//
+// - refreshRepoStart() and refreshRepoDone() are sent for every good repo,
+// - a broken repo (HTTP 404) is disabled, and only that one,
+// - the metadata downloads don't overlap: The worker threads serialize them,
+//   so the server never has requests for more than one repo at a time, and
+//   the total time is at least the sum of the latencies,
+// - only repos with new metadata are reported as changed.
+//
+// Usage:
+//
+//   repo-refresh-test [repo-count [max-workers [delay-millisec]]]
+
+
+static int errorCount = 0;
+
+
+/**
+ * A minimal HTTP server for the repos on 127.0.0.1 that delays its answers
+ * for repomd.xml by 'delayMillisec', like a slow mirror would.
+ *
+ * It keeps track of the repos (the first path component) with requests in
+ * flight and of the maximum number of them at the same time.
+ **/
+class SlowRepoServer
+{
+public:
+
+    SlowRepoServer( int delayMillisec )
+        : _delayMillisec( delayMillisec )
+        , _maxBusyRepos( 0 )
+    {
+        _server.listen( QHostAddress::LocalHost );
+
+        QObject::connect( &_server, &QTcpServer::newConnection,
+                          [this]() { acceptConnections(); } );
+    }
+
+    /**
+     * Return 'true' if the server is listening on 127.0.0.1.
+     **/
+    bool isListening() const { return _server.isListening(); }
+
+    /**
+     * Return the base URL of repo 'alias' on this server.
+     **/
+    QString repoUrl( const QString & alias ) const
+    {
+        return QString( "http://127.0.0.1:%1/%2/" ).arg( _server.serverPort() ).arg( alias );
+    }
+
+    /**
+     * Serve 'content' for 'path' (below a repo's base URL, with the repo
+     * alias as the first component).
+     **/
+    void addFile( const QString & path, const QByteArray & content )
+    {
+        _files.insert( path, content );
+    }
+
+    /**
+     * Return the maximum number of repos with requests in flight at the same
+     * time so far.
+     **/
+    int maxBusyRepos() const { return _maxBusyRepos; }
+
+    void setDelay( int millisec ) { _delayMillisec = millisec; }
+
+
+protected:
+
+    void acceptConnections()
+    {
+        while ( _server.hasPendingConnections() )
+        {
+            QTcpSocket * socket = _server.nextPendingConnection();
+
+            QObject::connect( socket, &QTcpSocket::readyRead,
+                              [this, socket]() { readRequest( socket ); } );
+
+            QObject::connect( socket, &QTcpSocket::disconnected,
+                              socket, &QObject::deleteLater );
+        }
+    }
+
+    void readRequest( QTcpSocket * socket )
+    {
+        // One request per connection: The answer closes it
+
+        if ( socket->property( "answering" ).toBool() )
+            return;
+
+        QByteArray request = socket->property( "request" ).toByteArray() + socket->readAll();
+        socket->setProperty( "request", request );
+
+        if ( ! request.contains( "\r\n\r\n" ) )
+            return;
+
+        socket->setProperty( "answering", true );
+
+        QList<QByteArray> requestLine = request.left( request.indexOf( "\r\n" ) ).split( ' ' );
+        QString method = QString::fromUtf8( requestLine.value( 0 ) );
+        QString path   = QString::fromUtf8( requestLine.value( 1 ) ).section( '?', 0, 0 ).mid( 1 );
+        QString alias  = path.section( '/', 0, 0 );
+
+        _busy[ alias ]++;
+        _maxBusyRepos = qMax( _maxBusyRepos, busyRepoCount() );
+
+        int delay = path.endsWith( "/repomd.xml" ) ? _delayMillisec : 0;
+
+        QTimer::singleShot( delay, socket, [this, socket, method, path, alias]()
+            {
+                QByteArray answer;
+
+                if ( _files.contains( path ) )
+                {
+                    const QByteArray & content = _files[ path ];
+
+                    answer = "HTTP/1.1 200 OK\r\n"
+                        "Content-Length: " + QByteArray::number( content.size() ) + "\r\n"
+                        "Connection: close\r\n\r\n";
+
+                    if ( method != "HEAD" )
+                        answer += content;
+                }
+                else
+                {
+                    answer = "HTTP/1.1 404 Not Found\r\n"
+                        "Content-Length: 0\r\n"
+                        "Connection: close\r\n\r\n";
+                }
+
+                _busy[ alias ]--;
+                socket->write( answer );
+                socket->disconnectFromHost();
+            });
+    }
+
+    int busyRepoCount() const
+    {
+        int count = 0;
+
+        for ( int requests: _busy )
+        {
+            if ( requests > 0 )
+                ++count;
+        }
+
+        return count;
+    }
+
+
+    QTcpServer                 _server;
+    QHash<QString, QByteArray> _files;
+    QHash<QString, int>        _busy;
+    int                        _delayMillisec;
+    int                        _maxBusyRepos;
+};
+
+
+static QByteArray sha256( const QByteArray & content )
+{
+    return QCryptographicHash::hash( content, QCryptographicHash::Sha256 ).toHex();
+}
+
+
+/**
+ * Add the metadata of an empty rpm-md repo 'alias' to 'server'.
+ **/
+static void addRepoFiles( SlowRepoServer & server, const QString & alias )
+{
+    QByteArray primary =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<metadata xmlns=\"http://linux.duke.edu/metadata/common\""
+        " xmlns:rpm=\"http://linux.duke.edu/metadata/rpm\" packages=\"0\">\n"
+        "</metadata>\n";
+
+    QByteArray repomd =
+        "<?xml version=\"1.0\" encoding=\"UTF-8\"?>\n"
+        "<repomd xmlns=\"http://linux.duke.edu/metadata/repo\""
+        " xmlns:rpm=\"http://linux.duke.edu/metadata/rpm\">\n"
+        "  <revision>1</revision>\n"
+        "  <data type=\"primary\">\n"
+        "    <checksum type=\"sha256\">" + sha256( primary ) + "</checksum>\n"
+        "    <open-checksum type=\"sha256\">" + sha256( primary ) + "</open-checksum>\n"
+        "    <location href=\"repodata/primary.xml\"/>\n"
+        "    <timestamp>1700000000</timestamp>\n"
+        "    <size>" + QByteArray::number( primary.size() ) + "</size>\n"
+        "  </data>\n"
+        "</repomd>\n";
+
+    server.addFile( alias + "/repodata/repomd.xml",  repomd  );
+    server.addFile( alias + "/repodata/primary.xml", primary );
+}
+
+
+static ZyppRepoInfo createRepo( const SlowRepoServer & server,
+                                const QString &        alias )
+{
+    ZyppRepoInfo repo;
+    repo.setAlias( toUTF8( alias ) );
+    repo.setName ( toUTF8( alias ) );
+    repo.setBaseUrl( zypp::Url( toUTF8( server.repoUrl( alias ) ) ) );
+    repo.setType( zypp::repo::RepoType::RPMMD );
+    repo.setGpgCheck( false ); // Unsigned test repos
+    repo.setEnabled( true );
+    repo.setAutorefresh( true );
+
+    return repo;
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Logger logger( "/tmp/myrlyn-$USER", "repo-refresh-test.log" );
+    QCoreApplication app( argc, argv );
+
+    QStringList args = app.arguments();
+    int repoCount    = args.size() > 1 ? args.at( 1 ).toInt() : 8;
+    int maxWorkers   = args.size() > 2 ? args.at( 2 ).toInt() : 4;
+    int delay        = args.size() > 3 ? args.at( 3 ).toInt() : 300; // millisec
+
+    // Don't send the requests for 127.0.0.1 to a proxy
+
+    qputenv( "no_proxy", "127.0.0.1,localhost" );
+
+    // The raw metadata and the solv caches below this directory
+
+    QString baseDir = Logger::lastLogDir() + "/repo-refresh-test";
+    QDir( baseDir ).removeRecursively();
+
+    SlowRepoServer server( delay );
+    RepoInfoList   repos;
+
+    if ( ! server.isListening() )
+    {
+        logError() << "Can't listen on 127.0.0.1" << endl;
+        return 1;
+    }
+
+    for ( int i=0; i < repoCount; ++i )
+    {
+        QString alias = QString( "test-repo-%1" ).arg( i );
+
+        addRepoFiles( server, alias );
+        repos.push_back( createRepo( server, alias ) );
+    }
+
+    // A repo that the server doesn't know: HTTP 404
+
+    QString brokenAlias = "broken-repo";
+    repos.push_back( createRepo( server, brokenAlias ) );
+
+    zypp::RepoManagerOptions options( toUTF8( baseDir + "/root" ) );
+    ParallelRepoRefresher refresher( options, maxWorkers );
+
+    int startCount = 0;
+    int doneCount  = 0;
+
+    QObject::connect( &refresher, &ParallelRepoRefresher::refreshRepoStart,
+                      [&]( const ZyppRepoInfo & ) { ++startCount; } );
+
+    QObject::connect( &refresher, &ParallelRepoRefresher::refreshRepoDone,
+                      [&]( const ZyppRepoInfo & ) { ++doneCount; } );
+
+    QElapsedTimer timer;
+    timer.start();
+
+    try
+    {
+        refresher.refresh( repos );
+    }
+    catch ( const zypp::Exception & exception )
+    {
+        logError() << "Unexpected exception: " << exception.asString() << endl;
+        return 1;
+    }
+
+    qint64 elapsed    = timer.elapsed(); // millisec
+    qint64 sequential = (qint64) repoCount * delay; // Not for the broken repo
+
+    logInfo() << "Refreshed " << repoCount + 1 << " repos in " << elapsed
+              << " millisec; sum of the latencies: " << sequential << " millisec; "
+              << "at most " << server.maxBusyRepos() << " repos downloading at the same time"
+              << endl;
+
+
+    // Check the results
+
+    for ( const ZyppRepoInfo & repo: repos )
+    {
+        bool broken = fromUTF8( repo.alias() ) == brokenAlias;
+
+        if ( repo.enabled() == broken )
+        {
+            logError() << "Repo " << repo.alias() << " is "
+                       << ( repo.enabled() ? "enabled" : "disabled" ) << endl;
+            ++errorCount;
+        }
+    }
+
+    if ( startCount != repoCount + 1 )
+    {
+        logError() << "Expected " << repoCount + 1 << " refreshRepoStart signals, got "
+                   << startCount << endl;
+        ++errorCount;
+    }
+
+    if ( doneCount != repoCount )
+    {
+        logError() << "Expected " << repoCount << " refreshRepoDone signals, got "
+                   << doneCount << endl;
+        ++errorCount;
+    }
+
+    // Downloading the metadata is serialized between the worker threads; only
+    // building the solv caches may overlap.
+
+    if ( server.maxBusyRepos() > 1 )
+    {
+        logError() << "Metadata of " << server.maxBusyRepos()
+                   << " repos downloaded at the same time" << endl;
+        ++errorCount;
+    }
+
+    if ( elapsed < sequential )
+    {
+        logError() << "Refreshing took only " << elapsed << " millisec, less than the "
+                   << sequential << " millisec of the latencies of the server" << endl;
+        ++errorCount;
+    }
+
+    // The first refresh built all the caches, so all good repos changed
+
+    if ( refresher.changedRepos().size() != repoCount )
+    {
+        logError() << "Expected " << repoCount << " changed repos, got "
+                   << refresher.changedRepos().size() << endl;
+        ++errorCount;
+    }
+
+
+    // Nothing changed in the repos since the last refresh
+
+    server.setDelay( 0 );
+    refresher.refresh( repos );
+
+    if ( ! refresher.changedRepos().isEmpty() )
+    {
+        logError() << "Unchanged repos reported as changed: "
+                   << refresher.changedRepos().join( ", " ) << endl;
+        ++errorCount;
+    }
+
+    if ( errorCount > 0 )
+        logError() << errorCount << " errors" << endl;
+    else
+        logInfo() << "All checks OK" << endl;
+
+    return errorCount > 0 ? 1 : 0;
+}
@@ -0,0 +1,546 @@
+/*
+    Project:  Myrlyn Package Manager GUI
+    Copyright (c) 2024-25 SUSE LLC
+    License:  GPL V2 - See file LICENSE for details.
+
+    Textdomain "qt-pkg"
+ */
+
+
+#include <algorithm>    // std::sort()
+#include <iostream>     // cout, cerr
+#include <list>
+#include <stdlib.h>     // setenv()
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QList>
+#include <QStringList>
+#include <QTemporaryDir>
+
+#include <zypp/RepoManager.h>
+#include <zypp/ResPool.h>
+#include <zypp/Resolver.h>
+#include <zypp/ZYppFactory.h>
+#include <zypp/misc/LoadTestcase.h>
+
+#include "../../src/Logger.h"
+#include "../../src/Exception.h"
+#include "../../src/utf8.h"
+
+
+// Load a solver test case directory as written by "Create Solver Test Case"
+// in the conflict dialog (or by "zypper --debug-solver"), replay its jobs
+// through the libzypp resolver several times and report the solve times and
+// whether all runs came to the same result.
+//
+// This needs neither root permissions nor network access, so test cases from
+// real machines can be used as reproducible performance regression tests for
+// solver-related changes.
+//
+// Usage:
+//
+//   solver-replay [<options>] <testcase-dir>
+//
+// Options:
+//
+//   --runs <n>               number of solver runs per trial  (default 10)
+//   --recommends             install recommended packages
+//   --only-requires          don't install recommended packages
+//   --allow-vendor-change    allow vendor changes
+//   --clean-deps             remove unneeded dependencies on remove
+//
+// Without the resolver options, the settings from the test case are used.
+//
+// The exit code is 0 if all runs gave the same result, 2 if they didn't,
+// and 1 for errors.
+
+
+using zypp::misc::testcase::LoadTestcase;
+using zypp::misc::testcase::TestcaseTrial;
+
+
+/**
+ * Resolver settings from the command line that override the ones from the
+ * test case; -1 means "use the test case value".
+ **/
+struct ResolverOverrides
+{
+    int onlyRequires      = -1;
+    int allowVendorChange = -1;
+    int cleanDeps         = -1;
+};
+
+
+/**
+ * What the trial asked the resolver to do after applying all the jobs.
+ **/
+enum SolveMode
+{
+    SolveResolvePool,
+    SolveUpdate,
+    SolveDistUpgrade,
+    SolveVerify
+};
+
+
+/**
+ * The extra requires, conflicts and upgrade repos that the jobs of a trial
+ * added to the resolver, so they can be removed again before the next run.
+ **/
+struct ResolverExtras
+{
+    std::list<zypp::Capability> extraRequires;
+    std::list<zypp::Capability> extraConflicts;
+    std::list<zypp::Repository> upgradeRepos;
+};
+
+
+/**
+ * Find the pool item for a trial node with the name, kind, arch, version,
+ * release and channel (repo alias) properties like "install" or "lock".
+ **/
+static zypp::PoolItem findPoolItem( const TestcaseTrial::Node & node, bool installed )
+{
+    std::string kind    = node.getProp( "kind", "package" );
+    std::string name    = node.getProp( "name" );
+    std::string arch    = node.getProp( "arch" );
+    std::string version = node.getProp( "version" );
+    std::string release = node.getProp( "release" );
+    std::string channel = node.getProp( "channel" );
+
+    zypp::Edition edition( version, release );
+
+    for ( const zypp::PoolItem & item: zypp::ResPool::instance().byIdent( zypp::ResKind( kind ), name ) )
+    {
+        if ( item.status().isInstalled() != installed )
+            continue;
+
+        if ( ! arch.empty() && item.arch().asString() != arch )
+            continue;
+
+        if ( ! version.empty() && item.edition() != edition )
+            continue;
+
+        if ( ! channel.empty() && ! installed && item.repoInfo().alias() != channel )
+            continue;
+
+        return item;
+    }
+
+    return zypp::PoolItem();
+}
+
+
+/**
+ * Apply the jobs of a trial to the pool and the resolver. Return what the
+ * resolver should do with them.
+ **/
+static SolveMode applyJobs( const TestcaseTrial & trial,
+                            ResolverExtras      & extras,
+                            QStringList         & unsupported )
+{
+    zypp::Resolver_Ptr resolver = zypp::getZYpp()->resolver();
+    SolveMode          mode     = SolveResolvePool;
+
+    for ( const TestcaseTrial::Node & node: trial.nodes() )
+    {
+        const std::string & job = node.name();
+
+        if ( job == "install" || job == "uninstall" || job == "lock" || job == "keep" )
+        {
+            bool installed = ( job == "uninstall" );
+            zypp::PoolItem item = findPoolItem( node, installed );
+
+            if ( ! item && job != "uninstall" )
+                item = findPoolItem( node, ! installed );
+
+            if ( ! item )
+            {
+                logWarning() << "No match for " << job << " " << node.getProp( "name" ) << endl;
+                continue;
+            }
+
+            if      ( job == "install"   ) item.status().setToBeInstalled  ( zypp::ResStatus::USER );
+            else if ( job == "uninstall" ) item.status().setToBeUninstalled( zypp::ResStatus::USER );
+            else if ( job == "lock"      ) item.status().setLock( true,      zypp::ResStatus::USER );
+            else /*   job == "keep"     */ item.status().setTransactValue( zypp::ResStatus::KEEP_STATE,
+                                                                           zypp::ResStatus::USER );
+        }
+        else if ( job == "addRequire" || job == "addConflict" )
+        {
+            zypp::Capability cap( node.getProp( "name" ) );
+
+            if ( job == "addRequire" )
+            {
+                resolver->addRequire( cap );
+                extras.extraRequires.push_back( cap );
+            }
+            else
+            {
+                resolver->addConflict( cap );
+                extras.extraConflicts.push_back( cap );
+            }
+        }
+        else if ( job == "upgradeRepo" )
+        {
+            zypp::Repository repo = zypp::ResPool::instance().reposFind( node.getProp( "name" ) );
+
+            if ( repo != zypp::Repository::noRepository )
+            {
+                resolver->addUpgradeRepo( repo );
+                extras.upgradeRepos.push_back( repo );
+            }
+        }
+        else if ( job == "distupgrade" ) mode = SolveDistUpgrade;
+        else if ( job == "update"      ) mode = SolveUpdate;
+        else if ( job == "verify"      ) mode = SolveVerify;
+        else if ( job == "current"     ||
+                  job == "subscribe"   ||
+                  job == "reportproblems" )
+        {
+            // Nothing to do: All repos are loaded, and problems are always
+            // reported
+        }
+        else
+        {
+            QString name = fromUTF8( job );
+
+            if ( ! unsupported.contains( name ) )
+                unsupported << name;
+        }
+    }
+
+    return mode;
+}
+
+
+/**
+ * Undo everything that applyJobs() and the last solver run did, so the next
+ * run starts from the same state.
+ **/
+static void resetPool( ResolverExtras & extras )
+{
+    zypp::Resolver_Ptr resolver = zypp::getZYpp()->resolver();
+
+    for ( const zypp::PoolItem & item: zypp::ResPool::instance() )
+    {
+        item.status().resetTransact( zypp::ResStatus::USER );
+        item.status().setLock( false, zypp::ResStatus::USER );
+    }
+
+    for ( const zypp::Capability & cap: extras.extraRequires )
+        resolver->removeRequire( cap );
+
+    for ( const zypp::Capability & cap: extras.extraConflicts )
+        resolver->removeConflict( cap );
+
+    for ( const zypp::Repository & repo: extras.upgradeRepos )
+        resolver->removeUpgradeRepo( repo );
+
+    extras = ResolverExtras();
+
+    resolver->setUpgradeMode( false );
+    resolver->setUpdateMode ( false );
+}
+
+
+/**
+ * Run the resolver and return 'true' on success.
+ **/
+static bool solve( SolveMode mode )
+{
+    zypp::Resolver_Ptr resolver = zypp::getZYpp()->resolver();
+
+    switch ( mode )
+    {
+        case SolveResolvePool:  return resolver->resolvePool();
+        case SolveDistUpgrade:  return resolver->doUpgrade();
+        case SolveVerify:       return resolver->verifySystem();
+        case SolveUpdate:       resolver->doUpdate(); return true; // No return value
+    }
+
+    return false;
+}
+
+
+/**
+ * Return a description of the result of the last solver run that can be
+ * compared between runs: All transactions and all problems, sorted.
+ **/
+static QString resultSignature( bool success )
+{
+    QStringList lines;
+
+    for ( const zypp::PoolItem & item: zypp::ResPool::instance() )
+    {
+        if ( ! item.status().transacts() )
+            continue;
+
+        QString line = QString( "%1%2 %3 %4" )
+            .arg( item.status().isInstalled() ? "-" : "+" )
+            .arg( fromUTF8( item.name() ) )
+            .arg( fromUTF8( item.edition().asString() ) )
+            .arg( fromUTF8( item.arch().asString() ) );
+
+        if ( item.status().isBySolver() )
+            line += " (solver)";
+
+        lines << line;
+    }
+
+    if ( ! success )
+    {
+        for ( const zypp::ResolverProblem_Ptr & problem: zypp::getZYpp()->resolver()->problems() )
+            lines << QString( "Problem: %1" ).arg( fromUTF8( problem->description() ) );
+    }
+
+    lines.sort();
+
+    return lines.join( "\n" );
+}
+
+
+/**
+ * Apply the resolver settings from the command line.
+ **/
+static void applyOverrides( const ResolverOverrides & overrides )
+{
+    zypp::Resolver_Ptr resolver = zypp::getZYpp()->resolver();
+
+    if ( overrides.onlyRequires >= 0 )
+        resolver->setOnlyRequires( overrides.onlyRequires == 1 );
+
+    if ( overrides.allowVendorChange >= 0 )
+    {
+        resolver->setAllowVendorChange   ( overrides.allowVendorChange == 1 );
+        resolver->dupSetAllowVendorChange( overrides.allowVendorChange == 1 ); // bsc#1170521
+    }
+
+    if ( overrides.cleanDeps >= 0 )
+        resolver->setCleandepsOnRemove( overrides.cleanDeps == 1 );
+
+    logInfo() << "Resolver settings:"
+              << " onlyRequires: "      << resolver->onlyRequires()
+              << " allowVendorChange: " << resolver->allowVendorChange()
+              << " cleandepsOnRemove: " << resolver->cleandepsOnRemove()
+              << endl;
+}
+
+
+/**
+ * Replay one trial 'runs' times and report the results.
+ * Return 'true' if all runs gave the same result.
+ **/
+static bool replayTrial( const TestcaseTrial & trial, int trialNo, int runs )
+{
+    QList<qint64>  durations; // microseconds
+    QString        firstResult;
+    bool           firstSuccess = false;
+    int            differing    = 0;
+    QStringList    unsupported;
+    ResolverExtras extras;
+
+    for ( int run=0; run < runs; ++run )
+    {
+        resetPool( extras );
+        SolveMode mode = applyJobs( trial, extras, unsupported );
+
+        QElapsedTimer timer;
+        timer.start();
+
+        bool success = solve( mode );
+
+        durations << timer.nsecsElapsed() / 1000;
+
+        QString result = resultSignature( success );
+
+        if ( run == 0 )
+        {
+            firstResult  = result;
+            firstSuccess = success;
+        }
+        else if ( result != firstResult )
+        {
+            logWarning() << "Trial " << trialNo << " run " << run + 1
+                         << ": Result differs from the first run" << endl;
+            ++differing;
+        }
+    }
+
+    resetPool( extras );
+
+    if ( ! unsupported.isEmpty() )
+        logWarning() << "Trial " << trialNo << ": Ignored unsupported jobs: "
+                     << unsupported.join( ", " ) << endl;
+
+    // The first run also prepares the pool (whatprovides etc.), so it
+    // doesn't count for the statistics if there are more runs.
+
+    qint64        firstDuration = durations.first();
+    QList<qint64> sorted        = durations;
+
+    if ( sorted.size() > 1 )
+        sorted.removeFirst();
+
+    std::sort( sorted.begin(), sorted.end() );
+
+    qint64 sum = 0;
+
+    for ( qint64 duration: sorted )
+        sum += duration;
+
+    int transactions = 0;
+
+    for ( const QString & line: firstResult.split( '\n', Qt::SkipEmptyParts ) )
+    {
+        if ( ! line.startsWith( "Problem:" ) )
+            ++transactions;
+    }
+
+    std::cout << "Trial " << trialNo << ": "
+              << ( firstSuccess ? "success" : "PROBLEMS" )
+              << ", " << transactions << " transactions\n"
+              << "  runs:    " << runs << " (" << differing << " with a different result)\n"
+              << "  first:   " << firstDuration / 1000.0 << " ms\n"
+              << "  min:     " << sorted.first() / 1000.0 << " ms\n"
+              << "  median:  " << sorted.at( sorted.size() / 2 ) / 1000.0 << " ms\n"
+              << "  mean:    " << sum / (double) sorted.size() / 1000.0 << " ms\n"
+              << "  max:     " << sorted.last() / 1000.0 << " ms\n"
+              << std::endl;
+
+    logInfo() << "Trial " << trialNo << ": " << runs << " runs, "
+              << differing << " different results, median "
+              << sorted.at( sorted.size() / 2 ) / 1000.0 << " ms" << endl;
+
+    return differing == 0;
+}
+
+
+static void usage( const QString & progName )
+{
+    std::cerr << "\n"
+              << "Usage: " << qPrintable( progName ) << " [<options>] <testcase-dir>\n"
+              << "\n"
+              << "Options:\n"
+              << "\n"
+              << "  --runs <n>               number of solver runs per trial  (default 10)\n"
+              << "  --recommends             install recommended packages\n"
+              << "  --only-requires          don't install recommended packages\n"
+              << "  --allow-vendor-change    allow vendor changes\n"
+              << "  --clean-deps             remove unneeded dependencies on remove\n"
+              << "\n"
+              << "Without the resolver options, the settings from the test case are used.\n"
+              << std::endl;
+
+    exit( 1 );
+}
+
+
+int main( int argc, char *argv[] )
+{
+    Logger logger( "/tmp/myrlyn-$USER", "solver-replay.log" );
+    QCoreApplication app( argc, argv );
+
+    QStringList       args     = app.arguments();
+    QString           progName = args.takeFirst();
+    QString           testcaseDir;
+    ResolverOverrides overrides;
+    int               runs = 10;
+
+    while ( ! args.isEmpty() )
+    {
+        QString arg = args.takeFirst();
+
+        if      ( arg == "--recommends"          ) overrides.onlyRequires      = 0;
+        else if ( arg == "--only-requires"       ) overrides.onlyRequires      = 1;
+        else if ( arg == "--allow-vendor-change" ) overrides.allowVendorChange = 1;
+        else if ( arg == "--clean-deps"          ) overrides.cleanDeps         = 1;
+        else if ( arg == "--runs" && ! args.isEmpty() )
+        {
+            bool ok = false;
+            runs = args.takeFirst().toInt( &ok );
+
+            if ( ! ok || runs < 1 )
+                usage( progName );
+        }
+        else if ( ! arg.startsWith( "--" ) && testcaseDir.isEmpty() )
+            testcaseDir = arg;
+        else
+            usage( progName );
+    }
+
+    if ( testcaseDir.isEmpty() )
+        usage( progName );
+
+
+    // Keep everything that libzypp might want to write (the zypp lock, the
+    // repo caches) away from the real system.
+
+    QTemporaryDir tmpRoot;
+
+    if ( ! tmpRoot.isValid() )
+    {
+        logError() << "Can't create a temporary directory" << endl;
+        return 1;
+    }
+
+    setenv( "ZYPP_LOCKFILE_ROOT", qPrintable( tmpRoot.path() ), 1 );
+
+    int  trialCount = 0;
+    bool stable     = true;
+
+    try
+    {
+        LoadTestcase testcase;
+        std::string  err;
+
+        if ( ! testcase.loadTestcaseAt( zypp::Pathname( toUTF8( testcaseDir ) ), &err ) )
+        {
+            logError() << "Can't load test case " << testcaseDir << ": " << err << endl;
+            return 1;
+        }
+
+        zypp::getZYpp(); // Initialize the pool and the resolver
+        zypp::RepoManager repoManager( zypp::RepoManagerOptions( toUTF8( tmpRoot.path() ) ) );
+
+        QElapsedTimer timer;
+        timer.start();
+
+        if ( ! testcase.setupInfo().applySetup( repoManager ) )
+        {
+            logError() << "Can't set up the pool from test case " << testcaseDir << endl;
+            return 1;
+        }
+
+        std::cout << "Loaded " << qPrintable( testcaseDir ) << ": "
+                  << zypp::ResPool::instance().size() << " pool items in "
+                  << timer.elapsed() << " ms\n" << std::endl;
+
+        applyOverrides( overrides );
+
+        for ( const TestcaseTrial & trial: testcase.trialInfo() )
+        {
+            if ( ! replayTrial( trial, ++trialCount, runs ) )
+                stable = false;
+        }
+    }
+    catch ( const zypp::Exception & exception )
+    {
+        logError() << "Caught zypp exception: " << exception.asString() << endl;
+        return 1;
+    }
+    catch ( const Exception & exception )
+    {
+        logError() << "Caught exception: " << exception.what() << endl;
+        return 1;
+    }
+
+    if ( trialCount == 0 )
+    {
+        logError() << "No trials in test case " << testcaseDir << endl;
+        return 1;
+    }
+
+    return stable ? 0 : 2;
+}